@@ -0,0 +1,75 @@
+/*
+ * BenchAlignment
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Measures the Bayer conversion and the YUV conversion of frames, whose
+ * lines are aligned to 4, 16, 32 and 64 bytes. The width isn't a multiple
+ * of 16, so the lines of A4 images start at arbitrary offsets within a
+ * vector, while the other alignments pad the stride.
+ */
+
+#include <stdio.h>
+#include <vector>
+#include <tt/ds/Image.h>
+#include <tt/process/Bayer.h>
+#include <tt/process/YUV.h>
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::process::Bayer;
+using tt::process::YUV;
+
+static const int WIDTH = 1596;
+static const int HEIGHT = 1200;
+static const int REPETITIONS = 50;
+
+static const Image::LineAlignment alignments[] = {
+	Image::A4, Image::A16, Image::A32, Image::A64
+};
+
+int main()
+{
+	unsigned int seed = 1;
+	std::vector<unsigned char> yuv(YUV::getLineBytes(YUV::FORMAT_YUV422, WIDTH) * HEIGHT);
+	for (size_t i = 0; i < yuv.size(); i++)
+	{
+		seed = seed*1103515245 + 12345;
+		yuv[i] = (unsigned char) (seed >> 16);
+	}
+
+	printf("%dx%d, ms per frame, speedup to A4\n", WIDTH, HEIGHT);
+	printf("  %-5s %-18s %-18s %-18s\n", "", "bilinear", "Malvar-He-Cutler", "YUV422");
+	double baseline[3] = {0.0, 0.0, 0.0};
+	for (int a = 0; a < 4; a++)
+	{
+		Image source(WIDTH, HEIGHT, Image::GREYSCALE);
+		Image destination(WIDTH, HEIGHT, Image::RGB);
+		source.setLineAlignment(alignments[a]);
+		destination.setLineAlignment(alignments[a]);
+		tt::test::randomize(source, seed);
+
+		double times[3];
+		times[0] = tt::test::measure(REPETITIONS, [&]() {
+			Bayer::deBayer(&source, &destination, Bayer::BayerRG2BGR);
+		});
+		times[1] = tt::test::measure(REPETITIONS, [&]() {
+			Bayer::deBayer(&source, &destination, Bayer::BayerRG2BGR, Bayer::QUALITY_MALVAR);
+		});
+		times[2] = tt::test::measure(REPETITIONS, [&]() {
+			YUV::convert(&yuv[0], YUV::FORMAT_YUV422, &destination);
+		});
+
+		printf("  A%-4d", alignments[a]);
+		for (int i = 0; i < 3; i++)
+		{
+			if (a == 0)
+			{
+				baseline[i] = times[i];
+			}
+			printf(" %7.2f  %5.2fx   ", times[i], baseline[i] / times[i]);
+		}
+		printf("\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * BenchBayer
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Measures the Bayer conversion of 1600x1200 frames with the original OpenCV
+ * port and with each kernel of the library. Compares the peak signal to
+ * noise ratio and the throughput of both interpolation methods on the mosaic
+ * of a known scene.
+ */
+
+#include <stdio.h>
+#include <tt/ds/Image.h>
+#include <tt/process/Bayer.h>
+#include "ReferenceBayer.h"
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::process::Bayer;
+
+static const int WIDTH = 1600;
+static const int HEIGHT = 1200;
+static const int REPETITIONS = 50;
+
+static const char* kernelNames[] = {"auto", "scalar", "SSE2", "SSSE3", "AVX2"};
+
+static const char* qualityNames[] = {"bilinear", "Malvar-He-Cutler"};
+
+int main()
+{
+	unsigned int seed = 1;
+	Image source(WIDTH, HEIGHT, Image::GREYSCALE);
+	Image destination(WIDTH, HEIGHT, Image::RGB);
+	tt::test::randomize(source, seed);
+
+	printf("bilinear %dx%d, ms per frame\n", WIDTH, HEIGHT);
+	double baseline = tt::test::measure(REPETITIONS, [&]() {
+		tt::test::referenceDeBayer(&source, &destination, Bayer::BayerRG2BGR);
+	});
+	printf("  %-8s %7.2f\n", "original", baseline);
+
+	for (int k = Bayer::KERNEL_SCALAR; k <= Bayer::KERNEL_AVX2; k++)
+	{
+		if (!Bayer::isKernelSupported((Bayer::Kernel) k))
+		{
+			continue;
+		}
+		Bayer::setKernel((Bayer::Kernel) k);
+		double time = tt::test::measure(REPETITIONS, [&]() {
+			Bayer::deBayer(&source, &destination, Bayer::BayerRG2BGR);
+		});
+		printf("  %-8s %7.2f  %5.2fx\n", kernelNames[k], time, baseline / time);
+	}
+	Bayer::setKernel(Bayer::KERNEL_AUTO);
+
+	Image scene(WIDTH, HEIGHT, Image::RGB);
+	Image mosaic(WIDTH, HEIGHT, Image::GREYSCALE);
+	tt::test::drawScene(scene);
+	Bayer::mosaic(&scene, &mosaic, Bayer::BayerBG2BGR);
+	tt::sys::WorkerPool pool(4);
+
+	printf("\nknown scene %dx%d, PSNR and ms per frame, serial and with 4 threads\n",
+		WIDTH, HEIGHT);
+	for (int q = Bayer::QUALITY_BILINEAR; q <= Bayer::QUALITY_MALVAR; q++)
+	{
+		Bayer::deBayer(&mosaic, &destination, Bayer::BayerBG2BGR, (Bayer::Quality) q);
+		printf("  %s, %.2f dB\n", qualityNames[q], tt::test::psnr(scene, destination, 2));
+
+		for (int k = Bayer::KERNEL_SCALAR; k <= Bayer::KERNEL_AVX2; k++)
+		{
+			if (!Bayer::isKernelSupported((Bayer::Kernel) k))
+			{
+				continue;
+			}
+			Bayer::setKernel((Bayer::Kernel) k);
+			double serial = tt::test::measure(REPETITIONS, [&]() {
+				Bayer::deBayer(&mosaic, &destination, Bayer::BayerBG2BGR, (Bayer::Quality) q);
+			});
+			double parallel = tt::test::measure(REPETITIONS, [&]() {
+				Bayer::deBayer(&mosaic, &destination, Bayer::BayerBG2BGR, pool,
+					(Bayer::Quality) q);
+			});
+			printf("    %-8s %7.2f %7.2f\n", kernelNames[k], serial, parallel);
+		}
+		Bayer::setKernel(Bayer::KERNEL_AUTO);
+	}
+
+	return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * BenchIterators
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Measures a read only pass (the sum of all channels) and a read write pass
+ * (inverting all channels) over a 1600x1200 RGB image with Image::operator(),
+ * with the lines of ImageRows indexed by ImageRow::operator() and with
+ * PixelIterator. The variants are checked to give the same results first.
+ */
+
+#include <stdio.h>
+#include <tt/ds/Image.h>
+#include <tt/ds/ImageRows.h>
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::ds::ImageRow;
+using tt::ds::ImageRows;
+using tt::ds::PixelIterator;
+using tt::ds::RowIterator;
+
+static const int WIDTH = 1600;
+static const int HEIGHT = 1200;
+static const int REPETITIONS = 50;
+
+static unsigned long sumOperator(const Image& image)
+{
+	unsigned long sum = 0;
+	for (int y = 0; y < image.getHeight(); y++)
+	{
+		for (int x = 0; x < image.getWidth(); x++)
+		{
+			sum += image(x, y, 0) + image(x, y, 1) + image(x, y, 2);
+		}
+	}
+	return sum;
+}
+
+static unsigned long sumRows(const Image& image)
+{
+	ImageRows<3, const unsigned char> rows = tt::ds::getRows<Image::RGB, Image::BPC8>(image);
+	unsigned long sum = 0;
+	for (int y = 0; y < rows.getHeight(); y++)
+	{
+		ImageRow<3, const unsigned char> line = rows[y];
+		for (int x = 0; x < line.getWidth(); x++)
+		{
+			sum += line(x, 0) + line(x, 1) + line(x, 2);
+		}
+	}
+	return sum;
+}
+
+static unsigned long sumIterators(const Image& image)
+{
+	ImageRows<3, const unsigned char> rows = tt::ds::getRows<Image::RGB, Image::BPC8>(image);
+	unsigned long sum = 0;
+	for (RowIterator<3, const unsigned char> row = rows.begin(); row != rows.end(); ++row)
+	{
+		ImageRow<3, const unsigned char> line = *row;
+		for (PixelIterator<3, const unsigned char> p = line.begin(); p != line.end(); ++p)
+		{
+			sum += p[0] + p[1] + p[2];
+		}
+	}
+	return sum;
+}
+
+static void invertOperator(Image& image)
+{
+	for (int y = 0; y < image.getHeight(); y++)
+	{
+		for (int x = 0; x < image.getWidth(); x++)
+		{
+			image(x, y, 0) = 255 - image(x, y, 0);
+			image(x, y, 1) = 255 - image(x, y, 1);
+			image(x, y, 2) = 255 - image(x, y, 2);
+		}
+	}
+}
+
+static void invertRows(Image& image)
+{
+	ImageRows<3, unsigned char> rows = tt::ds::getRows<Image::RGB, Image::BPC8>(image);
+	for (int y = 0; y < rows.getHeight(); y++)
+	{
+		ImageRow<3, unsigned char> line = rows[y];
+		for (int x = 0; x < line.getWidth(); x++)
+		{
+			line(x, 0) = 255 - line(x, 0);
+			line(x, 1) = 255 - line(x, 1);
+			line(x, 2) = 255 - line(x, 2);
+		}
+	}
+}
+
+static void invertIterators(Image& image)
+{
+	ImageRows<3, unsigned char> rows = tt::ds::getRows<Image::RGB, Image::BPC8>(image);
+	for (RowIterator<3, unsigned char> row = rows.begin(); row != rows.end(); ++row)
+	{
+		ImageRow<3, unsigned char> line = *row;
+		for (PixelIterator<3, unsigned char> p = line.begin(); p != line.end(); ++p)
+		{
+			p[0] = 255 - p[0];
+			p[1] = 255 - p[1];
+			p[2] = 255 - p[2];
+		}
+	}
+}
+
+int main()
+{
+	unsigned int seed = 1;
+	Image image(WIDTH, HEIGHT, Image::RGB);
+	tt::test::randomize(image, seed);
+
+	Image byOperator(image);
+	Image byRows(image);
+	Image byIterators(image);
+	invertOperator(byOperator);
+	invertRows(byRows);
+	invertIterators(byIterators);
+	if (sumOperator(image) != sumRows(image) || sumOperator(image) != sumIterators(image) ||
+		!tt::test::equal(byOperator, byRows) || !tt::test::equal(byOperator, byIterators))
+	{
+		printf("FAILED: the variants differ\n");
+		return 1;
+	}
+
+	// the sums are stored, so the compiler can't drop the read only passes
+	volatile unsigned long sum;
+	printf("RGB %dx%d, ms per pass\n", WIDTH, HEIGHT);
+	printf("  %-10s %-8s %-8s\n", "", "sum", "invert");
+
+	double sumTime = tt::test::measure(REPETITIONS, [&]() { sum = sumOperator(image); });
+	double invertTime = tt::test::measure(REPETITIONS, [&]() { invertOperator(image); });
+	printf("  %-10s %7.2f  %7.2f\n", "operator()", sumTime, invertTime);
+
+	sumTime = tt::test::measure(REPETITIONS, [&]() { sum = sumRows(image); });
+	invertTime = tt::test::measure(REPETITIONS, [&]() { invertRows(image); });
+	printf("  %-10s %7.2f  %7.2f\n", "ImageRow", sumTime, invertTime);
+
+	sumTime = tt::test::measure(REPETITIONS, [&]() { sum = sumIterators(image); });
+	invertTime = tt::test::measure(REPETITIONS, [&]() { invertIterators(image); });
+	printf("  %-10s %7.2f  %7.2f\n", "iterators", sumTime, invertTime);
+
+	return 0;
+}
@@ -0,0 +1,130 @@
+#ifndef TT_TEST_REFERENCEBAYER_H
+#define TT_TEST_REFERENCEBAYER_H
+
+#include <string.h>
+#include <tt/ds/Image.h>
+#include <tt/process/Bayer.h>
+
+namespace tt
+{
+
+namespace test
+{
+
+/**
+ * @brief The original Bayer::deBayer, a port of OpenCV's icvBayer2BGR_8u_C1C3R.
+ * @param source The source picture (must be GREYSCALE)
+ * @param destination (must be RGB)
+ * @param filter Use this filter for debayering
+ *
+ * It flips the channel order and the phase of the line at runtime after each
+ * line. The library kernels must give exactly the same output, the
+ * benchmarks use it as the baseline.
+ */
+inline void referenceDeBayer(const tt::ds::Image* source, tt::ds::Image* destination,
+	tt::process::Bayer::Filter filter)
+{
+	using tt::process::Bayer;
+
+	const unsigned char* bayer0 = source->getImageBuffer();
+	int bayer_step = source->getAllocatedWidth();
+	unsigned char* dst0 = destination->getImageBuffer();
+	int dst_step = destination->getAllocatedWidth();
+	int width = source->getWidth();
+	int height = source->getHeight();
+
+	int blue = filter == Bayer::BayerBG2BGR || filter == Bayer::BayerGB2BGR ? -1 : 1;
+	int start_with_green = filter == Bayer::BayerGB2BGR || filter == Bayer::BayerGR2BGR;
+
+	memset(dst0, 0, width*3);
+	memset(dst0 + (height - 1)*dst_step, 0, width*3);
+	dst0 += dst_step + 3 + 1;
+	height -= 2;
+	width -= 2;
+
+	for (; height-- > 0; bayer0 += bayer_step, dst0 += dst_step)
+	{
+		int t0, t1;
+		const unsigned char* bayer = bayer0;
+		unsigned char* dst = dst0;
+		const unsigned char* bayer_end = bayer + width;
+
+		dst[-4] = dst[-3] = dst[-2] = dst[width*3-1] =
+			dst[width*3] = dst[width*3+1] = 0;
+
+		if (width <= 0)
+			continue;
+
+		if (start_with_green)
+		{
+			t0 = (bayer[1] + bayer[bayer_step*2+1] + 1) >> 1;
+			t1 = (bayer[bayer_step] + bayer[bayer_step+2] + 1) >> 1;
+			dst[-blue] = (unsigned char)t0;
+			dst[0] = bayer[bayer_step+1];
+			dst[blue] = (unsigned char)t1;
+			bayer++;
+			dst += 3;
+		}
+
+		if (blue > 0)
+		{
+			for (; bayer <= bayer_end - 2; bayer += 2, dst += 6)
+			{
+				t0 = (bayer[0] + bayer[2] + bayer[bayer_step*2] +
+				      bayer[bayer_step*2+2] + 2) >> 2;
+				t1 = (bayer[1] + bayer[bayer_step] +
+				      bayer[bayer_step+2] + bayer[bayer_step*2+1] + 2) >> 2;
+				dst[-1] = (unsigned char)t0;
+				dst[0] = (unsigned char)t1;
+				dst[1] = bayer[bayer_step+1];
+
+				t0 = (bayer[2] + bayer[bayer_step*2+2] + 1) >> 1;
+				t1 = (bayer[bayer_step+1] + bayer[bayer_step+3] + 1) >> 1;
+				dst[2] = (unsigned char)t0;
+				dst[3] = bayer[bayer_step+2];
+				dst[4] = (unsigned char)t1;
+			}
+		}
+		else
+		{
+			for (; bayer <= bayer_end - 2; bayer += 2, dst += 6)
+			{
+				t0 = (bayer[0] + bayer[2] + bayer[bayer_step*2] +
+				      bayer[bayer_step*2+2] + 2) >> 2;
+				t1 = (bayer[1] + bayer[bayer_step] +
+				      bayer[bayer_step+2] + bayer[bayer_step*2+1] + 2) >> 2;
+				dst[1] = (unsigned char)t0;
+				dst[0] = (unsigned char)t1;
+				dst[-1] = bayer[bayer_step+1];
+
+				t0 = (bayer[2] + bayer[bayer_step*2+2] + 1) >> 1;
+				t1 = (bayer[bayer_step+1] + bayer[bayer_step+3] + 1) >> 1;
+				dst[4] = (unsigned char)t0;
+				dst[3] = bayer[bayer_step+2];
+				dst[2] = (unsigned char)t1;
+			}
+		}
+
+		if (bayer < bayer_end)
+		{
+			t0 = (bayer[0] + bayer[2] + bayer[bayer_step*2] +
+			      bayer[bayer_step*2+2] + 2) >> 2;
+			t1 = (bayer[1] + bayer[bayer_step] +
+			      bayer[bayer_step+2] + bayer[bayer_step*2+1] + 2) >> 2;
+			dst[-blue] = (unsigned char)t0;
+			dst[0] = (unsigned char)t1;
+			dst[blue] = bayer[bayer_step+1];
+			bayer++;
+			dst += 3;
+		}
+
+		blue = -blue;
+		start_with_green = !start_with_green;
+	}
+}
+
+} // namespace test
+
+} // namespace tt
+
+#endif /*TT_TEST_REFERENCEBAYER_H*/
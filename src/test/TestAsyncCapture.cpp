@@ -0,0 +1,435 @@
+/*
+ * TestAsyncCapture
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks the SPSCQueue on its own and between two threads, and the capture
+ * thread of ImageDevice on the stub device below: the frames arrive in
+ * order, frames captured while the queue is full are dropped and counted,
+ * released frames are reused, waitImage times out, and the end of the
+ * frames and an exception of the device reach the application. Checks the
+ * frames each delivery policy delivers to a slow application.
+ */
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <tt/ds/Image.h>
+#include <tt/input/ImageDevice.h>
+#include <tt/sys/SPSCQueue.h>
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::input::ImageDevice;
+using tt::sys::SPSCQueue;
+
+/**
+ * @brief A device of a number of small frames, all pixels of frame n have
+ * the value n. Captures a frame per period and throws at the failing frame.
+ */
+class StubDevice : public ImageDevice
+{
+public:
+	StubDevice(int frames, int period = 0, int failure = -1) :
+		frames(frames),
+		period(period),
+		failure(failure),
+		number(-1),
+		image(16, 8, Image::GREYSCALE)
+	{
+	}
+
+	virtual ~StubDevice()
+	{
+		stopAsyncCapture();
+	}
+
+	virtual void open() {}
+	virtual void close() {}
+	virtual void init() {}
+	virtual void captureStart() {}
+
+	virtual void captureStop()
+	{
+		stopAsyncCapture();
+	}
+
+	virtual void captureNext()
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(period));
+		number++;
+		if (number == failure)
+		{
+			throw std::runtime_error("void StubDevice::captureNext() the frame failed.");
+		}
+		for (int y = 0; y < image.getHeight(); y++)
+		{
+			for (int x = 0; x < image.getWidth(); x++)
+			{
+				image(x, y, 0) = (unsigned char) number;
+			}
+		}
+	}
+
+	virtual Image* getImage()
+	{
+		return number < frames ? &image : NULL;
+	}
+
+	virtual const int getImageWidth() const
+	{
+		return image.getWidth();
+	}
+
+	virtual const int getImageHeight() const
+	{
+		return image.getHeight();
+	}
+
+private:
+	int frames;
+	int period;
+	int failure;
+	int number;
+	Image image;
+};
+
+/**
+ * @brief Return true, if all pixels of a frame have the value of its number.
+ */
+static bool isFrame(const Image* image, int number)
+{
+	if (image == NULL)
+	{
+		return false;
+	}
+	for (int y = 0; y < image->getHeight(); y++)
+	{
+		for (int x = 0; x < image->getWidth(); x++)
+		{
+			if ((*image)(x, y, 0) != number)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Wait, until the capture thread delivered its last frame.
+ */
+static void waitFinished(const ImageDevice& device)
+{
+	while (device.isCapturingAsync())
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+/**
+ * @brief A queue keeps its items in order, also when its positions wrap around.
+ */
+static void testQueue(tt::test::Checks& checks)
+{
+	SPSCQueue<int> queue(3);
+	int item = 0;
+	checks.check(queue.isEmpty() && queue.getSize() == 0 && queue.getCapacity() == 3 &&
+		!queue.pop(item), "the new queue isn't empty");
+
+	int next = 0;
+	int expected = 0;
+	bool ordered = true;
+	for (int round = 0; round < 10; round++)
+	{
+		while (queue.push(next))
+		{
+			next++;
+		}
+		if (!queue.isFull() || queue.getSize() != 3)
+		{
+			ordered = false;
+		}
+		// take 2 of 3, the positions move by one item per round
+		for (int i = 0; i < 2; i++)
+		{
+			if (!queue.pop(item) || item != expected++)
+			{
+				ordered = false;
+			}
+		}
+	}
+	while (queue.pop(item))
+	{
+		if (item != expected++)
+		{
+			ordered = false;
+		}
+	}
+	checks.check(ordered && expected == next && queue.isEmpty(), "the queue lost its order");
+
+	bool rejected = false;
+	try
+	{
+		SPSCQueue<int> empty(0);
+	}
+	catch (std::runtime_error&)
+	{
+		rejected = true;
+	}
+	checks.check(rejected, "a queue without capacity was created");
+}
+
+/**
+ * @brief A consumer thread gets all items of a producer thread in order.
+ */
+static void testQueueThreads(tt::test::Checks& checks)
+{
+	const int ITEMS = 200000;
+	SPSCQueue<int> queue(16);
+	std::thread producer([&queue]()
+	{
+		for (int i = 0; i < ITEMS; i++)
+		{
+			while (!queue.push(i))
+			{
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	int expected = 0;
+	bool ordered = true;
+	while (expected < ITEMS)
+	{
+		int item;
+		if (!queue.pop(item))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		if (item != expected++)
+		{
+			ordered = false;
+		}
+	}
+	producer.join();
+	checks.check(ordered && queue.isEmpty(), "the consumer got the items out of order");
+}
+
+/**
+ * @brief Frames arrive in order, until the device has no more, and released
+ * frames are reused by the capture thread.
+ */
+static void testFrames(tt::test::Checks& checks)
+{
+	StubDevice device(30);
+	device.startAsyncCapture(32);
+	waitFinished(device);
+	bool ordered = true;
+	for (int n = 0; n < 30; n++)
+	{
+		Image* image = device.pollImage();
+		if (!isFrame(image, n))
+		{
+			ordered = false;
+		}
+		device.releaseImage(image);
+	}
+	checks.check(ordered, "the frames are out of order");
+	checks.check(device.pollImage() == NULL && device.waitImage(1000) == NULL &&
+		device.getDroppedFrames() == 0, "the end of the frames isn't delivered");
+	device.stopAsyncCapture();
+
+	// a frame released during the period of the device is captured into
+	StubDevice slow(6, 20);
+	slow.startAsyncCapture();
+	Image* previous = slow.waitImage(1000);
+	ordered = isFrame(previous, 0);
+	bool reused = false;
+	for (int n = 1; n < 6; n++)
+	{
+		slow.releaseImage(previous);
+		Image* image = slow.waitImage(1000);
+		if (!isFrame(image, n))
+		{
+			ordered = false;
+		}
+		if (image == previous)
+		{
+			reused = true;
+		}
+		previous = image;
+	}
+	slow.releaseImage(previous);
+	checks.check(ordered && reused, "the released frames weren't reused");
+}
+
+/**
+ * @brief Frames captured while the queue is full are dropped and counted.
+ */
+static void testDrops(tt::test::Checks& checks)
+{
+	StubDevice device(20);
+	device.startAsyncCapture(4);
+	waitFinished(device);
+	bool ordered = true;
+	for (int n = 0; n < 4; n++)
+	{
+		Image* image = device.pollImage();
+		if (!isFrame(image, n))
+		{
+			ordered = false;
+		}
+		delete image;
+	}
+	checks.check(ordered && device.pollImage() == NULL, "the queue holds other frames");
+	checks.check(device.getDroppedFrames() == 16, "%lu frames dropped instead of 16",
+		device.getDroppedFrames());
+}
+
+/**
+ * @brief waitImage returns NULL after the timeout and the frame, once it is captured.
+ */
+static void testTimeout(tt::test::Checks& checks)
+{
+	StubDevice device(1, 300);
+	device.startAsyncCapture();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	Image* image = device.waitImage(20);
+	long long waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	checks.check(image == NULL && waited >= 20 && waited < 250, "waitImage returned after %lld ms",
+		waited);
+
+	image = device.waitImage(2000);
+	checks.check(isFrame(image, 0), "the frame didn't arrive");
+	delete image;
+}
+
+/**
+ * @brief The exception of the device is thrown after the frames captured before it.
+ */
+static void testErrors(tt::test::Checks& checks)
+{
+	StubDevice device(10, 0, 3);
+	device.startAsyncCapture(8);
+	waitFinished(device);
+	bool ordered = true;
+	for (int n = 0; n < 3; n++)
+	{
+		Image* image = device.waitImage(1000);
+		if (!isFrame(image, n))
+		{
+			ordered = false;
+		}
+		delete image;
+	}
+	checks.check(ordered, "the frames before the exception are lost");
+
+	bool thrown = false;
+	try
+	{
+		device.pollImage();
+	}
+	catch (std::runtime_error&)
+	{
+		thrown = true;
+	}
+	checks.check(thrown, "the exception of the device didn't arrive");
+	device.stopAsyncCapture();
+
+	// the thread can only be started once and frames taken while it runs
+	thrown = false;
+	try
+	{
+		device.pollImage();
+	}
+	catch (std::runtime_error&)
+	{
+		thrown = true;
+	}
+	checks.check(thrown, "a frame was taken without capture thread");
+
+	StubDevice twice(1000, 1);
+	twice.startAsyncCapture();
+	thrown = false;
+	try
+	{
+		twice.startAsyncCapture();
+	}
+	catch (std::runtime_error&)
+	{
+		thrown = true;
+	}
+	checks.check(thrown, "a second capture thread was started");
+	twice.stopAsyncCapture();
+	checks.check(!twice.isCapturingAsync(), "the capture thread didn't stop");
+}
+
+/**
+ * @brief LATEST_ONLY delivers the newest frame, BLOCKING_LOSSLESS all frames.
+ */
+static void testPolicies(tt::test::Checks& checks)
+{
+	StubDevice latest(20);
+	checks.check(latest.getDeliveryPolicy() == ImageDevice::BOUNDED_QUEUE,
+		"the default policy isn't BOUNDED_QUEUE");
+	latest.setDeliveryPolicy(ImageDevice::LATEST_ONLY);
+	latest.startAsyncCapture();
+	waitFinished(latest);
+	Image* image = latest.pollImage();
+	checks.check(isFrame(image, 19) && latest.pollImage() == NULL &&
+		latest.getDroppedFrames() == 19, "LATEST_ONLY delivered another frame");
+	delete image;
+
+	bool rejected = false;
+	try
+	{
+		latest.setDeliveryPolicy(ImageDevice::BOUNDED_QUEUE);
+	}
+	catch (std::runtime_error&)
+	{
+		rejected = true;
+	}
+	checks.check(rejected, "the policy changed while capturing");
+	latest.stopAsyncCapture();
+
+	// the capture thread waits for the application instead of dropping
+	StubDevice lossless(20);
+	lossless.setDeliveryPolicy(ImageDevice::BLOCKING_LOSSLESS);
+	lossless.startAsyncCapture(2);
+	bool ordered = true;
+	for (int n = 0; n < 20; n++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		image = lossless.waitImage(1000);
+		if (!isFrame(image, n))
+		{
+			ordered = false;
+		}
+		lossless.releaseImage(image);
+	}
+	checks.check(ordered && lossless.waitImage(1000) == NULL &&
+		lossless.getDroppedFrames() == 0, "BLOCKING_LOSSLESS lost frames");
+
+	// stopping wakes a capture thread waiting for the application
+	StubDevice blocked(20);
+	blocked.setDeliveryPolicy(ImageDevice::BLOCKING_LOSSLESS);
+	blocked.startAsyncCapture(2);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	blocked.stopAsyncCapture();
+	checks.check(!blocked.isCapturingAsync(), "the waiting capture thread didn't stop");
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testQueue(checks);
+	testQueueThreads(checks);
+	testFrames(checks);
+	testDrops(checks);
+	testTimeout(checks);
+	testErrors(checks);
+	testPolicies(checks);
+	return checks.report("TestAsyncCapture");
+}
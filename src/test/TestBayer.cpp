@@ -0,0 +1,401 @@
+/*
+ * TestBayer
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks that the scalar Bayer kernel gives exactly the output of the
+ * original OpenCV port, and that all vectorized kernels, the parallel
+ * conversion and all instances of the templates give exactly the output of
+ * the scalar kernel, also for 16 bit pixels. Checks that Malvar-He-Cutler
+ * beats the bilinear interpolation on a known scene, and that the color
+ * correction within the conversion gives the result of a separate one.
+ */
+
+#include <stdexcept>
+#include <tt/ds/Image.h>
+#include <tt/process/Bayer.h>
+#include <tt/process/ColorCorrection.h>
+#include "ReferenceBayer.h"
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::process::Bayer;
+
+static const Bayer::Filter filters[] = {
+	Bayer::BayerBG2BGR, Bayer::BayerGB2BGR, Bayer::BayerRG2BGR, Bayer::BayerGR2BGR
+};
+
+static const Bayer::Kernel vectorKernels[] = {
+	Bayer::KERNEL_SSE2, Bayer::KERNEL_SSSE3, Bayer::KERNEL_AVX2
+};
+
+static const Bayer::Quality qualities[] = {
+	Bayer::QUALITY_BILINEAR, Bayer::QUALITY_MALVAR
+};
+
+/**
+ * @brief Compare the scalar kernel with the original OpenCV port.
+ */
+static void testScalar(tt::test::Checks& checks)
+{
+	unsigned int seed = 3;
+	Bayer::setKernel(Bayer::KERNEL_SCALAR);
+	for (int width = 1; width < 100; width += 3)
+	{
+		for (int height = 1; height < 80; height += 5)
+		{
+			Image source(width, height, Image::GREYSCALE);
+			tt::test::randomize(source, seed);
+
+			for (int f = 0; f < 4; f++)
+			{
+				Image reference(width, height, Image::RGB);
+				Image result(width, height, Image::RGB);
+				tt::test::referenceDeBayer(&source, &reference, filters[f]);
+				Bayer::deBayer(&source, &result, filters[f]);
+				checks.check(tt::test::equal(reference, result),
+					"scalar %dx%d filter %d", width, height, filters[f]);
+			}
+		}
+	}
+	Bayer::setKernel(Bayer::KERNEL_AUTO);
+}
+
+/**
+ * @brief Compare deBayer<P, O> with deBayer and the filter BayerP2O.
+ * 
+ * The RGB filters are aliases of the BGR filters with the mirrored pattern.
+ */
+static void testTemplates(tt::test::Checks& checks)
+{
+	unsigned int seed = 4;
+	for (int width = 1; width < 70; width += 5)
+	{
+		for (int height = 1; height < 20; height += 3)
+		{
+			Image source(width, height, Image::GREYSCALE);
+			tt::test::randomize(source, seed);
+
+			for (int f = 0; f < 4; f++)
+			{
+				Image reference(width, height, Image::RGB);
+				Image bgr(width, height, Image::RGB);
+				Image rgb(width, height, Image::RGB);
+				Bayer::deBayer(&source, &reference, filters[f]);
+				switch (filters[f])
+				{
+					case Bayer::BayerBG2BGR:
+						Bayer::deBayer<Bayer::PATTERN_BG, Bayer::ORDER_BGR>(&source, &bgr);
+						Bayer::deBayer<Bayer::PATTERN_RG, Bayer::ORDER_RGB>(&source, &rgb);
+						break;
+
+					case Bayer::BayerGB2BGR:
+						Bayer::deBayer<Bayer::PATTERN_GB, Bayer::ORDER_BGR>(&source, &bgr);
+						Bayer::deBayer<Bayer::PATTERN_GR, Bayer::ORDER_RGB>(&source, &rgb);
+						break;
+
+					case Bayer::BayerRG2BGR:
+						Bayer::deBayer<Bayer::PATTERN_RG, Bayer::ORDER_BGR>(&source, &bgr);
+						Bayer::deBayer<Bayer::PATTERN_BG, Bayer::ORDER_RGB>(&source, &rgb);
+						break;
+
+					default:
+						Bayer::deBayer<Bayer::PATTERN_GR, Bayer::ORDER_BGR>(&source, &bgr);
+						Bayer::deBayer<Bayer::PATTERN_GB, Bayer::ORDER_RGB>(&source, &rgb);
+						break;
+				}
+				checks.check(tt::test::equal(reference, bgr),
+					"template BGR %dx%d filter %d", width, height, filters[f]);
+				checks.check(tt::test::equal(reference, rgb),
+					"template RGB %dx%d filter %d", width, height, filters[f]);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Compare the bilinear interpolation of all vectorized kernels with
+ * the scalar one on random frames of odd and even sizes.
+ */
+static void testBilinear(tt::test::Checks& checks)
+{
+	unsigned int seed = 1;
+	for (int width = 1; width < 140; width += (width < 40 ? 1 : 7))
+	{
+		for (int height = 1; height < 12; height++)
+		{
+			Image source(width, height, Image::GREYSCALE);
+			tt::test::randomize(source, seed);
+
+			for (int f = 0; f < 4; f++)
+			{
+				Image reference(width, height, Image::RGB);
+				Bayer::setKernel(Bayer::KERNEL_SCALAR);
+				Bayer::deBayer(&source, &reference, filters[f]);
+
+				for (int k = 0; k < 3; k++)
+				{
+					if (!Bayer::isKernelSupported(vectorKernels[k]))
+					{
+						continue;
+					}
+					Image result(width, height, Image::RGB);
+					Bayer::setKernel(vectorKernels[k]);
+					Bayer::deBayer(&source, &result, filters[f]);
+					checks.check(tt::test::equal(reference, result),
+						"bilinear %dx%d filter %d kernel %d", width, height, filters[f],
+						vectorKernels[k]);
+				}
+			}
+		}
+	}
+	Bayer::setKernel(Bayer::KERNEL_AUTO);
+}
+
+/**
+ * @brief Compare both methods of all vectorized kernels and of the parallel
+ * conversion with the serial scalar one.
+ * 
+ * The heights cross the minimum band height, so the pool splits some frames.
+ */
+static void testKernels(tt::test::Checks& checks)
+{
+	unsigned int seed = 5;
+	tt::sys::WorkerPool pool(3);
+	for (int width = 1; width < 120; width += 3)
+	{
+		for (int height = 1; height < 80; height += 5)
+		{
+			Image source(width, height, Image::GREYSCALE);
+			tt::test::randomize(source, seed);
+
+			for (int f = 0; f < 4; f++)
+			{
+				for (int q = 0; q < 2; q++)
+				{
+					Image reference(width, height, Image::RGB);
+					Bayer::setKernel(Bayer::KERNEL_SCALAR);
+					Bayer::deBayer(&source, &reference, filters[f], qualities[q]);
+
+					for (int k = Bayer::KERNEL_SCALAR; k <= Bayer::KERNEL_AVX2; k++)
+					{
+						if (!Bayer::isKernelSupported((Bayer::Kernel) k))
+						{
+							continue;
+						}
+						Image serial(width, height, Image::RGB);
+						Image parallel(width, height, Image::RGB);
+						Bayer::setKernel((Bayer::Kernel) k);
+						Bayer::deBayer(&source, &serial, filters[f], qualities[q]);
+						Bayer::deBayer(&source, &parallel, filters[f], pool, qualities[q]);
+						checks.check(tt::test::equal(reference, serial),
+							"quality %d %dx%d filter %d kernel %d", qualities[q],
+							width, height, filters[f], k);
+						checks.check(tt::test::equal(reference, parallel),
+							"parallel quality %d %dx%d filter %d kernel %d", qualities[q],
+							width, height, filters[f], k);
+					}
+				}
+			}
+		}
+	}
+	Bayer::setKernel(Bayer::KERNEL_AUTO);
+}
+
+/**
+ * @brief Compare both methods of all vectorized kernels for 16 bit pixels
+ * with the scalar one.
+ */
+static void testKernels16(tt::test::Checks& checks)
+{
+	unsigned int seed = 6;
+	for (int width = 1; width < 60; width += 2)
+	{
+		for (int height = 1; height < 12; height += 2)
+		{
+			Image source(width, height, Image::GREYSCALE, Image::BPC16);
+			tt::test::randomize(source, seed);
+
+			for (int f = 0; f < 4; f++)
+			{
+				for (int q = 0; q < 2; q++)
+				{
+					Image reference(width, height, Image::RGB, Image::BPC16);
+					Bayer::setKernel(Bayer::KERNEL_SCALAR);
+					Bayer::deBayer(&source, &reference, filters[f], qualities[q]);
+
+					for (int k = 0; k < 3; k++)
+					{
+						if (!Bayer::isKernelSupported(vectorKernels[k]))
+						{
+							continue;
+						}
+						Image result(width, height, Image::RGB, Image::BPC16);
+						Bayer::setKernel(vectorKernels[k]);
+						Bayer::deBayer(&source, &result, filters[f], qualities[q]);
+						checks.check(tt::test::equal(reference, result),
+							"16 bit quality %d %dx%d filter %d kernel %d", qualities[q],
+							width, height, filters[f], vectorKernels[k]);
+					}
+				}
+			}
+		}
+	}
+	Bayer::setKernel(Bayer::KERNEL_AUTO);
+}
+
+/**
+ * @brief Compare the conversion with a color correction with a conversion
+ * followed by ColorCorrection::apply in both channel orders.
+ * 
+ * The gains differ for each channel, so a correction of the wrong channels
+ * is noticed. BPC16 images must be rejected.
+ */
+static void testCorrection(tt::test::Checks& checks)
+{
+	static const Bayer::Order orders[] = {Bayer::ORDER_BGR, Bayer::ORDER_RGB};
+	unsigned int seed = 7;
+	tt::process::ColorCorrection correction;
+	correction.setGains(1.5, 1.0, 0.5);
+	correction.setGamma(2.2);
+	tt::sys::WorkerPool pool(3);
+
+	Image source(67, 70, Image::GREYSCALE);
+	tt::test::randomize(source, seed);
+	for (int f = 0; f < 4; f++)
+	{
+		for (int q = 0; q < 2; q++)
+		{
+			for (int o = 0; o < 2; o++)
+			{
+				Image reference(67, 70, Image::RGB);
+				Image serial(67, 70, Image::RGB);
+				Image parallel(67, 70, Image::RGB);
+				Bayer::deBayer(&source, &reference, filters[f], qualities[q]);
+				correction.apply(&reference, orders[o]);
+				Bayer::deBayer(&source, &serial, filters[f], correction, qualities[q], orders[o]);
+				Bayer::deBayer(&source, &parallel, filters[f], pool, correction, qualities[q],
+					orders[o]);
+				checks.check(tt::test::equal(reference, serial),
+					"correction quality %d filter %d order %d", qualities[q], filters[f],
+					orders[o]);
+				checks.check(tt::test::equal(reference, parallel),
+					"parallel correction quality %d filter %d order %d", qualities[q],
+					filters[f], orders[o]);
+			}
+		}
+	}
+
+	Image source16(8, 8, Image::GREYSCALE, Image::BPC16);
+	Image destination16(8, 8, Image::RGB, Image::BPC16);
+	bool thrown = false;
+	try
+	{
+		Bayer::deBayer(&source16, &destination16, Bayer::BayerBG2BGR, correction);
+	}
+	catch (std::runtime_error&)
+	{
+		thrown = true;
+	}
+	checks.check(thrown, "correction of BPC16 images not rejected");
+
+	thrown = false;
+	try
+	{
+		correction.apply(&destination16);
+	}
+	catch (std::runtime_error&)
+	{
+		thrown = true;
+	}
+	checks.check(thrown, "separate correction of BPC16 images not rejected");
+}
+
+/**
+ * @brief Interpolate the mosaic of a known scene with both methods.
+ * 
+ * Malvar-He-Cutler must be closer to the scene than the bilinear
+ * interpolation for all filters.
+ */
+static void testQuality(tt::test::Checks& checks)
+{
+	Image scene(320, 240, Image::RGB);
+	Image mosaic(320, 240, Image::GREYSCALE);
+	Image bilinear(320, 240, Image::RGB);
+	Image malvar(320, 240, Image::RGB);
+	tt::test::drawScene(scene);
+
+	for (int f = 0; f < 4; f++)
+	{
+		Bayer::mosaic(&scene, &mosaic, filters[f]);
+		Bayer::deBayer(&mosaic, &bilinear, filters[f]);
+		Bayer::deBayer(&mosaic, &malvar, filters[f], Bayer::QUALITY_MALVAR);
+		double bilinearPsnr = tt::test::psnr(scene, bilinear, 2);
+		double malvarPsnr = tt::test::psnr(scene, malvar, 2);
+		checks.check(malvarPsnr > bilinearPsnr + 1.0, "quality filter %d: bilinear "
+			"%.2f dB, Malvar-He-Cutler %.2f dB", filters[f], bilinearPsnr, malvarPsnr);
+	}
+}
+
+/**
+ * @brief Compare shares of the destinations taken before a conversion with
+ * copies. The conversions must give the destination a buffer of its own,
+ * not write into the pixels of the shares.
+ */
+static void testShares(tt::test::Checks& checks)
+{
+	unsigned int seed = 11;
+	tt::process::ColorCorrection correction;
+	correction.setGains(1.5, 1.0, 0.5);
+	tt::sys::WorkerPool pool(3);
+
+	Image source(64, 64, Image::GREYSCALE);
+	tt::test::randomize(source, seed);
+	for (int variant = 0; variant < 5; variant++)
+	{
+		Image destination(64, 64, Image::RGB);
+		tt::test::randomize(destination, seed);
+		Image copy(destination);
+		Image share = destination.share();
+		switch (variant)
+		{
+			case 0:
+				Bayer::deBayer(&source, &destination, Bayer::BayerBG2BGR);
+				break;
+			case 1:
+				Bayer::deBayer(&source, &destination, Bayer::BayerBG2BGR, pool);
+				break;
+			case 2:
+				Bayer::deBayer<Bayer::PATTERN_BG, Bayer::ORDER_BGR>(&source, &destination);
+				break;
+			case 3:
+				Bayer::deBayer(&source, &destination, Bayer::BayerBG2BGR, correction);
+				break;
+			default:
+				correction.apply(&destination);
+				break;
+		}
+		checks.check(tt::test::equal(copy, share), "share written by variant %d", variant);
+		checks.check(!tt::test::equal(copy, destination), "variant %d didn't convert", variant);
+	}
+
+	Image grey(64, 64, Image::GREYSCALE);
+	tt::test::randomize(grey, seed);
+	Image copy(grey);
+	Image share = grey.share();
+	Bayer::deBayerLuma(&source, &grey, Bayer::BayerBG2BGR);
+	checks.check(tt::test::equal(copy, share), "share written by deBayerLuma");
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testScalar(checks);
+	testBilinear(checks);
+	testTemplates(checks);
+	testKernels(checks);
+	testKernels16(checks);
+	testQuality(checks);
+	testCorrection(checks);
+	testShares(checks);
+	return checks.report("TestBayer");
+}
@@ -0,0 +1,221 @@
+/*
+ * TestBitDepth
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks the 16 bit conversions of all kernels against a pixel by pixel
+ * reference on random big endian frames of all shifts, with lines aligned
+ * to 4 and to 64 bytes, and that mismatching images are rejected.
+ */
+
+#include <stdexcept>
+#include <vector>
+#include <tt/ds/Image.h>
+#include <tt/process/BitDepth.h>
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::process::BitDepth;
+
+/**
+ * @brief Return the 8 bit value of a 16 bit value, saturated like BitDepth::convert.
+ */
+static unsigned char referenceShift(int value, int shift)
+{
+	value >>= shift;
+	return (unsigned char) (value > 255 ? 255 : value);
+}
+
+/**
+ * @brief Return true, if a BPC16 image has the values of a big endian frame.
+ */
+static bool equalBigEndian(const unsigned char* frame, const Image& image)
+{
+	int count = image.getWidth() * image.getChannels();
+	for (int y = 0; y < image.getHeight(); y++)
+	{
+		const unsigned char* src = frame + y*count*2;
+		for (int i = 0; i < count; i++)
+		{
+			if (image.pixel16(i / image.getChannels(), y, i % image.getChannels()) !=
+				((src[2*i] << 8) | src[2*i + 1]))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Return true, if a BPC8 image has the shifted values of a big endian frame.
+ */
+static bool equalShifted(const unsigned char* frame, const Image& image, int shift)
+{
+	int count = image.getWidth() * image.getChannels();
+	for (int y = 0; y < image.getHeight(); y++)
+	{
+		const unsigned char* src = frame + y*count*2;
+		const unsigned char* dst = image.getImageBuffer() + y*image.getAllocatedWidth();
+		for (int i = 0; i < count; i++)
+		{
+			if (dst[i] != referenceShift((src[2*i] << 8) | src[2*i + 1], shift))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Return true, if a BPC8 image has the table entries of the values of a BPC16 image.
+ */
+static bool equalLookedUp(const Image& source, const Image& image,
+	const std::vector<unsigned char>& table)
+{
+	for (int y = 0; y < source.getHeight(); y++)
+	{
+		for (int x = 0; x < source.getWidth(); x++)
+		{
+			for (int c = 0; c < source.getChannels(); c++)
+			{
+				if (image(x, y, c) != table[source.pixel16(x, y, c)])
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Convert random frames, black and white frames with all kernels.
+ */
+static void testKernels(tt::test::Checks& checks)
+{
+	static const BitDepth::Kernel kernels[] = {BitDepth::KERNEL_SCALAR, BitDepth::KERNEL_SSE2};
+	static const Image::LineAlignment alignments[] = {Image::A4, Image::A64};
+	static const Image::Channels channels[] = {Image::GREYSCALE, Image::RGB};
+	unsigned int seed = 9;
+
+	std::vector<unsigned char> table(BitDepth::TABLE_SIZE);
+	for (size_t i = 0; i < table.size(); i++)
+	{
+		seed = seed*1103515245 + 12345;
+		table[i] = (unsigned char) (seed >> 16);
+	}
+
+	for (int i = 0; i < 400; i++)
+	{
+		int width = 1 + (i*7) % 45;
+		int height = 1 + i % 5;
+		int shift = i % 16;
+		Image::Channels channel = channels[(i / 2) % 2];
+		Image::setDefaultLineAlignment(alignments[i % 2]);
+
+		std::vector<unsigned char> frame(width * channel * height * 2);
+		for (size_t b = 0; b < frame.size(); b++)
+		{
+			seed = seed*1103515245 + 12345;
+			frame[b] = i < 2 ? 0 : (i < 4 ? 255 : (unsigned char) (seed >> 16));
+		}
+
+		for (int k = 0; k < 2; k++)
+		{
+			if (!BitDepth::isKernelSupported(kernels[k]))
+			{
+				continue;
+			}
+			BitDepth::setKernel(kernels[k]);
+
+			Image copy(width, height, channel, Image::BPC16);
+			BitDepth::copyBigEndian(&frame[0], &copy);
+			checks.check(equalBigEndian(&frame[0], copy), "copyBigEndian %dx%d A%d kernel %d",
+				width, height, alignments[i % 2], kernels[k]);
+
+			Image direct(width, height, channel);
+			BitDepth::convertBigEndian(&frame[0], &direct, shift);
+			checks.check(equalShifted(&frame[0], direct, shift),
+				"convertBigEndian %dx%d A%d shift %d kernel %d", width, height,
+				alignments[i % 2], shift, kernels[k]);
+
+			Image shifted(width, height, channel);
+			BitDepth::convert(&copy, &shifted, shift);
+			checks.check(equalShifted(&frame[0], shifted, shift),
+				"convert %dx%d A%d shift %d kernel %d", width, height, alignments[i % 2],
+				shift, kernels[k]);
+
+			Image lookedUp(width, height, channel);
+			BitDepth::convert(&copy, &lookedUp, table);
+			checks.check(equalLookedUp(copy, lookedUp, table), "table %dx%d A%d kernel %d",
+				width, height, alignments[i % 2], kernels[k]);
+		}
+	}
+	BitDepth::setKernel(BitDepth::KERNEL_AUTO);
+	Image::setDefaultLineAlignment(Image::A4);
+}
+
+/**
+ * @brief Images, shifts and tables, which don't match, must be rejected.
+ */
+static void testFormats(tt::test::Checks& checks)
+{
+	Image grey16(8, 8, Image::GREYSCALE, Image::BPC16);
+	Image grey(8, 8, Image::GREYSCALE);
+	Image rgb(8, 8, Image::RGB);
+	Image small(4, 8, Image::GREYSCALE);
+	std::vector<unsigned char> frame(8 * 8 * 2);
+	std::vector<unsigned char> shortTable(256);
+
+	for (int c = 0; c < 7; c++)
+	{
+		bool thrown = false;
+		try
+		{
+			switch (c)
+			{
+				case 0:
+					BitDepth::convert(&grey16, &rgb);
+					break;
+
+				case 1:
+					BitDepth::convert(&grey16, &small);
+					break;
+
+				case 2:
+					BitDepth::convert(&grey16, &grey, 16);
+					break;
+
+				case 3:
+					BitDepth::convert(&grey, &grey);
+					break;
+
+				case 4:
+					BitDepth::convert(&grey16, &grey, shortTable);
+					break;
+
+				case 5:
+					BitDepth::copyBigEndian(&frame[0], &grey);
+					break;
+
+				case 6:
+					BitDepth::convertBigEndian(&frame[0], &grey16);
+					break;
+			}
+		}
+		catch (std::runtime_error&)
+		{
+			thrown = true;
+		}
+		checks.check(thrown, "case %d not rejected", c);
+	}
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testKernels(checks);
+	testFormats(checks);
+	return checks.report("TestBitDepth");
+}
@@ -0,0 +1,153 @@
+/*
+ * TestCameraGroup
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks the frame sets of a CameraGroup of simulated cameras, which
+ * capture in phase, so every frame set matches without skew, and that the
+ * group leaves no camera capturing, if a camera doesn't start or the group
+ * is destroyed while capturing.
+ */
+
+#include <stdexcept>
+#include <vector>
+#include <tt/input/CameraGroup.h>
+#include <tt/input/SimulatedFirewireCamera.h>
+#include "TestUtils.h"
+
+using tt::input::CameraGroup;
+using tt::input::FirewireCamera;
+using tt::input::SimulatedFirewireCamera;
+
+/**
+ * @brief Create a simulated camera of small Format 7 frames.
+ */
+static SimulatedFirewireCamera* createCamera(int index, FirewireCamera::Framerate framerate)
+{
+	SimulatedFirewireCamera* camera = new SimulatedFirewireCamera();
+	camera->selectCamera(index);
+	camera->setVideoFormat(FirewireCamera::FORMAT7);
+	camera->setVideoMode(FirewireCamera::MODE0);
+	camera->setVideoFramerate(framerate);
+	camera->setFormat7ImageSize(160, 120);
+	return camera;
+}
+
+/**
+ * @brief Return true, if captureStart of a camera throws, since it captures.
+ */
+static bool isCapturing(FirewireCamera* camera)
+{
+	try
+	{
+		camera->captureStart();
+	}
+	catch (std::runtime_error&)
+	{
+		return true;
+	}
+	camera->captureStop();
+	return false;
+}
+
+/**
+ * @brief Two cameras at the same framerate deliver their frames at the same
+ * times, so all frame sets match with a tight tolerance.
+ */
+static void testInPhase(tt::test::Checks& checks)
+{
+	std::vector<SimulatedFirewireCamera*> cameras;
+	CameraGroup group;
+	for (int i = 0; i < 2; i++)
+	{
+		cameras.push_back(createCamera(i, FirewireCamera::FRAMERATE_120));
+		group.addCamera(cameras[i]);
+	}
+	group.setTolerance(2000);
+	group.open();
+	group.captureStart();
+
+	CameraGroup::FrameSet frameSet;
+	int frameSets = 0;
+	long long maxSkew = 0;
+	for (int i = 0; i < 30; i++)
+	{
+		if (group.waitFrameSet(frameSet, 1000))
+		{
+			frameSets++;
+			if (frameSet.getSkew() > maxSkew)
+			{
+				maxSkew = frameSet.getSkew();
+			}
+		}
+	}
+	checks.check(frameSets == 30 && group.getFrameSets() == 30, "%d of 30 frame sets",
+		frameSets);
+	checks.check(maxSkew == 0 && group.getMaxSkew(0) == 0 && group.getMaxSkew(1) == 0,
+		"skew %lld us", maxSkew);
+	checks.check(frameSet.getSize() == 2 && frameSet.getImage(1)->getWidth() == 160,
+		"the frame set has no frame of each camera");
+
+	group.captureStop();
+	checks.check(!isCapturing(cameras[0]) && !isCapturing(cameras[1]),
+		"captureStop left a camera capturing");
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		delete cameras[i];
+	}
+}
+
+/**
+ * @brief A camera, which doesn't start, stops the cameras started before.
+ */
+static void testStartFailure(tt::test::Checks& checks)
+{
+	SimulatedFirewireCamera* started = createCamera(0, FirewireCamera::FRAMERATE_120);
+	SimulatedFirewireCamera* failing = createCamera(1, FirewireCamera::FRAMERATE_120);
+	CameraGroup group;
+	group.addCamera(started);
+	group.addCamera(failing);
+	started->open();
+
+	// the second camera isn't open
+	bool rejected = false;
+	try
+	{
+		group.captureStart();
+	}
+	catch (std::runtime_error&)
+	{
+		rejected = true;
+	}
+	checks.check(rejected && !group.isCapturing(), "captureStart started without a camera");
+	checks.check(!isCapturing(started), "the first camera was left capturing");
+
+	delete started;
+	delete failing;
+}
+
+/**
+ * @brief The destructor of a capturing group stops the cameras.
+ */
+static void testDestruction(tt::test::Checks& checks)
+{
+	SimulatedFirewireCamera* camera = createCamera(0, FirewireCamera::FRAMERATE_240);
+	{
+		CameraGroup group;
+		group.addCamera(camera);
+		group.open();
+		group.captureStart();
+		CameraGroup::FrameSet frameSet;
+		group.waitFrameSet(frameSet, 1000);
+	}
+	checks.check(!isCapturing(camera), "~CameraGroup left the camera capturing");
+	delete camera;
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testInPhase(checks);
+	testStartFailure(checks);
+	testDestruction(checks);
+	return checks.report("TestCameraGroup");
+}
@@ -0,0 +1,152 @@
+/*
+ * TestFramePool
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks the size classes and the alignment of the FramePool buffers, that
+ * released buffers are handed out again and counted as hits, new buffers as
+ * misses, that the free lists stay below their limit, and that images draw
+ * their buffers from the pool and give them back, also from another thread.
+ */
+
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include <tt/ds/FramePool.h>
+#include <tt/ds/Image.h>
+#include "TestUtils.h"
+
+using tt::ds::FramePool;
+using tt::ds::Image;
+
+/**
+ * @brief Sizes are rounded up by less than a quarter to aligned classes.
+ */
+static void testClasses(tt::test::Checks& checks)
+{
+	static const size_t sizes[] = {1, 64, 65, 100, 1000, 1025, 4096, 4097, 640*480*3, 1600*1200};
+	static const size_t classes[] = {64, 64, 128, 128, 1024, 1280, 4096, 5120, 1048576, 2097152};
+	FramePool pool;
+
+	for (int i = 0; i < 10; i++)
+	{
+		checks.check(FramePool::getClassSize(sizes[i]) == classes[i], "size %lu in class %lu",
+			(unsigned long) sizes[i], (unsigned long) FramePool::getClassSize(sizes[i]));
+		unsigned char* buffer = pool.allocate(sizes[i]);
+		checks.check((uintptr_t) buffer % FramePool::ALIGNMENT == 0, "size %lu not aligned",
+			(unsigned long) sizes[i]);
+		pool.release(buffer, sizes[i]);
+	}
+}
+
+/**
+ * @brief Released buffers are handed out again to sizes of their class.
+ */
+static void testHits(tt::test::Checks& checks)
+{
+	FramePool pool;
+	unsigned char* buffer = pool.allocate(1030);
+	checks.check(pool.getHits() == 0 && pool.getMisses() == 1 && pool.getFreeBytes() == 0,
+		"the first buffer isn't a miss");
+
+	pool.release(buffer, 1030);
+	checks.check(pool.getFreeBytes() == 1280, "%lu free bytes instead of 1280",
+		(unsigned long) pool.getFreeBytes());
+	unsigned char* other = pool.allocate(1200);
+	checks.check(other == buffer && pool.getHits() == 1 && pool.getMisses() == 1 &&
+		pool.getFreeBytes() == 0, "a released buffer of the class wasn't reused");
+
+	// another class needs a new buffer
+	pool.release(other, 1200);
+	unsigned char* large = pool.allocate(4000);
+	checks.check(large != buffer && pool.getHits() == 1 && pool.getMisses() == 2,
+		"a buffer of another class was reused");
+	pool.release(large, 4000);
+
+	pool.resetCounters();
+	checks.check(pool.getHits() == 0 && pool.getMisses() == 0, "the counters weren't reset");
+}
+
+/**
+ * @brief Buffers beyond the limit of the free lists are freed instead of kept.
+ */
+static void testLimit(tt::test::Checks& checks)
+{
+	FramePool pool(2048);
+	std::vector<unsigned char*> buffers;
+	for (int i = 0; i < 3; i++)
+	{
+		buffers.push_back(pool.allocate(1000));
+	}
+	for (int i = 0; i < 3; i++)
+	{
+		pool.release(buffers[i], 1000);
+	}
+	checks.check(pool.getFreeBytes() == 2048, "%lu free bytes beyond the limit",
+		(unsigned long) pool.getFreeBytes());
+
+	pool.resetCounters();
+	for (int i = 0; i < 3; i++)
+	{
+		buffers[i] = pool.allocate(1000);
+	}
+	checks.check(pool.getHits() == 2 && pool.getMisses() == 1, "%lu hits and %lu misses",
+		pool.getHits(), pool.getMisses());
+	for (int i = 0; i < 3; i++)
+	{
+		pool.release(buffers[i], 1000);
+	}
+
+	pool.setMaxFreeBytes(1024);
+	checks.check(pool.getMaxFreeBytes() == 1024 && pool.getFreeBytes() == 1024,
+		"the free lists weren't trimmed to the new limit");
+	pool.clear();
+	checks.check(pool.getFreeBytes() == 0, "clear kept buffers");
+}
+
+/**
+ * @brief Images draw their buffers from the pool, their clones as well, and
+ * give them back on destruction, also in another thread.
+ */
+static void testImages(tt::test::Checks& checks)
+{
+	FramePool pool;
+	Image* image = new Image(320, 240, Image::RGB, Image::BPC8, &pool);
+	Image* clone = image->clone();
+	checks.check(image->getFramePool() == &pool && clone->getFramePool() == &pool &&
+		pool.getMisses() == 2, "the images didn't draw their buffers from the pool");
+	delete clone;
+	delete image;
+	checks.check(pool.getFreeBytes() > 0, "the images didn't give their buffers back");
+
+	pool.resetCounters();
+	std::vector<Image*> images;
+	for (int i = 0; i < 2; i++)
+	{
+		images.push_back(new Image(320, 240, Image::RGB, Image::BPC8, &pool));
+	}
+	checks.check(pool.getHits() == 2 && pool.getMisses() == 0 && pool.getFreeBytes() == 0,
+		"the new images didn't reuse the buffers");
+
+	// a consumer thread releases the frames of the capture thread
+	std::thread consumer([&images]()
+	{
+		for (size_t i = 0; i < images.size(); i++)
+		{
+			delete images[i];
+		}
+	});
+	consumer.join();
+	Image reused(320, 240, Image::RGB, Image::BPC8, &pool);
+	checks.check(pool.getHits() == 3 && pool.getMisses() == 0,
+		"the buffers released by the other thread weren't reused");
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testClasses(checks);
+	testHits(checks);
+	testLimit(checks);
+	testImages(checks);
+	return checks.report("TestFramePool");
+}
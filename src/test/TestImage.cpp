@@ -0,0 +1,312 @@
+/*
+ * TestImage
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks, that detach() and discard() leave the pixels of shares alone,
+ * that they keep the IplImage header, that discard() takes a new buffer
+ * from the FramePool of a shared image and that both keep a buffer, which
+ * isn't shared. Checks, that setLineAlignment() keeps the header, too,
+ * that shares of wrapped buffers are copies and that views keep the buffer
+ * and copy it only when writing to a shared one. Checks, that writing
+ * through the non-const getImageBuffer() detaches and drops the cached
+ * pyramid and integral image, and that the FrameInfo travels with copies,
+ * clones, shares, views and moves.
+ */
+
+#include <string.h>
+#include <tt/ds/FramePool.h>
+#include <tt/ds/Image.h>
+#include <tt/ds/IntegralImage.h>
+#include <tt/process/Integral.h>
+#include <tt/process/Pyramid.h>
+#include "TestUtils.h"
+
+using tt::ds::FramePool;
+using tt::ds::Image;
+using tt::ds::IntegralImage;
+using tt::process::Integral;
+using tt::process::Pyramid;
+using tt::test::getBuffer;
+
+
+/**
+ * @brief detach() copies a shared buffer, discard() only replaces it.
+ */
+static void testShared(tt::test::Checks& checks)
+{
+	unsigned int seed = 3;
+	FramePool pool;
+	for (int variant = 0; variant < 2; variant++)
+	{
+		Image image(37, 21, Image::RGB, Image::BPC8, &pool);
+		tt::test::randomize(image, seed);
+		Image copy(image);
+		// OpenCV code may hold the header of a frame across the detach
+		IplImage* header = image.getIplImage();
+		Image share = image.share();
+		const unsigned char* buffer = getBuffer(image);
+
+		if (variant == 0)
+		{
+			image.detach();
+			checks.check(tt::test::equal(image, copy), "detach lost the pixels");
+		}
+		else
+		{
+			image.discard();
+		}
+		checks.check(getBuffer(image) != buffer, "variant %d kept the shared buffer",
+			variant);
+		checks.check(getBuffer(share) == buffer, "variant %d moved the share", variant);
+		checks.check(!image.isShared() && !share.isShared(), "variant %d still shared",
+			variant);
+		checks.check(image.getFramePool() == &pool, "variant %d lost the pool", variant);
+		checks.check(image.getIplImage() == header &&
+			(unsigned char*) header->imageData == getBuffer(image) &&
+			header->widthStep == image.getAllocatedWidth(),
+			"variant %d replaced the IplImage header", variant);
+		checks.check(image.getWidth() == 37 && image.getHeight() == 21 &&
+			image.getAllocatedWidth() == copy.getAllocatedWidth() &&
+			image.getChannels() == Image::RGB, "variant %d changed the format", variant);
+
+		tt::test::randomize(image, seed);
+		checks.check(tt::test::equal(share, copy), "variant %d wrote to the share", variant);
+	}
+}
+
+/**
+ * @brief Neither detach() nor discard() replace a buffer, which isn't shared.
+ */
+static void testUnshared(tt::test::Checks& checks)
+{
+	unsigned int seed = 5;
+	Image image(16, 16, Image::GREYSCALE);
+	tt::test::randomize(image, seed);
+	Image copy(image);
+	const unsigned char* buffer = getBuffer(image);
+
+	image.discard();
+	checks.check(getBuffer(image) == buffer, "discard replaced an own buffer");
+	checks.check(tt::test::equal(image, copy), "discard changed an own buffer");
+
+	// the last holder of a shared buffer takes it back
+	{
+		Image share = image.share();
+	}
+	image.discard();
+	checks.check(getBuffer(image) == buffer, "discard replaced the last share");
+	checks.check(tt::test::equal(image, copy), "discard changed the last share");
+}
+
+/**
+ * @brief setLineAlignment() re-lays the pixels behind the same IplImage header.
+ */
+static void testLineAlignment(tt::test::Checks& checks)
+{
+	unsigned int seed = 7;
+	Image image(37, 21, Image::RGB);
+	tt::test::randomize(image, seed);
+	Image copy(image);
+	IplImage* header = image.getIplImage();
+	Image share = image.share();
+	const unsigned char* buffer = getBuffer(image);
+
+	image.setLineAlignment(Image::A64);
+	checks.check(image.getAllocatedWidth() == 128, "A64 stride %d",
+		image.getAllocatedWidth());
+	checks.check(tt::test::equal(image, copy), "setLineAlignment lost the pixels");
+	checks.check(image.getIplImage() == header &&
+		(unsigned char*) header->imageData == getBuffer(image) &&
+		header->widthStep == 128, "setLineAlignment replaced the IplImage header");
+	checks.check(getBuffer(share) == buffer && tt::test::equal(share, copy) &&
+		!share.isShared(), "setLineAlignment changed the share");
+
+	// the stride of 8 bytes is aligned to A8 already
+	Image grey(8, 4, Image::GREYSCALE);
+	const unsigned char* greyBuffer = getBuffer(grey);
+	grey.setLineAlignment(Image::A8);
+	checks.check(getBuffer(grey) == greyBuffer &&
+		grey.getLineAlignment() == Image::A8, "setLineAlignment copied aligned lines");
+}
+
+/**
+ * @brief A share of a wrapped buffer is a copy, an adopted buffer is shared.
+ */
+static void testWrapped(tt::test::Checks& checks)
+{
+	unsigned char pixels[8 * 4];
+	memset(pixels, 7, sizeof(pixels));
+	Image wrapped(pixels, 8, 4, 8, Image::GREYSCALE, Image::BPC8);
+	Image copy = wrapped.share();
+	memset(pixels, 9, sizeof(pixels));
+	checks.check(getBuffer(copy) != pixels && copy(7, 3, 0) == 7 && !wrapped.isShared(),
+		"the share of a wrapped buffer isn't a copy");
+
+	unsigned char* buffer = new unsigned char[8 * 4];
+	Image adopted(buffer, 8, 4, 8, Image::GREYSCALE, Image::BPC8,
+		[](unsigned char* pixels) { delete[] pixels; });
+	Image share = adopted.share();
+	checks.check(getBuffer(share) == buffer && adopted.isShared(),
+		"the adopted buffer wasn't shared");
+}
+
+/**
+ * @brief A view writes to its image without copying and keeps the buffer.
+ */
+static void testView(tt::test::Checks& checks)
+{
+	unsigned int seed = 11;
+	FramePool pool;
+	Image* image = new Image(37, 21, Image::RGB, Image::BPC8, &pool);
+	tt::test::randomize(*image, seed);
+	Image view = image->view(5, 3, 20, 10);
+	const unsigned char* region = getBuffer(*image) + 3 * image->getAllocatedWidth() + 15;
+	checks.check(getBuffer(view) == region && !image->isShared() && !view.isShared(),
+		"the view copied the image");
+
+	// writes go both ways
+	view(0, 0, 0) = 200;
+	(*image)(6, 3, 1) = 201;
+	checks.check((*image)(5, 3, 0) == 200 && view(1, 0, 1) == 201 &&
+		getBuffer(view) == region, "the view and the image don't write to each other");
+
+	// the view keeps the buffer after its image is gone
+	Image expected(view);
+	delete image;
+	Image reuse(37, 21, Image::RGB, Image::BPC8, &pool);
+	tt::test::randomize(reuse, seed);
+	checks.check(getBuffer(view) == region && tt::test::equal(view, expected) &&
+		pool.getFreeBytes() == 0, "the view lost the buffer of its image");
+}
+
+/**
+ * @brief A view of a shared frame doesn't copy, until it is written to.
+ */
+static void testSharedView(tt::test::Checks& checks)
+{
+	unsigned int seed = 13;
+	Image frame(37, 21, Image::RGB);
+	tt::test::randomize(frame, seed);
+	Image copy(frame);
+	Image share = frame.share();
+	const unsigned char* buffer = getBuffer(frame);
+
+	Image crop = share.view(5, 3, 20, 10);
+	Image cropCopy(crop);
+	checks.check(getBuffer(share) == buffer && frame.isShared() && crop.isShared() &&
+		getBuffer(crop) == buffer + 3 * frame.getAllocatedWidth() + 15,
+		"cropping a shared frame copied it");
+
+	// writing to the crop copies it, since the frame and the share use the buffer
+	crop(0, 0, 0) ^= 0xff;
+	checks.check(getBuffer(crop) != buffer + 3 * frame.getAllocatedWidth() + 15 &&
+		tt::test::equal(share, copy) && tt::test::equal(frame, copy) &&
+		crop(0, 0, 0) == (cropCopy(0, 0, 0) ^ 0xff) && crop(1, 0, 0) == cropCopy(1, 0, 0),
+		"writing to the crop changed the frame");
+
+	// the device overwrites its frame, a crop keeps the pixels
+	crop = share.view(5, 3, 20, 10);
+	frame.discard();
+	tt::test::randomize(frame, seed);
+	checks.check(getBuffer(frame) != buffer && tt::test::equal(crop, cropCopy),
+		"the crop sees the next frame");
+
+	// the share is the only image using the buffer now, so the crop writes to it
+	crop(0, 0, 0) ^= 0xff;
+	checks.check(getBuffer(share) == buffer && !share.isShared() &&
+		share(5, 3, 0) == (copy(5, 3, 0) ^ 0xff), "the crop didn't write to the share");
+
+	// shares of a view are views of the same region
+	Image view = share.view(1, 1, 4, 4);
+	Image viewShare = view.share();
+	checks.check(getBuffer(viewShare) == getBuffer(view) &&
+		viewShare.getWidth() == 4, "the share of a view isn't a view");
+}
+
+/**
+ * @brief Writing through the non-const getImageBuffer() drops the caches of
+ * the pixels and leaves a share alone.
+ */
+static void testCaches(tt::test::Checks& checks)
+{
+	unsigned int seed = 17;
+	Image frame(32, 16, Image::GREYSCALE);
+	tt::test::randomize(frame, seed);
+	Image level = Pyramid::getLevel(frame, 1);
+	std::shared_ptr<const IntegralImage> table = Integral::get(frame);
+	Image copy(level);
+	unsigned int sum = table->getSum(0, 0, 1, 1);
+
+	// reading through a const image doesn't detach
+	Image share = frame.share();
+	const Image& reader = frame;
+	checks.check(reader.getImageBuffer() == getBuffer(share) && frame.isShared() &&
+		getBuffer(Pyramid::getLevel(share, 1)) == getBuffer(level),
+		"reading the buffer dropped the caches");
+
+	// the share keeps the pixels and the caches
+	frame.getImageBuffer()[0] ^= 0xff;
+	checks.check(getBuffer(frame) != getBuffer(share) && !share.isShared() &&
+		getBuffer(Pyramid::getLevel(share, 1)) == getBuffer(level) &&
+		Integral::get(share) == table, "writing to the frame changed the share");
+
+	// the frame computes the caches of its new pixels
+	Image changed = Pyramid::getLevel(frame, 1);
+	std::shared_ptr<const IntegralImage> changedTable = Integral::get(frame);
+	checks.check(getBuffer(changed) != getBuffer(level) && !tt::test::equal(changed, copy),
+		"the pyramid of the frame is stale");
+	checks.check(changedTable != table && changedTable->getSum(0, 0, 1, 1) == (sum ^ 0xff),
+		"the integral image of the frame is stale");
+
+	// an image, which isn't shared, drops its caches, too
+	frame.getImageBuffer()[0] ^= 0xff;
+	checks.check(tt::test::equal(Pyramid::getLevel(frame, 1), copy) &&
+		Integral::get(frame)->getSum(0, 0, 1, 1) == sum, "the caches of the frame are stale");
+}
+
+/**
+ * @brief Copies, clones, shares, views and moves keep the FrameInfo.
+ */
+static void testFrameInfo(tt::test::Checks& checks)
+{
+	tt::ds::FrameInfo info;
+	info.timestamp = std::chrono::steady_clock::now();
+	info.sequence = 42;
+	info.droppedFrames = 3;
+	info.bufferIndex = 7;
+	Image frame(16, 8, Image::GREYSCALE);
+	frame.setFrameInfo(info);
+
+	Image copy(frame);
+	Image* clone = frame.clone();
+	Image share = frame.share();
+	Image view = frame.view(2, 2, 4, 4);
+	Image assigned(4, 4, Image::RGB);
+	assigned = frame;
+	const Image* images[5] = {&copy, clone, &share, &view, &assigned};
+	for (int i = 0; i < 5; i++)
+	{
+		const tt::ds::FrameInfo& kept = images[i]->getFrameInfo();
+		checks.check(kept.timestamp == info.timestamp && kept.sequence == 42 &&
+			kept.droppedFrames == 3 && kept.bufferIndex == 7, "image %d lost the frame info", i);
+	}
+	delete clone;
+
+	Image moved(std::move(frame));
+	checks.check(moved.getFrameInfo().sequence == 42 && frame.getFrameInfo().sequence == 0 &&
+		frame.getFrameInfo().bufferIndex == -1, "the move didn't take the frame info");
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testShared(checks);
+	testUnshared(checks);
+	testLineAlignment(checks);
+	testWrapped(checks);
+	testView(checks);
+	testSharedView(checks);
+	testCaches(checks);
+	testFrameInfo(checks);
+	return checks.report("TestImage");
+}
@@ -0,0 +1,184 @@
+/*
+ * TestIntegral
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks Integral::compute of all kernels, serial and in bands, against
+ * the sums computed pixel by pixel on random images with lines aligned to 4
+ * and to 64 bytes and on views, with and without the sums of squares.
+ * Checks, that get computes the table once for all shares of a frame.
+ */
+
+#include <stdexcept>
+#include <tt/ds/Image.h>
+#include <tt/ds/IntegralImage.h>
+#include <tt/process/Integral.h>
+#include <tt/sys/WorkerPool.h>
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::ds::IntegralImage;
+using tt::process::Integral;
+
+/**
+ * @brief Return true, if a table has the sums of the pixels above and left
+ * of each entry, and the sums of their squares, if it has them.
+ */
+static bool equalSums(const Image& image, const IntegralImage& table)
+{
+	for (int y = 0; y <= image.getHeight(); y++)
+	{
+		unsigned int sum = 0;
+		unsigned long long squares = 0;
+		const unsigned int* above = y > 0 ? table.getSums(y - 1) : NULL;
+		const unsigned long long* squaresAbove = y > 0 && table.hasSquares() ?
+			table.getSquares(y - 1) : NULL;
+		for (int x = 0; x <= image.getWidth(); x++)
+		{
+			if (x > 0 && y > 0)
+			{
+				unsigned int value = image(x - 1, y - 1, 0);
+				sum += value;
+				squares += value * value;
+			}
+			unsigned int expected = sum + (above != NULL ? above[x] : 0);
+			if (table.getSums(y)[x] != expected)
+			{
+				return false;
+			}
+			if (table.hasSquares() && table.getSquares(y)[x] !=
+				squares + (squaresAbove != NULL ? squaresAbove[x] : 0))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Compute the tables of random images, black and white images with all kernels.
+ */
+static void testKernels(tt::test::Checks& checks)
+{
+	static const Integral::Kernel kernels[] = {Integral::KERNEL_SCALAR, Integral::KERNEL_SSE2};
+	static const Image::LineAlignment alignments[] = {Image::A4, Image::A64};
+	tt::sys::WorkerPool pool(3);
+	unsigned int seed = 29;
+
+	for (int i = 0; i < 150; i++)
+	{
+		// the largest images have enough lines for 3 bands
+		int width = 1 + (i*13) % 90;
+		int height = 1 + (i*7) % 110;
+		bool squares = i % 2 == 1;
+		Image::setDefaultLineAlignment(alignments[(i / 2) % 2]);
+
+		Image source(width, height, Image::GREYSCALE);
+		tt::test::randomize(source, seed);
+		if (i < 4)
+		{
+			for (int y = 0; y < height; y++)
+			{
+				for (int x = 0; x < width; x++)
+				{
+					source(x, y, 0) = i < 2 ? 0 : 255;
+				}
+			}
+		}
+
+		for (int k = 0; k < 2; k++)
+		{
+			if (!Integral::isKernelSupported(kernels[k]))
+			{
+				continue;
+			}
+			Integral::setKernel(kernels[k]);
+
+			IntegralImage serial(width, height, squares);
+			Integral::compute(&source, &serial);
+			checks.check(equalSums(source, serial), "%dx%d squares %d A%d kernel %d",
+				width, height, squares, alignments[(i / 2) % 2], kernels[k]);
+
+			IntegralImage banded(width, height, squares);
+			Integral::compute(&source, &banded, pool);
+			checks.check(equalSums(source, banded), "bands %dx%d squares %d A%d kernel %d",
+				width, height, squares, alignments[(i / 2) % 2], kernels[k]);
+		}
+	}
+	Integral::setKernel(Integral::KERNEL_AUTO);
+	Image::setDefaultLineAlignment(Image::A4);
+
+	// a view has the line stride of its image
+	Image image(100, 80, Image::GREYSCALE);
+	tt::test::randomize(image, seed);
+	Image view = image.view(3, 5, 41, 33);
+	IntegralImage table(41, 33, true);
+	Integral::compute(&view, &table);
+	checks.check(equalSums(view, table), "view has other sums");
+}
+
+/**
+ * @brief Images and tables, which don't match, must be rejected.
+ */
+static void testFormats(tt::test::Checks& checks)
+{
+	Image rgb(8, 8, Image::RGB);
+	Image grey16(8, 8, Image::GREYSCALE, Image::BPC16);
+	Image grey(8, 8, Image::GREYSCALE);
+	IntegralImage table(8, 8);
+	IntegralImage small(8, 4);
+	Image* sources[] = {&rgb, &grey16, &grey};
+	IntegralImage* tables[] = {&table, &table, &small};
+
+	for (int c = 0; c < 3; c++)
+	{
+		bool thrown = false;
+		try
+		{
+			Integral::compute(sources[c], tables[c]);
+		}
+		catch (std::runtime_error&)
+		{
+			thrown = true;
+		}
+		checks.check(thrown, "case %d not rejected", c);
+	}
+}
+
+/**
+ * @brief get computes the table once and shares it with all shares of the frame.
+ */
+static void testCache(tt::test::Checks& checks)
+{
+	unsigned int seed = 31;
+	Image frame(64, 48, Image::GREYSCALE);
+	tt::test::randomize(frame, seed);
+
+	std::shared_ptr<const IntegralImage> table = Integral::get(frame);
+	checks.check(equalSums(frame, *table) && !table->hasSquares(), "the table has other sums");
+	Image share = frame.share();
+	checks.check(Integral::get(share) == table, "the share computed the table again");
+
+	// the squares are computed, when they are needed
+	std::shared_ptr<const IntegralImage> squares = Integral::get(share, true);
+	checks.check(squares->hasSquares() && equalSums(frame, *squares) &&
+		Integral::get(frame) == squares, "the table has no squares");
+
+	// on the pool of get
+	tt::sys::WorkerPool pool(2);
+	Integral::setWorkerPool(&pool);
+	Image other(64, 100, Image::GREYSCALE);
+	tt::test::randomize(other, seed);
+	checks.check(equalSums(other, *Integral::get(other, true)),
+		"the table of the pool has other sums");
+	Integral::setWorkerPool(NULL);
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testKernels(checks);
+	testFormats(checks);
+	testCache(checks);
+	return checks.report("TestIntegral");
+}
@@ -0,0 +1,181 @@
+/*
+ * TestLentFrame
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks the lifetime of frames lent from a DMA ring: a released buffer
+ * goes back to the ring at once, a second frame isn't lent before the first
+ * one is back, and stopping or destroying the device takes a lent frame
+ * back, so the application's handle doesn't dangle. Checks the same for
+ * SimulatedFirewireCamera.
+ */
+
+#include <stdexcept>
+#include <tt/ds/Image.h>
+#include <tt/input/LentFrame.h>
+#include <tt/input/SimulatedDMARing.h>
+#include <tt/input/SimulatedFirewireCamera.h>
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::input::FirewireCamera;
+using tt::input::LentFrame;
+using tt::input::SimulatedDMARing;
+using tt::input::SimulatedFirewireCamera;
+
+/**
+ * @brief Return true, if all bytes of a buffer have the value.
+ */
+static bool filled(const unsigned char* buffer, int bytes, unsigned char value)
+{
+	for (int i = 0; i < bytes; i++)
+	{
+		if (buffer[i] != value)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Lend and release frames of a SimulatedDMARing.
+ */
+static void testRing(tt::test::Checks& checks)
+{
+	SimulatedDMARing ring(6, 4, Image::RGB, 3);
+	const int frameBytes = 6 * 4 * 3;
+	{
+		LentFrame frame;
+		checks.check(!frame.isLent() && frame.getImage() == NULL, "new frame is lent");
+
+		ring.lendImage(frame);
+		Image* image = frame.getImage();
+		checks.check(frame.isLent() && image != NULL, "lendImage didn't lend");
+		checks.check(image->getImageBuffer() == ring.getBuffer(0) &&
+			image->getWidth() == 6 && image->getAllocatedWidth() == 18,
+			"the lent image doesn't wrap the ring");
+		checks.check(filled(image->getImageBuffer(), frameBytes, 1), "frame 1 has other pixels");
+
+		// only one frame is lent at a time
+		LentFrame second;
+		bool rejected = false;
+		try
+		{
+			ring.lendImage(second);
+		}
+		catch (std::runtime_error&)
+		{
+			rejected = true;
+		}
+		checks.check(rejected && !second.isLent(), "a second frame was lent");
+
+		frame.release();
+		checks.check(!frame.isLent() && frame.getImage() == NULL, "release kept the frame");
+		checks.check(ring.getReturnedFrames() == 1 && !ring.isFrameLent(),
+			"release didn't return the buffer");
+		checks.check(filled(ring.getBuffer(0), frameBytes, SimulatedDMARing::RETURNED_BYTE),
+			"the returned buffer wasn't refilled");
+		frame.release();
+		checks.check(ring.getReturnedFrames() == 1, "a second release returned again");
+
+		ring.lendImage(second);
+		checks.check(second.getImage()->getImageBuffer() == ring.getBuffer(1) &&
+			filled(ring.getBuffer(1), frameBytes, 2), "frame 2 isn't in the next buffer");
+	}
+	checks.check(ring.getReturnedFrames() == 2 && !ring.isFrameLent(),
+		"~LentFrame didn't return the buffer");
+
+	// stop() takes the frame back and doesn't lend any more
+	LentFrame frame;
+	ring.lendImage(frame);
+	ring.stop();
+	checks.check(!frame.isLent() && frame.getImage() == NULL, "stop didn't reclaim the frame");
+	checks.check(ring.getReturnedFrames() == 3, "stop didn't return the buffer");
+	bool rejected = false;
+	try
+	{
+		ring.lendImage(frame);
+	}
+	catch (std::runtime_error&)
+	{
+		rejected = true;
+	}
+	checks.check(rejected && !frame.isLent(), "a stopped ring lent a frame");
+
+	// a ring destroyed before the frame takes it back
+	{
+		SimulatedDMARing shortRing(4, 4);
+		shortRing.lendImage(frame);
+		checks.check(frame.isLent(), "the second ring didn't lend");
+	}
+	checks.check(!frame.isLent() && frame.getImage() == NULL,
+		"the destroyed ring didn't reclaim the frame");
+}
+
+/**
+ * @brief Lend frames of SimulatedFirewireCamera, which come from its simulated ring.
+ */
+static void testCamera(tt::test::Checks& checks)
+{
+	SimulatedFirewireCamera* camera = new SimulatedFirewireCamera();
+	camera->open();
+	camera->setVideoFormat(FirewireCamera::FORMAT0);
+	camera->setVideoMode(FirewireCamera::MODE_640x480_MONO8);
+	camera->setVideoFramerate(FirewireCamera::FRAMERATE_240);
+	camera->captureStart();
+
+	Image expected(640, 480, Image::GREYSCALE);
+	LentFrame frame;
+	for (unsigned long n = 0; n < 3; n++)
+	{
+		camera->lendImage(frame);
+		Image* image = frame.getImage();
+		SimulatedFirewireCamera::fillFrame(expected.getImageBuffer(),
+			expected.getAllocatedWidth(), 480, camera->getFrameNumber(), 0);
+		checks.check(image != NULL && image->getChannels() == Image::GREYSCALE &&
+			tt::test::equal(*image, expected), "lent frame %lu has other pixels", n);
+
+		// neither a second frame nor a copy while the frame is lent
+		LentFrame second;
+		bool rejected = false;
+		try
+		{
+			camera->lendImage(second);
+		}
+		catch (std::runtime_error&)
+		{
+			rejected = true;
+		}
+		checks.check(rejected && !second.isLent(), "a second frame was lent");
+		rejected = false;
+		try
+		{
+			camera->getImage();
+		}
+		catch (std::runtime_error&)
+		{
+			rejected = true;
+		}
+		checks.check(rejected, "getImage copied a frame while one is lent");
+		frame.release();
+	}
+
+	camera->lendImage(frame);
+	camera->captureStop();
+	checks.check(!frame.isLent() && frame.getImage() == NULL,
+		"captureStop didn't reclaim the frame");
+
+	camera->captureStart();
+	camera->lendImage(frame);
+	delete camera;
+	checks.check(!frame.isLent() && frame.getImage() == NULL,
+		"the destroyed camera didn't reclaim the frame");
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testRing(checks);
+	testCamera(checks);
+	return checks.report("TestLentFrame");
+}
@@ -0,0 +1,273 @@
+/*
+ * TestMoviePlayer
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks the MoviePlayer on a video decoded by the stub capture below, which
+ * replaces the file capture of OpenCV: shares of a frame keep its pixels,
+ * while the capture decodes the next frames into its buffer, and opening
+ * another video releases the frame, which wraps the buffer of the previous
+ * capture. Checks, that the read ahead decoder delivers the same frames in
+ * order until isFinished, also after restarts and below the capture thread.
+ */
+
+#include <string.h>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tt/ds/Image.h>
+#include <tt/input/MoviePlayer.h>
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::input::MoviePlayer;
+
+/**
+ * @brief A video of FRAMES frames of 64x48 BGR pixels, all pixels of frame n
+ * have the value n, or an EMPTY video. Decodes every frame into the same
+ * image, like the captures of OpenCV.
+ */
+struct CvCapture
+{
+	int frames;
+	int position;
+	IplImage* frame;
+};
+
+static const int FRAMES = 20;
+static const std::string VIDEO = "stub.avi";
+static const std::string EMPTY = "empty.avi";
+
+CvCapture* cvCreateFileCapture(const char* filename)
+{
+	if (VIDEO != filename && EMPTY != filename)
+	{
+		return NULL;
+	}
+	CvCapture* capture = new CvCapture();
+	capture->frames = VIDEO == filename ? FRAMES : 0;
+	capture->position = 0;
+	capture->frame = cvCreateImage(cvSize(64, 48), IPL_DEPTH_8U, 3);
+	return capture;
+}
+
+void cvReleaseCapture(CvCapture** capture)
+{
+	cvReleaseImage(&(*capture)->frame);
+	delete *capture;
+	*capture = NULL;
+}
+
+int cvGrabFrame(CvCapture* capture)
+{
+	if (capture->position >= capture->frames)
+	{
+		return 0;
+	}
+	memset(capture->frame->imageData, capture->position, capture->frame->imageSize);
+	capture->position++;
+	return 1;
+}
+
+IplImage* cvRetrieveFrame(CvCapture* capture, int)
+{
+	return capture->position > 0 && capture->position <= capture->frames ? capture->frame : NULL;
+}
+
+double cvGetCaptureProperty(CvCapture* capture, int property)
+{
+	return property == CV_CAP_PROP_FPS ? 25.0 : capture->frames;
+}
+
+int cvSetCaptureProperty(CvCapture* capture, int, double)
+{
+	capture->position = 0;
+	return 1;
+}
+
+/**
+ * @brief A share of a frame copies it, since the capture decodes the next
+ * frame into the buffer, which the frame wraps.
+ */
+static void testShares(tt::test::Checks& checks)
+{
+	MoviePlayer player;
+	player.open(VIDEO);
+	Image* frame = player.getImage();
+	Image share = frame->share();
+	checks.check((*frame)(0, 0, 0) == 0 && share(0, 0, 0) == 0, "frame 0 has other pixels");
+
+	player.captureNext();
+	player.captureNext();
+	checks.check((*player.getImage())(0, 0, 0) == 2, "frame 2 has other pixels");
+	checks.check(share(0, 0, 0) == 0 && share(63, 47, 2) == 0,
+		"the share sees the pixels of frame 2");
+}
+
+/**
+ * @brief Opening another video drops the frame of the previous one, also
+ * when the other video can't be opened.
+ */
+static void testReopen(tt::test::Checks& checks)
+{
+	MoviePlayer player;
+	player.open(VIDEO);
+	player.captureNext();
+	Image share = player.getImage()->share();
+
+	player.open(VIDEO);
+	checks.check((*player.getImage())(0, 0, 0) == 0 && share(0, 0, 0) == 1,
+		"the video didn't start again");
+
+	bool rejected = false;
+	try
+	{
+		player.open("missing.avi");
+	}
+	catch (std::runtime_error&)
+	{
+		rejected = true;
+	}
+	checks.check(rejected, "a missing video was opened");
+	rejected = false;
+	try
+	{
+		player.getImage();
+	}
+	catch (std::runtime_error&)
+	{
+		rejected = true;
+	}
+	checks.check(rejected, "the frame of the released capture is still delivered");
+	checks.check(share(0, 0, 0) == 1, "the share lost its pixels");
+}
+
+/**
+ * @brief Return true, if a player delivers all frames of the video in order
+ * and is finished after the last one.
+ */
+static bool playsInOrder(MoviePlayer& player)
+{
+	int count = 0;
+	while (!player.isFinished())
+	{
+		const Image* image = player.getImage();
+		if ((*image)(5, 5, 0) != count || (*image)(63, 47, 2) != count ||
+			image->getFrameInfo().sequence != (unsigned long) count)
+		{
+			return false;
+		}
+		count++;
+		// the decoder runs ahead, while the frame is processed
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		player.captureNext();
+	}
+	return count == FRAMES;
+}
+
+/**
+ * @brief The decoder delivers the frames of the synchronous player, with any
+ * number of frames read ahead, and an empty video is finished right away.
+ */
+static void testReadAhead(tt::test::Checks& checks)
+{
+	static const int frames[] = {0, 1, 4, FRAMES + 5};
+	for (int i = 0; i < 4; i++)
+	{
+		MoviePlayer player;
+		player.setReadAhead(frames[i]);
+		player.open(VIDEO);
+		checks.check(player.getReadAhead() == frames[i] && playsInOrder(player),
+			"read ahead %d delivered other frames", frames[i]);
+	}
+
+	MoviePlayer empty;
+	empty.setReadAhead(2);
+	empty.open(EMPTY);
+	checks.check(empty.isFinished(), "the empty video isn't finished");
+
+	bool rejected = false;
+	try
+	{
+		empty.setReadAhead(-1);
+	}
+	catch (std::runtime_error&)
+	{
+		rejected = true;
+	}
+	checks.check(rejected && empty.getReadAhead() == 2, "read ahead -1 was set");
+}
+
+/**
+ * @brief captureStart starts the video again with the decoder running,
+ * stopped or switched off, and shares keep their pixels meanwhile.
+ */
+static void testRestart(tt::test::Checks& checks)
+{
+	MoviePlayer player;
+	player.setReadAhead(3);
+	player.open(VIDEO);
+	for (int n = 0; n < 10; n++)
+	{
+		player.captureNext();
+	}
+	Image share = player.getImage()->share();
+	for (int n = 0; n < 5; n++)
+	{
+		player.captureNext();
+	}
+	checks.check(share(0, 0, 0) == 10 && (*player.getImage())(0, 0, 0) == 15,
+		"the share sees the pixels of the decoder");
+
+	player.captureStart();
+	checks.check((*player.getImage())(0, 0, 0) == 0 &&
+		player.getImage()->getFrameInfo().sequence == 0, "the video didn't start again");
+	player.captureNext();
+	checks.check((*player.getImage())(0, 0, 0) == 1, "the restarted video skipped frames");
+
+	player.captureStop();
+	player.setReadAhead(0);
+	player.captureStart();
+	checks.check((*player.getImage())(0, 0, 0) == 0, "the video didn't start without decoder");
+	player.setReadAhead(2);
+	player.captureStart();
+	checks.check(playsInOrder(player), "the decoder didn't start again");
+}
+
+/**
+ * @brief The capture thread takes all frames of the decoder until the end.
+ */
+static void testAsync(tt::test::Checks& checks)
+{
+	MoviePlayer player;
+	player.setReadAhead(4);
+	player.setDeliveryPolicy(MoviePlayer::BLOCKING_LOSSLESS);
+	player.open(VIDEO);
+	player.startAsyncCapture(2);
+
+	// the first frame is delivered by open, the thread captures the next ones
+	int frames = 0;
+	bool ordered = true;
+	while (Image* image = player.waitImage(1000))
+	{
+		if ((*image)(0, 0, 0) != frames + 1)
+		{
+			ordered = false;
+		}
+		frames++;
+		player.releaseImage(image);
+	}
+	checks.check(ordered && frames == FRAMES - 1 && player.isFinished(),
+		"the capture thread got %d frames", frames);
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testShares(checks);
+	testReopen(checks);
+	testReadAhead(checks);
+	testRestart(checks);
+	testAsync(checks);
+	return checks.report("TestMoviePlayer");
+}
@@ -0,0 +1,204 @@
+/*
+ * TestPyramid
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks Pyramid::reduce of all kernels, serial and in bands, against the
+ * 5x5 binomial filter computed pixel by pixel on random images of all
+ * channels, with lines aligned to 4 and to 64 bytes and on views. Checks,
+ * that getLevel computes each level once for all shares of a frame.
+ */
+
+#include <stdexcept>
+#include <tt/ds/Image.h>
+#include <tt/ds/PyramidCache.h>
+#include <tt/process/Pyramid.h>
+#include <tt/sys/WorkerPool.h>
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::process::Pyramid;
+using tt::test::getBuffer;
+
+/**
+ * @brief Halve an image with the weights 1 4 6 4 1, repeating the edge pixels.
+ */
+static void referenceReduce(const Image& source, Image& destination)
+{
+	static const int weights[5] = {1, 4, 6, 4, 1};
+	for (int y = 0; y < destination.getHeight(); y++)
+	{
+		for (int x = 0; x < destination.getWidth(); x++)
+		{
+			for (int c = 0; c < source.getChannels(); c++)
+			{
+				int sum = 0;
+				for (int j = 0; j < 5; j++)
+				{
+					int row = 2*y - 2 + j;
+					row = row < 0 ? 0 : (row >= source.getHeight() ? source.getHeight() - 1 : row);
+					for (int i = 0; i < 5; i++)
+					{
+						int column = 2*x - 2 + i;
+						column = column < 0 ? 0 :
+							(column >= source.getWidth() ? source.getWidth() - 1 : column);
+						sum += weights[j] * weights[i] * source(column, row, c);
+					}
+				}
+				destination(x, y, c) = (unsigned char) ((sum + 128) >> 8);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Reduce random images, black and white images with all kernels.
+ */
+static void testKernels(tt::test::Checks& checks)
+{
+	static const Pyramid::Kernel kernels[] = {Pyramid::KERNEL_SCALAR, Pyramid::KERNEL_SSE2};
+	static const Image::LineAlignment alignments[] = {Image::A4, Image::A64};
+	static const Image::Channels channels[] = {Image::GREYSCALE, Image::RGB, Image::RGBA};
+	tt::sys::WorkerPool pool(3);
+	unsigned int seed = 19;
+
+	for (int i = 0; i < 150; i++)
+	{
+		// the largest images have enough lines for 3 bands
+		int width = 1 + (i*13) % 90;
+		int height = 1 + (i*7) % 110;
+		Image::Channels channel = channels[i % 3];
+		Image::setDefaultLineAlignment(alignments[(i / 3) % 2]);
+
+		Image source(width, height, channel);
+		tt::test::randomize(source, seed);
+		if (i < 6)
+		{
+			for (int y = 0; y < height; y++)
+			{
+				for (int x = 0; x < width * channel; x++)
+				{
+					source(x / channel, y, x % channel) = i < 3 ? 0 : 255;
+				}
+			}
+		}
+		Image reference((width + 1) / 2, (height + 1) / 2, channel);
+		referenceReduce(source, reference);
+
+		for (int k = 0; k < 2; k++)
+		{
+			if (!Pyramid::isKernelSupported(kernels[k]))
+			{
+				continue;
+			}
+			Pyramid::setKernel(kernels[k]);
+
+			Image serial(reference.getWidth(), reference.getHeight(), channel);
+			Pyramid::reduce(&source, &serial);
+			checks.check(tt::test::equal(serial, reference), "%dx%d channels %d A%d kernel %d",
+				width, height, channel, alignments[(i / 3) % 2], kernels[k]);
+
+			Image banded(reference.getWidth(), reference.getHeight(), channel);
+			Pyramid::reduce(&source, &banded, pool);
+			checks.check(tt::test::equal(banded, reference),
+				"bands %dx%d channels %d A%d kernel %d", width, height, channel,
+				alignments[(i / 3) % 2], kernels[k]);
+		}
+	}
+	Pyramid::setKernel(Pyramid::KERNEL_AUTO);
+	Image::setDefaultLineAlignment(Image::A4);
+
+	// a view has the line stride of its image
+	Image image(100, 80, Image::RGB);
+	tt::test::randomize(image, seed);
+	Image view = image.view(3, 5, 41, 33);
+	Image reference(21, 17, Image::RGB);
+	referenceReduce(view, reference);
+	Image result(21, 17, Image::RGB);
+	Pyramid::reduce(&view, &result);
+	checks.check(tt::test::equal(result, reference), "view has other pixels");
+}
+
+/**
+ * @brief Images, which don't match, must be rejected.
+ */
+static void testFormats(tt::test::Checks& checks)
+{
+	Image source(16, 16, Image::RGB);
+	Image grey(8, 8, Image::GREYSCALE);
+	Image large(9, 8, Image::RGB);
+	Image rgb16(8, 8, Image::RGB, Image::BPC16);
+	Image* destinations[] = {&grey, &large, &rgb16};
+
+	for (int d = 0; d < 3; d++)
+	{
+		bool thrown = false;
+		try
+		{
+			Pyramid::reduce(&source, destinations[d]);
+		}
+		catch (std::runtime_error&)
+		{
+			thrown = true;
+		}
+		checks.check(thrown, "destination %d not rejected", d);
+	}
+}
+
+/**
+ * @brief getLevel computes each level once and shares it with all shares of the frame.
+ */
+static void testLevels(tt::test::Checks& checks)
+{
+	unsigned int seed = 23;
+	Image frame(64, 48, Image::GREYSCALE);
+	tt::test::randomize(frame, seed);
+
+	// level 2 computes level 1 on the way
+	Image level2 = Pyramid::getLevel(frame, 2);
+	checks.check(level2.getWidth() == 16 && level2.getHeight() == 12 &&
+		frame.getPyramidCache().getLevels() == 2, "level 2 has the wrong size");
+	Image level1 = Pyramid::getLevel(frame, 1);
+	Image reference1(32, 24, Image::GREYSCALE);
+	referenceReduce(frame, reference1);
+	Image reference2(16, 12, Image::GREYSCALE);
+	referenceReduce(reference1, reference2);
+	checks.check(tt::test::equal(level1, reference1) && tt::test::equal(level2, reference2),
+		"the levels have other pixels");
+
+	// shares of the frame get the cached levels
+	Image share = frame.share();
+	checks.check(getBuffer(Pyramid::getLevel(share, 1)) == getBuffer(level1) &&
+		getBuffer(Pyramid::getLevel(share, 0)) == getBuffer(frame),
+		"the share computed the levels again");
+
+	// on the pool of getLevel
+	tt::sys::WorkerPool pool(2);
+	Pyramid::setWorkerPool(&pool);
+	Image other(64, 48, Image::GREYSCALE);
+	tt::test::randomize(other, seed);
+	Image reference(32, 24, Image::GREYSCALE);
+	referenceReduce(other, reference);
+	checks.check(tt::test::equal(Pyramid::getLevel(other, 1), reference),
+		"the level of the pool has other pixels");
+	Pyramid::setWorkerPool(NULL);
+
+	bool thrown = false;
+	try
+	{
+		Pyramid::getLevel(frame, -1);
+	}
+	catch (std::runtime_error&)
+	{
+		thrown = true;
+	}
+	checks.check(thrown, "level -1 not rejected");
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testKernels(checks);
+	testFormats(checks);
+	testLevels(checks);
+	return checks.report("TestPyramid");
+}
@@ -0,0 +1,235 @@
+/*
+ * TestSimulatedCamera
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks the SimulatedFirewireCamera: the factory hands it out after
+ * setSimulatedCameras, its frames are the converted raw frames of
+ * fillFrame, a slow application loses the frames each delivery policy
+ * gives up and they are counted in the frame info and by the device, and
+ * the jitter is the same in every run.
+ */
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <tt/ds/Image.h>
+#include <tt/input/SimulatedFirewireCamera.h>
+#include <tt/process/Bayer.h>
+#include <tt/process/YUV.h>
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::input::FirewireCamera;
+using tt::input::ImageDevice;
+using tt::input::SimulatedFirewireCamera;
+using tt::process::Bayer;
+using tt::process::YUV;
+
+/**
+ * @brief Create an open simulated camera with the video mode and framerate.
+ */
+static SimulatedFirewireCamera* createCamera(FirewireCamera::Format format,
+	FirewireCamera::Mode mode, FirewireCamera::Framerate framerate)
+{
+	SimulatedFirewireCamera* camera = new SimulatedFirewireCamera();
+	camera->open();
+	camera->setVideoFormat(format);
+	camera->setVideoMode(mode);
+	camera->setVideoFramerate(framerate);
+	return camera;
+}
+
+/**
+ * @brief The factory creates simulated cameras, while they are selected.
+ */
+static void testFactory(tt::test::Checks& checks)
+{
+	SimulatedFirewireCamera::setSimulatedCameras(2);
+	checks.check(FirewireCamera::getNumberOfFirewireCameras() == 2, "%d cameras",
+		FirewireCamera::getNumberOfFirewireCameras());
+
+	FirewireCamera* camera = FirewireCamera::createFirewireCamera(1);
+	checks.check(dynamic_cast<SimulatedFirewireCamera*>(camera) != NULL,
+		"the factory created no simulated camera");
+	camera->open();
+	FirewireCamera::deleteFirewireCamera(camera);
+
+	// the third camera doesn't exist
+	camera = FirewireCamera::createFirewireCamera(2);
+	bool rejected = false;
+	try
+	{
+		camera->open();
+	}
+	catch (std::runtime_error&)
+	{
+		rejected = true;
+	}
+	checks.check(rejected, "a camera beyond the simulated ones opened");
+	FirewireCamera::deleteFirewireCamera(camera);
+	SimulatedFirewireCamera::setSimulatedCameras(0);
+}
+
+/**
+ * @brief The frames are the raw frames of fillFrame, converted like the
+ * frames of a real camera.
+ */
+static void testPixels(tt::test::Checks& checks)
+{
+	// RGB lines are copied into frames with padded lines
+	Image::setDefaultLineAlignment(Image::A64);
+	SimulatedFirewireCamera* camera = createCamera(FirewireCamera::FORMAT0,
+		FirewireCamera::MODE_800x600_RGB, FirewireCamera::FRAMERATE_240);
+	camera->captureStart();
+	Image* image = camera->getImage();
+	Image expected(800, 600, Image::RGB);
+	SimulatedFirewireCamera::fillFrame(expected.getImageBuffer(), expected.getAllocatedWidth(),
+		600, camera->getFrameNumber(), 0);
+	checks.check(image->getAllocatedWidth() == 2432 && tt::test::equal(*image, expected),
+		"RGB frame has other pixels");
+	delete camera;
+	Image::setDefaultLineAlignment(Image::A4);
+
+	// the second camera has other pixels
+	camera = createCamera(FirewireCamera::FORMAT0, FirewireCamera::MODE_640x480_MONO8,
+		FirewireCamera::FRAMERATE_240);
+	camera->selectCamera(1);
+	camera->captureStart();
+	image = camera->getImage();
+	Image raw(640, 480, Image::GREYSCALE);
+	SimulatedFirewireCamera::fillFrame(raw.getImageBuffer(), raw.getAllocatedWidth(), 480,
+		camera->getFrameNumber(), 1);
+	Image converted(640, 480, Image::RGB);
+	Bayer::deBayer(&raw, &converted, Bayer::BayerRG2BGR);
+	checks.check(tt::test::equal(*image, converted), "MONO8 frame has other pixels");
+	delete camera;
+
+	camera = createCamera(FirewireCamera::FORMAT0, FirewireCamera::MODE_320x240_YUV422,
+		FirewireCamera::FRAMERATE_240);
+	camera->captureStart();
+	image = camera->getImage();
+	int lineBytes = YUV::getLineBytes(YUV::FORMAT_YUV422, 320);
+	std::vector<unsigned char> yuv(lineBytes * 240);
+	SimulatedFirewireCamera::fillFrame(&yuv[0], lineBytes, 240, camera->getFrameNumber(), 0);
+	Image rgb(320, 240, Image::RGB);
+	YUV::convert(&yuv[0], YUV::FORMAT_YUV422, &rgb, Bayer::ORDER_RGB);
+	checks.check(tt::test::equal(*image, rgb), "YUV422 frame has other pixels");
+	delete camera;
+}
+
+/**
+ * @brief An application stalling for 12 frame periods loses the frames the
+ * delivery policy gives up, all of them are counted.
+ */
+static void testSlowApplication(tt::test::Checks& checks)
+{
+	const ImageDevice::DeliveryPolicy policies[3] = {ImageDevice::LATEST_ONLY,
+		ImageDevice::BOUNDED_QUEUE, ImageDevice::BLOCKING_LOSSLESS};
+	for (int i = 0; i < 3; i++)
+	{
+		SimulatedFirewireCamera* camera = createCamera(FirewireCamera::FORMAT7,
+			FirewireCamera::MODE0, FirewireCamera::FRAMERATE_120);
+		camera->setFormat7ImageSize(160, 120);
+		camera->setDMABuffers(4);
+		camera->setDeliveryPolicy(policies[i]);
+		camera->captureStart();
+
+		camera->getImage();
+		checks.check(camera->getFrameNumber() == 0, "policy %d didn't start at frame 0", i);
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		tt::ds::FrameInfo info = camera->getImage()->getFrameInfo();
+		unsigned long stalled = camera->getFrameNumber();
+		camera->getImage();
+		unsigned long next = camera->getFrameNumber();
+
+		if (policies[i] == ImageDevice::LATEST_ONLY)
+		{
+			// the newest frame, 12 periods after frame 0
+			checks.check(stalled >= 12, "LATEST_ONLY delivered frame %lu", stalled);
+		}
+		else
+		{
+			// the oldest frame in the ring of 4, then the next one
+			checks.check(stalled >= 9 && next == stalled + 1,
+				"policy %d delivered frames %lu and %lu", i, stalled, next);
+		}
+		checks.check(info.sequence == stalled && info.droppedFrames == stalled - 1 &&
+			info.bufferIndex == (int) (stalled % 4), "policy %d frame info of frame %lu",
+			i, stalled);
+		checks.check(camera->getCapturedFrames() == 3 &&
+			camera->getDeviceDroppedFrames() == next + 1 - 3,
+			"policy %d counted %lu delivered and %lu dropped frames of %lu", i,
+			camera->getCapturedFrames(), camera->getDeviceDroppedFrames(), next + 1);
+
+		// the ring is in use
+		bool rejected = false;
+		try
+		{
+			camera->setDMABuffers(8);
+		}
+		catch (std::runtime_error&)
+		{
+			rejected = true;
+		}
+		checks.check(rejected && camera->getDMABuffers() == 4,
+			"policy %d resized the ring while capturing", i);
+		delete camera;
+	}
+}
+
+/**
+ * @brief The delays of the jitter depend on the camera and the frame only.
+ */
+static void testJitter(tt::test::Checks& checks)
+{
+	const std::chrono::nanoseconds period = std::chrono::nanoseconds(1000000000 / 120);
+	std::vector<std::chrono::nanoseconds> delays[3];
+	for (int run = 0; run < 3; run++)
+	{
+		SimulatedFirewireCamera* camera = createCamera(FirewireCamera::FORMAT7,
+			FirewireCamera::MODE0, FirewireCamera::FRAMERATE_120);
+		camera->setFormat7ImageSize(160, 120);
+		camera->selectCamera(run == 2 ? 1 : 0);
+		camera->setJitter(3000);
+		camera->captureStart();
+		for (unsigned long n = 0; n < 50; n++)
+		{
+			delays[run].push_back(camera->getArrivalTime(n) -
+				camera->getArrivalTime(0) - period * (long long) n);
+		}
+
+		// the frames are stamped with their arrival time
+		Image* image = camera->getImage();
+		checks.check(image->getFrameInfo().timestamp ==
+			camera->getArrivalTime(camera->getFrameNumber()), "run %d timestamp", run);
+		delete camera;
+	}
+
+	bool bounded = true;
+	bool delayed = false;
+	for (size_t n = 0; n < delays[0].size(); n++)
+	{
+		if (delays[0][n] < -std::chrono::microseconds(3000) ||
+			delays[0][n] > std::chrono::microseconds(3000))
+		{
+			bounded = false;
+		}
+		if (delays[0][n] != std::chrono::nanoseconds(0))
+		{
+			delayed = true;
+		}
+	}
+	checks.check(bounded && delayed, "the jitter isn't up to 3000 us");
+	checks.check(delays[0] == delays[1], "the jitter differs between runs");
+	checks.check(delays[0] != delays[2], "two cameras have the same jitter");
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testFactory(checks);
+	testPixels(checks);
+	testSlowApplication(checks);
+	testJitter(checks);
+	return checks.report("TestSimulatedCamera");
+}
@@ -0,0 +1,202 @@
+#ifndef TT_TEST_TESTUTILS_H
+#define TT_TEST_TESTUTILS_H
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <tt/ds/Image.h>
+
+namespace tt
+{
+
+/**
+ * @brief Namespace of the helpers shared by the regression tests and benchmarks.
+ */
+namespace test
+{
+
+/**
+ * @brief Fill all lines of an image with reproducible pseudo random bytes.
+ * @param image The image to fill.
+ * @param seed The state of the generator, which is advanced.
+ */
+inline void randomize(tt::ds::Image& image, unsigned int& seed)
+{
+	int lineBytes = image.getWidth() * image.getBytesPerPixel();
+	for (int y = 0; y < image.getHeight(); y++)
+	{
+		unsigned char* line = image.getImageBuffer() + y*image.getAllocatedWidth();
+		for (int x = 0; x < lineBytes; x++)
+		{
+			seed = seed*1103515245 + 12345;
+			line[x] = (unsigned char) (seed >> 16);
+		}
+	}
+}
+
+/**
+ * @brief Return the buffer of an image, reading it through a const image
+ * doesn't detach it.
+ */
+inline const unsigned char* getBuffer(const tt::ds::Image& image)
+{
+	return image.getImageBuffer();
+}
+
+/**
+ * @brief Return true, if two images of the same format have the same pixels.
+ *
+ * Only the visible part of the lines is compared, the padding is ignored.
+ */
+inline bool equal(const tt::ds::Image& a, const tt::ds::Image& b)
+{
+	if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight() ||
+		a.getBytesPerPixel() != b.getBytesPerPixel())
+	{
+		return false;
+	}
+
+	int lineBytes = a.getWidth() * a.getBytesPerPixel();
+	for (int y = 0; y < a.getHeight(); y++)
+	{
+		if (memcmp(a.getImageBuffer() + y*a.getAllocatedWidth(),
+			b.getImageBuffer() + y*b.getAllocatedWidth(), lineBytes) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Draw a known color scene into an 8 bit RGB image.
+ * 
+ * Smooth rings of varying brightness are overlaid with sharp edged tiles of
+ * different hues, which gives both the flat areas and the color edges the
+ * demosaicing methods differ on.
+ */
+inline void drawScene(tt::ds::Image& image)
+{
+	for (int y = 0; y < image.getHeight(); y++)
+	{
+		unsigned char* line = image.getImageBuffer() + y*image.getAllocatedWidth();
+		for (int x = 0; x < image.getWidth(); x++)
+		{
+			double brightness = 0.5 + 0.45*sin((x*x + y*y)*0.0004) *
+				((x/37 + y/53) % 2 == 1 ? 1.0 : 0.6);
+			int hue = (x/200 + y/150) % 3;
+			line[x*3] = (unsigned char) (255*brightness*(hue == 0 ? 0.9 : 0.6));
+			line[x*3 + 1] = (unsigned char) (255*brightness*0.8);
+			line[x*3 + 2] = (unsigned char) (255*brightness*(hue == 2 ? 0.95 : 0.5));
+		}
+	}
+}
+
+/**
+ * @brief Return the peak signal to noise ratio of an 8 bit image in dB.
+ * @param reference The original image.
+ * @param image The image to rate, of the same format.
+ * @param border Columns and lines at each edge, which are not compared.
+ */
+inline double psnr(const tt::ds::Image& reference, const tt::ds::Image& image, int border)
+{
+	int channels = reference.getBytesPerPixel();
+	double squaredError = 0.0;
+	long values = 0;
+	for (int y = border; y < reference.getHeight() - border; y++)
+	{
+		const unsigned char* a = reference.getImageBuffer() + y*reference.getAllocatedWidth();
+		const unsigned char* b = image.getImageBuffer() + y*image.getAllocatedWidth();
+		for (int x = border*channels; x < (reference.getWidth() - border)*channels; x++)
+		{
+			double difference = a[x] - b[x];
+			squaredError += difference*difference;
+			values++;
+		}
+	}
+	if (squaredError == 0.0)
+	{
+		return INFINITY;
+	}
+	return 10.0*log10(255.0*255.0*values / squaredError);
+}
+
+/**
+ * @brief Counts checks and reports the failed ones.
+ */
+class Checks
+{
+public:
+	Checks() :
+		checks(0),
+		failures(0)
+	{
+	}
+
+	/**
+	 * @brief Count a check, print the message if it failed.
+	 * @return ok
+	 */
+	bool check(bool ok, const char* format, ...)
+	{
+		checks++;
+		if (!ok)
+		{
+			failures++;
+			va_list arguments;
+			va_start(arguments, format);
+			printf("FAILED: ");
+			vprintf(format, arguments);
+			printf("\n");
+			va_end(arguments);
+		}
+		return ok;
+	}
+
+	/**
+	 * @brief Print the summary and return the exit code of the test.
+	 */
+	int report(const char* name) const
+	{
+		printf("%s: %d checks, %d failed\n", name, checks, failures);
+		return failures == 0 ? 0 : 1;
+	}
+
+private:
+	int checks;
+	int failures;
+};
+
+/**
+ * @brief Return the milliseconds of the fastest of repetitions calls of a
+ * function after one warm up call.
+ * 
+ * The fastest call is hardly disturbed by other processes, so the results
+ * of different runs are comparable.
+ */
+template <typename Function>
+double measure(int repetitions, Function function)
+{
+	function();
+	double fastest = 0.0;
+	for (int i = 0; i < repetitions; i++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		function();
+		std::chrono::duration<double, std::milli> elapsed =
+			std::chrono::steady_clock::now() - start;
+		if (i == 0 || elapsed.count() < fastest)
+		{
+			fastest = elapsed.count();
+		}
+	}
+	return fastest;
+}
+
+} // namespace test
+
+} // namespace tt
+
+#endif /*TT_TEST_TESTUTILS_H*/
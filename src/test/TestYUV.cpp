@@ -0,0 +1,169 @@
+/*
+ * TestYUV
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Checks the YUV conversions of all kernels against the YUV2RGB arithmetic
+ * of libdc1394 on random frames of all formats and both channel orders.
+ */
+
+#include <stdexcept>
+#include <vector>
+#include <tt/ds/Image.h>
+#include <tt/process/YUV.h>
+#include "TestUtils.h"
+
+using tt::ds::Image;
+using tt::process::Bayer;
+using tt::process::YUV;
+
+static int clamp(int value)
+{
+	return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+/**
+ * @brief Convert one pixel into BGR with the fixed point factors of libdc1394.
+ */
+static void referencePixel(int y, int u, int v, unsigned char* bgr)
+{
+	u -= 128;
+	v -= 128;
+	bgr[0] = (unsigned char) clamp(y + ((u*1814) >> 10));
+	bgr[1] = (unsigned char) clamp(y - ((u*352 + v*731) >> 10));
+	bgr[2] = (unsigned char) clamp(y + ((v*1436) >> 10));
+}
+
+/**
+ * @brief Convert a frame into a BGR image pixel by pixel.
+ */
+static void referenceConvert(const unsigned char* source, YUV::Format format, Image& destination)
+{
+	static const int yuv411Luma[4] = {1, 2, 4, 5};
+	int lineBytes = YUV::getLineBytes(format, destination.getWidth());
+
+	for (int y = 0; y < destination.getHeight(); y++)
+	{
+		const unsigned char* line = source + y*lineBytes;
+		unsigned char* dst = destination.getImageBuffer() + y*destination.getAllocatedWidth();
+		for (int x = 0; x < destination.getWidth(); x++)
+		{
+			const unsigned char* group;
+			switch (format)
+			{
+				case YUV::FORMAT_YUV444:
+					group = line + x*3;
+					referencePixel(group[1], group[0], group[2], dst + x*3);
+					break;
+
+				case YUV::FORMAT_YUV422:
+					group = line + (x/2)*4;
+					referencePixel(group[1 + 2*(x%2)], group[0], group[2], dst + x*3);
+					break;
+
+				case YUV::FORMAT_YUV411:
+					group = line + (x/4)*6;
+					referencePixel(group[yuv411Luma[x%4]], group[0], group[3], dst + x*3);
+					break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Return true, if an image has the pixels of a BGR image in the given order.
+ */
+static bool equalInOrder(const Image& bgr, const Image& image, Bayer::Order order)
+{
+	for (int y = 0; y < bgr.getHeight(); y++)
+	{
+		const unsigned char* a = bgr.getImageBuffer() + y*bgr.getAllocatedWidth();
+		const unsigned char* b = image.getImageBuffer() + y*image.getAllocatedWidth();
+		for (int x = 0; x < bgr.getWidth()*3; x += 3)
+		{
+			int first = order == Bayer::ORDER_BGR ? 0 : 2;
+			if (a[x] != b[x + first] || a[x + 1] != b[x + 1] || a[x + 2] != b[x + 2 - first])
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Convert random frames, black and white frames with all kernels.
+ */
+static void testKernels(tt::test::Checks& checks)
+{
+	static const YUV::Kernel kernels[] = {YUV::KERNEL_SCALAR, YUV::KERNEL_SSSE3};
+	static const Bayer::Order orders[] = {Bayer::ORDER_BGR, Bayer::ORDER_RGB};
+	static const int groupPixels[] = {1, 2, 4};
+	unsigned int seed = 8;
+
+	for (int i = 0; i < 600; i++)
+	{
+		YUV::Format format = (YUV::Format) (i % 3);
+		int width = groupPixels[format] * (1 + (i*7) % 40);
+		int height = 1 + i % 6;
+		std::vector<unsigned char> source(YUV::getLineBytes(format, width) * height);
+		for (size_t b = 0; b < source.size(); b++)
+		{
+			seed = seed*1103515245 + 12345;
+			source[b] = i < 3 ? 0 : (i < 6 ? 255 : (unsigned char) (seed >> 16));
+		}
+
+		Image reference(width, height, Image::RGB);
+		referenceConvert(&source[0], format, reference);
+
+		for (int k = 0; k < 2; k++)
+		{
+			if (!YUV::isKernelSupported(kernels[k]))
+			{
+				continue;
+			}
+			YUV::setKernel(kernels[k]);
+			for (int o = 0; o < 2; o++)
+			{
+				Image result(width, height, Image::RGB);
+				YUV::convert(&source[0], format, &result, orders[o]);
+				checks.check(equalInOrder(reference, result, orders[o]),
+					"format %d %dx%d kernel %d order %d", format, width, height,
+					kernels[k], orders[o]);
+			}
+		}
+	}
+	YUV::setKernel(YUV::KERNEL_AUTO);
+}
+
+/**
+ * @brief Destinations which aren't RGB BPC8 images must be rejected.
+ */
+static void testFormats(tt::test::Checks& checks)
+{
+	std::vector<unsigned char> source(YUV::getLineBytes(YUV::FORMAT_YUV444, 8) * 8);
+	Image grey(8, 8, Image::GREYSCALE);
+	Image rgb16(8, 8, Image::RGB, Image::BPC16);
+	Image* destinations[] = {&grey, &rgb16};
+
+	for (int d = 0; d < 2; d++)
+	{
+		bool thrown = false;
+		try
+		{
+			YUV::convert(&source[0], YUV::FORMAT_YUV444, destinations[d]);
+		}
+		catch (std::runtime_error&)
+		{
+			thrown = true;
+		}
+		checks.check(thrown, "destination %d not rejected", d);
+	}
+}
+
+int main()
+{
+	tt::test::Checks checks;
+	testKernels(checks);
+	testFormats(checks);
+	return checks.report("TestYUV");
+}
@@ -0,0 +1,48 @@
+#ifndef TT_DS_FRAMEINFO_H
+#define TT_DS_FRAMEINFO_H
+
+#include <chrono>
+
+namespace tt
+{
+
+namespace ds
+{
+
+/**
+ * @class FrameInfo FrameInfo.h tt/ds/FrameInfo.h
+ * @brief Capture metadata of a frame.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Every Image carries a FrameInfo, which the image devices fill in for the
+ * frames they deliver. Copies, clones, shares and views of a frame keep its
+ * FrameInfo, Images, which weren't captured, have the default one.
+ *
+ * The sequence numbers count all frames of the device since captureStart,
+ * including the dropped ones, so droppedFrames is the gap to the sequence
+ * number of the previous delivered frame.
+ */
+struct FrameInfo
+{
+	/** @brief The time the frame was captured, the epoch if unknown */
+	std::chrono::steady_clock::time_point timestamp;
+	/** @brief The number of the frame of its device, starting at 0 */
+	unsigned long sequence;
+	/** @brief The number of frames the device dropped since the previous frame */
+	unsigned long droppedFrames;
+	/** @brief The index of the buffer of the device, which held the frame, or -1 */
+	int bufferIndex;
+
+	FrameInfo() :
+		sequence(0),
+		droppedFrames(0),
+		bufferIndex(-1)
+	{
+	}
+};
+
+} // namespace ds
+
+} // namespace tt
+
+#endif /*TT_DS_FRAMEINFO_H*/
@@ -0,0 +1,177 @@
+/*
+ * FramePool
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <tt/sys/Memory.h>
+#include "FramePool.h"
+
+namespace tt
+{
+
+namespace ds
+{
+
+const size_t FramePool::ALIGNMENT;
+const size_t FramePool::DEFAULT_MAX_FREE_BYTES;
+
+FramePool::FramePool(size_t maxFreeBytes) :
+	freeBytes(0),
+	maxFreeBytes(maxFreeBytes),
+	hugePageBytes(0),
+	hits(0),
+	misses(0)
+{
+}
+
+FramePool::~FramePool()
+{
+	clear();
+}
+
+FramePool& FramePool::getDefault()
+{
+	// never destroyed, so images in static objects can still release their buffers
+	static FramePool* pool = new FramePool();
+	return *pool;
+}
+
+size_t FramePool::getClassSize(size_t bytes)
+{
+	if (bytes <= ALIGNMENT)
+	{
+		return ALIGNMENT;
+	}
+
+	// the largest power of two below bytes
+	size_t power = 1;
+	while (power * 2 < bytes)
+	{
+		power *= 2;
+	}
+
+	size_t step = power / 4 < ALIGNMENT ? ALIGNMENT : power / 4;
+	return (bytes + step - 1) / step * step;
+}
+
+unsigned char* FramePool::allocate(size_t bytes)
+{
+	size_t classSize = getClassSize(bytes);
+	bool hugePages;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::map<size_t, std::vector<unsigned char*> >::iterator list = freeLists.find(classSize);
+		if (list != freeLists.end() && !list->second.empty())
+		{
+			unsigned char* buffer = list->second.back();
+			list->second.pop_back();
+			freeBytes -= classSize;
+			hits++;
+			return buffer;
+		}
+		misses++;
+		hugePages = hugePageBytes > 0 && classSize >= hugePageBytes;
+	}
+
+	// allocate outside of the lock, other threads may go on meanwhile
+	if (hugePages)
+	{
+		return tt::sys::Memory::allocateHugePages(classSize);
+	}
+	return tt::sys::Memory::allocate(classSize, ALIGNMENT);
+}
+
+void FramePool::release(unsigned char* buffer, size_t bytes)
+{
+	if (buffer == NULL)
+	{
+		return;
+	}
+
+	size_t classSize = getClassSize(bytes);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (freeBytes + classSize <= maxFreeBytes)
+		{
+			freeLists[classSize].push_back(buffer);
+			freeBytes += classSize;
+			return;
+		}
+	}
+	tt::sys::Memory::release(buffer);
+}
+
+void FramePool::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	trim(0);
+}
+
+void FramePool::setMaxFreeBytes(size_t maxFreeBytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	this->maxFreeBytes = maxFreeBytes;
+	trim(maxFreeBytes);
+}
+
+size_t FramePool::getMaxFreeBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return maxFreeBytes;
+}
+
+void FramePool::setHugePageBytes(size_t hugePageBytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	this->hugePageBytes = hugePageBytes;
+}
+
+size_t FramePool::getHugePageBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return hugePageBytes;
+}
+
+size_t FramePool::getFreeBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return freeBytes;
+}
+
+unsigned long FramePool::getHits() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return hits;
+}
+
+unsigned long FramePool::getMisses() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return misses;
+}
+
+void FramePool::resetCounters()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	hits = 0;
+	misses = 0;
+}
+
+void FramePool::trim(size_t limit)
+{
+	// free the largest buffers first, they are the least likely to be reused
+	std::map<size_t, std::vector<unsigned char*> >::reverse_iterator list = freeLists.rbegin();
+	for (; list != freeLists.rend() && freeBytes > limit; ++list)
+	{
+		while (!list->second.empty() && freeBytes > limit)
+		{
+			tt::sys::Memory::release(list->second.back());
+			list->second.pop_back();
+			freeBytes -= list->first;
+		}
+	}
+}
+
+} // namespace ds
+
+} // namespace tt
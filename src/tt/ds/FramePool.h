@@ -0,0 +1,162 @@
+#ifndef TT_DS_FRAMEPOOL_H
+#define TT_DS_FRAMEPOOL_H
+
+#include <stddef.h>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace tt
+{
+
+namespace ds
+{
+
+/**
+ * @class FramePool FramePool.h tt/ds/FramePool.h
+ * @brief Recycling allocator for image buffers.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Capture loops allocate and free buffers of the same few sizes over and
+ * over. A FramePool keeps released buffers in free lists per size class and
+ * hands them out again, so a long running loop neither calls the heap nor
+ * faults in fresh pages once it has seen each size. Sizes are rounded up to
+ * classes in steps of a quarter of a power of two, which wastes less than a
+ * quarter of a buffer and lets slightly different sizes share buffers. All
+ * buffers start at a cache line. Buffers of at least getHugePageBytes are
+ * allocated on huge pages, see tt::sys::Memory. Released buffers beyond
+ * getMaxFreeBytes are freed instead of kept.
+ *
+ * An Image constructed with a FramePool draws its buffer from the pool and
+ * gives it back on destruction. A FramePool is thread safe, so images may
+ * be released by another thread than the one which created them. The pool
+ * must outlive its images, getDefault is never destroyed.
+ */
+class FramePool
+{
+public:
+	/** @brief Alignment of all buffers in bytes */
+	static const size_t ALIGNMENT = 64;
+
+	/** @brief Default limit of the bytes kept in the free lists */
+	static const size_t DEFAULT_MAX_FREE_BYTES = 128 << 20;
+
+	/**
+	 * @brief Create an empty pool.
+	 * @param maxFreeBytes Maximum number of bytes kept in the free lists.
+	 */
+	FramePool(size_t maxFreeBytes = DEFAULT_MAX_FREE_BYTES);
+
+	/**
+	 * @brief Free the buffers in the free lists.
+	 *
+	 * Buffers, which are still in use, must not be released afterwards.
+	 */
+	virtual ~FramePool();
+
+	/**
+	 * @brief Return the pool used by the devices.
+	 */
+	static FramePool& getDefault();
+
+	/**
+	 * @brief Return the size class of a buffer of the given size.
+	 *
+	 * The size class of a size class is the size class itself.
+	 */
+	static size_t getClassSize(size_t bytes);
+
+	/**
+	 * @brief Return a buffer of getClassSize(bytes) bytes.
+	 *
+	 * Reuses a released buffer of the size class, if there is one, otherwise
+	 * allocates a new one. Throws a std::bad_alloc, if the memory is exhausted.
+	 */
+	unsigned char* allocate(size_t bytes);
+
+	/**
+	 * @brief Give a buffer back to the pool.
+	 * @param buffer A buffer returned by allocate of this pool or NULL.
+	 * @param bytes The size passed to allocate or its size class.
+	 */
+	void release(unsigned char* buffer, size_t bytes);
+
+	/**
+	 * @brief Free all buffers in the free lists.
+	 */
+	void clear();
+
+	/**
+	 * @brief Set the maximum number of bytes kept in the free lists.
+	 *
+	 * Frees buffers, until the free lists are below the new limit.
+	 */
+	void setMaxFreeBytes(size_t maxFreeBytes);
+
+	/**
+	 * @brief Return the maximum number of bytes kept in the free lists.
+	 */
+	size_t getMaxFreeBytes() const;
+
+	/**
+	 * @brief Allocate buffers of at least this size on huge pages.
+	 * @param hugePageBytes The minimum size, 0 never uses huge pages (default).
+	 * 
+	 * Applies to new buffers, buffers in the free lists are kept.
+	 */
+	void setHugePageBytes(size_t hugePageBytes);
+
+	/**
+	 * @brief Return the minimum size of buffers on huge pages, 0 for none.
+	 */
+	size_t getHugePageBytes() const;
+
+	/**
+	 * @brief Return the number of bytes in the free lists.
+	 */
+	size_t getFreeBytes() const;
+
+	/**
+	 * @brief Return the number of allocations served from the free lists.
+	 */
+	unsigned long getHits() const;
+
+	/**
+	 * @brief Return the number of allocations, which needed a new buffer.
+	 */
+	unsigned long getMisses() const;
+
+	/**
+	 * @brief Set the hit and miss counters to 0.
+	 */
+	void resetCounters();
+
+private:
+	/** @brief Protects the state below */
+	mutable std::mutex mutex;
+	/** @brief Released buffers by size class */
+	std::map<size_t, std::vector<unsigned char*> > freeLists;
+	/** @brief Bytes in the free lists */
+	size_t freeBytes;
+	/** @brief Limit of freeBytes */
+	size_t maxFreeBytes;
+	/** @brief Minimum size of buffers on huge pages, 0 for none */
+	size_t hugePageBytes;
+	/** @brief Allocations served from the free lists */
+	unsigned long hits;
+	/** @brief Allocations, which needed a new buffer */
+	unsigned long misses;
+
+	/** @brief Free buffers, until freeBytes is at most limit, mutex must be locked */
+	void trim(size_t limit);
+
+	// a FramePool owns its buffers and can't be copied
+	FramePool(const FramePool&);
+	FramePool& operator = (const FramePool&);
+};
+
+} // namespace ds
+
+} // namespace tt
+
+#endif /*TT_DS_FRAMEPOOL_H*/
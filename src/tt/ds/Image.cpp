@@ -3,21 +3,137 @@
 #include <iostream>
 
 #include <assert.h>
+#include <atomic>
+#include <stdexcept>
 #include <cv.h>
 #include <cxcore.h>
 #include <highgui.h>
 
+#include <tt/sys/Memory.h>
+#include "FramePool.h"
 #include "Image.h"
+#include "IntegralCache.h"
+#include "PyramidCache.h"
 
 namespace tt
 {
 
 namespace ds
 {
+
+/**
+ * @brief Owner of a buffer shared by several images.
+ * 
+ * Holds the buffer the way the first image held it, so the last holder
+ * releases it the same way. The SharedBuffer of a view holds a reference
+ * to the SharedBuffer of the whole buffer instead.
+ */
+struct Image::SharedBuffer
+{
+	/** @brief Number of images and views using the buffer */
+	std::atomic<int> references;
+	/** @brief Number of the references held by views */
+	std::atomic<int> views;
+	/** @brief The SharedBuffer the region of a view lies in or NULL */
+	SharedBuffer* viewed;
+	/** @brief The shared buffer */
+	unsigned char* buffer;
+	/** @brief Size of the buffer */
+	size_t bytes;
+	/** @brief Pool of the buffer or NULL for the heap */
+	FramePool* pool;
+	/** @brief False for a wrapped buffer, which isn't released */
+	bool owned;
+	/** @brief Releases an adopted buffer instead of the pool or the heap */
+	Deleter deleter;
+	/** @brief Pyramid levels of the pixels or NULL, created on demand */
+	std::atomic<PyramidCache*> pyramid;
+	/** @brief Integral image of the pixels or NULL, created on demand */
+	std::atomic<IntegralCache*> integral;
+	
+	~SharedBuffer()
+	{
+		clearCaches();
+	}
+	
+	/** @brief Drop the data computed from the pixels */
+	void clearCaches()
+	{
+		delete pyramid.exchange(NULL);
+		delete integral.exchange(NULL);
+	}
+	
+	/** @brief Return the number of images, which aren't views, using the buffer */
+	int getHolders() const
+	{
+		return references - views;
+	}
+	
+	/** @brief Drop a reference, the last one releases the buffer like its first owner */
+	static void release(SharedBuffer* shared)
+	{
+		if (--shared->references != 0)
+		{
+			return;
+		}
+		
+		if (shared->deleter)
+		{
+			shared->deleter(shared->buffer);
+		}
+		else if (shared->owned && shared->pool != NULL)
+		{
+			shared->pool->release(shared->buffer, shared->bytes);
+		}
+		else if (shared->owned)
+		{
+			tt::sys::Memory::release(shared->buffer);
+		}
+		
+		if (shared->viewed != NULL)
+		{
+			// counted as a view until the reference is gone, so the holders
+			// are never underestimated
+			shared->viewed->views--;
+			release(shared->viewed);
+		}
+		delete shared;
+	}
+};
+
+/**
+ * @brief Return the cache of a SharedBuffer, which is created by the first caller.
+ * 
+ * Readers sharing the buffer may ask for the cache concurrently.
+ */
+template <typename T>
+static T& getCache(std::atomic<T*>& slot)
+{
+	T* cache = slot.load();
+	if (cache == NULL)
+	{
+		T* created = new T();
+		if (slot.compare_exchange_strong(cache, created))
+		{
+			cache = created;
+		}
+		else
+		{
+			delete created;
+		}
+	}
+	return *cache;
+}
+
+Image::LineAlignment Image::defaultLineAlignment = Image::A4;
 	
 Image::Image() :
 	allocatedBytes(0),
 	imageBuffer(NULL),
+	ownsBuffer(true),
+	framePool(NULL),
+	bufferBytes(0),
+	sharedBuffer(NULL),
 	allocatedWidth(0),
 	allocatedHeight(0),
 	width(0),
@@ -30,74 +146,193 @@ Image::Image() :
 	//updateOpencvHeader(); // Create OpenCV Header
 }
 
-Image::Image(int initWidth, int initHeight, Channels initChannels) :
+Image::Image(int initWidth, int initHeight, Channels initChannels,
+	BitsPerChannel initBitsPerChannel, FramePool* pool) :
+	imageBuffer(NULL),
+	ownsBuffer(true),
+	framePool(pool),
+	bufferBytes(0),
+	sharedBuffer(NULL),
 	width(initWidth),
 	height(initHeight),
 	channels(initChannels),
-	bitsPerChannel(BPC8),
-	lineAlignment(A4),
+	bitsPerChannel(initBitsPerChannel),
+	lineAlignment(defaultLineAlignment),
 	opencvHeader(NULL)
 {
 	// get an imageBuffer with the appropriate line Alignment
-	int remainder = (this->lineAlignment - ((this->width * this->channels) % this->lineAlignment)) % this->lineAlignment;
-	this->allocatedWidth = this->width * this->channels + remainder; 
-	this->allocatedHeight = this->height;
+	updateAllocatedSize();
+	allocateBuffer();
 
-	this->allocatedBytes = this->allocatedWidth * this->allocatedHeight;
-	imageBuffer = new unsigned char[this->allocatedBytes]; 
+	updateOpencvHeader(); // Create OpenCV Header
+}
+
+Image::Image(unsigned char* buffer, int initWidth, int initHeight, int lineBytes,
+	Channels initChannels, BitsPerChannel initBitsPerChannel) :
+	allocatedBytes(lineBytes * initHeight),
+	imageBuffer(buffer),
+	ownsBuffer(false),
+	framePool(NULL),
+	bufferBytes(0),
+	sharedBuffer(NULL),
+	allocatedWidth(lineBytes),
+	allocatedHeight(initHeight),
+	width(initWidth),
+	height(initHeight),
+	channels(initChannels),
+	bitsPerChannel(initBitsPerChannel),
+	lineAlignment(A4),
+	opencvHeader(NULL)
+{
+	assert(lineBytes >= initWidth * getBytesPerPixel());
 
 	updateOpencvHeader(); // Create OpenCV Header
 }
 
+Image::Image(unsigned char* buffer, int initWidth, int initHeight, int lineBytes,
+	Channels initChannels, BitsPerChannel initBitsPerChannel, Deleter deleter) :
+	Image(buffer, initWidth, initHeight, lineBytes, initChannels, initBitsPerChannel)
+{
+	if (deleter)
+	{
+		// the deleter is kept by the owner of shared buffers, which is never
+		// taken back by detach
+		sharedBuffer = new SharedBuffer();
+		sharedBuffer->references = 1;
+		sharedBuffer->views = 0;
+		sharedBuffer->viewed = NULL;
+		sharedBuffer->buffer = buffer;
+		sharedBuffer->bytes = allocatedBytes;
+		sharedBuffer->pool = NULL;
+		sharedBuffer->owned = false;
+		sharedBuffer->deleter = deleter;
+		sharedBuffer->pyramid = NULL;
+		sharedBuffer->integral = NULL;
+	}
+}
+
 Image::Image(const IplImage* image)
 {
 	// OpenCV image must be greyscale or RGB
 	assert((image->nChannels == 1) || (image->nChannels == 3) || (image->nChannels == 4));
-	// Pixel depth must be 8 bits per pixel 
-	assert(image->depth == IPL_DEPTH_8U);
+	// Pixel depth must be 8 or 16 bits per channel
+	assert((image->depth == IPL_DEPTH_8U) || (image->depth == IPL_DEPTH_16U));
 	
 	this->width = image->width;
 	this->height = image->height;
 	this->channels = (Channels) image->nChannels;
-	this->bitsPerChannel = BPC8; // only 8 bits per Pixel supported and checked by assert
+	this->bitsPerChannel = image->depth == IPL_DEPTH_16U ? BPC16 : BPC8;
 	this->lineAlignment = (LineAlignment) image->align;
 	this->allocatedWidth = image->widthStep;
 	this->allocatedHeight = this->height;
 	this->opencvHeader = NULL;
+	this->imageBuffer = NULL;
+	this->ownsBuffer = true;
+	this->framePool = NULL;
+	this->bufferBytes = 0;
+	this->sharedBuffer = NULL;
 
 	this->allocatedBytes = this->allocatedWidth * this->allocatedHeight;
-	imageBuffer = new unsigned char[this->allocatedBytes];
+	allocateBuffer();
 	memcpy(imageBuffer, image->imageData, this->allocatedBytes);
 
 	updateOpencvHeader(); // Create OpenCV Header
 }
 
-Image::Image(std::string filename)
+Image::Image(std::string filename) :
+	Image(load(filename))
 {
-	IplImage *image = cvLoadImage(filename.c_str());
-	assert(image);
-	this->width = image->width;
-	this->height = image->height;
-	this->channels = (Channels) image->nChannels;
-	this->bitsPerChannel = BPC8; // only 8 bits per Pixel supported and checked by assert
-	this->lineAlignment = (LineAlignment) image->align;
-	this->allocatedWidth = image->widthStep;
-	this->allocatedHeight = this->height;
-	this->opencvHeader = NULL;
+}
 
-	this->allocatedBytes = this->allocatedWidth * this->allocatedHeight;
-	imageBuffer = new unsigned char[this->allocatedBytes];
-	memcpy(imageBuffer, image->imageData, this->allocatedBytes); 
+Image Image::adopt(IplImage* image)
+{
+	// OpenCV image must be greyscale or RGB
+	assert((image->nChannels == 1) || (image->nChannels == 3) || (image->nChannels == 4));
+	// Pixel depth must be 8 or 16 bits per channel
+	assert((image->depth == IPL_DEPTH_8U) || (image->depth == IPL_DEPTH_16U));
+	
+	Image adopted((unsigned char*) image->imageData, image->width, image->height,
+		image->widthStep, (Channels) image->nChannels,
+		image->depth == IPL_DEPTH_16U ? BPC16 : BPC8,
+		[image] (unsigned char*) mutable { cvReleaseImage(&image); });
+	adopted.lineAlignment = (LineAlignment) image->align;
+	return adopted;
+}
+
+#if CV_MAJOR_VERSION >= 2
+Image Image::adopt(const cv::Mat& mat)
+{
+	// matrix must be greyscale or RGB with 8 or 16 bits per channel
+	assert((mat.channels() == 1) || (mat.channels() == 3) || (mat.channels() == 4));
+	assert((mat.depth() == CV_8U) || (mat.depth() == CV_16U));
+	assert(mat.dims == 2);
+	
+	// the copy of the header holds a reference to the buffer
+	cv::Mat owner = mat;
+	return Image(mat.data, mat.cols, mat.rows, (int) mat.step[0], (Channels) mat.channels(),
+		mat.depth() == CV_16U ? BPC16 : BPC8,
+		[owner] (unsigned char*) mutable { owner.release(); });
+}
+#endif
+
+Image Image::wrap(IplImage* image)
+{
+	// OpenCV image must be greyscale or RGB
+	assert((image->nChannels == 1) || (image->nChannels == 3) || (image->nChannels == 4));
+	// Pixel depth must be 8 or 16 bits per channel
+	assert((image->depth == IPL_DEPTH_8U) || (image->depth == IPL_DEPTH_16U));
+	
+	Image wrapped((unsigned char*) image->imageData, image->width, image->height,
+		image->widthStep, (Channels) image->nChannels,
+		image->depth == IPL_DEPTH_16U ? BPC16 : BPC8);
+	wrapped.lineAlignment = (LineAlignment) image->align;
+	return wrapped;
+}
+
+Image Image::load(const std::string& filename)
+{
+	std::string functionSignature = "Image Image::load(const std::string& filename)";
+	
+	IplImage* image = cvLoadImage(filename.c_str());
+	if (image == NULL)
+	{
+		throw std::runtime_error(functionSignature + " can't load " + filename + ".");
+	}
+	return adopt(image);
+}
+
+Image::Image(const Image& img) :
+	imageBuffer(NULL),
+	ownsBuffer(true),
+	framePool(img.framePool),
+	bufferBytes(0),
+	sharedBuffer(NULL),
+	width(img.width),
+	height(img.height),
+	channels(img.channels),
+	bitsPerChannel(img.bitsPerChannel),
+	lineAlignment(img.lineAlignment),
+	frameInfo(img.frameInfo),
+	opencvHeader(NULL)
+{
+	updateAllocatedSize();
+	allocateBuffer();
+	copyPixels(img);
 
 	updateOpencvHeader(); // Create OpenCV Header
-} 	
+}
+
+Image::Image(Image&& img) noexcept :
+	imageBuffer(NULL),
+	sharedBuffer(NULL),
+	opencvHeader(NULL)
+{
+	moveFrom(img);
+}
 
 Image::~Image()
 {
-	if (allocatedBytes > 0)
-	{
-		delete[] imageBuffer;
-	};
+	releaseBuffer();
 	
 	if (opencvHeader != NULL)
 	{
@@ -115,14 +350,184 @@ Image::BitsPerChannel Image::getBitsPerChannel() const
 	return this->bitsPerChannel;
 }
 
+int Image::getBytesPerPixel() const
+{
+	return this->channels * (this->bitsPerChannel / 8);
+}
+
 Image* Image::clone() const
 {
-	Image* tmp = new Image(this->getWidth(), this->getHeight(), this->getChannels());
-	*tmp=*this;
-	return (tmp);	
+	return new Image(*this);
+}
+
+Image Image::share()
+{
+	// the owner of a wrapped buffer overwrites or releases it, whenever it
+	// likes, so the share gets a copy of the pixels
+	bool wrapped = sharedBuffer == NULL ? !ownsBuffer :
+		!sharedBuffer->owned && !sharedBuffer->deleter && sharedBuffer->viewed == NULL;
+	if (wrapped)
+	{
+		return Image(*this);
+	}
+	
+	shareBuffer();
+	sharedBuffer->references++;
+	
+	Image image;
+	image.imageBuffer = this->imageBuffer;
+	image.framePool = this->framePool;
+	image.sharedBuffer = this->sharedBuffer;
+	image.allocatedBytes = this->allocatedBytes;
+	image.allocatedWidth = this->allocatedWidth;
+	image.allocatedHeight = this->allocatedHeight;
+	image.width = this->width;
+	image.height = this->height;
+	image.channels = this->channels;
+	image.bitsPerChannel = this->bitsPerChannel;
+	image.lineAlignment = this->lineAlignment;
+	image.frameInfo = this->frameInfo;
+	image.updateOpencvHeader();
+	return image;
+}
+
+Image Image::view(int x, int y, int viewWidth, int viewHeight)
+{
+	std::string functionSignature = "Image Image::view(int x, int y, int viewWidth, int viewHeight)";
+	
+	if (x < 0 || y < 0 || viewWidth < 0 || viewHeight < 0 ||
+		x + viewWidth > this->width || y + viewHeight > this->height)
+	{
+		throw std::runtime_error(functionSignature + " region exceeds the image.");
+	}
+	
+	// the view holds a reference to the whole buffer, the views of a view
+	// refer to it as well
+	shareBuffer();
+	SharedBuffer* viewed = sharedBuffer->viewed != NULL ? sharedBuffer->viewed : sharedBuffer;
+	viewed->references++;
+	viewed->views++;
+	
+	Image image(this->imageBuffer + y * this->allocatedWidth + x * getBytesPerPixel(),
+		viewWidth, viewHeight, this->allocatedWidth, this->channels, this->bitsPerChannel);
+	// the last line of the view ends before the end of the buffer's line
+	image.allocatedBytes = viewHeight > 0 ?
+		(viewHeight - 1) * this->allocatedWidth + viewWidth * getBytesPerPixel() : 0;
+	image.framePool = this->framePool;
+	image.frameInfo = this->frameInfo;
+	
+	// the view has caches of its own, shares of the view share them
+	image.sharedBuffer = new SharedBuffer();
+	image.sharedBuffer->references = 1;
+	image.sharedBuffer->views = 0;
+	image.sharedBuffer->viewed = viewed;
+	image.sharedBuffer->buffer = image.imageBuffer;
+	image.sharedBuffer->bytes = image.allocatedBytes;
+	image.sharedBuffer->pool = NULL;
+	image.sharedBuffer->owned = false;
+	image.sharedBuffer->pyramid = NULL;
+	image.sharedBuffer->integral = NULL;
+	return image;
+}
+
+bool Image::isShared() const
+{
+	if (sharedBuffer == NULL)
+	{
+		return false;
+	}
+	if (sharedBuffer->viewed != NULL)
+	{
+		// a view writes to the image it was taken from, unless that is shared
+		return sharedBuffer->references > 1 || sharedBuffer->viewed->getHolders() > 1;
+	}
+	// views write to the image they were taken from, they don't share it
+	return sharedBuffer->getHolders() > 1;
 }
 
-unsigned char* Image::getImageBuffer() const
+void Image::detach()
+{
+	if (sharedBuffer == NULL)
+	{
+		return;
+	}
+	
+	if (isShared())
+	{
+		// the other holders keep the buffer, the IplImage header stays valid
+		copyToOwnBuffer();
+		return;
+	}
+	
+	if (sharedBuffer->viewed != NULL)
+	{
+		// a view writes to the image it was taken from, whose pixels change, too
+		sharedBuffer->clearCaches();
+		sharedBuffer->viewed->clearCaches();
+		return;
+	}
+	
+	if (sharedBuffer->deleter || sharedBuffer->views > 0)
+	{
+		// an adopted buffer stays with its owner and a viewed buffer with
+		// its views, only the caches are dropped
+		sharedBuffer->clearCaches();
+		return;
+	}
+	
+	// the last holder can't be shared concurrently, so it takes the buffer back
+	ownsBuffer = sharedBuffer->owned;
+	bufferBytes = sharedBuffer->bytes;
+	framePool = sharedBuffer->pool;
+	delete sharedBuffer;
+	sharedBuffer = NULL;
+}
+
+void Image::discard()
+{
+	if (!isShared())
+	{
+		// nobody else sees the pixels, so detach() doesn't copy them
+		detach();
+		return;
+	}
+	
+	// the other holders keep the buffer, the new one has the layout of a copy
+	releaseBuffer();
+	updateAllocatedSize();
+	allocateBuffer();
+	updateOpencvHeader();
+}
+
+PyramidCache& Image::getPyramidCache()
+{
+	shareBuffer();
+	return getCache(sharedBuffer->pyramid);
+}
+
+IntegralCache& Image::getIntegralCache()
+{
+	shareBuffer();
+	return getCache(sharedBuffer->integral);
+}
+
+const FrameInfo& Image::getFrameInfo() const
+{
+	return this->frameInfo;
+}
+
+void Image::setFrameInfo(const FrameInfo& info)
+{
+	this->frameInfo = info;
+}
+
+unsigned char* Image::getImageBuffer()
+{
+	detach();
+	return imageBuffer;
+}
+
+const unsigned char* Image::getImageBuffer() const
 {
 	return imageBuffer;
 }
@@ -152,77 +557,99 @@ int Image::getAllocatedBytes() const
 	return this->allocatedBytes;
 }
 
+FramePool* Image::getFramePool() const
+{
+	return this->framePool;
+}
+
+Image::LineAlignment Image::getLineAlignment() const
+{
+	return this->lineAlignment;
+}
+
+void Image::setLineAlignment(LineAlignment alignment)
+{
+	if (alignment == this->lineAlignment)
+	{
+		return;
+	}
+	
+	this->lineAlignment = alignment;
+	int lineBytes = this->width * getBytesPerPixel();
+	if (this->allocatedWidth == lineBytes + (alignment - lineBytes % alignment) % alignment)
+	{
+		// the lines are aligned already
+		return;
+	}
+	
+	// shares keep the old buffer, the IplImage header stays valid
+	copyToOwnBuffer();
+}
+
+void Image::setDefaultLineAlignment(LineAlignment alignment)
+{
+	Image::defaultLineAlignment = alignment;
+}
+
+Image::LineAlignment Image::getDefaultLineAlignment()
+{
+	return Image::defaultLineAlignment;
+}
+
 // TODO test for memory correctness, should be ok, according to cxarray.cpp
 IplImage* Image::getIplImage()
 {
+	detach();
 	return opencvHeader;
 }
 
 void Image::resizeMemory(const int newWidth, const int newHeight)
 {
-	// release memory if allocated before
-	if (allocatedBytes > 0)
-	{
-		delete[] imageBuffer;
-	};
-
 	this->width = newWidth;
 	this->height = newHeight;
 
 	// get an imageBuffer with the appropriate line Alignment
-	int remainder = (this->lineAlignment - ((this->width * this->channels) % this->lineAlignment)) % this->lineAlignment;
-	this->allocatedWidth = this->width * this->channels + remainder; 
-	this->allocatedHeight = this->height;
-
-	this->allocatedBytes = this->allocatedWidth * this->allocatedHeight;
-	imageBuffer = new unsigned char[allocatedBytes]; 
+	updateAllocatedSize();
+	allocateBuffer();
 
 	updateOpencvHeader(); // Update OpenCV Header
 }
 
-//inline
-unsigned char& Image::operator() (unsigned x, unsigned y, unsigned channel)
+Image& Image::operator = (const Image &img)
 {
-	// TODO check bounds, if wanted?
-	return imageBuffer[(y * this->allocatedWidth) + (x * this->channels) + channel];
-}
+	if (this == &img)
+	{
+		return *this;
+	}
+	
+	lineAlignment = img.lineAlignment;
+	this->width = img.getWidth();
+	this->height = img.getHeight();
+	this->bitsPerChannel = img.getBitsPerChannel();
+	this->channels = img.getChannels();
+	this->frameInfo = img.frameInfo;
+	updateAllocatedSize();
 
-//inline
-unsigned char Image::operator() (unsigned x, unsigned y, unsigned channel) const
-{
-	// TODO check bounds, if wanted?
-	return imageBuffer[(y * this->allocatedWidth) + (x * this->channels) + channel];
+	// keeps the buffer, if its size doesn't change
+	allocateBuffer();
+	copyPixels(img);
+
+	updateOpencvHeader(); // Update OpenCV Header
+	return *this;
 }
 
-void Image::operator = (const Image &img)
+Image& Image::operator = (Image&& img)
 {
-	lineAlignment = img.lineAlignment;
-	if(getWidth() != img.getWidth() || getHeight() != img.getHeight())
-	{
-		resizeMemory(img.getWidth(), img.getHeight());
-	}
-	if(this->getBitsPerChannel() != img.getBitsPerChannel())
+	if (this != &img)
 	{
-		this->bitsPerChannel = img.getBitsPerChannel();
+		releaseBuffer();
+		if (opencvHeader != NULL)
+		{
+			cvReleaseImageHeader(&opencvHeader);
+		}
+		moveFrom(img);
 	}
-	if(this->getChannels() != img.getChannels())
-	{
-		this->channels = img.getChannels();
-	}
-	int remainder = (lineAlignment - ((img.getWidth() * img.getChannels()) % lineAlignment)) % lineAlignment;
-	this->allocatedWidth = img.getWidth() * img.getChannels() + remainder; 
-	this->allocatedHeight = img.getHeight();
-	this->allocatedBytes = this->allocatedWidth * this->allocatedHeight;
-
-	// IMPORTANT!
-	if (allocatedBytes > 0)
-		delete [] imageBuffer;
-
-	imageBuffer = new unsigned char[this->allocatedBytes]; 
-	this->channels = img.getChannels();
-	memcpy(this->imageBuffer, img.getImageBuffer(), this->allocatedBytes);
-
-	updateOpencvHeader(); // Update OpenCV Header
+	return *this;
 }
 
 void Image::updateOpencvHeader()
@@ -243,6 +670,171 @@ void Image::updateOpencvHeader()
 	cvSetData(opencvHeader, this->imageBuffer, this->allocatedWidth);
 }
 
+void Image::releaseBuffer()
+{
+	if (sharedBuffer != NULL)
+	{
+		SharedBuffer::release(sharedBuffer);
+		sharedBuffer = NULL;
+	}
+	else if (imageBuffer != NULL && ownsBuffer)
+	{
+		if (framePool != NULL)
+		{
+			framePool->release(imageBuffer, bufferBytes);
+		}
+		else
+		{
+			tt::sys::Memory::release(imageBuffer);
+		}
+	};
+	
+	// a newly allocated buffer belongs to this image
+	imageBuffer = NULL;
+	bufferBytes = 0;
+	ownsBuffer = true;
+}
+
+void Image::allocateBuffer()
+{
+	size_t bytes = this->allocatedBytes;
+	if (framePool != NULL)
+	{
+		bytes = FramePool::getClassSize(bytes);
+	}
+	
+	if (imageBuffer != NULL && ownsBuffer && sharedBuffer == NULL && bufferBytes == bytes)
+	{
+		return;
+	}
+	
+	releaseBuffer();
+	if (framePool != NULL)
+	{
+		imageBuffer = framePool->allocate(bytes);
+	}
+	else
+	{
+		imageBuffer = tt::sys::Memory::allocate(bytes);
+	}
+	bufferBytes = bytes;
+}
+
+void Image::copyPixels(const Image& img)
+{
+	// a view may end before its last padded line
+	if (img.getAllocatedWidth() == this->allocatedWidth &&
+		img.getAllocatedBytes() >= this->allocatedBytes)
+	{
+		memcpy(this->imageBuffer, img.getImageBuffer(), this->allocatedBytes);
+	}
+	else
+	{
+		// a wrapped buffer or a view may have other line padding
+		int lineBytes = this->width * getBytesPerPixel();
+		for (int y = 0; y < this->height; y++)
+		{
+			memcpy(this->imageBuffer + y * this->allocatedWidth,
+				img.getImageBuffer() + y * img.getAllocatedWidth(), lineBytes);
+		}
+	}
+}
+
+void Image::copyToOwnBuffer()
+{
+	// the current buffer keeps the pixels until they are copied
+	const unsigned char* source = this->imageBuffer;
+	int sourceLineBytes = this->allocatedWidth;
+	
+	updateAllocatedSize();
+	size_t bytes = this->allocatedBytes;
+	unsigned char* buffer;
+	if (framePool != NULL)
+	{
+		bytes = FramePool::getClassSize(bytes);
+		buffer = framePool->allocate(bytes);
+	}
+	else
+	{
+		buffer = tt::sys::Memory::allocate(bytes);
+	}
+	
+	int lineBytes = this->width * getBytesPerPixel();
+	for (int y = 0; y < this->height; y++)
+	{
+		memcpy(buffer + y * this->allocatedWidth, source + y * sourceLineBytes, lineBytes);
+	}
+	
+	releaseBuffer();
+	this->imageBuffer = buffer;
+	this->bufferBytes = bytes;
+	updateOpencvHeader();
+}
+
+void Image::moveFrom(Image& img)
+{
+	this->allocatedBytes = img.allocatedBytes;
+	this->imageBuffer = img.imageBuffer;
+	this->ownsBuffer = img.ownsBuffer;
+	this->framePool = img.framePool;
+	this->bufferBytes = img.bufferBytes;
+	this->sharedBuffer = img.sharedBuffer;
+	this->allocatedWidth = img.allocatedWidth;
+	this->allocatedHeight = img.allocatedHeight;
+	this->width = img.width;
+	this->height = img.height;
+	this->channels = img.channels;
+	this->bitsPerChannel = img.bitsPerChannel;
+	this->lineAlignment = img.lineAlignment;
+	this->frameInfo = img.frameInfo;
+	// the header points to the buffer already
+	this->opencvHeader = img.opencvHeader;
+	
+	// leave img like Image()
+	img.allocatedBytes = 0;
+	img.imageBuffer = NULL;
+	img.ownsBuffer = true;
+	img.framePool = NULL;
+	img.bufferBytes = 0;
+	img.sharedBuffer = NULL;
+	img.allocatedWidth = 0;
+	img.allocatedHeight = 0;
+	img.width = 0;
+	img.height = 0;
+	img.channels = RGB;
+	img.bitsPerChannel = BPC8;
+	img.lineAlignment = A4;
+	img.frameInfo = FrameInfo();
+	img.opencvHeader = NULL;
+}
+
+void Image::shareBuffer()
+{
+	if (sharedBuffer == NULL)
+	{
+		// the buffer is handed to its owner, which releases it with the last holder
+		sharedBuffer = new SharedBuffer();
+		sharedBuffer->references = 1;
+		sharedBuffer->views = 0;
+		sharedBuffer->viewed = NULL;
+		sharedBuffer->buffer = imageBuffer;
+		sharedBuffer->bytes = bufferBytes;
+		sharedBuffer->pool = framePool;
+		sharedBuffer->owned = ownsBuffer;
+		sharedBuffer->pyramid = NULL;
+		sharedBuffer->integral = NULL;
+	}
+}
+
+void Image::updateAllocatedSize()
+{
+	int lineBytes = this->width * getBytesPerPixel();
+	int remainder = (this->lineAlignment - (lineBytes % this->lineAlignment)) % this->lineAlignment;
+	this->allocatedWidth = lineBytes + remainder; 
+	this->allocatedHeight = this->height;
+	this->allocatedBytes = this->allocatedWidth * this->allocatedHeight;
+}
+
 } // namespace ds
 
 } // namespace tt
@@ -1,8 +1,10 @@
 #ifndef TT_DS_IMAGE_H
 #define TT_DS_IMAGE_H
 
+#include <functional>
 #include <string>
 #include <cv.h>
+#include <tt/ds/FrameInfo.h>
 
 namespace tt
 {
@@ -13,6 +15,10 @@ namespace tt
 namespace ds
 {
 
+class FramePool;
+class IntegralCache;
+class PyramidCache;
+
 /**
  * @class Image Image.h tt/ds/Image.h
  * @brief Class for Image Storage
@@ -20,6 +26,25 @@ namespace ds
  * 
  * Image represents an Image and provides converter functions to the OpenCV
  * IplImage data type.
+ * 
+ * Copies are deep copies. Moving an Image hands its buffer over without
+ * copying. share() returns an Image, which uses the same buffer under a
+ * reference count, so a frame can be passed to several pipeline stages or
+ * threads without copying. The buffer is copied only when one of the
+ * holders writes to it through a non-const accessor or detach(). The reference
+ * count is thread safe, the pixels aren't protected.
+ * 
+ * Buffers of other libraries are taken over without copying them. An Image
+ * constructed with a Deleter, adopt() and load() release the buffer through
+ * the owner it came from, wrap() and the buffer constructor leave it alone.
+ * 
+ * view() returns a window into the buffer, which has its own width and
+ * height and the line stride of the parent, so processing functions and
+ * OpenCV work on a crop without copying it. A view holds a reference to
+ * the buffer like a share.
+ * 
+ * The FrameInfo of a captured frame travels with its copies, clones, shares
+ * and views.
  */
 class Image
 {
@@ -33,12 +58,29 @@ public:
 	
 	enum BitsPerChannel
 	{
-		BPC8 = 8
+		BPC8 = 8,
+		BPC16 = 16
 	};
 
+	/**
+	 * @brief Releases a buffer, which was taken over by an Image
+	 */
+	typedef std::function<void (unsigned char* buffer)> Deleter;
+
+	/**
+	 * @brief Alignment of the line stride in bytes
+	 * 
+	 * A4 is the default of OpenCV. A16, A32 and A64 let every line of an
+	 * image start at the alignment of SSE or AVX vectors or at a cache line,
+	 * since all buffers start at a cache line.
+	 */
 	enum LineAlignment
 	{
-		A4 = 4
+		A4 = 4,
+		A8 = 8,
+		A16 = 16,
+		A32 = 32,
+		A64 = 64
 	};
 	
 	
@@ -54,19 +96,117 @@ public:
 	 * @param initWidth Width of the new image
 	 * @param initHeight Height of the new image
 	 * @param initChannels Number of channels (supported: GREYSCALE = 1, RGB = 3; default = RGB) 
+	 * @param initBitsPerChannel Bits per channel (BPC8 or BPC16; default = BPC8)
+	 * @param pool Draw the buffer from this FramePool instead of the heap
+	 * (default = NULL, the heap)
+	 * 
+	 * BPC16 images store each channel as an unsigned short in host byte order.
+	 * The lines are aligned to getDefaultLineAlignment. The buffer of an
+	 * image with a pool goes back to the pool on destruction, the pool must
+	 * outlive the image. clone, resizeMemory and the assignment use the pool
+	 * of the image as well.
 	 */ 
-	Image(int initWidth, int initHeight, Channels initChannels = RGB);
+	Image(int initWidth, int initHeight, Channels initChannels = RGB,
+		BitsPerChannel initBitsPerChannel = BPC8, FramePool* pool = NULL);
+
+	/**
+	 * @brief Create an Image using an existing buffer without copying it
+	 * @param buffer The first byte of the first line
+	 * @param initWidth Width of the image
+	 * @param initHeight Height of the image
+	 * @param lineBytes Number of bytes from one line to the next
+	 * @param initChannels Number of channels
+	 * @param initBitsPerChannel Bits per channel
+	 * 
+	 * The Image doesn't release the buffer, which must stay valid during the
+	 * lifetime of the Image. resizeMemory and the assignment allocate a buffer
+	 * owned by the Image.
+	 */
+	Image(unsigned char* buffer, int initWidth, int initHeight, int lineBytes,
+		Channels initChannels = RGB, BitsPerChannel initBitsPerChannel = BPC8);
+
+	/**
+	 * @brief Create an Image, which takes over an existing buffer without copying it
+	 * @param buffer The first byte of the first line
+	 * @param initWidth Width of the image
+	 * @param initHeight Height of the image
+	 * @param lineBytes Number of bytes from one line to the next
+	 * @param initChannels Number of channels
+	 * @param initBitsPerChannel Bits per channel
+	 * @param deleter Called with the buffer, when the last Image using it
+	 * releases it
+	 * 
+	 * share() and moving keep the buffer, resizeMemory and the assignment
+	 * release it and allocate a buffer owned by the Image. The deleter may be
+	 * called by another thread, if the buffer was shared with it.
+	 */
+	Image(unsigned char* buffer, int initWidth, int initHeight, int lineBytes,
+		Channels initChannels, BitsPerChannel initBitsPerChannel, Deleter deleter);
 
 	/**
 	 * @brief Create an Image based on an OpenCV image
-	 * @param image The OpenCV Source image
+	 * @param image The OpenCV Source image (IPL_DEPTH_8U or IPL_DEPTH_16U)
+	 * 
+	 * Copies the pixels, see adopt() and wrap() for the zero copy variants.
 	 */ 
 	Image(const IplImage* image);
 	
+	/**
+	 * @brief Load an image file, see load()
+	 */
 	Image(std::string filename);
+	
+	/**
+	 * @brief Return an Image, which takes over an OpenCV image without copying it
+	 * @param image The OpenCV image (IPL_DEPTH_8U or IPL_DEPTH_16U), which is
+	 * released with cvReleaseImage together with the buffer.
+	 */
+	static Image adopt(IplImage* image);
+
+#if CV_MAJOR_VERSION >= 2
+	/**
+	 * @brief Return an Image, which uses the buffer of a cv::Mat without copying it
+	 * @param mat The matrix (CV_8U or CV_16U, 1, 3 or 4 channels), whose
+	 * reference counted buffer is kept until the last Image using it is gone.
+	 */
+	static Image adopt(const cv::Mat& mat);
+#endif
+
+	/**
+	 * @brief Return an Image, which uses the buffer of an OpenCV image without owning it
+	 * @param image The OpenCV image (IPL_DEPTH_8U or IPL_DEPTH_16U), which
+	 * must stay valid during the lifetime of the Image.
+	 */
+	static Image wrap(IplImage* image);
+
+	/**
+	 * @brief Load an image file with OpenCV without copying the decoded pixels
+	 * @param filename The name of the file.
+	 * 
+	 * Throws a std::runtime_error, if the file can't be loaded.
+	 */
+	static Image load(const std::string& filename);
+
+	/**
+	 * @brief Create a deep copy of an Image
+	 * @param img The source image, which may wrap a buffer or share it
+	 * 
+	 * The copy has an own buffer from the FramePool of the source.
+	 */
+	Image(const Image& img);
+
+	/**
+	 * @brief Take over the buffer of an Image without copying it
+	 * @param img The source image, which is empty afterwards like Image()
+	 * 
+	 * Doesn't throw, so containers of images move them when they grow.
+	 */
+	Image(Image&& img) noexcept;
 
 	/**
 	 * @brief Destroy an Image object and release the image buffer.
+	 * 
+	 * A shared buffer is released by its last holder.
 	 */
 	virtual ~Image();
 
@@ -81,14 +221,29 @@ public:
 	BitsPerChannel getBitsPerChannel() const;
 
 	/**
-	 * @brief Return a pointer to the internal image buffer
+	 * @brief Return the number of bytes per pixel.
 	 */
-	unsigned char* getImageBuffer() const;
+	int getBytesPerPixel() const;
+
+	/**
+	 * @brief Return a pointer to the internal image buffer for writing
+	 * 
+	 * A shared buffer is detached and the caches of the pixels are dropped,
+	 * like by the non-const operator(). Call discard() before overwriting all
+	 * pixels, and read through a const image, which keeps the buffer shared.
+	 */
+	unsigned char* getImageBuffer();
+
+	/**
+	 * @brief Return a pointer to the internal image buffer for reading
+	 */
+	const unsigned char* getImageBuffer() const;
 
 	/**
 	 * @brief Return a pointer to this image in a form which is compatible with OpenCV
 	 * 
 	 * The memory of the IplImage is released on destruction of this Image Object.
+	 * A shared buffer is detached, since OpenCV may write to it.
 	 */	
 	IplImage* getIplImage();
 
@@ -119,6 +274,37 @@ public:
 	 * @brief Return the number of bytes allocated for this Image.
 	 */
 	int getAllocatedBytes() const;
+
+	/**
+	 * @brief Return the FramePool of the image buffer or NULL for the heap.
+	 */
+	FramePool* getFramePool() const;
+
+	/**
+	 * @brief Return the alignment of the line stride.
+	 */
+	LineAlignment getLineAlignment() const;
+
+	/**
+	 * @brief Change the alignment of the line stride, keeping the pixels.
+	 * 
+	 * Copies the pixels into a new buffer, if the stride changes. The
+	 * IplImage header gets the new stride.
+	 */
+	void setLineAlignment(LineAlignment alignment);
+
+	/**
+	 * @brief Select the line alignment of images created with a size.
+	 * @param alignment The alignment, A4 by default.
+	 * 
+	 * Copies and clones keep the alignment of their source.
+	 */
+	static void setDefaultLineAlignment(LineAlignment alignment);
+
+	/**
+	 * @brief Return the line alignment of images created with a size.
+	 */
+	static LineAlignment getDefaultLineAlignment();
 	
 	/**
 	 * @brief Resize the image buffer of an existing image to the new dimensions
@@ -127,7 +313,8 @@ public:
 	 * 
 	 * Release an existing image buffer and allocate a new image buffer for the 
 	 * given dimensions with appropriate pixel line alignment. The content of the
-	 * new image buffer is undefined.
+	 * new image buffer is undefined. An own buffer of the needed size (or size
+	 * class of the FramePool) is kept instead.
 	 */
 	void resizeMemory(const int newWidth, const int newHeight);
 	
@@ -140,7 +327,9 @@ public:
 	 * This operator doesn't check any bounds, yet. For performance reasons
 	 * this function was declared inline, but still it involves 2
 	 * multiplications. Please do not use this function for sequential pixel 
-	 * access.
+	 * access, use the ImageRows of getRows instead. Use pixel16 for BPC16
+	 * images. A shared buffer is detached, read shared images through a const
+	 * reference.
 	 */
 	unsigned char& operator() (unsigned x, unsigned y, unsigned channel);
 	
@@ -153,22 +342,155 @@ public:
 	 * This operator doesn't check any bounds, yet. For performance reasons
 	 * this function was declared inline, but still it involves 2
 	 * multiplications. Please do not use this function for sequential pixel 
-	 * access.
+	 * access, use the ImageRows of getRows instead. Use pixel16 for BPC16
+	 * images.
 	 */
 	unsigned char operator() (unsigned x, unsigned y, unsigned channel) const;
+
+	/**
+	 * @brief Random Pixel Access for BPC16 images.
+	 * @param x x-coordinate of the pixel starting at 0
+	 * @param y y-coordinate of the pixel starting at 0
+	 * @param channel Select the desired channel (0, 1, 2 or 3)
+	 * 
+	 * Like operator(), but for images with 16 bits per channel. A shared
+	 * buffer is detached.
+	 */
+	unsigned short& pixel16(unsigned x, unsigned y, unsigned channel);
+
+	/**
+	 * @brief Random Pixel Access for BPC16 images.
+	 * @param x x-coordinate of the pixel starting at 0
+	 * @param y y-coordinate of the pixel starting at 0
+	 * @param channel Select the desired channel (0, 1, 2 or 3)
+	 * 
+	 * Like operator(), but for images with 16 bits per channel.
+	 */
+	unsigned short pixel16(unsigned x, unsigned y, unsigned channel) const;
 	
-	/* overload the = operator 
-	 *TODO check the memory!!
+	/**
+	 * @brief Copy the pixels and the format of another image
+	 * 
+	 * Keeps an own buffer, if its size doesn't change, otherwise releases it
+	 * and allocates a new one.
 	 */
-	void operator = (const Image &img);
+	Image& operator = (const Image &img);
 
+	/**
+	 * @brief Release the own buffer and take over the buffer of img
+	 * @param img The source image, which is empty afterwards like Image()
+	 */
+	Image& operator = (Image&& img);
+
+	/**
+	 * @brief Return a deep copy allocated with new
+	 */
 	virtual Image* clone() const;		
+
+	/**
+	 * @brief Return an Image, which shares the buffer of this image
+	 * 
+	 * Both images refer to the same pixels until one of them detaches,
+	 * resizes or is assigned to. The buffer is released by its last holder.
+	 * A buffer of wrap() or the constructor without a Deleter isn't owned by
+	 * the image, so it is copied instead, e.g. the decode buffer of an
+	 * OpenCV capture.
+	 */
+	Image share();
+
+	/**
+	 * @brief Return true, if another Image shares the buffer
+	 * 
+	 * Views of an image don't count, see view().
+	 */
+	bool isShared() const;
+
+	/**
+	 * @brief Give this image an own copy of a shared buffer
+	 * 
+	 * Does nothing, if the buffer isn't shared. The last holder takes the
+	 * buffer back without copying, unless it has views or is a view, which
+	 * keep writing to the same buffer. Drops the PyramidCache and
+	 * IntegralCache of the buffer in this image, and of the viewed image in a
+	 * view, since the pixels are about to change.
+	 * The non-const getImageBuffer() and operator() call it.
+	 */
+	void detach();
+
+	/**
+	 * @brief Like detach(), but without copying the pixels
+	 * 
+	 * A shared buffer is left to the other holders and this image gets a
+	 * new buffer of the same size from its FramePool or the heap, whose
+	 * pixels are undefined. A buffer, which isn't shared, is kept like by
+	 * detach(). Code overwriting all pixels calls discard() instead of
+	 * detach(), so taking a share of a frame doesn't cost a copy.
+	 */
+	void discard();
+
+	/**
+	 * @brief Return the pyramid levels cached for the pixels of this image
+	 * 
+	 * All images sharing the buffer use the same cache. It is dropped by
+	 * detach() and everything calling it, so it is valid until the pixels
+	 * of this image are written or this image is destroyed. Like share(),
+	 * don't call it concurrently on the same Image object.
+	 */
+	PyramidCache& getPyramidCache();
+
+	/**
+	 * @brief Return the integral image cached for the pixels of this image
+	 * 
+	 * Shared and dropped like getPyramidCache().
+	 */
+	IntegralCache& getIntegralCache();
+
+	/**
+	 * @brief Return the capture metadata of this image
+	 */
+	const FrameInfo& getFrameInfo() const;
+
+	/**
+	 * @brief Set the capture metadata of this image
+	 * @param info The metadata, set by the image devices for their frames
+	 */
+	void setFrameInfo(const FrameInfo& info);
+
+	/**
+	 * @brief Return a view of a rectangular region of this image
+	 * @param x The left column of the region
+	 * @param y The upper line of the region
+	 * @param viewWidth The width of the region
+	 * @param viewHeight The height of the region
+	 * 
+	 * The view uses the pixels of the region without copying them, with the
+	 * line stride of this image as its allocated width, and has a matching
+	 * IplImage header. It holds a reference to the buffer like share(), so
+	 * it may outlive this image. Writing to the view writes to this image
+	 * and writing to this image shows in the view, until one of them
+	 * detaches from a buffer shared with other images, is resized or
+	 * assigned to. The view has caches of its own, which writes to this
+	 * image don't drop. Shares of a view are views of the same region, copies,
+	 * clones and assignments of a view copy the pixels of the region. Throws
+	 * a std::runtime_error, if the region exceeds this image.
+	 */
+	Image view(int x, int y, int viewWidth, int viewHeight);
 	
 protected:
 	/** @brief number of allocated bytes in total for this image */
 	int allocatedBytes;
 	/** @brief buffer for this image */
 	unsigned char* imageBuffer;
+	/** @brief false, if imageBuffer belongs to someone else and isn't released */
+	bool ownsBuffer;
+	/** @brief The pool of imageBuffer or NULL, if it is allocated from the heap */
+	FramePool* framePool;
+	/** @brief Size of an own imageBuffer, which may exceed allocatedBytes */
+	size_t bufferBytes;
+	/** @brief Owner and reference count of a shared imageBuffer */
+	struct SharedBuffer;
+	/** @brief The owner of a shared imageBuffer or NULL */
+	SharedBuffer* sharedBuffer;
 	/** @brief allocated width for this Image, usually is aligned to sth */
 	int allocatedWidth;
 	/** @brief allocated height for this Image */
@@ -182,15 +504,84 @@ protected:
 	Channels channels;
 	/** @brief number of bits per channels (default 8) */
 	BitsPerChannel bitsPerChannel;
-	/** @brief Alignment of image lines (default 4) */
+	/** @brief Alignment of image lines (default getDefaultLineAlignment) */
 	LineAlignment lineAlignment;
+	/** @brief Capture metadata of the frame */
+	FrameInfo frameInfo;
 	/** @brief For compatibility provide an OpenCV Header */
 	IplImage* opencvHeader;
+	/** @brief The alignment selected by setDefaultLineAlignment */
+	static LineAlignment defaultLineAlignment;
 	
 	/** @brief Updates the internal opencvHeader attribute */
 	void updateOpencvHeader();
+
+	/** @brief Release the imageBuffer, if owned by this image */
+	void releaseBuffer();
+
+	/**
+	 * @brief Provide an own imageBuffer of allocatedBytes, keeping the current
+	 * one if it has the same size.
+	 */
+	void allocateBuffer();
+
+	/**
+	 * @brief Copy the pixels of img, which has the same format, line by line,
+	 * if the line padding differs.
+	 */
+	void copyPixels(const Image& img);
+
+	/**
+	 * @brief Copy the pixels into a new own buffer with the layout of the
+	 * line alignment and release the current one.
+	 * 
+	 * The opencvHeader is kept and points to the new buffer afterwards.
+	 */
+	void copyToOwnBuffer();
+
+	/** @brief Take over the buffer and the format of img and make img empty */
+	void moveFrom(Image& img);
+
+	/** @brief Hand the buffer to a SharedBuffer, if it hasn't one yet */
+	void shareBuffer();
+
+	/**
+	 * @brief Compute allocatedWidth, allocatedHeight and allocatedBytes for
+	 * the current dimensions, channels, bits per channel and line alignment.
+	 */
+	void updateAllocatedSize();
 };
 
+inline unsigned char& Image::operator() (unsigned x, unsigned y, unsigned channel)
+{
+	if (sharedBuffer != NULL)
+	{
+		detach();
+	}
+	// TODO check bounds, if wanted?
+	return imageBuffer[(y * this->allocatedWidth) + (x * this->channels) + channel];
+}
+
+inline unsigned char Image::operator() (unsigned x, unsigned y, unsigned channel) const
+{
+	// TODO check bounds, if wanted?
+	return imageBuffer[(y * this->allocatedWidth) + (x * this->channels) + channel];
+}
+
+inline unsigned short& Image::pixel16(unsigned x, unsigned y, unsigned channel)
+{
+	if (sharedBuffer != NULL)
+	{
+		detach();
+	}
+	return ((unsigned short*) (imageBuffer + y * this->allocatedWidth))[x * this->channels + channel];
+}
+
+inline unsigned short Image::pixel16(unsigned x, unsigned y, unsigned channel) const
+{
+	return ((const unsigned short*) (imageBuffer + y * this->allocatedWidth))[x * this->channels + channel];
+}
+
 } // namespace ds
 
 } // namespace tt
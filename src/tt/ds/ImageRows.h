@@ -0,0 +1,394 @@
+#ifndef TT_DS_IMAGEROWS_H
+#define TT_DS_IMAGEROWS_H
+
+#include <assert.h>
+#include <tt/ds/Image.h>
+
+namespace tt
+{
+
+namespace ds
+{
+
+/**
+ * @brief Channel type of the pixels of an Image with B bits per channel.
+ */
+template <Image::BitsPerChannel B>
+struct ChannelType;
+
+template <>
+struct ChannelType<Image::BPC8>
+{
+	typedef unsigned char Type;
+};
+
+template <>
+struct ChannelType<Image::BPC16>
+{
+	typedef unsigned short Type;
+};
+
+/**
+ * @brief Byte type with the constness of the channel type T, for stepping
+ * by the line stride.
+ */
+template <typename T>
+struct ByteType
+{
+	typedef unsigned char Type;
+};
+
+template <typename T>
+struct ByteType<const T>
+{
+	typedef const unsigned char Type;
+};
+
+/**
+ * @class PixelIterator ImageRows.h tt/ds/ImageRows.h
+ * @brief Iterator over the pixels of one line with C channels of type T.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Incrementing adds C to a pointer, the channels of the current pixel are
+ * accessed with operator[]. T is const for read only access.
+ */
+template <int C, typename T>
+class PixelIterator
+{
+public:
+	/**
+	 * @brief Point to the pixel starting at the given channel.
+	 */
+	explicit PixelIterator(T* pixel) : pixel(pixel)
+	{
+	}
+
+	/**
+	 * @brief Return channel c of the current pixel.
+	 */
+	T& operator[] (int c) const
+	{
+		return pixel[c];
+	}
+
+	/**
+	 * @brief Return the first channel of the current pixel.
+	 */
+	T* operator* () const
+	{
+		return pixel;
+	}
+
+	PixelIterator& operator++ ()
+	{
+		pixel += C;
+		return *this;
+	}
+
+	PixelIterator operator++ (int)
+	{
+		PixelIterator previous = *this;
+		pixel += C;
+		return previous;
+	}
+
+	PixelIterator& operator+= (int pixels)
+	{
+		pixel += pixels * C;
+		return *this;
+	}
+
+	bool operator== (const PixelIterator& other) const
+	{
+		return pixel == other.pixel;
+	}
+
+	bool operator!= (const PixelIterator& other) const
+	{
+		return pixel != other.pixel;
+	}
+
+	bool operator< (const PixelIterator& other) const
+	{
+		return pixel < other.pixel;
+	}
+
+private:
+	/** @brief First channel of the current pixel */
+	T* pixel;
+};
+
+/**
+ * @class ImageRow ImageRows.h tt/ds/ImageRows.h
+ * @brief One line of an Image with C channels of type T.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+template <int C, typename T>
+class ImageRow
+{
+public:
+	/**
+	 * @brief Create a line of width pixels starting at first.
+	 */
+	ImageRow(T* first, int width) : first(first), width(width)
+	{
+	}
+
+	/**
+	 * @brief Return the first channel of pixel x.
+	 */
+	T* operator[] (int x) const
+	{
+		return first + x * C;
+	}
+
+	/**
+	 * @brief Return channel c of pixel x.
+	 */
+	T& operator() (int x, int c) const
+	{
+		return first[x * C + c];
+	}
+
+	/**
+	 * @brief Return an iterator to the first pixel.
+	 */
+	PixelIterator<C, T> begin() const
+	{
+		return PixelIterator<C, T>(first);
+	}
+
+	/**
+	 * @brief Return an iterator behind the last pixel.
+	 */
+	PixelIterator<C, T> end() const
+	{
+		return PixelIterator<C, T>(first + width * C);
+	}
+
+	/**
+	 * @brief Return the first channel of the first pixel.
+	 */
+	T* getData() const
+	{
+		return first;
+	}
+
+	/**
+	 * @brief Return the number of pixels.
+	 */
+	int getWidth() const
+	{
+		return width;
+	}
+
+private:
+	/** @brief First channel of the first pixel */
+	T* first;
+	/** @brief Number of pixels */
+	int width;
+};
+
+/**
+ * @class RowIterator ImageRows.h tt/ds/ImageRows.h
+ * @brief Iterator over the lines of an Image.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Incrementing adds the line stride of the image to a pointer.
+ */
+template <int C, typename T>
+class RowIterator
+{
+public:
+	/**
+	 * @brief Point to the line starting at first.
+	 * @param first First channel of the first pixel of the line.
+	 * @param stride Bytes from one line to the next.
+	 * @param width Number of pixels per line.
+	 */
+	RowIterator(T* first, int stride, int width) :
+		first(first),
+		stride(stride),
+		width(width)
+	{
+	}
+
+	ImageRow<C, T> operator* () const
+	{
+		return ImageRow<C, T>(first, width);
+	}
+
+	RowIterator& operator++ ()
+	{
+		first = (T*) ((Byte*) first + stride);
+		return *this;
+	}
+
+	RowIterator operator++ (int)
+	{
+		RowIterator previous = *this;
+		++*this;
+		return previous;
+	}
+
+	bool operator== (const RowIterator& other) const
+	{
+		return first == other.first;
+	}
+
+	bool operator!= (const RowIterator& other) const
+	{
+		return first != other.first;
+	}
+
+private:
+	/** @brief Bytes with the constness of T */
+	typedef typename ByteType<T>::Type Byte;
+
+	/** @brief First channel of the first pixel of the current line */
+	T* first;
+	/** @brief Bytes from one line to the next */
+	int stride;
+	/** @brief Number of pixels per line */
+	int width;
+};
+
+/**
+ * @class ImageRows ImageRows.h tt/ds/ImageRows.h
+ * @brief The lines of an Image with C channels of type T.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * ImageRows replaces the index computation of Image::operator() in
+ * sequential loops by pointer increments. Get it with getRows:
+ *
+ * @code
+ * ImageRows<3, unsigned char> rows = getRows<Image::RGB, Image::BPC8>(image);
+ * for (RowIterator<3, unsigned char> row = rows.begin(); row != rows.end(); ++row)
+ * {
+ *     ImageRow<3, unsigned char> line = *row;
+ *     for (PixelIterator<3, unsigned char> p = line.begin(); p != line.end(); ++p)
+ *     {
+ *         p[0] = 255 - p[0];
+ *     }
+ * }
+ * @endcode
+ *
+ * Everything is inline, so an optimizing compiler generates the same code
+ * as for hand written pointer loops. The rows are valid until the image is
+ * resized, assigned to or destroyed.
+ */
+template <int C, typename T>
+class ImageRows
+{
+public:
+	/**
+	 * @brief Create the lines of an image.
+	 * @param first First channel of the first pixel.
+	 * @param stride Bytes from one line to the next.
+	 * @param width Number of pixels per line.
+	 * @param height Number of lines.
+	 */
+	ImageRows(T* first, int stride, int width, int height) :
+		first(first),
+		stride(stride),
+		width(width),
+		height(height)
+	{
+	}
+
+	/**
+	 * @brief Return line y.
+	 */
+	ImageRow<C, T> operator[] (int y) const
+	{
+		return ImageRow<C, T>((T*) ((Byte*) first + y * stride), width);
+	}
+
+	/**
+	 * @brief Return an iterator to the first line.
+	 */
+	RowIterator<C, T> begin() const
+	{
+		return RowIterator<C, T>(first, stride, width);
+	}
+
+	/**
+	 * @brief Return an iterator behind the last line.
+	 */
+	RowIterator<C, T> end() const
+	{
+		return RowIterator<C, T>((T*) ((Byte*) first + height * stride), stride, width);
+	}
+
+	/**
+	 * @brief Return the number of pixels per line.
+	 */
+	int getWidth() const
+	{
+		return width;
+	}
+
+	/**
+	 * @brief Return the number of lines.
+	 */
+	int getHeight() const
+	{
+		return height;
+	}
+
+private:
+	/** @brief Bytes with the constness of T */
+	typedef typename ByteType<T>::Type Byte;
+
+	/** @brief First channel of the first pixel */
+	T* first;
+	/** @brief Bytes from one line to the next */
+	int stride;
+	/** @brief Number of pixels per line */
+	int width;
+	/** @brief Number of lines */
+	int height;
+};
+
+/**
+ * @brief Return the lines of an image for writing.
+ * @param C The channels of the image.
+ * @param B The bits per channel of the image.
+ *
+ * A shared buffer is detached. The format of the image must match C and B.
+ */
+template <Image::Channels C, Image::BitsPerChannel B>
+inline ImageRows<C, typename ChannelType<B>::Type> getRows(Image& image)
+{
+	assert(image.getChannels() == C);
+	assert(image.getBitsPerChannel() == B);
+
+	// the non-const buffer accessor detaches
+	return ImageRows<C, typename ChannelType<B>::Type>(
+		(typename ChannelType<B>::Type*) image.getImageBuffer(),
+		image.getAllocatedWidth(), image.getWidth(), image.getHeight());
+}
+
+/**
+ * @brief Return the lines of an image for reading.
+ * @param C The channels of the image.
+ * @param B The bits per channel of the image.
+ *
+ * The format of the image must match C and B.
+ */
+template <Image::Channels C, Image::BitsPerChannel B>
+inline ImageRows<C, const typename ChannelType<B>::Type> getRows(const Image& image)
+{
+	assert(image.getChannels() == C);
+	assert(image.getBitsPerChannel() == B);
+
+	return ImageRows<C, const typename ChannelType<B>::Type>(
+		(const typename ChannelType<B>::Type*) image.getImageBuffer(),
+		image.getAllocatedWidth(), image.getWidth(), image.getHeight());
+}
+
+} // namespace ds
+
+} // namespace tt
+
+#endif /*TT_DS_IMAGEROWS_H*/
@@ -0,0 +1,39 @@
+/*
+ * IntegralCache
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include "IntegralCache.h"
+
+namespace tt
+{
+
+namespace ds
+{
+
+IntegralCache::IntegralCache()
+{
+}
+
+IntegralCache::~IntegralCache()
+{
+}
+
+std::shared_ptr<const IntegralImage> IntegralCache::get(const Image& base, bool squares,
+	Compute compute)
+{
+	// readers wait for the first one to compute the table
+	std::lock_guard<std::mutex> lock(mutex);
+	if (integral == NULL || (squares && !integral->hasSquares()))
+	{
+		std::shared_ptr<IntegralImage> computed(
+			new IntegralImage(base.getWidth(), base.getHeight(), squares));
+		compute(&base, computed.get());
+		integral = computed;
+	}
+	return integral;
+}
+
+} // namespace ds
+
+} // namespace tt
@@ -0,0 +1,72 @@
+#ifndef TT_DS_INTEGRALCACHE_H
+#define TT_DS_INTEGRALCACHE_H
+
+#include <memory>
+#include <mutex>
+#include <tt/ds/Image.h>
+#include <tt/ds/IntegralImage.h>
+
+namespace tt
+{
+
+namespace ds
+{
+
+/**
+ * @class IntegralCache IntegralCache.h tt/ds/IntegralCache.h
+ * @brief The lazily computed IntegralImage of a frame.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Image::getIntegralCache() returns the cache of the buffer of an image,
+ * which is shared and dropped like the PyramidCache. The first reader
+ * computes the table, the others wait for it and get the same table. Use
+ * tt::process::Integral::get to read it.
+ */
+class IntegralCache
+{
+public:
+	/**
+	 * @brief Computes the table of an image.
+	 * @param source The image.
+	 * @param destination The table of the size of the image.
+	 */
+	typedef void (*Compute)(const Image* source, IntegralImage* destination);
+
+	/**
+	 * @brief Create an empty cache.
+	 */
+	IntegralCache();
+
+	/**
+	 * @brief Release the table, unless a reader still holds it.
+	 */
+	virtual ~IntegralCache();
+
+	/**
+	 * @brief Return the table of an image.
+	 * @param base The image the cache belongs to.
+	 * @param squares True, if the table needs sums of squares.
+	 * @param compute The function computing a missing table.
+	 *
+	 * A table without squares is computed again, when squares are asked
+	 * for. The table stays valid, while it is held. Thread safe.
+	 */
+	std::shared_ptr<const IntegralImage> get(const Image& base, bool squares,
+		Compute compute);
+
+private:
+	/** @brief Protects the table */
+	std::mutex mutex;
+	/** @brief The computed table or NULL */
+	std::shared_ptr<const IntegralImage> integral;
+
+	// an IntegralCache owns its table and can't be copied
+	IntegralCache(const IntegralCache&);
+	IntegralCache& operator = (const IntegralCache&);
+};
+
+} // namespace ds
+
+} // namespace tt
+
+#endif /*TT_DS_INTEGRALCACHE_H*/
@@ -0,0 +1,32 @@
+/*
+ * IntegralImage
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <cstddef>
+#include "IntegralImage.h"
+
+namespace tt
+{
+
+namespace ds
+{
+
+IntegralImage::IntegralImage(int width, int height, bool squares) :
+	width(width),
+	height(height),
+	sums((std::size_t) (width + 1) * (height + 1), 0)
+{
+	if (squares)
+	{
+		this->squares.assign((std::size_t) (width + 1) * (height + 1), 0);
+	}
+}
+
+IntegralImage::~IntegralImage()
+{
+}
+
+} // namespace ds
+
+} // namespace tt
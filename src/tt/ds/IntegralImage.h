@@ -0,0 +1,145 @@
+#ifndef TT_DS_INTEGRALIMAGE_H
+#define TT_DS_INTEGRALIMAGE_H
+
+#include <vector>
+
+namespace tt
+{
+
+namespace ds
+{
+
+/**
+ * @class IntegralImage IntegralImage.h tt/ds/IntegralImage.h
+ * @brief Summed area table of a greyscale image.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Entry (x, y) holds the sum of all pixels above and left of pixel (x, y),
+ * so the sum of any rectangle is computed from 4 entries. The table has one
+ * more column and line than the image, the first ones are 0. Sums are 32
+ * bit and may wrap around on large images, rectangle sums are still exact
+ * for rectangles of up to 16843009 pixels. Sums of squares, which are
+ * needed for the variance, are optional and 64 bit. Compute the table with
+ * tt::process::Integral.
+ */
+class IntegralImage
+{
+public:
+	/**
+	 * @brief Create a table for an image, initialized to 0.
+	 * @param width Width of the image
+	 * @param height Height of the image
+	 * @param squares True to keep the sums of squares as well
+	 */
+	IntegralImage(int width, int height, bool squares = false);
+
+	/**
+	 * @brief Release the table.
+	 */
+	virtual ~IntegralImage();
+
+	/**
+	 * @brief Return the width of the image.
+	 */
+	int getWidth() const
+	{
+		return width;
+	}
+
+	/**
+	 * @brief Return the height of the image.
+	 */
+	int getHeight() const
+	{
+		return height;
+	}
+
+	/**
+	 * @brief Return true, if the table has sums of squares.
+	 */
+	bool hasSquares() const
+	{
+		return !squares.empty();
+	}
+
+	/**
+	 * @brief Return the line y of the sums, getWidth() + 1 entries.
+	 * @param y The line from 0 to getHeight().
+	 */
+	unsigned int* getSums(int y)
+	{
+		return &sums[y * (width + 1)];
+	}
+
+	/**
+	 * @brief Return the line y of the sums, getWidth() + 1 entries.
+	 * @param y The line from 0 to getHeight().
+	 */
+	const unsigned int* getSums(int y) const
+	{
+		return &sums[y * (width + 1)];
+	}
+
+	/**
+	 * @brief Return the line y of the sums of squares, getWidth() + 1 entries.
+	 * @param y The line from 0 to getHeight().
+	 */
+	unsigned long long* getSquares(int y)
+	{
+		return &squares[y * (width + 1)];
+	}
+
+	/**
+	 * @brief Return the line y of the sums of squares, getWidth() + 1 entries.
+	 * @param y The line from 0 to getHeight().
+	 */
+	const unsigned long long* getSquares(int y) const
+	{
+		return &squares[y * (width + 1)];
+	}
+
+	/**
+	 * @brief Return the sum of the pixels of a rectangle.
+	 * @param x The left column of the rectangle
+	 * @param y The upper line of the rectangle
+	 * @param w The width of the rectangle
+	 * @param h The height of the rectangle
+	 *
+	 * The rectangle must be within the image.
+	 */
+	unsigned int getSum(int x, int y, int w, int h) const
+	{
+		const unsigned int* top = getSums(y);
+		const unsigned int* bottom = getSums(y + h);
+		// the unsigned arithmetic undoes wrapped sums
+		return bottom[x + w] - bottom[x] - top[x + w] + top[x];
+	}
+
+	/**
+	 * @brief Return the sum of the squares of the pixels of a rectangle.
+	 *
+	 * The rectangle must be within the image, the table must have squares.
+	 */
+	unsigned long long getSquareSum(int x, int y, int w, int h) const
+	{
+		const unsigned long long* top = getSquares(y);
+		const unsigned long long* bottom = getSquares(y + h);
+		return bottom[x + w] - bottom[x] - top[x + w] + top[x];
+	}
+
+private:
+	/** @brief Width of the image */
+	int width;
+	/** @brief Height of the image */
+	int height;
+	/** @brief The sums, (width + 1) * (height + 1) entries */
+	std::vector<unsigned int> sums;
+	/** @brief The sums of squares or empty */
+	std::vector<unsigned long long> squares;
+};
+
+} // namespace ds
+
+} // namespace tt
+
+#endif /*TT_DS_INTEGRALIMAGE_H*/
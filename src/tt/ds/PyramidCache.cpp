@@ -0,0 +1,81 @@
+/*
+ * PyramidCache
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <stdexcept>
+#include <string>
+#include "PyramidCache.h"
+
+namespace tt
+{
+
+namespace ds
+{
+
+PyramidCache::PyramidCache() :
+	reduce(NULL)
+{
+}
+
+PyramidCache::~PyramidCache()
+{
+	clear();
+}
+
+Image PyramidCache::getLevel(const Image& base, int level, Reduce reduce)
+{
+	std::string functionSignature = "Image PyramidCache::getLevel(const Image& base, "
+		"int level, Reduce reduce)";
+
+	if (level < 1)
+	{
+		throw std::runtime_error(functionSignature + " level out of range.");
+	}
+
+	// readers of the same level wait for the first one to compute it
+	std::lock_guard<std::mutex> lock(mutex);
+	if (reduce != this->reduce)
+	{
+		clear();
+		this->reduce = reduce;
+	}
+
+	while ((int) levels.size() < level)
+	{
+		const Image* source = levels.empty() ? &base : levels.back();
+		Image* destination = new Image((source->getWidth() + 1) / 2,
+			(source->getHeight() + 1) / 2, source->getChannels(),
+			source->getBitsPerChannel(), base.getFramePool());
+		try
+		{
+			reduce(source, destination);
+		}
+		catch (...)
+		{
+			delete destination;
+			throw;
+		}
+		levels.push_back(destination);
+	}
+	return levels[level - 1]->share();
+}
+
+int PyramidCache::getLevels() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return (int) levels.size();
+}
+
+void PyramidCache::clear()
+{
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		delete levels[i];
+	}
+	levels.clear();
+}
+
+} // namespace ds
+
+} // namespace tt
@@ -0,0 +1,86 @@
+#ifndef TT_DS_PYRAMIDCACHE_H
+#define TT_DS_PYRAMIDCACHE_H
+
+#include <mutex>
+#include <vector>
+#include <tt/ds/Image.h>
+
+namespace tt
+{
+
+namespace ds
+{
+
+/**
+ * @class PyramidCache PyramidCache.h tt/ds/PyramidCache.h
+ * @brief The lazily computed levels of the image pyramid of a frame.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Image::getPyramidCache() returns the cache of the buffer of an image. All
+ * images sharing the buffer see the same cache, so each level is computed
+ * once by the first reader asking for it, the others wait for it and get
+ * the same pixels. Writing to the buffer through a non-const accessor,
+ * detach() or discard() drops the cache, the next request computes the
+ * levels of the new pixels. Use tt::process::Pyramid::getLevel to read the levels.
+ *
+ * Level n has half the width and height of level n - 1, rounded up. Level
+ * 0 is the image itself and isn't stored.
+ */
+class PyramidCache
+{
+public:
+	/**
+	 * @brief Computes a level from the previous one.
+	 * @param source The previous level.
+	 * @param destination The next level, allocated with the channels and
+	 * bits per channel of the source and half its size, rounded up.
+	 */
+	typedef void (*Reduce)(const Image* source, Image* destination);
+
+	/**
+	 * @brief Create an empty cache.
+	 */
+	PyramidCache();
+
+	/**
+	 * @brief Release the computed levels.
+	 */
+	virtual ~PyramidCache();
+
+	/**
+	 * @brief Return a level, which shares the buffer of the cached level.
+	 * @param base The image the cache belongs to.
+	 * @param level The level, at least 1.
+	 * @param reduce The function computing the missing levels. Levels of
+	 * another function are dropped and computed again.
+	 *
+	 * Thread safe. Throws a std::runtime_error, if the level is below 1.
+	 */
+	Image getLevel(const Image& base, int level, Reduce reduce);
+
+	/**
+	 * @brief Return the number of computed levels.
+	 */
+	int getLevels() const;
+
+private:
+	/** @brief Protects the state below */
+	mutable std::mutex mutex;
+	/** @brief The computed levels starting with level 1 */
+	std::vector<Image*> levels;
+	/** @brief The function, which computed the levels */
+	Reduce reduce;
+
+	/** @brief Release the computed levels, mutex must be locked */
+	void clear();
+
+	// a PyramidCache owns its levels and can't be copied
+	PyramidCache(const PyramidCache&);
+	PyramidCache& operator = (const PyramidCache&);
+};
+
+} // namespace ds
+
+} // namespace tt
+
+#endif /*TT_DS_PYRAMIDCACHE_H*/
@@ -0,0 +1,264 @@
+#ifndef TT_DS_TYPEDIMAGE_H
+#define TT_DS_TYPEDIMAGE_H
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <tt/ds/Image.h>
+#include <tt/ds/ImageRows.h>
+
+namespace tt
+{
+
+namespace ds
+{
+
+/**
+ * @brief Base of the pixel formats of TypedImage.
+ * @param C The channels of the format.
+ * @param B The bits per channel of the format.
+ */
+template <Image::Channels C, Image::BitsPerChannel B>
+struct PixelFormat
+{
+	/** @brief Channels of an Image in this format */
+	static const Image::Channels CHANNELS = C;
+	/** @brief Bits per channel of an Image in this format */
+	static const Image::BitsPerChannel BITS_PER_CHANNEL = B;
+	/** @brief Type of one channel of a pixel */
+	typedef typename ChannelType<B>::Type Channel;
+};
+
+/** @brief 8 bit greyscale */
+struct Gray8 : PixelFormat<Image::GREYSCALE, Image::BPC8>
+{
+};
+
+/** @brief 8 bit red, green, blue */
+struct Rgb8 : PixelFormat<Image::RGB, Image::BPC8>
+{
+};
+
+/** @brief 8 bit blue, green, red, the channel order of OpenCV */
+struct Bgr8 : PixelFormat<Image::RGB, Image::BPC8>
+{
+};
+
+/** @brief 8 bit red, green, blue, alpha */
+struct Rgba8 : PixelFormat<Image::RGBA, Image::BPC8>
+{
+};
+
+/**
+ * @brief 8 bit raw Bayer pattern
+ * @param P The color filter array, a tt::process::Bayer::Pattern.
+ */
+template <int P>
+struct Bayer8 : PixelFormat<Image::GREYSCALE, Image::BPC8>
+{
+	/** @brief The color filter array */
+	static const int PATTERN = P;
+};
+
+/** @brief 16 bit greyscale */
+struct Gray16 : PixelFormat<Image::GREYSCALE, Image::BPC16>
+{
+	/** @brief The format with 8 bits per channel */
+	typedef Gray8 Format8;
+};
+
+/** @brief 16 bit red, green, blue */
+struct Rgb16 : PixelFormat<Image::RGB, Image::BPC16>
+{
+	/** @brief The format with 8 bits per channel */
+	typedef Rgb8 Format8;
+};
+
+/** @brief 16 bit blue, green, red */
+struct Bgr16 : PixelFormat<Image::RGB, Image::BPC16>
+{
+	/** @brief The format with 8 bits per channel */
+	typedef Bgr8 Format8;
+};
+
+/**
+ * @brief 16 bit raw Bayer pattern
+ * @param P The color filter array, a tt::process::Bayer::Pattern.
+ */
+template <int P>
+struct Bayer16 : PixelFormat<Image::GREYSCALE, Image::BPC16>
+{
+	/** @brief The color filter array */
+	static const int PATTERN = P;
+	/** @brief The format with 8 bits per channel */
+	typedef Bayer8<P> Format8;
+};
+
+/**
+ * @class TypedImage TypedImage.h tt/ds/TypedImage.h
+ * @brief Image with a pixel format fixed at compile time.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * An Image carries its channels and bits per channel at runtime, so every
+ * processing function has to check them. A TypedImage<F> holds an Image,
+ * whose format is always the one of F, for example TypedImage<Gray8> or
+ * TypedImage<Bayer8<Bayer::PATTERN_BG> >. Functions taking a TypedImage
+ * are selected by the format at compile time, a wrong format doesn't
+ * compile, and formats with equal channels like Rgb8 and Bgr8 or the Bayer
+ * patterns are told apart.
+ *
+ * Converting is cheap in both directions. A TypedImage is created by moving
+ * an Image into it or by sharing the buffer of an Image, which checks the
+ * format once. getImage() returns the held Image for all functions taking
+ * an Image. Resizing it keeps the format, changing its channels or bits per
+ * channel through getImage() is not allowed.
+ */
+template <typename F>
+class TypedImage
+{
+public:
+	/** @brief The pixel format */
+	typedef F Format;
+	/** @brief Type of one channel of a pixel */
+	typedef typename F::Channel Channel;
+
+	/**
+	 * @brief Create an image with an uninitialized buffer.
+	 * @param width Width of the image
+	 * @param height Height of the image
+	 * @param pool The pool of the buffer or NULL for the heap
+	 */
+	TypedImage(int width, int height, FramePool* pool = NULL) :
+		image(width, height, F::CHANNELS, F::BITS_PER_CHANNEL, pool)
+	{
+	}
+
+	/**
+	 * @brief Take over an Image without copying its buffer.
+	 * @param image The source image, which is empty afterwards.
+	 *
+	 * Throws a std::runtime_error and leaves the image as it is, if its format
+	 * doesn't match.
+	 */
+	explicit TypedImage(Image&& image) :
+		image(std::move(checked(image, "TypedImage<F>::TypedImage(Image&& image)")))
+	{
+	}
+
+	/**
+	 * @brief Share the buffer of an Image without copying it.
+	 * @param image The source image, see Image::share().
+	 *
+	 * Throws a std::runtime_error, if the format of the image doesn't match.
+	 */
+	explicit TypedImage(Image& image) :
+		image(checked(image, "TypedImage<F>::TypedImage(Image& image)").share())
+	{
+	}
+
+	/**
+	 * @brief Return true, if an Image has the format F.
+	 */
+	static bool matches(const Image& image)
+	{
+		return image.getChannels() == F::CHANNELS
+			&& image.getBitsPerChannel() == F::BITS_PER_CHANNEL;
+	}
+
+	/**
+	 * @brief Return the held Image.
+	 */
+	Image& getImage()
+	{
+		return image;
+	}
+
+	/**
+	 * @brief Return the held Image.
+	 */
+	const Image& getImage() const
+	{
+		return image;
+	}
+
+	/**
+	 * @brief Return the width of the image.
+	 */
+	int getWidth() const
+	{
+		return image.getWidth();
+	}
+
+	/**
+	 * @brief Return the height of the image.
+	 */
+	int getHeight() const
+	{
+		return image.getHeight();
+	}
+
+	/**
+	 * @brief Random Pixel Access
+	 *
+	 * Like Image::operator() and Image::pixel16, with the number of channels
+	 * known to the compiler. A shared buffer is detached.
+	 */
+	Channel& operator() (int x, int y, int channel)
+	{
+		// the non-const Image accessor detaches and points to the line
+		return ((Channel*) &image(0, y, 0))[x * F::CHANNELS + channel];
+	}
+
+	/**
+	 * @brief Random Pixel Access
+	 */
+	Channel operator() (int x, int y, int channel) const
+	{
+		return ((const Channel*) (image.getImageBuffer() + y * image.getAllocatedWidth()))
+			[x * F::CHANNELS + channel];
+	}
+
+	/**
+	 * @brief Return the lines of the image for writing, see getRows.
+	 */
+	ImageRows<F::CHANNELS, Channel> getRows()
+	{
+		return tt::ds::getRows<F::CHANNELS, F::BITS_PER_CHANNEL>(image);
+	}
+
+	/**
+	 * @brief Return the lines of the image for reading, see getRows.
+	 */
+	ImageRows<F::CHANNELS, const Channel> getRows() const
+	{
+		return tt::ds::getRows<F::CHANNELS, F::BITS_PER_CHANNEL>(image);
+	}
+
+	/**
+	 * @brief Return a TypedImage, which shares the buffer of this image
+	 */
+	TypedImage share()
+	{
+		return TypedImage(image);
+	}
+
+private:
+	/** @brief The image, always in the format F */
+	Image image;
+
+	/** @brief Return image or throw a std::runtime_error, if it doesn't have the format F */
+	static Image& checked(Image& image, const std::string& functionSignature)
+	{
+		if (!matches(image))
+		{
+			throw std::runtime_error(functionSignature + " image has the wrong pixel format.");
+		}
+		return image;
+	}
+};
+
+} // namespace ds
+
+} // namespace tt
+
+#endif /*TT_DS_TYPEDIMAGE_H*/
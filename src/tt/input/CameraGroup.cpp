@@ -0,0 +1,513 @@
+/*
+ * CameraGroup
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <stdexcept>
+#include <string>
+#include "CameraGroup.h"
+
+namespace tt
+{
+
+namespace input
+{
+
+CameraGroup::FrameSet::FrameSet()
+{
+}
+
+CameraGroup::FrameSet::~FrameSet()
+{
+	clear();
+}
+
+int CameraGroup::FrameSet::getSize() const
+{
+	return (int) frames.size();
+}
+
+const CameraGroup::Frame& CameraGroup::FrameSet::getFrame(int camera) const
+{
+	return frames.at(camera);
+}
+
+tt::ds::Image* CameraGroup::FrameSet::getImage(int camera) const
+{
+	return frames.at(camera).image;
+}
+
+long long CameraGroup::FrameSet::getSkew() const
+{
+	if (frames.empty())
+	{
+		return 0;
+	}
+
+	std::chrono::steady_clock::time_point oldest = frames[0].timestamp;
+	std::chrono::steady_clock::time_point newest = frames[0].timestamp;
+	for (size_t i = 1; i < frames.size(); i++)
+	{
+		if (frames[i].timestamp < oldest)
+		{
+			oldest = frames[i].timestamp;
+		}
+		if (frames[i].timestamp > newest)
+		{
+			newest = frames[i].timestamp;
+		}
+	}
+	return std::chrono::duration_cast<std::chrono::microseconds>(newest - oldest).count();
+}
+
+void CameraGroup::FrameSet::clear()
+{
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		delete frames[i].image;
+	}
+	frames.clear();
+}
+
+CameraGroup::CameraGroup() :
+	tolerance(5000),
+	stopping(false),
+	capturing(false),
+	frameSets(0)
+{
+}
+
+CameraGroup::~CameraGroup()
+{
+	if (capturing)
+	{
+		stopping = true;
+		for (size_t i = 0; i < cameras.size(); i++)
+		{
+			cameras[i]->thread.join();
+		}
+		deleteFrames();
+
+		// like captureStop, but a destructor mustn't throw
+		for (size_t i = 0; i < cameras.size(); i++)
+		{
+			try
+			{
+				cameras[i]->camera->captureStop();
+			}
+			catch (...)
+			{
+			}
+		}
+	}
+
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		delete cameras[i];
+	}
+}
+
+void CameraGroup::addCamera(FirewireCamera* camera)
+{
+	std::string functionSignature = "void CameraGroup::addCamera(FirewireCamera* camera)";
+
+	if (capturing)
+	{
+		throw std::runtime_error(functionSignature + " the group is capturing.");
+	}
+
+	CameraState* state = new CameraState();
+	state->camera = camera;
+	state->frames = NULL;
+	state->hasHead = false;
+	state->failed = false;
+	state->capturedFrames = 0;
+	state->droppedFrames = 0;
+	state->unmatchedFrames = 0;
+	state->skew = 0;
+	state->maxSkew = 0;
+	cameras.push_back(state);
+}
+
+int CameraGroup::getCameras() const
+{
+	return (int) cameras.size();
+}
+
+FirewireCamera* CameraGroup::getCamera(int camera) const
+{
+	std::string functionSignature = "FirewireCamera* CameraGroup::getCamera(int camera) const";
+
+	return getState(functionSignature, camera)->camera;
+}
+
+void CameraGroup::openCamera(FirewireCamera* camera, std::exception_ptr* error)
+{
+	try
+	{
+		camera->open();
+	}
+	catch (...)
+	{
+		*error = std::current_exception();
+	}
+}
+
+void CameraGroup::open()
+{
+	// scanning the bus and initializing takes a while per camera
+	std::vector<std::exception_ptr> errors(cameras.size());
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		threads.push_back(std::thread(&CameraGroup::openCamera, cameras[i]->camera, &errors[i]));
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+
+	for (size_t i = 0; i < errors.size(); i++)
+	{
+		if (errors[i])
+		{
+			std::rethrow_exception(errors[i]);
+		}
+	}
+}
+
+void CameraGroup::close()
+{
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		cameras[i]->camera->close();
+	}
+}
+
+void CameraGroup::captureStart(int queueSize)
+{
+	std::string functionSignature = "void CameraGroup::captureStart(int queueSize)";
+
+	if (capturing)
+	{
+		throw std::runtime_error(functionSignature + " already in capture mode.");
+	}
+	if (queueSize < 1)
+	{
+		throw std::runtime_error(functionSignature + " queue size must be at least 1.");
+	}
+	if (cameras.empty())
+	{
+		throw std::runtime_error(functionSignature + " the group has no cameras.");
+	}
+
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		try
+		{
+			cameras[i]->camera->captureStart();
+		}
+		catch (...)
+		{
+			// the group doesn't capture, so the cameras started before don't either
+			for (size_t j = 0; j < i; j++)
+			{
+				try
+				{
+					cameras[j]->camera->captureStop();
+				}
+				catch (...)
+				{
+				}
+			}
+			throw;
+		}
+	}
+
+	stopping = false;
+	frameSets = 0;
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		CameraState* state = cameras[i];
+		state->frames = new tt::sys::SPSCQueue<Frame>(queueSize);
+		state->hasHead = false;
+		state->error = std::exception_ptr();
+		state->failed = false;
+		state->capturedFrames = 0;
+		state->droppedFrames = 0;
+		state->unmatchedFrames = 0;
+		state->skew = 0;
+		state->maxSkew = 0;
+	}
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		cameras[i]->thread = std::thread(&CameraGroup::captureLoop, this, cameras[i]);
+	}
+	capturing = true;
+}
+
+void CameraGroup::captureStop()
+{
+	std::string functionSignature = "void CameraGroup::captureStop()";
+
+	if (!capturing)
+	{
+		throw std::runtime_error(functionSignature + " not in capture mode.");
+	}
+
+	stopping = true;
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		cameras[i]->thread.join();
+	}
+	deleteFrames();
+	capturing = false;
+
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		cameras[i]->camera->captureStop();
+	}
+}
+
+bool CameraGroup::isCapturing() const
+{
+	return capturing;
+}
+
+void CameraGroup::setTolerance(int microseconds)
+{
+	this->tolerance = std::chrono::microseconds(microseconds);
+}
+
+int CameraGroup::getTolerance() const
+{
+	return (int) this->tolerance.count();
+}
+
+void CameraGroup::captureLoop(CameraState* state)
+{
+	try
+	{
+		while (!stopping)
+		{
+			state->camera->captureNext();
+			tt::ds::Image* image = state->camera->getImage();
+
+			Frame frame;
+			frame.timestamp = image->getFrameInfo().timestamp;
+			frame.sequence = image->getFrameInfo().sequence;
+			state->capturedFrames++;
+
+			// only this thread adds frames, so the queue can't fill up
+			// between the check and the push
+			if (state->frames->isFull())
+			{
+				state->droppedFrames++;
+				continue;
+			}
+			// the camera takes a new buffer for the next frame
+			frame.image = new tt::ds::Image(image->share());
+			state->frames->push(frame);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+			}
+			frameAvailable.notify_one();
+		}
+	}
+	catch (...)
+	{
+		state->error = std::current_exception();
+		state->failed = true;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		frameAvailable.notify_one();
+	}
+}
+
+bool CameraGroup::takeFrames()
+{
+	bool complete = true;
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		CameraState* state = cameras[i];
+		if (state->hasHead)
+		{
+			continue;
+		}
+		if (state->frames->pop(state->head))
+		{
+			state->hasHead = true;
+			continue;
+		}
+		// the frames queued before the exception are used up
+		if (state->failed)
+		{
+			std::rethrow_exception(state->error);
+		}
+		complete = false;
+	}
+	return complete;
+}
+
+bool CameraGroup::waitFrameSet(FrameSet& frameSet, int timeout)
+{
+	std::string functionSignature = "bool CameraGroup::waitFrameSet(FrameSet& frameSet, int timeout)";
+
+	if (!capturing)
+	{
+		throw std::runtime_error(functionSignature + " not in capture mode.");
+	}
+
+	frameSet.clear();
+	std::chrono::steady_clock::time_point deadline =
+		std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+	for (;;)
+	{
+		if (!takeFrames())
+		{
+			// the capture threads take the mutex between queueing and
+			// notifying, so a frame queued after the check is never missed
+			std::unique_lock<std::mutex> lock(mutex);
+			if (takeFrames())
+			{
+				continue;
+			}
+			if (frameAvailable.wait_until(lock, deadline) == std::cv_status::timeout)
+			{
+				lock.unlock();
+				if (!takeFrames())
+				{
+					return false;
+				}
+			}
+			continue;
+		}
+
+		// drop the frames, which are too old for the newest one
+		std::chrono::steady_clock::time_point newest = cameras[0]->head.timestamp;
+		for (size_t i = 1; i < cameras.size(); i++)
+		{
+			if (cameras[i]->head.timestamp > newest)
+			{
+				newest = cameras[i]->head.timestamp;
+			}
+		}
+		bool matched = true;
+		for (size_t i = 0; i < cameras.size(); i++)
+		{
+			CameraState* state = cameras[i];
+			if (state->head.timestamp + tolerance < newest)
+			{
+				delete state->head.image;
+				state->hasHead = false;
+				state->unmatchedFrames++;
+				matched = false;
+			}
+		}
+		if (!matched)
+		{
+			continue;
+		}
+
+		std::chrono::steady_clock::time_point oldest = cameras[0]->head.timestamp;
+		for (size_t i = 1; i < cameras.size(); i++)
+		{
+			if (cameras[i]->head.timestamp < oldest)
+			{
+				oldest = cameras[i]->head.timestamp;
+			}
+		}
+		for (size_t i = 0; i < cameras.size(); i++)
+		{
+			CameraState* state = cameras[i];
+			long long skew = std::chrono::duration_cast<std::chrono::microseconds>(
+				state->head.timestamp - oldest).count();
+			state->skew = skew;
+			if (skew > state->maxSkew)
+			{
+				state->maxSkew = skew;
+			}
+			frameSet.frames.push_back(state->head);
+			state->hasHead = false;
+		}
+		frameSets++;
+		return true;
+	}
+}
+
+void CameraGroup::deleteFrames()
+{
+	for (size_t i = 0; i < cameras.size(); i++)
+	{
+		CameraState* state = cameras[i];
+		if (state->hasHead)
+		{
+			delete state->head.image;
+			state->hasHead = false;
+		}
+		Frame frame;
+		while (state->frames->pop(frame))
+		{
+			delete frame.image;
+		}
+		delete state->frames;
+		state->frames = NULL;
+	}
+}
+
+unsigned long CameraGroup::getFrameSets() const
+{
+	return frameSets;
+}
+
+const CameraGroup::CameraState* CameraGroup::getState(const std::string& functionSignature,
+	int camera) const
+{
+	if (camera < 0 || camera >= (int) cameras.size())
+	{
+		throw std::runtime_error(functionSignature + " camera out of range.");
+	}
+	return cameras[camera];
+}
+
+unsigned long CameraGroup::getCapturedFrames(int camera) const
+{
+	std::string functionSignature = "unsigned long CameraGroup::getCapturedFrames(int camera) const";
+
+	return getState(functionSignature, camera)->capturedFrames;
+}
+
+unsigned long CameraGroup::getDroppedFrames(int camera) const
+{
+	std::string functionSignature = "unsigned long CameraGroup::getDroppedFrames(int camera) const";
+
+	return getState(functionSignature, camera)->droppedFrames;
+}
+
+unsigned long CameraGroup::getUnmatchedFrames(int camera) const
+{
+	std::string functionSignature = "unsigned long CameraGroup::getUnmatchedFrames(int camera) const";
+
+	return getState(functionSignature, camera)->unmatchedFrames;
+}
+
+long long CameraGroup::getSkew(int camera) const
+{
+	std::string functionSignature = "long long CameraGroup::getSkew(int camera) const";
+
+	return getState(functionSignature, camera)->skew;
+}
+
+long long CameraGroup::getMaxSkew(int camera) const
+{
+	std::string functionSignature = "long long CameraGroup::getMaxSkew(int camera) const";
+
+	return getState(functionSignature, camera)->maxSkew;
+}
+
+} // namespace input
+
+} // namespace tt
@@ -0,0 +1,298 @@
+#ifndef TT_INPUT_CAMERAGROUP_H
+#define TT_INPUT_CAMERAGROUP_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tt/ds/Image.h>
+#include <tt/sys/SPSCQueue.h>
+#include "FirewireCamera.h"
+
+namespace tt
+{
+
+namespace input
+{
+
+/**
+ * @class CameraGroup CameraGroup.h tt/input/CameraGroup.h
+ * @brief Synchronized capture of several Firewire cameras.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * A CameraGroup captures each camera on a thread of its own and matches
+ * the frames of all cameras by their timestamps into frame sets for stereo
+ * and multi view setups. The timestamps are the capture times of the
+ * tt::ds::FrameInfo of the frames, so the time the conversion in getImage
+ * takes doesn't add to the skew.
+ *
+ * Each capture thread hands its frames over by a bounded SPSCQueue and
+ * never waits for the application or the other cameras, frames captured
+ * while the queue is full are dropped. waitFrameSet takes the oldest frame
+ * of each camera and drops frames, which are older than the newest one by
+ * more than the tolerance, until the frames of all cameras match. The
+ * drops and the skew of the matched frames are counted per camera.
+ *
+ * The frames share the buffers of the frames of the cameras. The cameras
+ * write the next frame into a new buffer from the FramePool instead, see
+ * tt::ds::Image::discard, so the group adds no copy of the pixels to the
+ * one a camera makes out of its DMA buffer.
+ */
+class CameraGroup
+{
+public:
+	/**
+	 * @brief One frame of a camera
+	 */
+	struct Frame
+	{
+		/** @brief The frame, owned by the FrameSet */
+		tt::ds::Image* image;
+		/** @brief The capture time of the frame */
+		std::chrono::steady_clock::time_point timestamp;
+		/** @brief The sequence number of the frame of its camera, starting at 0 */
+		unsigned long sequence;
+	};
+
+	/**
+	 * @class FrameSet CameraGroup.h tt/input/CameraGroup.h
+	 * @brief The matched frames of all cameras of a group.
+	 */
+	class FrameSet
+	{
+	public:
+		FrameSet();
+
+		/**
+		 * @brief Delete the frames.
+		 */
+		virtual ~FrameSet();
+
+		/**
+		 * @brief Return the number of frames, one per camera.
+		 */
+		int getSize() const;
+
+		/**
+		 * @brief Return the frame of a camera.
+		 * @param camera The index of the camera in the group.
+		 */
+		const Frame& getFrame(int camera) const;
+
+		/**
+		 * @brief Return the image of a camera.
+		 * @param camera The index of the camera in the group.
+		 */
+		tt::ds::Image* getImage(int camera) const;
+
+		/**
+		 * @brief Return the time between the oldest and the newest frame in
+		 * microseconds.
+		 */
+		long long getSkew() const;
+
+		/**
+		 * @brief Delete the frames.
+		 */
+		void clear();
+
+	private:
+		friend class CameraGroup;
+
+		/** @brief The frames in the order of the cameras */
+		std::vector<Frame> frames;
+
+		// a FrameSet owns its frames and can't be copied
+		FrameSet(const FrameSet&);
+		FrameSet& operator = (const FrameSet&);
+	};
+
+	CameraGroup();
+
+	/**
+	 * @brief Stop capturing like captureStop, the cameras are not deleted.
+	 */
+	virtual ~CameraGroup();
+
+	/**
+	 * @brief Add a camera to the group.
+	 * @param camera The camera with its video format, mode and framerate set.
+	 * The group doesn't own it, delete it after the group.
+	 *
+	 * Throws a std::runtime_error while capturing.
+	 */
+	void addCamera(FirewireCamera* camera);
+
+	/**
+	 * @brief Return the number of cameras.
+	 */
+	int getCameras() const;
+
+	/**
+	 * @brief Return a camera.
+	 * @param camera The index of the camera in the group.
+	 */
+	FirewireCamera* getCamera(int camera) const;
+
+	/**
+	 * @brief Open all cameras in parallel.
+	 *
+	 * Rethrows the exception of the first camera, which failed, after all
+	 * cameras returned.
+	 */
+	void open();
+
+	/**
+	 * @brief Close all cameras.
+	 */
+	void close();
+
+	/**
+	 * @brief Start capturing all cameras, each on a thread of its own.
+	 * @param queueSize Maximum number of frames per camera waiting for
+	 * waitFrameSet.
+	 *
+	 * If a camera doesn't start, the cameras started before are stopped
+	 * again and its exception is rethrown.
+	 */
+	void captureStart(int queueSize = 4);
+
+	/**
+	 * @brief Stop the capture threads and the cameras.
+	 *
+	 * Frames, which weren't matched, are deleted.
+	 */
+	void captureStop();
+
+	/**
+	 * @brief Return true, while the capture threads run.
+	 */
+	bool isCapturing() const;
+
+	/**
+	 * @brief Set the maximum time between the frames of a set.
+	 * @param microseconds The tolerance, 5000 by default. Less than half the
+	 * frame period keeps consecutive frames apart.
+	 */
+	void setTolerance(int microseconds);
+
+	/**
+	 * @brief Return the maximum time between the frames of a set in microseconds.
+	 */
+	int getTolerance() const;
+
+	/**
+	 * @brief Wait for the next matched frames of all cameras.
+	 * @param frameSet The set receiving the frames, its previous frames are
+	 * deleted.
+	 * @param timeout Maximum time to wait in milliseconds.
+	 * @return true, false after the timeout.
+	 *
+	 * If a capture thread stopped with an exception, the exception is
+	 * rethrown once the frames of its camera are used up. Only one thread
+	 * may wait for frame sets.
+	 */
+	bool waitFrameSet(FrameSet& frameSet, int timeout);
+
+	/**
+	 * @brief Return the number of matched frame sets since captureStart.
+	 */
+	unsigned long getFrameSets() const;
+
+	/**
+	 * @brief Return the number of frames captured by a camera since captureStart.
+	 */
+	unsigned long getCapturedFrames(int camera) const;
+
+	/**
+	 * @brief Return the number of frames of a camera dropped, because its
+	 * queue was full.
+	 */
+	unsigned long getDroppedFrames(int camera) const;
+
+	/**
+	 * @brief Return the number of frames of a camera dropped, because the
+	 * other cameras had no frame within the tolerance.
+	 */
+	unsigned long getUnmatchedFrames(int camera) const;
+
+	/**
+	 * @brief Return the time of the frame of a camera after the oldest frame
+	 * of the last frame set in microseconds.
+	 */
+	long long getSkew(int camera) const;
+
+	/**
+	 * @brief Return the largest skew of a camera since captureStart in
+	 * microseconds.
+	 */
+	long long getMaxSkew(int camera) const;
+
+private:
+	/**
+	 * @brief The capture thread and the counters of a camera
+	 */
+	struct CameraState
+	{
+		FirewireCamera* camera;
+		std::thread thread;
+		/** @brief Captured frames waiting for waitFrameSet */
+		tt::sys::SPSCQueue<Frame>* frames;
+		/** @brief The oldest frame taken from the queue, but not matched yet */
+		Frame head;
+		bool hasHead;
+		/** @brief Exception, which stopped the capture thread */
+		std::exception_ptr error;
+		/** @brief True after the capture thread stopped with an exception */
+		std::atomic<bool> failed;
+		std::atomic<unsigned long> capturedFrames;
+		std::atomic<unsigned long> droppedFrames;
+		std::atomic<unsigned long> unmatchedFrames;
+		std::atomic<long long> skew;
+		std::atomic<long long> maxSkew;
+	};
+
+	/** @brief The cameras in the order they were added */
+	std::vector<CameraState*> cameras;
+	/** @brief The maximum time between the frames of a set */
+	std::chrono::microseconds tolerance;
+	/** @brief True if captureStop asks the capture threads to quit */
+	std::atomic<bool> stopping;
+	/** @brief True between captureStart and captureStop */
+	bool capturing;
+	/** @brief Number of matched frame sets */
+	std::atomic<unsigned long> frameSets;
+	/** @brief Protects waiting for frames */
+	std::mutex mutex;
+	/** @brief Signals a new frame or the end of a capture thread */
+	std::condition_variable frameAvailable;
+
+	/** @brief Main loop of a capture thread */
+	void captureLoop(CameraState* state);
+
+	/** @brief Take the next frame of each camera without one, return true if all have one */
+	bool takeFrames();
+
+	/** @brief Delete the frames, which weren't matched */
+	void deleteFrames();
+
+	/** @brief Return the state of a camera or throw a std::runtime_error */
+	const CameraState* getState(const std::string& functionSignature, int camera) const;
+
+	/** @brief Open a camera on a thread of open() */
+	static void openCamera(FirewireCamera* camera, std::exception_ptr* error);
+
+	// a CameraGroup owns its capture threads and can't be copied
+	CameraGroup(const CameraGroup&);
+	CameraGroup& operator = (const CameraGroup&);
+};
+
+} // namespace input
+
+} // namespace tt
+
+#endif /*TT_INPUT_CAMERAGROUP_H*/
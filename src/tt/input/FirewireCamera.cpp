@@ -5,6 +5,9 @@
 
 #include "FirewireCamera.h"
 #include <string>
+#include <stdexcept>
+#include <tt/process/BitDepth.h>
+#include "SimulatedFirewireCamera.h"
 
 // include linux camera interface
 #ifdef LINUX
@@ -28,16 +31,35 @@ FirewireCamera::FirewireCamera() :
 	videoModeSet(false),
 	videoFramerate(FirewireCamera::FRAMERATE_15),
 	videoFramerateSet(false),
-	bayerFilter(tt::process::Bayer::BayerRG2BGR)
+	bayerFilter(tt::process::Bayer::BayerRG2BGR),
+	bayerQuality(tt::process::Bayer::QUALITY_BILINEAR),
+	deBayerPool(NULL),
+	whiteBalanceSoftware(false),
+	whiteBalanceSoftwareUB(WHITE_BALANCE_SOFTWARE_ONE),
+	whiteBalanceSoftwareVR(WHITE_BALANCE_SOFTWARE_ONE),
+	mono16BitsPerChannel(tt::ds::Image::BPC8),
+	significantBits(16),
+	dmaBuffers(16)
 {
+	// the newest frame of the ring by default, like libdc1394 dropping frames
+	setDeliveryPolicy(ImageDevice::LATEST_ONLY);
 }
 
 FirewireCamera::~FirewireCamera()
 {
+	if (deBayerPool != NULL)
+	{
+		delete deBayerPool;
+	}
 }
 
 int FirewireCamera::getNumberOfFirewireCameras()
 {
+	if (SimulatedFirewireCamera::getSimulatedCameras() > 0)
+	{
+		return SimulatedFirewireCamera::getSimulatedCameras();
+	}
+
 	#if LINUX
 		return LinuxDC1394Camera::getNumberOfLinuxDC1394Cameras();
 	#elif WIN32
@@ -49,6 +71,13 @@ int FirewireCamera::getNumberOfFirewireCameras()
 
 FirewireCamera* FirewireCamera::createFirewireCamera(int cameraNumber)
 {
+	if (SimulatedFirewireCamera::getSimulatedCameras() > 0)
+	{
+		SimulatedFirewireCamera* camera = new SimulatedFirewireCamera();
+		camera->selectCamera(cameraNumber);
+		return camera;
+	}
+
 	#if LINUX
 		LinuxDC1394Camera* camera = new LinuxDC1394Camera();
 		camera->selectCamera(cameraNumber);
@@ -303,6 +332,231 @@ process::Bayer::Filter FirewireCamera::getBayerFilter() const
 	return this->bayerFilter;
 }
 
+void FirewireCamera::setBayerQuality(process::Bayer::Quality quality)
+{
+	this->bayerQuality = quality;
+}
+
+process::Bayer::Quality FirewireCamera::getBayerQuality() const
+{
+	return this->bayerQuality;
+}
+
+void FirewireCamera::setDeBayerThreads(int threads)
+{
+	if (deBayerPool != NULL)
+	{
+		delete deBayerPool;
+		deBayerPool = NULL;
+	}
+	
+	if (threads != 1)
+	{
+		deBayerPool = new tt::sys::WorkerPool(threads);
+	}
+}
+
+int FirewireCamera::getDeBayerThreads() const
+{
+	if (deBayerPool == NULL)
+	{
+		return 1;
+	}
+	return deBayerPool->getThreads();
+}
+
+void FirewireCamera::deBayer(tt::ds::Image* source, tt::ds::Image* destination)
+{
+	// the color correction works on 8 bit frames only, the frames of all
+	// color modes are corrected as RGB
+	bool correct = source->getBitsPerChannel() == tt::ds::Image::BPC8;
+	
+	if (deBayerPool != NULL && correct)
+	{
+		tt::process::Bayer::deBayer(source, destination, this->bayerFilter, *deBayerPool,
+			this->colorCorrection, this->bayerQuality, tt::process::Bayer::ORDER_RGB);
+	}
+	else if (deBayerPool != NULL)
+	{
+		tt::process::Bayer::deBayer(source, destination, this->bayerFilter, *deBayerPool,
+			this->bayerQuality);
+	}
+	else if (correct)
+	{
+		tt::process::Bayer::deBayer(source, destination, this->bayerFilter,
+			this->colorCorrection, this->bayerQuality, tt::process::Bayer::ORDER_RGB);
+	}
+	else
+	{
+		tt::process::Bayer::deBayer(source, destination, this->bayerFilter,
+			this->bayerQuality);
+	}
+}
+
+bool FirewireCamera::isMono16(Mode mode)
+{
+	switch (mode)
+	{
+		case MODE_640x480_MONO16:
+		case MODE_800x600_MONO16:
+		case MODE_1024x768_MONO16:
+		case MODE_1280x960_MONO16:
+		case MODE_1600x1200_MONO16:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+tt::ds::Image::BitsPerChannel FirewireCamera::getFrameBitsPerChannel() const
+{
+	if (this->videoModeSet && isMono16(this->videoMode) &&
+		this->bayerFilter != tt::process::Bayer::NONE)
+	{
+		return this->mono16BitsPerChannel;
+	}
+	return tt::ds::Image::BPC8;
+}
+
+std::chrono::nanoseconds FirewireCamera::getFramePeriod() const
+{
+	return std::chrono::nanoseconds(533333333LL >> this->videoFramerate);
+}
+
+unsigned long FirewireCamera::estimateDroppedFrames(std::chrono::nanoseconds interval) const
+{
+	std::chrono::nanoseconds period = getFramePeriod();
+	long long periods = (interval + period / 2) / period;
+	return periods > 1 ? (unsigned long) (periods - 1) : 0;
+}
+
+void FirewireCamera::convertMono16(const unsigned char* source, tt::ds::Image* frame)
+{
+	if (frame->getBitsPerChannel() == tt::ds::Image::BPC16)
+	{
+		tt::process::BitDepth::copyBigEndian(source, frame);
+	}
+	else
+	{
+		tt::process::BitDepth::convertBigEndian(source, frame, this->significantBits - 8);
+	}
+}
+
+void FirewireCamera::copyPacked(const unsigned char* source, tt::ds::Image* frame)
+{
+	int lineBytes = frame->getWidth() * frame->getBytesPerPixel();
+	unsigned char* destination = frame->getImageBuffer();
+	if (frame->getAllocatedWidth() == lineBytes)
+	{
+		memcpy(destination, source, lineBytes * frame->getHeight());
+		return;
+	}
+	
+	// the lines of the image are padded to its line alignment
+	for (int y = 0; y < frame->getHeight(); y++)
+	{
+		memcpy(destination + y * frame->getAllocatedWidth(), source + y * lineBytes, lineBytes);
+	}
+}
+
+void FirewireCamera::correctColors(tt::ds::Image* image, tt::process::Bayer::Order order)
+{
+	this->colorCorrection.apply(image, order);
+}
+
+void FirewireCamera::enableWhiteBalanceSoftware(bool enable)
+{
+	this->whiteBalanceSoftware = enable;
+	if (enable)
+	{
+		setWhiteBalanceSoftware(whiteBalanceSoftwareUB, whiteBalanceSoftwareVR);
+	}
+	else
+	{
+		this->colorCorrection.setGains(1.0, 1.0, 1.0);
+	}
+}
+
+bool FirewireCamera::isWhiteBalanceSoftware() const
+{
+	return this->whiteBalanceSoftware;
+}
+
+void FirewireCamera::getWhiteBalanceSoftware(unsigned int* ubValue, unsigned int* vrValue) const
+{
+	*ubValue = this->whiteBalanceSoftwareUB;
+	*vrValue = this->whiteBalanceSoftwareVR;
+}
+
+void FirewireCamera::setWhiteBalanceSoftware(unsigned int ubValue, unsigned int vrValue)
+{
+	std::string functionSignature = "void FirewireCamera::setWhiteBalanceSoftware(unsigned int ubValue, unsigned int vrValue)";
+	
+	const unsigned int maxValue = tt::process::ColorCorrection::MAX_GAIN * WHITE_BALANCE_SOFTWARE_ONE;
+	if (ubValue > maxValue || vrValue > maxValue)
+	{
+		throw std::runtime_error(functionSignature + " white balance value out of range.");
+	}
+	
+	this->whiteBalanceSoftwareUB = ubValue;
+	this->whiteBalanceSoftwareVR = vrValue;
+	this->colorCorrection.setGains((double) vrValue / WHITE_BALANCE_SOFTWARE_ONE, 1.0,
+		(double) ubValue / WHITE_BALANCE_SOFTWARE_ONE);
+}
+
+void FirewireCamera::setGamma(double gamma)
+{
+	this->colorCorrection.setGamma(gamma);
+}
+
+double FirewireCamera::getGamma() const
+{
+	return this->colorCorrection.getGamma();
+}
+
+void FirewireCamera::setMono16BitsPerChannel(ds::Image::BitsPerChannel bpc)
+{
+	this->mono16BitsPerChannel = bpc;
+}
+
+ds::Image::BitsPerChannel FirewireCamera::getMono16BitsPerChannel() const
+{
+	return this->mono16BitsPerChannel;
+}
+
+void FirewireCamera::setSignificantBits(int bits)
+{
+	std::string functionSignature = "void FirewireCamera::setSignificantBits(int bits)";
+	
+	if (bits < 8 || bits > 16)
+	{
+		throw std::runtime_error(functionSignature + " bits out of range.");
+	}
+	this->significantBits = bits;
+}
+
+int FirewireCamera::getSignificantBits() const
+{
+	return this->significantBits;
+}
+
+void FirewireCamera::setDMABuffers(int buffers)
+{
+	std::string functionSignature = "void FirewireCamera::setDMABuffers(int buffers)";
+	
+	if (buffers < 1)
+	{
+		throw std::runtime_error(functionSignature + " buffers out of range.");
+	}
+	this->dmaBuffers = buffers;
+}
+
+int FirewireCamera::getDMABuffers() const
+{
+	return this->dmaBuffers;
+}
+
 } // namespace input
 
 } // namespace tt
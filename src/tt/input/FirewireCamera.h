@@ -1,8 +1,11 @@
 #ifndef TT_INPUT_FIREWIRECAMERA_H
 #define TT_INPUT_FIREWIRECAMERA_H
 
+#include <chrono>
 #include "ImageDevice.h"
 #include <tt/process/Bayer.h>
+#include <tt/process/ColorCorrection.h>
+#include <tt/sys/WorkerPool.h>
 
 namespace tt
 {
@@ -18,6 +21,14 @@ namespace input
  * FirewireCamera is the base class for operating system specific
  * implementations of Firewire Cameras. Use this class to instantiate 
  * FirewireCamera Objects.
+ * 
+ * The cameras capture into a ring of DMA buffers. With the delivery
+ * policy LATEST_ONLY, the default of Firewire cameras, the newest frame in
+ * the ring is delivered and the older ones are dropped. BOUNDED_QUEUE and
+ * BLOCKING_LOSSLESS deliver the oldest frame in the ring, so the ring
+ * absorbs delays of the application up to its depth, see setDMABuffers.
+ * Frames arriving while the ring is full are lost in the driver and
+ * counted by getDeviceDroppedFrames, also with BLOCKING_LOSSLESS.
  */
 class FirewireCamera : public tt::input::ImageDevice
 {
@@ -82,7 +93,10 @@ public:
 	{
 		COLOR_RGB = 0,
 		COLOR_GREYSCALE = 1,
-		COLOR_YUV422 = 2
+		COLOR_YUV422 = 2,
+		COLOR_YUV444 = 3,
+		COLOR_YUV411 = 4,
+		COLOR_GREYSCALE16 = 5
 	};
 	
 protected:
@@ -107,12 +121,118 @@ protected:
 	/** @brief The Bayer filter for color conversion. */
 	tt::process::Bayer::Filter bayerFilter;
 
+	/** @brief The interpolation quality for color conversion. */
+	tt::process::Bayer::Quality bayerQuality;
+
+	/** @brief Threads for the color conversion, NULL converts on the calling thread. */
+	tt::sys::WorkerPool* deBayerPool;
+
+	/** @brief True, if the white balance is applied in software. */
+	bool whiteBalanceSoftware;
+
+	/** @brief The software white balance values, see setWhiteBalance. */
+	unsigned int whiteBalanceSoftwareUB;
+	unsigned int whiteBalanceSoftwareVR;
+
+	/** @brief Software white balance and gamma of the color frames. */
+	tt::process::ColorCorrection colorCorrection;
+
+	/** @brief The bits per channel of the frames of MONO16 modes. */
+	tt::ds::Image::BitsPerChannel mono16BitsPerChannel;
+
+	/** @brief The number of bits used by the camera in MONO16 modes. */
+	int significantBits;
+
+	/** @brief The number of buffers of the DMA ring. */
+	int dmaBuffers;
+
+	/**
+	 * @brief Return true, if the mode delivers 16 bit greyscale frames.
+	 */
+	static bool isMono16(Mode mode);
+
+	/**
+	 * @brief Return the bits per channel of the frames for the current mode.
+	 * 
+	 * The mono16BitsPerChannel for MONO16 modes with a Bayer filter, BPC8
+	 * otherwise.
+	 */
+	tt::ds::Image::BitsPerChannel getFrameBitsPerChannel() const;
+
+	/**
+	 * @brief Return the time between two frames at the video framerate.
+	 * 
+	 * The framerates double from 1.875 frames per second. Format 7 ignores
+	 * the video framerate, so the period doesn't apply to it.
+	 */
+	std::chrono::nanoseconds getFramePeriod() const;
+
+	/**
+	 * @brief Estimate the frames lost between two delivered frames.
+	 * @param interval The time between the capture of the frames.
+	 * @return The frame periods in the interval rounded less one, at least 0.
+	 */
+	unsigned long estimateDroppedFrames(std::chrono::nanoseconds interval) const;
+
+	/**
+	 * @brief Copy a MONO16 frame from the camera buffer into a greyscale image.
+	 * @param source The big endian frame delivered by the camera.
+	 * @param frame The image, BPC16 keeps all bits, BPC8 drops the bits
+	 * below the 8 most significant ones, see setSignificantBits.
+	 */
+	void convertMono16(const unsigned char* source, tt::ds::Image* frame);
+
+	/**
+	 * @brief Copy a frame with unpadded lines from the camera buffer into an image.
+	 * @param source The frame delivered by the camera, whose lines follow
+	 * each other without padding.
+	 * @param frame The image of the same format, whose lines may be padded
+	 * to its line alignment.
+	 */
+	void copyPacked(const unsigned char* source, tt::ds::Image* frame);
+
+	/**
+	 * @brief Convert a Bayer pattern frame with the current Bayer filter and
+	 * quality.
+	 * 
+	 * Uses the threads set by setDeBayerThreads and applies the software
+	 * white balance and gamma while converting. BPC16 frames are converted
+	 * without white balance and gamma.
+	 */
+	void deBayer(tt::ds::Image* source, tt::ds::Image* destination);
+
+	/**
+	 * @brief Apply the software white balance and gamma to a color frame,
+	 * which was delivered by the camera.
+	 * @param order The channel order of the frame.
+	 */
+	void correctColors(tt::ds::Image* image, tt::process::Bayer::Order order);
+
+	/**
+	 * @brief Return the software white balance values.
+	 * 
+	 * Implementations of getWhiteBalance return these, if
+	 * whiteBalanceSoftware is set.
+	 */
+	void getWhiteBalanceSoftware(unsigned int* ubValue, unsigned int* vrValue) const;
+
+	/**
+	 * @brief Set the software white balance values.
+	 * 
+	 * Implementations of setWhiteBalance call this, if whiteBalanceSoftware
+	 * is set.
+	 */
+	void setWhiteBalanceSoftware(unsigned int ubValue, unsigned int vrValue);
+
 public:
 	FirewireCamera();
 	virtual ~FirewireCamera();
 	
 	/**
 	 * @brief Return the number of connected Firewire Cameras.
+	 * 
+	 * Returns the number of simulated cameras instead, if
+	 * SimulatedFirewireCamera::setSimulatedCameras was called.
 	 */ 
 	static int getNumberOfFirewireCameras();
 
@@ -120,6 +240,9 @@ public:
 	 * @brief Factory function to create a FirewireCamera instance.
 	 * @param index of the camera to connect to
 	 * @return The created Camera object.
+	 * 
+	 * Creates a SimulatedFirewireCamera instead of the camera of the platform,
+	 * if SimulatedFirewireCamera::setSimulatedCameras was called.
 	 */
 	static FirewireCamera* createFirewireCamera(int cameraNumber = 0);
 
@@ -225,6 +348,114 @@ public:
 	 */
 	virtual process::Bayer::Filter getBayerFilter() const;
 
+	/**
+	 * @brief Set the interpolation quality for Bayer pattern frames.
+	 * @param quality The desired quality.
+	 * 
+	 * Bayer::QUALITY_BILINEAR is the default, Bayer::QUALITY_MALVAR
+	 * gives sharper edges and less color fringes at about twice the cost.
+	 */
+	virtual void setBayerQuality(process::Bayer::Quality quality);
+
+	/**
+	 * @brief Return the interpolation quality for Bayer pattern frames.
+	 */
+	virtual process::Bayer::Quality getBayerQuality() const;
+
+	/**
+	 * @brief Set the number of threads converting Bayer pattern frames.
+	 * @param threads The number of threads including the thread calling
+	 * getImage(). 1 converts on the calling thread only, which is the default,
+	 * 0 uses one thread per processor core.
+	 * 
+	 * Limit the threads to share the processor cores between several cameras.
+	 */
+	virtual void setDeBayerThreads(int threads);
+
+	/**
+	 * @brief Return the number of threads converting Bayer pattern frames.
+	 */
+	virtual int getDeBayerThreads() const;
+
+	/** @brief The software white balance value for a gain of 1. */
+	static const unsigned int WHITE_BALANCE_SOFTWARE_ONE = 512;
+
+	/**
+	 * @brief Apply the white balance in software instead of the camera.
+	 * @param enable true for the software white balance, false for the camera.
+	 * 
+	 * For cameras without a white balance feature. While enabled,
+	 * setWhiteBalance and getWhiteBalance don't access the camera, the U/B
+	 * value is the gain of the blue channel and the V/R value the gain of the
+	 * red channel in units of 1 / WHITE_BALANCE_SOFTWARE_ONE. The gains are
+	 * applied while converting the frames, without an extra pass. Disable the
+	 * automatic white balance of the camera, if it has one.
+	 */
+	virtual void enableWhiteBalanceSoftware(bool enable);
+
+	/**
+	 * @brief Return true, if the white balance is applied in software.
+	 */
+	virtual bool isWhiteBalanceSoftware() const;
+
+	/**
+	 * @brief Set the gamma applied in software to the color frames.
+	 * @param gamma The gamma, 1 is the default and leaves the frames untouched.
+	 * 
+	 * See tt::process::ColorCorrection::setGamma.
+	 */
+	virtual void setGamma(double gamma);
+
+	/**
+	 * @brief Return the gamma applied in software to the color frames.
+	 */
+	virtual double getGamma() const;
+
+	/**
+	 * @brief Set the bits per channel of the frames in MONO16 modes.
+	 * @param bpc BPC8, the default, or BPC16.
+	 * 
+	 * With BPC16 getImage returns BPC16 frames in MONO16 modes with a Bayer
+	 * filter, which keep the full bit depth of the camera. Software white
+	 * balance and gamma are not applied to these. Set before captureStart.
+	 */
+	virtual void setMono16BitsPerChannel(ds::Image::BitsPerChannel bpc);
+
+	/**
+	 * @brief Return the bits per channel of the frames in MONO16 modes.
+	 */
+	virtual ds::Image::BitsPerChannel getMono16BitsPerChannel() const;
+
+	/**
+	 * @brief Set the number of bits the camera uses in MONO16 modes.
+	 * @param bits 8 to 16, the default is 16.
+	 * 
+	 * IIDC cameras align the pixels to the most significant bit, so the
+	 * default fits most cameras. For cameras aligning them to the least
+	 * significant bit, e.g. 12 drops the 4 lowest bits instead of the 8
+	 * lowest ones when converting MONO16 frames to BPC8.
+	 */
+	virtual void setSignificantBits(int bits);
+
+	/**
+	 * @brief Return the number of bits the camera uses in MONO16 modes.
+	 */
+	virtual int getSignificantBits() const;
+
+	/**
+	 * @brief Set the number of buffers of the DMA ring.
+	 * @param buffers 1 or more, 16 by default. Set before captureStart.
+	 * 
+	 * A deeper ring holds more frames for a slow application, but takes
+	 * more memory and, with BOUNDED_QUEUE, delays the frames more.
+	 */
+	virtual void setDMABuffers(int buffers);
+
+	/**
+	 * @brief Return the number of buffers of the DMA ring.
+	 */
+	virtual int getDMABuffers() const;
+
 	virtual void getCaptureParameters(int& width, int& height, 
 		ds::Image::Channels& channels, ds::Image::BitsPerChannel& bpc) = 0;
 	virtual void enableWhiteBalanceOnePush(bool enable) = 0;
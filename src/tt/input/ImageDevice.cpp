@@ -3,6 +3,9 @@
  * by Martin Wojtczyk <wojtczyk@in.tum.de>
  */
 
+#include <string.h>
+#include <chrono>
+#include <string>
 #include "ImageDevice.h"
 
 namespace tt
@@ -11,18 +14,422 @@ namespace tt
 namespace input
 {
 	
-/**
- * @brief Does nothing.
- */
-ImageDevice::ImageDevice()
+ImageDevice::ImageDevice() :
+	frames(NULL),
+	freeFrames(NULL),
+	latestFrame(NULL),
+	deliveryPolicy(BOUNDED_QUEUE),
+	stopping(false),
+	finished(true),
+	droppedFrames(0),
+	nextSequence(0),
+	capturedFrames(0),
+	deviceDroppedFrames(0),
+	frameInterval(0),
+	latency(0),
+	maxLatency(0)
 {
 }
 
 /**
- * @brief Does nothing.
+ * @brief Stop the capture thread, if a derived class didn't.
  */
 ImageDevice::~ImageDevice()
 {
+	stopAsyncCapture();
+}
+
+void ImageDevice::lendImage(LentFrame& /*frame*/)
+{
+	std::string functionSignature = "void ImageDevice::lendImage(LentFrame& frame)";
+	
+	throw std::runtime_error(functionSignature + " this device can't lend frames.");
+}
+
+void ImageDevice::setDeliveryPolicy(DeliveryPolicy policy)
+{
+	std::string functionSignature = "void ImageDevice::setDeliveryPolicy(DeliveryPolicy policy)";
+	
+	if (captureThread.joinable())
+	{
+		throw std::runtime_error(functionSignature + " capture thread runs.");
+	}
+	deliveryPolicy = policy;
+}
+
+ImageDevice::DeliveryPolicy ImageDevice::getDeliveryPolicy() const
+{
+	return deliveryPolicy;
+}
+
+void ImageDevice::startAsyncCapture(int queueSize)
+{
+	std::string functionSignature = "void ImageDevice::startAsyncCapture(int queueSize)";
+	
+	if (captureThread.joinable())
+	{
+		throw std::runtime_error(functionSignature + " capture thread runs already.");
+	}
+	if (queueSize < 1)
+	{
+		throw std::runtime_error(functionSignature + " queue size must be at least 1.");
+	}
+	
+	frames = new tt::sys::SPSCQueue<tt::ds::Image*>(queueSize);
+	// the application may hold a few frames besides the queued ones
+	freeFrames = new tt::sys::SPSCQueue<tt::ds::Image*>(queueSize + 2);
+	stopping = false;
+	finished = false;
+	droppedFrames = 0;
+	latency = 0;
+	maxLatency = 0;
+	error = std::exception_ptr();
+	captureThread = std::thread(&ImageDevice::captureLoop, this);
+}
+
+void ImageDevice::stopAsyncCapture()
+{
+	if (!captureThread.joinable())
+	{
+		return;
+	}
+	
+	stopping = true;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+	}
+	spaceAvailable.notify_all();
+	captureThread.join();
+	
+	tt::ds::Image* image = latestFrame.exchange(NULL);
+	if (image != NULL)
+	{
+		delete image;
+	}
+	while (frames->pop(image))
+	{
+		delete image;
+	}
+	while (freeFrames->pop(image))
+	{
+		delete image;
+	}
+	delete frames;
+	delete freeFrames;
+	frames = NULL;
+	freeFrames = NULL;
+	error = std::exception_ptr();
+}
+
+bool ImageDevice::isCapturingAsync() const
+{
+	return frames != NULL && !finished;
+}
+
+tt::ds::Image* ImageDevice::pollImage()
+{
+	std::string functionSignature = "tt::ds::Image* ImageDevice::pollImage()";
+	
+	if (frames == NULL)
+	{
+		throw std::runtime_error(functionSignature + " asynchronous capture not started.");
+	}
+	
+	tt::ds::Image* image;
+	if (takeFrame(image))
+	{
+		return frameTaken(image);
+	}
+	return endOfFrames();
+}
+
+tt::ds::Image* ImageDevice::waitImage(int timeout)
+{
+	std::string functionSignature = "tt::ds::Image* ImageDevice::waitImage(int timeout)";
+	
+	if (frames == NULL)
+	{
+		throw std::runtime_error(functionSignature + " asynchronous capture not started.");
+	}
+	
+	// the common case of a queued frame doesn't touch the mutex
+	tt::ds::Image* image;
+	if (takeFrame(image))
+	{
+		return frameTaken(image);
+	}
+	
+	std::chrono::steady_clock::time_point deadline = 
+		std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+	std::unique_lock<std::mutex> lock(mutex);
+	// the capture thread takes the mutex between queueing and notifying,
+	// so a frame queued after the check is never missed
+	while (!takeFrame(image))
+	{
+		if (finished)
+		{
+			lock.unlock();
+			return endOfFrames();
+		}
+		if (frameAvailable.wait_until(lock, deadline) == std::cv_status::timeout)
+		{
+			if (!takeFrame(image))
+			{
+				return NULL;
+			}
+			break;
+		}
+	}
+	lock.unlock();
+	return frameTaken(image);
+}
+
+void ImageDevice::releaseImage(tt::ds::Image* image)
+{
+	if (image == NULL)
+	{
+		return;
+	}
+	if (freeFrames == NULL || !freeFrames->push(image))
+	{
+		delete image;
+	}
+}
+
+unsigned long ImageDevice::getDroppedFrames() const
+{
+	return droppedFrames;
+}
+
+unsigned long ImageDevice::getCapturedFrames() const
+{
+	return capturedFrames;
+}
+
+unsigned long ImageDevice::getDeviceDroppedFrames() const
+{
+	return deviceDroppedFrames;
+}
+
+double ImageDevice::getFrameRate() const
+{
+	long long interval = frameInterval;
+	return interval > 0 ? 1e9 / interval : 0.0;
+}
+
+void ImageDevice::resetFrameCounters()
+{
+	nextSequence = 0;
+	capturedFrames = 0;
+	deviceDroppedFrames = 0;
+	frameInterval = 0;
+	latency = 0;
+	maxLatency = 0;
+}
+
+void ImageDevice::stampFrame(tt::ds::Image* image, std::chrono::steady_clock::time_point timestamp,
+	unsigned long dropped, int bufferIndex)
+{
+	tt::ds::FrameInfo info;
+	info.timestamp = timestamp;
+	info.sequence = nextSequence + dropped;
+	info.droppedFrames = dropped;
+	info.bufferIndex = bufferIndex;
+	image->setFrameInfo(info);
+	
+	if (capturedFrames > 0)
+	{
+		// an average over about the last 8 intervals follows changes quickly
+		long long interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			timestamp - previousTimestamp).count();
+		long long average = frameInterval;
+		frameInterval = average == 0 ? interval : average + (interval - average) / 8;
+	}
+	nextSequence = info.sequence + 1;
+	previousTimestamp = timestamp;
+	deviceDroppedFrames += dropped;
+	capturedFrames++;
+	
+	// the capture thread copies the frame, the application gets it later
+	if (frames == NULL)
+	{
+		measureLatency(image);
+	}
+}
+
+long long ImageDevice::getLatency() const
+{
+	return latency / 1000;
+}
+
+long long ImageDevice::getMaxLatency() const
+{
+	return maxLatency / 1000;
+}
+
+void ImageDevice::measureLatency(const tt::ds::Image* image)
+{
+	std::chrono::steady_clock::time_point timestamp = image->getFrameInfo().timestamp;
+	if (timestamp == std::chrono::steady_clock::time_point())
+	{
+		return;
+	}
+	
+	long long delay = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - timestamp).count();
+	long long average = latency;
+	latency = average == 0 ? delay : average + (delay - average) / 8;
+	if (delay > maxLatency)
+	{
+		maxLatency = delay;
+	}
+}
+
+tt::ds::Image* ImageDevice::captureAsync()
+{
+	captureNext();
+	return getImage();
+}
+
+void ImageDevice::captureLoop()
+{
+	try
+	{
+		while (!stopping)
+		{
+			tt::ds::Image* image = captureAsync();
+			if (image == NULL)
+			{
+				break;
+			}
+			
+			tt::ds::Image* frame;
+			switch (deliveryPolicy)
+			{
+				case LATEST_ONLY:
+					// the frame replaces the previous one, if it wasn't taken
+					frame = latestFrame.exchange(copyFrame(image));
+					if (frame != NULL)
+					{
+						droppedFrames++;
+						delete frame;
+					}
+					break;
+					
+				case BOUNDED_QUEUE:
+					// only this thread adds frames, so the queue can't fill up
+					// between the check and the push
+					if (frames->isFull())
+					{
+						droppedFrames++;
+						continue;
+					}
+					frames->push(copyFrame(image));
+					break;
+					
+				case BLOCKING_LOSSLESS:
+					{
+						// the application takes the mutex between taking a frame
+						// and notifying, so a freed place is never missed
+						std::unique_lock<std::mutex> lock(mutex);
+						while (frames->isFull() && !stopping)
+						{
+							spaceAvailable.wait(lock);
+						}
+					}
+					if (stopping)
+					{
+						continue;
+					}
+					frames->push(copyFrame(image));
+					break;
+			}
+			
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+			}
+			frameAvailable.notify_one();
+		}
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+	
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finished = true;
+	}
+	frameAvailable.notify_all();
+}
+
+tt::ds::Image* ImageDevice::copyFrame(const tt::ds::Image* image)
+{
+	tt::ds::Image* frame;
+	if (freeFrames->pop(frame))
+	{
+		if (frame->getWidth() == image->getWidth() &&
+			frame->getHeight() == image->getHeight() &&
+			frame->getChannels() == image->getChannels() &&
+			frame->getBitsPerChannel() == image->getBitsPerChannel() &&
+			frame->getAllocatedWidth() == image->getAllocatedWidth() &&
+			frame->getAllocatedBytes() == image->getAllocatedBytes())
+		{
+			// a consumer may have kept a share of the frame, which keeps its
+			// pixels, the frame gets a new buffer instead of a copy
+			frame->discard();
+			memcpy(frame->getImageBuffer(), image->getImageBuffer(), image->getAllocatedBytes());
+			frame->setFrameInfo(image->getFrameInfo());
+			return frame;
+		}
+		delete frame;
+	}
+	return image->clone();
+}
+
+bool ImageDevice::takeFrame(tt::ds::Image*& image)
+{
+	if (deliveryPolicy == LATEST_ONLY)
+	{
+		image = latestFrame.exchange(NULL);
+		return image != NULL;
+	}
+	return frames->pop(image);
+}
+
+tt::ds::Image* ImageDevice::frameTaken(tt::ds::Image* image)
+{
+	if (deliveryPolicy == BLOCKING_LOSSLESS)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		spaceAvailable.notify_one();
+	}
+	measureLatency(image);
+	return image;
+}
+
+tt::ds::Image* ImageDevice::endOfFrames()
+{
+	if (!finished)
+	{
+		return NULL;
+	}
+	
+	// frames queued before the end are delivered first
+	tt::ds::Image* image;
+	if (takeFrame(image))
+	{
+		return frameTaken(image);
+	}
+	if (error)
+	{
+		std::exception_ptr e = error;
+		error = std::exception_ptr();
+		std::rethrow_exception(e);
+	}
+	return NULL;
 }
 
 } // namespace input
@@ -1,9 +1,16 @@
 #ifndef TT_INPUT_IMAGEDEVICE_H
 #define TT_INPUT_IMAGEDEVICE_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <exception>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <tt/ds/Image.h>
+#include <tt/sys/SPSCQueue.h>
+#include "LentFrame.h"
 
 namespace tt
 {
@@ -18,10 +25,42 @@ namespace input
  * 
  * The ImageDevice class is an abstract class specifying the ImageDevice
  * interface.
+ * 
+ * Frames are captured synchronously with captureNext and getImage by
+ * default. startAsyncCapture moves this into a capture thread, which
+ * copies each converted frame into a bounded SPSCQueue, while the
+ * application thread takes the frames with pollImage or waitImage. The
+ * wait for the camera then overlaps the processing of the previous frames,
+ * and the device keeps being drained, while the processing stalls.
+ * 
+ * The delivery policy selects what happens to frames the application
+ * doesn't take in time. LATEST_ONLY keeps only the newest frame for the
+ * lowest latency, BOUNDED_QUEUE queues frames and drops the ones captured
+ * while the queue is full, BLOCKING_LOSSLESS lets the capture thread wait
+ * for the application instead. Devices with a ring of capture buffers
+ * apply the policy to their ring as well, see FirewireCamera.
+ * 
+ * Each delivered frame carries a tt::ds::FrameInfo with its capture time,
+ * sequence number, the frames the device dropped before it and its buffer
+ * index. The device counts the delivered and dropped frames and measures
+ * the rate of the delivered frames.
  */
 class ImageDevice
 {
 public:
+	/**
+	 * @brief The handling of frames, which the application doesn't take in time
+	 */
+	enum DeliveryPolicy
+	{
+		/** @brief Deliver the newest frame, older frames are dropped */
+		LATEST_ONLY,
+		/** @brief Deliver the frames in order, frames, which don't fit into the queue, are dropped */
+		BOUNDED_QUEUE,
+		/** @brief Deliver all frames in order, capturing waits while the queue is full */
+		BLOCKING_LOSSLESS
+	};
+
 	ImageDevice();
 	virtual ~ImageDevice();
 
@@ -34,6 +73,221 @@ public:
 	virtual tt::ds::Image* getImage() = 0;
 	virtual const int getImageWidth() const = 0;
 	virtual const int getImageHeight() const = 0;
+
+	/**
+	 * @brief Lend the next frame without copying it.
+	 * @param frame The handle, whose image points into the capture buffer of
+	 * the device until the frame is released.
+	 * 
+	 * Replaces the getImage and captureNext pair for devices, which can
+	 * deliver frames straight from their capture buffer. The frame is raw,
+	 * no color conversion or correction is applied. The default
+	 * implementation throws a std::runtime_error for devices, which can't
+	 * lend frames.
+	 */
+	virtual void lendImage(LentFrame& frame);
+
+	/**
+	 * @brief Set the handling of frames, which the application doesn't take
+	 * in time.
+	 * @param policy The policy, BOUNDED_QUEUE by default.
+	 * 
+	 * Set it before captureStart, devices may read it there. Throws a
+	 * std::runtime_error, while the capture thread runs.
+	 */
+	void setDeliveryPolicy(DeliveryPolicy policy);
+
+	/**
+	 * @brief Return the handling of frames, which the application doesn't
+	 * take in time.
+	 */
+	DeliveryPolicy getDeliveryPolicy() const;
+
+	/**
+	 * @brief Start capturing in a thread of the device.
+	 * @param queueSize Maximum number of captured frames waiting for the
+	 * application, LATEST_ONLY keeps one.
+	 * 
+	 * The device must be in capture mode already. The capture thread calls
+	 * captureNext and getImage, which must not be called by the application
+	 * until stopAsyncCapture. Throws a std::runtime_error, if the thread
+	 * runs already.
+	 */
+	void startAsyncCapture(int queueSize = 4);
+
+	/**
+	 * @brief Stop and join the capture thread.
+	 * 
+	 * Returns after the frame being captured is finished. Frames, which
+	 * haven't been taken, are deleted. Does nothing, if the thread doesn't
+	 * run. Derived classes call this before captureStop and destruction.
+	 */
+	void stopAsyncCapture();
+
+	/**
+	 * @brief Return true, while the capture thread runs and delivers frames.
+	 * 
+	 * False after the device ran out of frames or failed, see pollImage.
+	 */
+	bool isCapturingAsync() const;
+
+	/**
+	 * @brief Take the oldest captured frame without waiting.
+	 * @return The frame or NULL, if no frame is queued.
+	 * 
+	 * The caller owns the frame and hands it back with releaseImage, which
+	 * reuses its memory, or deletes it. If the capture thread stopped with an
+	 * exception, the exception is rethrown once all queued frames are taken.
+	 * Only one thread may take frames.
+	 */
+	tt::ds::Image* pollImage();
+
+	/**
+	 * @brief Take the oldest captured frame, waiting for it if necessary.
+	 * @param timeout Maximum time to wait in milliseconds.
+	 * @return The frame or NULL after the timeout or the end of capturing.
+	 * 
+	 * Like pollImage otherwise.
+	 */
+	tt::ds::Image* waitImage(int timeout);
+
+	/**
+	 * @brief Hand a frame from pollImage or waitImage back for reuse.
+	 * @param image The frame, which must not be used any more.
+	 */
+	void releaseImage(tt::ds::Image* image);
+
+	/**
+	 * @brief Return the number of frames dropped by the capture thread,
+	 * because the queue was full or a newer frame replaced them.
+	 */
+	unsigned long getDroppedFrames() const;
+
+	/**
+	 * @brief Return the number of frames delivered since captureStart.
+	 */
+	unsigned long getCapturedFrames() const;
+
+	/**
+	 * @brief Return the number of frames the device dropped since captureStart.
+	 * 
+	 * Unlike the frames of getDroppedFrames, these were lost in the device or
+	 * its driver before they were delivered, because they weren't taken in
+	 * time.
+	 */
+	unsigned long getDeviceDroppedFrames() const;
+
+	/**
+	 * @brief Return the recent rate of the delivered frames per second.
+	 * 
+	 * The average of the last frame intervals, weighted towards the newest,
+	 * 0 before the second frame.
+	 */
+	double getFrameRate() const;
+
+	/**
+	 * @brief Return the recent time from the capture of the frames until the
+	 * application got them in microseconds.
+	 * 
+	 * Measured, when getImage or lendImage return a frame and, while
+	 * capturing asynchronously, when pollImage or waitImage do. Averaged like
+	 * getFrameRate, 0 before the first frame.
+	 */
+	long long getLatency() const;
+
+	/**
+	 * @brief Return the largest latency since captureStart or
+	 * startAsyncCapture in microseconds.
+	 */
+	long long getMaxLatency() const;
+
+protected:
+	/**
+	 * @brief Restart the sequence numbers and the counters, called by
+	 * captureStart of the derived classes.
+	 */
+	void resetFrameCounters();
+
+	/**
+	 * @brief Fill in the FrameInfo of a delivered frame and count it.
+	 * @param image The frame.
+	 * @param timestamp The time the frame was captured.
+	 * @param dropped The frames the device dropped since the previous frame.
+	 * @param bufferIndex The buffer of the device, which held the frame, or -1.
+	 */
+	void stampFrame(tt::ds::Image* image, std::chrono::steady_clock::time_point timestamp,
+		unsigned long dropped, int bufferIndex);
+
+	/**
+	 * @brief Capture the next frame in the capture thread.
+	 * @return The converted frame owned by the device or NULL, if the
+	 * device has no more frames.
+	 * 
+	 * The default implementation calls captureNext and getImage.
+	 */
+	virtual tt::ds::Image* captureAsync();
+
+private:
+	/** @brief The capture thread */
+	std::thread captureThread;
+	/** @brief Captured frames waiting for the application */
+	tt::sys::SPSCQueue<tt::ds::Image*>* frames;
+	/** @brief Frames handed back by the application */
+	tt::sys::SPSCQueue<tt::ds::Image*>* freeFrames;
+	/** @brief The newest frame, which wasn't taken yet, for LATEST_ONLY */
+	std::atomic<tt::ds::Image*> latestFrame;
+	/** @brief The handling of frames, which aren't taken in time */
+	DeliveryPolicy deliveryPolicy;
+	/** @brief True if stopAsyncCapture asks the capture thread to quit */
+	std::atomic<bool> stopping;
+	/** @brief True after the capture thread delivered its last frame */
+	std::atomic<bool> finished;
+	/** @brief Number of frames dropped by the capture thread */
+	std::atomic<unsigned long> droppedFrames;
+	/** @brief Exception, which stopped the capture thread */
+	std::exception_ptr error;
+	/** @brief Protects waiting for frames */
+	std::mutex mutex;
+	/** @brief Signals a new frame or the end of the capture thread */
+	std::condition_variable frameAvailable;
+	/** @brief Signals a taken frame to a capture thread waiting for BLOCKING_LOSSLESS */
+	std::condition_variable spaceAvailable;
+	/** @brief The sequence number of the next frame */
+	unsigned long nextSequence;
+	/** @brief The capture time of the previous frame */
+	std::chrono::steady_clock::time_point previousTimestamp;
+	/** @brief Number of frames delivered since captureStart */
+	std::atomic<unsigned long> capturedFrames;
+	/** @brief Number of frames the device dropped since captureStart */
+	std::atomic<unsigned long> deviceDroppedFrames;
+	/** @brief Average frame interval in nanoseconds, 0 before the second frame */
+	std::atomic<long long> frameInterval;
+	/** @brief Average latency in nanoseconds, 0 before the first frame */
+	std::atomic<long long> latency;
+	/** @brief Largest latency in nanoseconds */
+	std::atomic<long long> maxLatency;
+
+	/** @brief Main loop of the capture thread */
+	void captureLoop();
+
+	/** @brief Copy a frame into a handed back frame or a new one */
+	tt::ds::Image* copyFrame(const tt::ds::Image* image);
+
+	/** @brief Take the next frame for the application, return false if there is none */
+	bool takeFrame(tt::ds::Image*& image);
+
+	/** @brief Wake a waiting capture thread and measure the latency of a taken frame */
+	tt::ds::Image* frameTaken(tt::ds::Image* image);
+
+	/** @brief Add the latency of a frame, which the application gets now */
+	void measureLatency(const tt::ds::Image* image);
+
+	/** @brief Return NULL or rethrow the error after the last frame */
+	tt::ds::Image* endOfFrames();
+
+	// an ImageDevice owns its capture thread and can't be copied
+	ImageDevice(const ImageDevice&);
+	ImageDevice& operator = (const ImageDevice&);
 };
 
 } // namespace input
@@ -0,0 +1,92 @@
+/*
+ * LentFrame
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <assert.h>
+#include "LentFrame.h"
+
+namespace tt
+{
+
+namespace input
+{
+
+LentFrame::Lender::Lender() :
+	lentFrame(NULL)
+{
+}
+
+LentFrame::Lender::~Lender()
+{
+	if (lentFrame != NULL)
+	{
+		delete lentFrame->image;
+		lentFrame->image = NULL;
+		lentFrame->lender = NULL;
+	}
+}
+
+void LentFrame::Lender::lend(LentFrame& frame, tt::ds::Image* image)
+{
+	assert(lentFrame == NULL);
+	assert(frame.lender == NULL);
+	
+	frame.lender = this;
+	frame.image = image;
+	lentFrame = &frame;
+}
+
+void LentFrame::Lender::reclaim()
+{
+	if (lentFrame != NULL)
+	{
+		lentFrame->release();
+	}
+}
+
+bool LentFrame::Lender::isLending() const
+{
+	return lentFrame != NULL;
+}
+
+LentFrame::LentFrame() :
+	lender(NULL),
+	image(NULL)
+{
+}
+
+LentFrame::~LentFrame()
+{
+	release();
+}
+
+tt::ds::Image* LentFrame::getImage() const
+{
+	return image;
+}
+
+bool LentFrame::isLent() const
+{
+	return lender != NULL;
+}
+
+void LentFrame::release()
+{
+	if (lender == NULL)
+	{
+		return;
+	}
+	
+	// drop the view before the device reuses the buffer
+	Lender* owner = lender;
+	delete image;
+	image = NULL;
+	lender = NULL;
+	owner->lentFrame = NULL;
+	owner->returnBuffer();
+}
+
+} // namespace input
+
+} // namespace tt
@@ -0,0 +1,125 @@
+#ifndef TT_INPUT_LENTFRAME_H
+#define TT_INPUT_LENTFRAME_H
+
+#include <tt/ds/Image.h>
+
+namespace tt
+{
+
+namespace input
+{
+
+/**
+ * @class LentFrame LentFrame.h tt/input/LentFrame.h
+ * @brief Handle of a frame lent by a device without copying it.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ * 
+ * A device lends a frame by pointing the image of a LentFrame straight into
+ * its capture buffer, e.g. the DMA ring buffer of a Firewire camera. The
+ * buffer belongs to the device until release is called or the LentFrame is
+ * destroyed, which gives it back. Don't use the image afterwards. Devices
+ * lend one frame at a time, so release each frame before lending the next.
+ * A device, which stops capturing or is destroyed, takes back its frame and
+ * the image of the LentFrame becomes NULL.
+ */
+class LentFrame
+{
+public:
+	/**
+	 * @brief Base class of devices lending frames.
+	 * 
+	 * Keeps track of the lent frame and gives the buffer back by calling
+	 * returnBuffer once per lent frame.
+	 */
+	class Lender
+	{
+	public:
+		Lender();
+
+		/**
+		 * @brief Detach a frame, which is still lent, without returning it.
+		 * 
+		 * Derived classes call reclaim in their destructor, while the
+		 * buffer can still be returned.
+		 */
+		virtual ~Lender();
+
+	protected:
+		/**
+		 * @brief Lend an image to a frame.
+		 * @param frame The frame, which must not be lent.
+		 * @param image A view of the capture buffer, the frame deletes it on
+		 * release.
+		 */
+		void lend(LentFrame& frame, tt::ds::Image* image);
+
+		/**
+		 * @brief Release the lent frame, if any.
+		 */
+		void reclaim();
+
+		/**
+		 * @brief Return true, if a frame is lent.
+		 */
+		bool isLending() const;
+
+		/**
+		 * @brief Give the buffer of the lent frame back to the device.
+		 * 
+		 * Called by the release of the frame after its image was deleted.
+		 * Must not throw.
+		 */
+		virtual void returnBuffer() = 0;
+
+	private:
+		friend class LentFrame;
+
+		/** @brief The lent frame or NULL */
+		LentFrame* lentFrame;
+	};
+
+	/**
+	 * @brief Create a frame, which is not lent.
+	 */
+	LentFrame();
+
+	/**
+	 * @brief Release the frame.
+	 */
+	~LentFrame();
+
+	/**
+	 * @brief Return the lent image or NULL, if the frame is not lent.
+	 * 
+	 * The image doesn't own its buffer, see tt::ds::Image.
+	 */
+	tt::ds::Image* getImage() const;
+
+	/**
+	 * @brief Return true, if the frame is lent.
+	 */
+	bool isLent() const;
+
+	/**
+	 * @brief Give the frame back to the device, which lent it.
+	 * 
+	 * Does nothing, if the frame is not lent.
+	 */
+	void release();
+
+private:
+	/** @brief Frames can't be copied, a copy would release the buffer twice. */
+	LentFrame(const LentFrame& frame);
+	void operator = (const LentFrame& frame);
+
+	/** @brief The device, which lent the frame, or NULL */
+	Lender* lender;
+	/** @brief The lent image or NULL */
+	tt::ds::Image* image;
+};
+
+} // namespace input
+
+} // namespace tt
+
+#endif /*TT_INPUT_LENTFRAME_H*/
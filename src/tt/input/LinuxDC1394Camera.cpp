@@ -8,7 +8,9 @@
 #include <string>
 #include <sstream>
 #include <assert.h>
-#include <tracking/cvprocess/Bayer.h>
+#include <tt/ds/FramePool.h>
+#include <tt/process/Bayer.h>
+#include <tt/process/YUV.h>
 #include "LinuxDC1394Camera.h"
 
 #include <iostream>
@@ -38,12 +40,12 @@ LinuxDC1394Camera::LinuxDC1394Camera()
 	channel = currentChannel++; // Where is the documentation for channel?
 	cout << "iso channel = " << channel << endl;
 	speed = SPEED_400;
-	dmaBufNum = 16;
 	imageWidth = 640;
 	imageHeight = 480;
 	currentFrame = NULL;
 	currentRGBFrame = NULL;
 	colorMode = FirewireCamera::COLOR_RGB;
+	lostFrames = 0;
 }
 
 /**
@@ -51,6 +53,12 @@ LinuxDC1394Camera::LinuxDC1394Camera()
  */
 LinuxDC1394Camera::~LinuxDC1394Camera()
 {
+	// the capture thread uses the camera and the frames
+	stopAsyncCapture();
+	
+	// give back a lent frame while the DMA buffers still exist
+	reclaim();
+	
 	if (currentFrame != NULL)
 	{
 		delete currentFrame;
@@ -236,8 +244,8 @@ void LinuxDC1394Camera::captureStart()
 			QUERY_FROM_CAMERA, /* top */
 			USE_MAX_AVAIL, /* width */
 			USE_MAX_AVAIL, /* height */
-			this->dmaBufNum,
-			1, /* drop frames */
+			this->dmaBuffers,
+			0, /* drop frames, see captureFrame */
 			video1394devname.str().c_str(),
 			&(this->camera)) != DC1394_SUCCESS)
 		{
@@ -453,8 +461,8 @@ void LinuxDC1394Camera::captureStart()
 			dc1394Mode,
 			this->speed,
 			dc1394Framerate,
-			this->dmaBufNum,
-			1, // drop frames
+			this->dmaBuffers,
+			0, // drop frames, see captureFrame
 			video1394devname.str().c_str(),
 			&(this->camera)) != DC1394_SUCCESS)
 		{
@@ -500,12 +508,21 @@ void LinuxDC1394Camera::captureStart()
 				break;
 				
 			case FirewireCamera::MODE_160x120_YUV444:
+				this->colorMode = FirewireCamera::COLOR_YUV444;
+				break;
+				
 			case FirewireCamera::MODE_640x480_YUV411:
+				this->colorMode = FirewireCamera::COLOR_YUV411;
+				break;
+				
 			case FirewireCamera::MODE_640x480_MONO16:				
 			case FirewireCamera::MODE_800x600_MONO16:
 			case FirewireCamera::MODE_1024x768_MONO16:
 			case FirewireCamera::MODE_1280x960_MONO16:
 			case FirewireCamera::MODE_1600x1200_MONO16:
+				this->colorMode = FirewireCamera::COLOR_GREYSCALE16;
+				break;
+				
 			default:
 				throw std::runtime_error(functionSignature
 					+ " Sorry, color conversion for "
@@ -515,7 +532,8 @@ void LinuxDC1394Camera::captureStart()
 		}
 	}
 	
-	// allocate Images to store frames
+	// allocate Images to store frames, restarts get the buffers back from the pool
+	FramePool* pool = &FramePool::getDefault();
 	if (currentFrame != NULL)
 	{
 		delete currentFrame;
@@ -523,12 +541,21 @@ void LinuxDC1394Camera::captureStart()
 	switch (this->colorMode)
 	{
 		case FirewireCamera::COLOR_GREYSCALE:
-			currentFrame = new Image(this->imageWidth, this->imageHeight, Image::GREYSCALE);
+			currentFrame = new Image(this->imageWidth, this->imageHeight, Image::GREYSCALE,
+				Image::BPC8, pool);
+			break;
+
+		case FirewireCamera::COLOR_GREYSCALE16:
+			currentFrame = new Image(this->imageWidth, this->imageHeight, Image::GREYSCALE,
+				this->getFrameBitsPerChannel(), pool);
 			break;
 
 		case FirewireCamera::COLOR_RGB:
 		case FirewireCamera::COLOR_YUV422: /* jaja, this actually takes 2 bytes only, but we just need the buffer */
-			currentFrame = new Image(this->imageWidth, this->imageHeight, Image::RGB);
+		case FirewireCamera::COLOR_YUV444:
+		case FirewireCamera::COLOR_YUV411:
+			currentFrame = new Image(this->imageWidth, this->imageHeight, Image::RGB,
+				Image::BPC8, pool);
 			break;
 	}
 
@@ -536,7 +563,8 @@ void LinuxDC1394Camera::captureStart()
 	{
 		delete currentRGBFrame;
 	}
-	currentRGBFrame = new Image(this->imageWidth, this->imageHeight, Image::RGB);
+	currentRGBFrame = new Image(this->imageWidth, this->imageHeight, Image::RGB,
+		this->getFrameBitsPerChannel(), pool);
 	
 	if (dc1394_start_iso_transmission(this->rawHandle, this->cameraNode) != DC1394_SUCCESS)
 	{
@@ -544,6 +572,7 @@ void LinuxDC1394Camera::captureStart()
 			" unable to start iso transmission from camera.");
 	}
 
+	resetFrameCounters();
 	capturing = true;
 }
 
@@ -554,11 +583,16 @@ void LinuxDC1394Camera::captureStop()
 {
 	string functionSignature = "void LinuxDC1394Camera::captureStop()";
 
+	stopAsyncCapture();
+
 	if (!capturing)
 	{
 		throw std::runtime_error(functionSignature + " not in capture mode.");
 	}
 
+	// a lent frame can't outlive the DMA buffers
+	reclaim();
+
 	if (dc1394_dma_single_capture(&(this->camera)) != DC1394_SUCCESS)
 	{
 		throw std::runtime_error(functionSignature + " unable to capture a single frame.");	
@@ -589,6 +623,12 @@ void LinuxDC1394Camera::captureNext()
 		throw std::runtime_error(functionSignature + " not in capture mode.");
 	}
 	
+	if (isLending())
+	{
+		throw std::runtime_error(functionSignature + 
+			" a frame is lent, release it instead.");
+	}
+	
 	if (dc1394_dma_done_with_buffer(&(this->camera)) != DC1394_SUCCESS)
 	{
 		throw std::runtime_error(functionSignature + 
@@ -596,6 +636,64 @@ void LinuxDC1394Camera::captureNext()
 	}
 }
 
+/**
+ * @brief Capture the next frame of the DMA ring.
+ * 
+ * With LATEST_ONLY the newest frame. libdc1394 drops the frames behind the
+ * newest one without telling, so the ring is set up without dropping and
+ * they are given back here, where they can be counted.
+ */
+void LinuxDC1394Camera::captureFrame(const string& functionSignature)
+{
+	if (dc1394_dma_single_capture(&(this->camera)) != DC1394_SUCCESS)
+	{
+		throw std::runtime_error(functionSignature + " unable to capture a single frame.");	
+	}
+	
+	unsigned long dropped = 0;
+	while (getDeliveryPolicy() == ImageDevice::LATEST_ONLY &&
+		this->camera.num_dma_buffers_behind > 0)
+	{
+		if (dc1394_dma_done_with_buffer(&(this->camera)) != DC1394_SUCCESS)
+		{
+			throw std::runtime_error(functionSignature + 
+				" dc1394_dma_done_with_buffer() failed.");
+		}
+		if (dc1394_dma_single_capture(&(this->camera)) != DC1394_SUCCESS)
+		{
+			throw std::runtime_error(functionSignature + " unable to capture a single frame.");	
+		}
+		dropped++;
+	}
+	
+	// filltime is wall clock time, move it to the steady clock
+	std::chrono::system_clock::time_point filled = std::chrono::system_clock::time_point(
+		std::chrono::seconds(this->camera.filltime.tv_sec) +
+		std::chrono::microseconds(this->camera.filltime.tv_usec));
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::chrono::system_clock::duration age = std::chrono::system_clock::now() - filled;
+	std::chrono::steady_clock::time_point timestamp = age > std::chrono::system_clock::duration::zero() ?
+		now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(age) : now;
+	
+	// frames, which arrived while the ring was full, are missing between the
+	// fill times, Format 7 has no known framerate
+	if (getCapturedFrames() > 0 && this->videoFormat != FirewireCamera::FORMAT7)
+	{
+		unsigned long missing = estimateDroppedFrames(timestamp - this->fillTime);
+		if (missing > dropped)
+		{
+			dropped = missing;
+		}
+	}
+	this->fillTime = timestamp;
+	this->lostFrames = dropped;
+}
+
+void LinuxDC1394Camera::stampLastFrame(tt::ds::Image* image)
+{
+	stampFrame(image, this->fillTime, this->lostFrames, this->camera.dma_last_buffer);
+}
+
 /**
  * @brief Return a pointer to the next image.
  * @return Pointer to the image raw data within the dma ring buffer.
@@ -612,35 +710,127 @@ tt::ds::Image* LinuxDC1394Camera::getImage()
 		throw std::runtime_error(functionSignature + " not in capture mode.");
 	}
 	
-	if (dc1394_dma_single_capture(&(this->camera)) != DC1394_SUCCESS)
+	if (isLending())
 	{
-		throw std::runtime_error(functionSignature + " unable to capture a single frame.");	
+		throw std::runtime_error(functionSignature + 
+			" a frame is lent, release it first.");
 	}
+	
+	captureFrame(functionSignature);
+
+	// images sharing the frames keep the previous pixels and pyramids, the
+	// frames get new buffers instead of copies, since they are overwritten
+	this->currentFrame->discard();
+	this->currentRGBFrame->discard();
 
-	unsigned char* rgbImage;
-	unsigned char* greyImage;
 	switch (this->colorMode)
 	{
 		case FirewireCamera::COLOR_RGB:
 			// just copy directly to currentRGBFrame
-			rgbImage = this->currentRGBFrame->getImageBuffer();
-			memcpy(rgbImage, (unsigned char*)(this->camera.capture_buffer), this->bufferSize); 
+			this->copyPacked((unsigned char*)(this->camera.capture_buffer), this->currentRGBFrame);
+			this->correctColors(this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
 			break;
 			
 		case FirewireCamera::COLOR_GREYSCALE:
 			// copy from camera buffer to grey image
-			greyImage = this->currentFrame->getImageBuffer();
-			memcpy(greyImage, (unsigned char*)(this->camera.capture_buffer), this->bufferSize); 
-			Bayer::deBayer(this->currentFrame, this->currentRGBFrame, this->bayerFilter);
+			this->copyPacked((unsigned char*)(this->camera.capture_buffer), this->currentFrame);
+			this->deBayer(this->currentFrame, this->currentRGBFrame);
+			break;
+
+		case FirewireCamera::COLOR_GREYSCALE16:
+			// swap the big endian pixels while copying, reduce them to 8 bits
+			// if the frames have 8 bits per channel
+			this->convertMono16((unsigned char*)(this->camera.capture_buffer), this->currentFrame);
+			this->deBayer(this->currentFrame, this->currentRGBFrame);
 			break;
 
 		case FirewireCamera::COLOR_YUV422:
+			// convert directly from the dma buffer
+			tt::process::YUV::convert((unsigned char*)(this->camera.capture_buffer),
+				tt::process::YUV::FORMAT_YUV422, this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			this->correctColors(this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			break;
+
+		case FirewireCamera::COLOR_YUV444:
+			tt::process::YUV::convert((unsigned char*)(this->camera.capture_buffer),
+				tt::process::YUV::FORMAT_YUV444, this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			this->correctColors(this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			break;
+
+		case FirewireCamera::COLOR_YUV411:
+			tt::process::YUV::convert((unsigned char*)(this->camera.capture_buffer),
+				tt::process::YUV::FORMAT_YUV411, this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			this->correctColors(this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
 			break;
 	}
 
+	stampLastFrame(this->currentRGBFrame);
 	return this->currentRGBFrame;
 }
 
+/**
+ * @brief Lend the next frame straight from the DMA ring buffer.
+ * @param frame The handle for the frame, which must not be lent.
+ * 
+ * Captures the next frame like getImage, but instead of copying it, the
+ * image of the frame points into the DMA buffer. RGB frames are RGB images
+ * in RGB order, MONO8 frames are the raw GREYSCALE images, see
+ * setBayerFilter. Releasing the frame calls dc1394_dma_done_with_buffer
+ * instead of captureNext. libdc1394 gives back the buffers in the order
+ * they were captured, so only one frame can be lent at a time.
+ */
+void LinuxDC1394Camera::lendImage(LentFrame& frame)
+{
+	string functionSignature = "void LinuxDC1394Camera::lendImage(LentFrame& frame)";
+
+	if (!capturing)
+	{
+		throw std::runtime_error(functionSignature + " not in capture mode.");
+	}
+	
+	if (isLending())
+	{
+		throw std::runtime_error(functionSignature + 
+			" a frame is lent already, release it first.");
+	}
+	
+	if (frame.isLent())
+	{
+		throw std::runtime_error(functionSignature + " frame is lent already.");
+	}
+
+	Image::Channels channels;
+	switch (this->colorMode)
+	{
+		case FirewireCamera::COLOR_RGB:
+			channels = Image::RGB;
+			break;
+			
+		case FirewireCamera::COLOR_GREYSCALE:
+			channels = Image::GREYSCALE;
+			break;
+			
+		default:
+			throw std::runtime_error(functionSignature + 
+				" frames of Mode " + FirewireCamera::getVideoModeString(this->videoMode)
+				+ " need a conversion, use getImage.");
+	}
+
+	captureFrame(functionSignature);
+	
+	// the DMA frames are packed, the lines have no padding
+	Image* image = new Image((unsigned char*)(this->camera.capture_buffer), this->imageWidth,
+		this->imageHeight, this->imageWidth * channels, channels);
+	stampLastFrame(image);
+	lend(frame, image);
+}
+
+void LinuxDC1394Camera::returnBuffer()
+{
+	// called from release and destructors, so a failure can't be thrown
+	dc1394_dma_done_with_buffer(&(this->camera));
+}
+
 /**
  * @brief Returns the width of the captured image.
  * @return Width in pixel.
@@ -671,7 +861,7 @@ void LinuxDC1394Camera::getCaptureParameters(int& width, int& height,
 	width = this->imageWidth;
 	height = this->imageHeight;
 	channels = ds::Image::RGB;
-	bpc = ds::Image::BPC8;
+	bpc = this->getFrameBitsPerChannel();
 }
 
 void LinuxDC1394Camera::enableWhiteBalanceOnePush(bool enable)
@@ -686,12 +876,24 @@ void LinuxDC1394Camera::enableWhiteBalanceAuto(bool enable)
 
 void LinuxDC1394Camera::getWhiteBalance(unsigned int* ubValue, unsigned int* vrValue)
 {
+	if (this->whiteBalanceSoftware)
+	{
+		this->getWhiteBalanceSoftware(ubValue, vrValue);
+		return;
+	}
+
 	// TODO test
 	dc1394_get_white_balance(this->rawHandle, this->cameraNode, ubValue, vrValue);
 }
 
 void LinuxDC1394Camera::setWhiteBalance(unsigned int ubValue, unsigned int vrValue)
 {
+	if (this->whiteBalanceSoftware)
+	{
+		this->setWhiteBalanceSoftware(ubValue, vrValue);
+		return;
+	}
+
 	// TODO test
 	dc1394_set_white_balance(this->rawHandle, this->cameraNode, ubValue, vrValue);
 }
@@ -22,8 +22,17 @@ namespace input
  * LinuxDC1394Camera implements the Camera interface for Firewire cameras
  * on Linux platforms and is based on the two open source libraries
  * libraw1394 and libdc1394.
+ * 
+ * lendImage lends RGB and MONO8 frames straight from the DMA ring buffer,
+ * without the copy of getImage.
+ * 
+ * The DMA ring is set up with setDMABuffers buffers. With LATEST_ONLY the
+ * frames behind the newest one are given back by the camera instead of
+ * libdc1394, so they are counted as dropped. Frames lost while the ring was
+ * full are estimated from the fill times of the frames, except in Format 7.
+ * The timestamp of a frame is the time the driver filled its buffer.
  */
-class LinuxDC1394Camera : public tt::input::FirewireCamera
+class LinuxDC1394Camera : public tt::input::FirewireCamera, private LentFrame::Lender
 {
 private:
 	/** @brief Index of the camera */
@@ -44,8 +53,6 @@ private:
 	static int currentChannel;
 	/** @brief The libdc1394 speed. See documentation of libdc1394. */
 	int speed;
-	/** @brief The number of buffers libdc1394 should use for capturing images. See documentation of libdc1394. */
-	int dmaBufNum;
 	/** @brief Width of the captured image. */
 	int imageWidth;
 	/** @brief Height of the captured image. */
@@ -58,6 +65,19 @@ private:
 	tt::ds::Image* currentFrame;
 	/** @brief The grabbed frame as a RGB image */ 
 	tt::ds::Image* currentRGBFrame;
+	/** @brief The time the driver filled the buffer of the last frame. */
+	std::chrono::steady_clock::time_point fillTime;
+	/** @brief The frames dropped before the last frame. */
+	unsigned long lostFrames;
+
+	/** @brief Capture the newest frame and count the older ones as dropped. */
+	void captureFrame(const std::string& functionSignature);
+
+	/** @brief Stamp a frame with the metadata of the last captured frame. */
+	void stampLastFrame(tt::ds::Image* image);
+
+	/** @brief Give the DMA buffer of a lent frame back to libdc1394. */
+	virtual void returnBuffer();
 	
 public:
 	LinuxDC1394Camera();
@@ -70,6 +90,7 @@ public:
 	virtual void captureStop();
 	virtual void captureNext();
 	virtual tt::ds::Image* getImage();
+	virtual void lendImage(LentFrame& frame);
 	virtual const int getImageWidth() const;
 	virtual const int getImageHeight() const;
 	virtual void getCaptureParameters(int& width, int& height, 
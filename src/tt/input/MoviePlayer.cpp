@@ -6,6 +6,7 @@
 #include "MoviePlayer.h"
 
 #include <math.h>
+#include <tt/ds/FramePool.h>
 
 namespace tt
 {
@@ -25,10 +26,19 @@ MoviePlayer::MoviePlayer()
 	m_finished = true;
 	m_image = NULL;
 	m_maxmsec = 0.0f;
+	m_readAhead = 0;
+	m_decodedFrames = NULL;
+	m_freeFrames = NULL;
+	m_stopping = false;
+	m_decoderFinished = true;
 }
 
 MoviePlayer::~MoviePlayer()
 {
+	// the capture thread uses the capture and the image
+	stopAsyncCapture();
+	stopDecoder();
+	
 	if (m_capture)
 	{
 		cvReleaseCapture(&m_capture);
@@ -60,6 +70,12 @@ void MoviePlayer::captureNext()
 	
 	m_end = clock();
 	
+	if (m_readAhead > 0)
+	{
+		takeDecodedFrame();
+		return;
+	}
+	
 	// film current position in milliseconds
 	//double msec = (m_end - m_start) * 1000 / CLOCKS_PER_SEC * m_speed;
 	
@@ -77,7 +93,10 @@ void MoviePlayer::captureNext()
 		m_finished = true;
 	// FIXED BUG: at the end of the sequence, the next image is absent!
 	else
-		cvCopy(img, m_image->getIplImage());
+	{
+		wrapFrame(img);
+		stampFrame(m_image, std::chrono::steady_clock::now(), 0, -1);
+	}
 }
 
 void MoviePlayer::captureStart()
@@ -91,27 +110,218 @@ void MoviePlayer::captureStart()
 	
 	m_start = clock();
 
+	// the decoder of a previous start reads the capture
+	stopDecoder();
 	cvSetCaptureProperty(m_capture, CV_CAP_PROP_POS_MSEC, 0);
+	resetFrameCounters();
+	this->m_finished = false;
+	
+	if (m_readAhead > 0)
+	{
+		// the current frame may wrap the buffer of the capture
+		if (m_image)
+		{
+			delete m_image;
+			m_image = NULL;
+		}
+		startDecoder();
+		takeDecodedFrame();
+		return;
+	}
+	
 	cvGrabFrame(m_capture);
 	
 	IplImage *img = cvRetrieveFrame(m_capture);
+	
+	wrapFrame(img);
+	stampFrame(m_image, std::chrono::steady_clock::now(), 0, -1);
+}
+
+void MoviePlayer::captureStop()
+{
+	stopAsyncCapture();
+	stopDecoder();
+	
 	if (m_image)
 	{
 		delete m_image;
+		m_image = NULL;
 	}
-	this->m_finished = false;
-	m_image = new tt::ds::Image(img);
+
+	this->m_finished = true;
 }
 
-void MoviePlayer::captureStop()
+void MoviePlayer::wrapFrame(IplImage* frame)
 {
+	// the capture usually decodes every frame into the same buffer, shares
+	// of the previous frame copied its pixels
+	if (m_image != NULL &&
+		((const tt::ds::Image*) m_image)->getImageBuffer() == (unsigned char*) frame->imageData &&
+		m_image->getWidth() == frame->width && m_image->getHeight() == frame->height &&
+		m_image->getChannels() == frame->nChannels &&
+		m_image->getAllocatedWidth() == frame->widthStep)
+	{
+		// the pixels are new, drop the pyramid of the previous frame
+		m_image->detach();
+		return;
+	}
+	
 	if (m_image)
 	{
 		delete m_image;
-		m_image = NULL;
 	}
+	m_image = new tt::ds::Image(tt::ds::Image::wrap(frame));
+}
 
-	this->m_finished = true;
+void MoviePlayer::startDecoder()
+{
+	m_decodedFrames = new tt::sys::SPSCQueue<tt::ds::Image*>(m_readAhead);
+	// captureNext gives back the previous current frame
+	m_freeFrames = new tt::sys::SPSCQueue<tt::ds::Image*>(m_readAhead + 2);
+	m_stopping = false;
+	m_decoderFinished = false;
+	m_error = std::exception_ptr();
+	m_decoder = std::thread(&MoviePlayer::decodeLoop, this);
+}
+
+void MoviePlayer::stopDecoder()
+{
+	if (!m_decoder.joinable())
+	{
+		return;
+	}
+	
+	m_stopping = true;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+	}
+	m_frameTaken.notify_all();
+	m_decoder.join();
+	
+	tt::ds::Image* image;
+	while (m_decodedFrames->pop(image))
+	{
+		delete image;
+	}
+	while (m_freeFrames->pop(image))
+	{
+		delete image;
+	}
+	delete m_decodedFrames;
+	delete m_freeFrames;
+	m_decodedFrames = NULL;
+	m_freeFrames = NULL;
+	m_error = std::exception_ptr();
+}
+
+void MoviePlayer::decodeLoop()
+{
+	try
+	{
+		while (!m_stopping)
+		{
+			if (!cvGrabFrame(m_capture))
+			{
+				break;
+			}
+			IplImage *img = cvRetrieveFrame(m_capture);
+			if (!img)
+			{
+				break;
+			}
+			
+			// the capture decodes into its own buffer, copy it into a
+			// handed back frame or a new one from the pool
+			tt::ds::Image* frame;
+			if (!m_freeFrames->pop(frame))
+			{
+				frame = new tt::ds::Image(img->width, img->height,
+					(tt::ds::Image::Channels) img->nChannels, tt::ds::Image::BPC8,
+					&tt::ds::FramePool::getDefault());
+			}
+			const tt::ds::Image decoded = tt::ds::Image::wrap(img);
+			*frame = decoded;
+			tt::ds::FrameInfo info;
+			info.timestamp = std::chrono::steady_clock::now();
+			frame->setFrameInfo(info);
+			
+			{
+				// captureNext takes the mutex between taking a frame and
+				// notifying, so a freed place is never missed
+				std::unique_lock<std::mutex> lock(m_mutex);
+				while (m_decodedFrames->isFull() && !m_stopping)
+				{
+					m_frameTaken.wait(lock);
+				}
+			}
+			if (m_stopping)
+			{
+				delete frame;
+				break;
+			}
+			m_decodedFrames->push(frame);
+			
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+			}
+			m_frameDecoded.notify_one();
+		}
+	}
+	catch (...)
+	{
+		m_error = std::current_exception();
+	}
+	
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_decoderFinished = true;
+	}
+	m_frameDecoded.notify_all();
+}
+
+void MoviePlayer::takeDecodedFrame()
+{
+	tt::ds::Image* frame;
+	if (!m_decodedFrames->pop(frame))
+	{
+		// the decoder takes the mutex between queueing and notifying, so a
+		// frame queued after the check is never missed
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (!m_decodedFrames->pop(frame))
+		{
+			if (m_decoderFinished)
+			{
+				// frames queued before the end were taken already
+				if (m_decodedFrames->pop(frame))
+				{
+					break;
+				}
+				lock.unlock();
+				this->m_finished = true;
+				if (m_error)
+				{
+					std::exception_ptr e = m_error;
+					m_error = std::exception_ptr();
+					std::rethrow_exception(e);
+				}
+				return;
+			}
+			m_frameDecoded.wait(lock);
+		}
+	}
+	
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+	}
+	m_frameTaken.notify_one();
+	
+	// the previous frame goes back to the decoder, shares keep its pixels
+	if (m_image != NULL && !m_freeFrames->push(m_image))
+	{
+		delete m_image;
+	}
+	m_image = frame;
+	stampFrame(m_image, m_image->getFrameInfo().timestamp, 0, -1);
 }
 
 void MoviePlayer::close() 
@@ -123,6 +333,18 @@ bool MoviePlayer::isFinished() const
 	return m_finished;
 }
 
+tt::ds::Image* MoviePlayer::captureAsync()
+{
+	captureNext();
+	
+	// the last frame isn't delivered again at the end of the video
+	if (this->m_finished)
+	{
+		return NULL;
+	}
+	return m_image;
+}
+
 tt::ds::Image* MoviePlayer::getImage()
 {
 	std::string functionSignature = "tracking::ds::Image* MoviePlayer::getImage()";
@@ -185,6 +407,15 @@ void MoviePlayer::open(std::string filename)
 	
 	m_filename = filename;
 
+	// the capture thread and the decoder read the previous capture, the
+	// current frame may wrap its buffer
+	stopAsyncCapture();
+	stopDecoder();
+	if (m_image)
+	{
+		delete m_image;
+		m_image = NULL;
+	}
 	if (m_capture) {
 		cvReleaseCapture(&m_capture);
 	}
@@ -208,6 +439,22 @@ void MoviePlayer::setSpeed(double factor)
 	m_speed = factor;
 }
 
+void MoviePlayer::setReadAhead(int frames)
+{
+	std::string functionSignature = "void MoviePlayer::setReadAhead(int frames)";
+	
+	if (frames < 0)
+	{
+		throw std::runtime_error(functionSignature + " frames out of range.");
+	}
+	m_readAhead = frames;
+}
+
+int MoviePlayer::getReadAhead() const
+{
+	return m_readAhead;
+}
+
 } // namespace input
 
 } // namespace tt
@@ -3,11 +3,17 @@
 
 #include <cv.h>
 #include <highgui.h>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <time.h>
 
 #include <tt/input/ImageDevice.h>
 #include <tt/ds/Image.h>
+#include <tt/sys/SPSCQueue.h>
 
 namespace tt
 {
@@ -19,6 +25,15 @@ namespace input
  * @class MoviePlayer MoviePlayer.h tt/input/MoviePlayer.h
  * @brief class to capture images from a video file
  * @author Thomas Friedlhuber <friedlhu@in.tum.de>
+ *
+ * The frames are stamped with the time they were decoded, a video drops
+ * no frames and has no buffer index.
+ *
+ * By default captureNext decodes the next frame and getImage returns it
+ * without copying. With setReadAhead a decoder thread copies the decoded
+ * frames into pooled images and queues them ahead of the application, so
+ * decoding overlaps the processing. The decoder waits while the queue is
+ * full, no frame is skipped.
  **/
 class MoviePlayer : public tt::input::ImageDevice
 {
@@ -113,8 +128,55 @@ public:
 	 * the faster the video is running. A value of 1.0 means realtime.
 	 **/
 	void setSpeed(double factor);
+
+	/**
+	 * set the number of frames a decoder thread decodes ahead of captureNext.
+	 * Takes effect at the next captureStart or open.
+	 * @param frames queue depth, 0 decodes in captureNext, which is the default
+	 **/
+	void setReadAhead(int frames);
+
+	/**
+	 * get the number of frames decoded ahead of captureNext
+	 * @return queue depth, 0 if captureNext decodes
+	 **/
+	int getReadAhead() const;
+
+protected:
+	/**
+	 * capture next image in the capture thread
+	 * @return image data or NULL at the end of the video
+	 **/
+	virtual tt::ds::Image* captureAsync();
 		
 private:
+	/**
+	 * let m_image wrap a frame of the capture without copying it
+	 * @param frame frame, which stays valid until the next grab
+	 **/
+	void wrapFrame(IplImage* frame);
+
+	/**
+	 * start the decoder thread with an empty queue
+	 **/
+	void startDecoder();
+
+	/**
+	 * stop the decoder thread and delete the decoded frames
+	 **/
+	void stopDecoder();
+
+	/**
+	 * main loop of the decoder thread
+	 **/
+	void decodeLoop();
+
+	/**
+	 * make the next decoded frame the current one, waiting for it if
+	 * necessary, or set m_finished after the last one
+	 **/
+	void takeDecodedFrame();
+	
 	
 	/** capture instance for opencv **/
 	CvCapture *m_capture;
@@ -128,7 +190,7 @@ private:
 	/** states if video is finished **/
 	bool m_finished;
 	
-	/** image data **/
+	/** image data, wraps the last frame of the capture **/
 	tt::ds::Image* m_image;
 
 	/** milliseconds of video file **/
@@ -139,6 +201,36 @@ private:
 	  
 	/** timestamp of first captured image **/
 	clock_t m_start;
+
+	/** number of frames decoded ahead, 0 if captureNext decodes **/
+	int m_readAhead;
+
+	/** decoder thread of the read ahead **/
+	std::thread m_decoder;
+
+	/** decoded frames waiting for captureNext **/
+	tt::sys::SPSCQueue<tt::ds::Image*>* m_decodedFrames;
+
+	/** frames given back by captureNext for reuse by the decoder **/
+	tt::sys::SPSCQueue<tt::ds::Image*>* m_freeFrames;
+
+	/** true if stopDecoder asks the decoder thread to quit **/
+	std::atomic<bool> m_stopping;
+
+	/** true after the decoder thread queued its last frame **/
+	std::atomic<bool> m_decoderFinished;
+
+	/** exception, which stopped the decoder thread **/
+	std::exception_ptr m_error;
+
+	/** protects waiting for decoded frames and free places in the queue **/
+	std::mutex m_mutex;
+
+	/** signals a decoded frame or the end of the decoder thread **/
+	std::condition_variable m_frameDecoded;
+
+	/** signals a frame taken from the queue **/
+	std::condition_variable m_frameTaken;
 	
 	/** default filename */
 	static const std::string DEFAULT_FILENAME;
@@ -0,0 +1,101 @@
+/*
+ * SimulatedDMARing
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <string.h>
+#include <stdexcept>
+#include <string>
+#include "SimulatedDMARing.h"
+
+namespace tt
+{
+
+namespace input
+{
+
+const unsigned char SimulatedDMARing::RETURNED_BYTE;
+
+SimulatedDMARing::SimulatedDMARing(int width, int height,
+	tt::ds::Image::Channels channels, int buffers) :
+	width(width),
+	height(height),
+	channels(channels),
+	ring(width * height * channels * buffers, RETURNED_BYTE),
+	buffers(buffers),
+	currentBuffer(-1),
+	capturedFrames(0),
+	returnedFrames(0),
+	stopped(false)
+{
+}
+
+SimulatedDMARing::~SimulatedDMARing()
+{
+	reclaim();
+}
+
+void SimulatedDMARing::lendImage(LentFrame& frame)
+{
+	std::string functionSignature = "void SimulatedDMARing::lendImage(LentFrame& frame)";
+	
+	if (stopped)
+	{
+		throw std::runtime_error(functionSignature + " not in capture mode.");
+	}
+	if (isLending())
+	{
+		throw std::runtime_error(functionSignature + 
+			" a frame is lent already, release it first.");
+	}
+	if (frame.isLent())
+	{
+		throw std::runtime_error(functionSignature + " frame is lent already.");
+	}
+	
+	// the camera fills the next buffer of the ring
+	int lineBytes = width * channels;
+	currentBuffer = (currentBuffer + 1) % buffers;
+	capturedFrames++;
+	unsigned char* buffer = &ring[currentBuffer * lineBytes * height];
+	memset(buffer, capturedFrames & 0xff, lineBytes * height);
+	
+	lend(frame, new tt::ds::Image(buffer, width, height, lineBytes, channels));
+}
+
+void SimulatedDMARing::stop()
+{
+	reclaim();
+	stopped = true;
+}
+
+int SimulatedDMARing::getCapturedFrames() const
+{
+	return capturedFrames;
+}
+
+int SimulatedDMARing::getReturnedFrames() const
+{
+	return returnedFrames;
+}
+
+bool SimulatedDMARing::isFrameLent() const
+{
+	return isLending();
+}
+
+const unsigned char* SimulatedDMARing::getBuffer(int index) const
+{
+	return &ring[index * width * height * channels];
+}
+
+void SimulatedDMARing::returnBuffer()
+{
+	int bufferBytes = width * height * channels;
+	memset(&ring[currentBuffer * bufferBytes], RETURNED_BYTE, bufferBytes);
+	returnedFrames++;
+}
+
+} // namespace input
+
+} // namespace tt
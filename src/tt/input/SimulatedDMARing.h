@@ -0,0 +1,102 @@
+#ifndef TT_INPUT_SIMULATEDDMARING_H
+#define TT_INPUT_SIMULATEDDMARING_H
+
+#include <vector>
+#include <tt/ds/Image.h>
+#include "LentFrame.h"
+
+namespace tt
+{
+
+namespace input
+{
+
+/**
+ * @class SimulatedDMARing SimulatedDMARing.h tt/input/SimulatedDMARing.h
+ * @brief Simulation of the DMA ring buffer of a Firewire camera.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ * 
+ * Lends frames like LinuxDC1394Camera::lendImage, but from a ring of
+ * buffers in memory, so the lifetime and the release order of lent frames
+ * can be checked without a camera. Every byte of the n-th captured frame
+ * (starting at 1) is n modulo 256. A returned buffer is overwritten with
+ * RETURNED_BYTE, like a buffer refilled by the camera, so reading a
+ * released image shows up at once.
+ */
+class SimulatedDMARing : public LentFrame::Lender
+{
+public:
+	/** @brief The value of the bytes of returned buffers. */
+	static const unsigned char RETURNED_BYTE = 0xdd;
+
+	/**
+	 * @brief Create a ring of buffers for packed frames.
+	 * @param width Width of the frames.
+	 * @param height Height of the frames.
+	 * @param channels Number of channels of the frames.
+	 * @param buffers Number of buffers in the ring.
+	 */
+	SimulatedDMARing(int width, int height,
+		tt::ds::Image::Channels channels = tt::ds::Image::GREYSCALE, int buffers = 4);
+
+	/**
+	 * @brief Take back a frame, which is still lent.
+	 */
+	virtual ~SimulatedDMARing();
+
+	/**
+	 * @brief Capture the next frame and lend it.
+	 * @param frame The handle for the frame, which must not be lent.
+	 * 
+	 * Throws a std::runtime_error, if a frame is lent already or the ring
+	 * is stopped.
+	 */
+	void lendImage(LentFrame& frame);
+
+	/**
+	 * @brief Stop capturing like captureStop, which takes back a lent frame.
+	 */
+	void stop();
+
+	/**
+	 * @brief Return the number of captured frames.
+	 */
+	int getCapturedFrames() const;
+
+	/**
+	 * @brief Return the number of returned frames.
+	 */
+	int getReturnedFrames() const;
+
+	/**
+	 * @brief Return true, if a frame is lent.
+	 */
+	bool isFrameLent() const;
+
+	/**
+	 * @brief Return the first byte of a buffer of the ring.
+	 */
+	const unsigned char* getBuffer(int index) const;
+
+protected:
+	virtual void returnBuffer();
+
+private:
+	int width;
+	int height;
+	tt::ds::Image::Channels channels;
+	/** @brief All buffers of the ring, one after the other */
+	std::vector<unsigned char> ring;
+	int buffers;
+	/** @brief Index of the buffer of the last captured frame */
+	int currentBuffer;
+	int capturedFrames;
+	int returnedFrames;
+	bool stopped;
+};
+
+} // namespace input
+
+} // namespace tt
+
+#endif /*TT_INPUT_SIMULATEDDMARING_H*/
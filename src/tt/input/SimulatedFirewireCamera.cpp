@@ -0,0 +1,631 @@
+/*
+ * SimulatedFirewireCamera
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <string.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tt/ds/FramePool.h>
+#include <tt/process/Bayer.h>
+#include <tt/process/YUV.h>
+#include "SimulatedFirewireCamera.h"
+
+using namespace std;
+using namespace tt::ds;
+
+namespace tt
+{
+
+namespace input
+{
+
+int SimulatedFirewireCamera::simulatedCameras = 0;
+
+SimulatedFirewireCamera::SimulatedFirewireCamera() :
+	cameraIndex(0),
+	opened(false),
+	capturing(false),
+	jitter(0),
+	format7Width(640),
+	format7Height(480),
+	imageWidth(640),
+	imageHeight(480),
+	lineBytes(640),
+	colorMode(FirewireCamera::COLOR_GREYSCALE),
+	framePeriod(0),
+	nextFrame(0),
+	frameNumber(0),
+	lostFrames(0),
+	currentFrame(NULL),
+	currentRGBFrame(NULL)
+{
+}
+
+SimulatedFirewireCamera::~SimulatedFirewireCamera()
+{
+	// the capture thread uses the camera and the frames
+	stopAsyncCapture();
+
+	reclaim();
+
+	if (currentFrame != NULL)
+	{
+		delete currentFrame;
+	}
+	if (currentRGBFrame != NULL)
+	{
+		delete currentRGBFrame;
+	}
+}
+
+void SimulatedFirewireCamera::open()
+{
+	string functionSignature = "void SimulatedFirewireCamera::open()";
+
+	if (simulatedCameras > 0 && cameraIndex >= simulatedCameras)
+	{
+		throw std::runtime_error(functionSignature + " no camera found.");
+	}
+	opened = true;
+}
+
+void SimulatedFirewireCamera::close()
+{
+	opened = false;
+}
+
+void SimulatedFirewireCamera::init()
+{
+}
+
+void SimulatedFirewireCamera::captureStart()
+{
+	string functionSignature = "void SimulatedFirewireCamera::captureStart()";
+
+	if (!opened)
+	{
+		throw std::runtime_error(functionSignature + " camera is not open.");
+	}
+	if (capturing)
+	{
+		throw std::runtime_error(functionSignature +
+			" already in capture mode.");
+	}
+
+	// the frame sizes and color codings of the IIDC modes
+	bool format7 = this->videoFormat == FirewireCamera::FORMAT7;
+	bool format7Mode = this->videoMode == FirewireCamera::MODE0 ||
+		this->videoMode == FirewireCamera::MODE1;
+	if (format7 != format7Mode)
+	{
+		throw std::runtime_error(functionSignature
+			+ " Format " + FirewireCamera::getVideoFormatString(this->videoFormat)
+			+ ", Mode " + FirewireCamera::getVideoModeString(this->videoMode)
+			+ " not supported.");
+	}
+
+	int width = this->format7Width;
+	int height = this->format7Height;
+	Color color = FirewireCamera::COLOR_GREYSCALE;
+	switch (this->videoMode)
+	{
+		case FirewireCamera::MODE0:
+		case FirewireCamera::MODE1:
+			break;
+
+		case FirewireCamera::MODE_160x120_YUV444:
+			width = 160; height = 120; color = FirewireCamera::COLOR_YUV444;
+			break;
+
+		case FirewireCamera::MODE_320x240_YUV422:
+			width = 320; height = 240; color = FirewireCamera::COLOR_YUV422;
+			break;
+
+		case FirewireCamera::MODE_640x480_YUV411:
+			width = 640; height = 480; color = FirewireCamera::COLOR_YUV411;
+			break;
+
+		case FirewireCamera::MODE_640x480_YUV422:
+			width = 640; height = 480; color = FirewireCamera::COLOR_YUV422;
+			break;
+
+		case FirewireCamera::MODE_640x480_RGB:
+			width = 640; height = 480; color = FirewireCamera::COLOR_RGB;
+			break;
+
+		case FirewireCamera::MODE_640x480_MONO8:
+			width = 640; height = 480; color = FirewireCamera::COLOR_GREYSCALE;
+			break;
+
+		case FirewireCamera::MODE_640x480_MONO16:
+			width = 640; height = 480; color = FirewireCamera::COLOR_GREYSCALE16;
+			break;
+
+		case FirewireCamera::MODE_800x600_YUV422:
+			width = 800; height = 600; color = FirewireCamera::COLOR_YUV422;
+			break;
+
+		case FirewireCamera::MODE_800x600_RGB:
+			width = 800; height = 600; color = FirewireCamera::COLOR_RGB;
+			break;
+
+		case FirewireCamera::MODE_800x600_MONO8:
+			width = 800; height = 600; color = FirewireCamera::COLOR_GREYSCALE;
+			break;
+
+		case FirewireCamera::MODE_800x600_MONO16:
+			width = 800; height = 600; color = FirewireCamera::COLOR_GREYSCALE16;
+			break;
+
+		case FirewireCamera::MODE_1024x768_YUV422:
+			width = 1024; height = 768; color = FirewireCamera::COLOR_YUV422;
+			break;
+
+		case FirewireCamera::MODE_1024x768_RGB:
+			width = 1024; height = 768; color = FirewireCamera::COLOR_RGB;
+			break;
+
+		case FirewireCamera::MODE_1024x768_MONO8:
+			width = 1024; height = 768; color = FirewireCamera::COLOR_GREYSCALE;
+			break;
+
+		case FirewireCamera::MODE_1024x768_MONO16:
+			width = 1024; height = 768; color = FirewireCamera::COLOR_GREYSCALE16;
+			break;
+
+		case FirewireCamera::MODE_1280x960_YUV422:
+			width = 1280; height = 960; color = FirewireCamera::COLOR_YUV422;
+			break;
+
+		case FirewireCamera::MODE_1280x960_RGB:
+			width = 1280; height = 960; color = FirewireCamera::COLOR_RGB;
+			break;
+
+		case FirewireCamera::MODE_1280x960_MONO8:
+			width = 1280; height = 960; color = FirewireCamera::COLOR_GREYSCALE;
+			break;
+
+		case FirewireCamera::MODE_1280x960_MONO16:
+			width = 1280; height = 960; color = FirewireCamera::COLOR_GREYSCALE16;
+			break;
+
+		case FirewireCamera::MODE_1600x1200_YUV422:
+			width = 1600; height = 1200; color = FirewireCamera::COLOR_YUV422;
+			break;
+
+		case FirewireCamera::MODE_1600x1200_RGB:
+			width = 1600; height = 1200; color = FirewireCamera::COLOR_RGB;
+			break;
+
+		case FirewireCamera::MODE_1600x1200_MONO8:
+			width = 1600; height = 1200; color = FirewireCamera::COLOR_GREYSCALE;
+			break;
+
+		case FirewireCamera::MODE_1600x1200_MONO16:
+			width = 1600; height = 1200; color = FirewireCamera::COLOR_GREYSCALE16;
+			break;
+
+		default:
+			throw std::runtime_error(functionSignature
+				+ " Format " + FirewireCamera::getVideoFormatString(this->videoFormat)
+				+ ", Mode " + FirewireCamera::getVideoModeString(this->videoMode)
+				+ " not supported.");
+			break;
+	}
+
+	switch (color)
+	{
+		case FirewireCamera::COLOR_GREYSCALE:
+			this->lineBytes = width;
+			break;
+
+		case FirewireCamera::COLOR_GREYSCALE16:
+			this->lineBytes = 2 * width;
+			break;
+
+		case FirewireCamera::COLOR_RGB:
+			this->lineBytes = 3 * width;
+			break;
+
+		case FirewireCamera::COLOR_YUV444:
+			this->lineBytes = tt::process::YUV::getLineBytes(tt::process::YUV::FORMAT_YUV444, width);
+			break;
+
+		case FirewireCamera::COLOR_YUV422:
+			this->lineBytes = tt::process::YUV::getLineBytes(tt::process::YUV::FORMAT_YUV422, width);
+			break;
+
+		case FirewireCamera::COLOR_YUV411:
+			this->lineBytes = tt::process::YUV::getLineBytes(tt::process::YUV::FORMAT_YUV411, width);
+			break;
+	}
+
+	int framerate = this->videoFramerate;
+	if (framerate < FirewireCamera::FRAMERATE_1_875 || framerate > FirewireCamera::FRAMERATE_240)
+	{
+		throw std::runtime_error(functionSignature
+			+ " Framerate " + FirewireCamera::getVideoFramerateString(this->videoFramerate)
+			+ " not supported.");
+	}
+	this->framePeriod = getFramePeriod();
+
+	this->imageWidth = width;
+	this->imageHeight = height;
+	this->colorMode = color;
+	this->ring.assign((size_t) this->dmaBuffers * this->lineBytes * height, 0);
+
+	// allocate Images to store frames, restarts get the buffers back from the pool
+	FramePool* pool = &FramePool::getDefault();
+	if (currentFrame != NULL)
+	{
+		delete currentFrame;
+		currentFrame = NULL;
+	}
+	if (color == FirewireCamera::COLOR_GREYSCALE)
+	{
+		currentFrame = new Image(width, height, Image::GREYSCALE, Image::BPC8, pool);
+	}
+	else if (color == FirewireCamera::COLOR_GREYSCALE16)
+	{
+		currentFrame = new Image(width, height, Image::GREYSCALE,
+			this->getFrameBitsPerChannel(), pool);
+	}
+
+	if (currentRGBFrame != NULL)
+	{
+		delete currentRGBFrame;
+	}
+	currentRGBFrame = new Image(width, height, Image::RGB,
+		this->getFrameBitsPerChannel(), pool);
+
+	this->nextFrame = 0;
+	this->frameNumber = 0;
+	this->lostFrames = 0;
+	resetFrameCounters();
+
+	// frames arrive at multiples of the frame period of the steady clock, so
+	// cameras with the same framerate are in phase like synchronized cameras
+	std::chrono::steady_clock::duration now = std::chrono::steady_clock::now().time_since_epoch();
+	long long periods = (now + this->framePeriod - std::chrono::nanoseconds(1)) / this->framePeriod;
+	this->startTime = std::chrono::steady_clock::time_point() + this->framePeriod * periods;
+	capturing = true;
+}
+
+void SimulatedFirewireCamera::captureStop()
+{
+	string functionSignature = "void SimulatedFirewireCamera::captureStop()";
+
+	stopAsyncCapture();
+
+	if (!capturing)
+	{
+		throw std::runtime_error(functionSignature + " not in capture mode.");
+	}
+
+	reclaim();
+	capturing = false;
+}
+
+void SimulatedFirewireCamera::captureNext()
+{
+	string functionSignature = "void SimulatedFirewireCamera::captureNext()";
+
+	if (!capturing)
+	{
+		throw std::runtime_error(functionSignature + " not in capture mode.");
+	}
+
+	if (isLending())
+	{
+		throw std::runtime_error(functionSignature +
+			" a frame is lent, release it instead.");
+	}
+}
+
+std::chrono::steady_clock::time_point SimulatedFirewireCamera::getArrivalTime(
+	unsigned long frame) const
+{
+	std::chrono::steady_clock::time_point arrival = startTime + framePeriod * (long long) frame;
+	if (jitter == 0)
+	{
+		return arrival;
+	}
+
+	// a hash of the camera and the frame gives the same delays in every run
+	unsigned long long hash = ((unsigned long long) cameraIndex << 48) ^ frame;
+	hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+	hash = hash ^ (hash >> 31);
+	return arrival + std::chrono::microseconds(hash % ((unsigned long long) jitter + 1));
+}
+
+const unsigned char* SimulatedFirewireCamera::capture()
+{
+	// wait for the next frame
+	std::this_thread::sleep_until(getArrivalTime(nextFrame));
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	// the newest frame, which has arrived, no later frame arrives before its period
+	unsigned long newest = nextFrame + (unsigned long) ((now - getArrivalTime(nextFrame)) / framePeriod);
+	while (newest > nextFrame && getArrivalTime(newest) > now)
+	{
+		newest--;
+	}
+
+	// the frames, which don't fit into the ring, were overwritten
+	unsigned long frame = nextFrame;
+	if (getDeliveryPolicy() == ImageDevice::LATEST_ONLY)
+	{
+		frame = newest;
+	}
+	else if (newest - nextFrame >= (unsigned long) dmaBuffers)
+	{
+		frame = newest - dmaBuffers + 1;
+	}
+	lostFrames = frame - nextFrame;
+	nextFrame = frame + 1;
+	frameNumber = frame;
+
+	// the camera filled the buffer of the frame in the ring
+	unsigned char* buffer = &ring[(frame % dmaBuffers) * lineBytes * imageHeight];
+	fillFrame(buffer, lineBytes, imageHeight, frame, cameraIndex);
+	return buffer;
+}
+
+void SimulatedFirewireCamera::stampLastFrame(tt::ds::Image* image)
+{
+	ImageDevice::stampFrame(image, getArrivalTime(frameNumber), lostFrames,
+		(int) (frameNumber % dmaBuffers));
+}
+
+tt::ds::Image* SimulatedFirewireCamera::getImage()
+{
+	string functionSignature = "tt::ds::Image* SimulatedFirewireCamera::getImage()";
+
+	if (!capturing)
+	{
+		throw std::runtime_error(functionSignature + " not in capture mode.");
+	}
+
+	if (isLending())
+	{
+		throw std::runtime_error(functionSignature +
+			" a frame is lent, release it first.");
+	}
+
+	const unsigned char* buffer = capture();
+
+	// images sharing the frames keep the previous pixels and pyramids, the
+	// frames get new buffers instead of copies, since they are overwritten
+	if (this->currentFrame != NULL)
+	{
+		this->currentFrame->discard();
+	}
+	this->currentRGBFrame->discard();
+
+	switch (this->colorMode)
+	{
+		case FirewireCamera::COLOR_RGB:
+			for (int y = 0; y < this->imageHeight; y++)
+			{
+				memcpy(this->currentRGBFrame->getImageBuffer() +
+					y * this->currentRGBFrame->getAllocatedWidth(),
+					buffer + y * this->lineBytes, this->lineBytes);
+			}
+			this->correctColors(this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			break;
+
+		case FirewireCamera::COLOR_GREYSCALE:
+			for (int y = 0; y < this->imageHeight; y++)
+			{
+				memcpy(this->currentFrame->getImageBuffer() +
+					y * this->currentFrame->getAllocatedWidth(),
+					buffer + y * this->lineBytes, this->lineBytes);
+			}
+			this->deBayer(this->currentFrame, this->currentRGBFrame);
+			break;
+
+		case FirewireCamera::COLOR_GREYSCALE16:
+			this->convertMono16(buffer, this->currentFrame);
+			this->deBayer(this->currentFrame, this->currentRGBFrame);
+			break;
+
+		case FirewireCamera::COLOR_YUV422:
+			tt::process::YUV::convert(buffer, tt::process::YUV::FORMAT_YUV422,
+				this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			this->correctColors(this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			break;
+
+		case FirewireCamera::COLOR_YUV444:
+			tt::process::YUV::convert(buffer, tt::process::YUV::FORMAT_YUV444,
+				this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			this->correctColors(this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			break;
+
+		case FirewireCamera::COLOR_YUV411:
+			tt::process::YUV::convert(buffer, tt::process::YUV::FORMAT_YUV411,
+				this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			this->correctColors(this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
+			break;
+	}
+
+	stampLastFrame(this->currentRGBFrame);
+	return this->currentRGBFrame;
+}
+
+/**
+ * @brief Lend the next frame straight from the simulated DMA ring.
+ *
+ * Like LinuxDC1394Camera::lendImage, RGB frames are RGB images and MONO8
+ * frames the raw GREYSCALE images.
+ */
+void SimulatedFirewireCamera::lendImage(LentFrame& frame)
+{
+	string functionSignature = "void SimulatedFirewireCamera::lendImage(LentFrame& frame)";
+
+	if (!capturing)
+	{
+		throw std::runtime_error(functionSignature + " not in capture mode.");
+	}
+
+	if (isLending())
+	{
+		throw std::runtime_error(functionSignature +
+			" a frame is lent already, release it first.");
+	}
+
+	if (frame.isLent())
+	{
+		throw std::runtime_error(functionSignature + " frame is lent already.");
+	}
+
+	Image::Channels channels;
+	switch (this->colorMode)
+	{
+		case FirewireCamera::COLOR_RGB:
+			channels = Image::RGB;
+			break;
+
+		case FirewireCamera::COLOR_GREYSCALE:
+			channels = Image::GREYSCALE;
+			break;
+
+		default:
+			throw std::runtime_error(functionSignature +
+				" frames of Mode " + FirewireCamera::getVideoModeString(this->videoMode)
+				+ " need a conversion, use getImage.");
+	}
+
+	unsigned char* buffer = (unsigned char*) capture();
+	Image* image = new Image(buffer, this->imageWidth, this->imageHeight, this->lineBytes, channels);
+	stampLastFrame(image);
+	lend(frame, image);
+}
+
+void SimulatedFirewireCamera::returnBuffer()
+{
+}
+
+const int SimulatedFirewireCamera::getImageWidth() const
+{
+	return this->imageWidth;
+}
+
+const int SimulatedFirewireCamera::getImageHeight() const
+{
+	return this->imageHeight;
+}
+
+void SimulatedFirewireCamera::getCaptureParameters(int& width, int& height,
+	ds::Image::Channels& channels, ds::Image::BitsPerChannel& bpc)
+{
+	width = this->imageWidth;
+	height = this->imageHeight;
+	channels = ds::Image::RGB;
+	bpc = this->getFrameBitsPerChannel();
+}
+
+void SimulatedFirewireCamera::enableWhiteBalanceOnePush(bool /*enable*/)
+{
+}
+
+void SimulatedFirewireCamera::enableWhiteBalanceAuto(bool /*enable*/)
+{
+}
+
+void SimulatedFirewireCamera::getWhiteBalance(unsigned int* ubValue, unsigned int* vrValue)
+{
+	// the simulated camera has no white balance of its own
+	this->getWhiteBalanceSoftware(ubValue, vrValue);
+}
+
+void SimulatedFirewireCamera::setWhiteBalance(unsigned int ubValue, unsigned int vrValue)
+{
+	if (this->whiteBalanceSoftware)
+	{
+		this->setWhiteBalanceSoftware(ubValue, vrValue);
+	}
+}
+
+void SimulatedFirewireCamera::enableShutterAuto(bool /*enable*/)
+{
+}
+
+void SimulatedFirewireCamera::enableGainAuto(bool /*enable*/)
+{
+}
+
+void SimulatedFirewireCamera::setDMABuffers(int buffers)
+{
+	string functionSignature = "void SimulatedFirewireCamera::setDMABuffers(int buffers)";
+
+	if (capturing)
+	{
+		throw std::runtime_error(functionSignature + " already in capture mode.");
+	}
+	FirewireCamera::setDMABuffers(buffers);
+}
+
+// SimulatedFirewireCamera specific functions
+
+void SimulatedFirewireCamera::setSimulatedCameras(int cameras)
+{
+	simulatedCameras = cameras;
+}
+
+int SimulatedFirewireCamera::getSimulatedCameras()
+{
+	return simulatedCameras;
+}
+
+void SimulatedFirewireCamera::selectCamera(int index)
+{
+	this->cameraIndex = index;
+}
+
+void SimulatedFirewireCamera::setJitter(int microseconds)
+{
+	string functionSignature = "void SimulatedFirewireCamera::setJitter(int microseconds)";
+
+	if (microseconds < 0)
+	{
+		throw std::runtime_error(functionSignature + " jitter out of range.");
+	}
+	this->jitter = microseconds;
+}
+
+int SimulatedFirewireCamera::getJitter() const
+{
+	return this->jitter;
+}
+
+void SimulatedFirewireCamera::setFormat7ImageSize(int width, int height)
+{
+	this->format7Width = width;
+	this->format7Height = height;
+}
+
+unsigned long SimulatedFirewireCamera::getFrameNumber() const
+{
+	return this->frameNumber;
+}
+
+void SimulatedFirewireCamera::fillFrame(unsigned char* buffer, int lineBytes, int height,
+	unsigned long frame, int camera)
+{
+	for (int y = 0; y < height; y++)
+	{
+		unsigned char first = (unsigned char) (2 * y + frame + 64 * camera);
+		unsigned char* line = buffer + y * lineBytes;
+		for (int i = 0; i < lineBytes; i++)
+		{
+			line[i] = (unsigned char) (first + i);
+		}
+	}
+}
+
+} // namespace input
+
+} // namespace tt
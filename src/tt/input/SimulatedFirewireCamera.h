@@ -0,0 +1,195 @@
+#ifndef TT_INPUT_SIMULATEDFIREWIRECAMERA_H
+#define TT_INPUT_SIMULATEDFIREWIRECAMERA_H
+
+#include <chrono>
+#include <vector>
+#include <tt/ds/Image.h>
+#include "FirewireCamera.h"
+
+namespace tt
+{
+
+namespace input
+{
+
+/**
+ * @class SimulatedFirewireCamera SimulatedFirewireCamera.h tt/input/SimulatedFirewireCamera.h
+ * @brief FirewireCamera producing synthetic frames without a camera.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * SimulatedFirewireCamera implements the whole FirewireCamera interface,
+ * so capture pipelines can be run and load tested without IEEE1394
+ * hardware. Select it through the factory with setSimulatedCameras.
+ *
+ * The camera delivers frames in the raw format of the video mode, MONO8
+ * and Format 7 frames are Bayer patterns unless the Bayer filter is NONE,
+ * and converts them like LinuxDC1394Camera. Byte i of line y of the raw
+ * frame number n (starting at 0) of the camera with index c is
+ * (i + 2 * y + n + 64 * c) modulo 256, see fillFrame.
+ *
+ * The frames arrive at the multiples of the frame period of the video
+ * framerate on the steady clock, so all simulated cameras with the same
+ * framerate capture in phase like cameras synchronized on the bus. Frame n
+ * arrives n frame periods after the first one following captureStart,
+ * delayed by up to the jitter set by setJitter. The delays are pseudo
+ * random, but the same for every run. getImage and lendImage wait
+ * for the next frame. Like a DMA ring with setDMABuffers buffers, frames
+ * are lost, if the application is slow: with LATEST_ONLY, the default like
+ * LinuxDC1394Camera, the newest arrived frame is delivered and the older
+ * ones are dropped, with the other delivery policies the oldest frame still
+ * in the ring is delivered.
+ *
+ * The timestamp of a frame is its arrival time, its buffer index the
+ * index in the simulated ring and the frames lost in the ring are counted
+ * as dropped by the device.
+ */
+class SimulatedFirewireCamera : public tt::input::FirewireCamera, private LentFrame::Lender
+{
+private:
+	/** @brief Index of the camera */
+	int cameraIndex;
+	/** @brief True after open */
+	bool opened;
+	/** @brief Indicates, if we are in capture state or not. */
+	bool capturing;
+	/** @brief The maximum delay of a frame in microseconds. */
+	int jitter;
+	/** @brief Width of Format 7 frames. */
+	int format7Width;
+	/** @brief Height of Format 7 frames. */
+	int format7Height;
+	/** @brief Width of the captured image. */
+	int imageWidth;
+	/** @brief Height of the captured image. */
+	int imageHeight;
+	/** @brief Bytes of one line of a raw frame. */
+	int lineBytes;
+	/** @brief The color setting for the current video mode. */
+	Color colorMode;
+	/** @brief The buffers of the simulated DMA ring, one after the other. */
+	std::vector<unsigned char> ring;
+	/** @brief The arrival time of the first frame after captureStart. */
+	std::chrono::steady_clock::time_point startTime;
+	/** @brief The time between two frames. */
+	std::chrono::nanoseconds framePeriod;
+	/** @brief The number of the next frame, which wasn't delivered or dropped. */
+	unsigned long nextFrame;
+	/** @brief The number of the last delivered frame. */
+	unsigned long frameNumber;
+	/** @brief The frames lost in the simulated DMA ring before the last delivered frame. */
+	unsigned long lostFrames;
+	/** @brief The grabbed frame. */
+	tt::ds::Image* currentFrame;
+	/** @brief The grabbed frame as a RGB image */
+	tt::ds::Image* currentRGBFrame;
+
+	/** @brief The number of simulated cameras of the factory. */
+	static int simulatedCameras;
+
+	/** @brief Wait for the next frame and return its buffer in the ring. */
+	const unsigned char* capture();
+
+	/** @brief Stamp a frame with the metadata of the last captured frame. */
+	void stampLastFrame(tt::ds::Image* image);
+
+	/** @brief Nothing to give back, the ring is simulated. */
+	virtual void returnBuffer();
+
+public:
+	SimulatedFirewireCamera();
+	virtual ~SimulatedFirewireCamera();
+
+	virtual void open();
+	virtual void close();
+	virtual void init();
+	virtual void captureStart();
+	virtual void captureStop();
+	virtual void captureNext();
+	virtual tt::ds::Image* getImage();
+	virtual void lendImage(LentFrame& frame);
+	virtual const int getImageWidth() const;
+	virtual const int getImageHeight() const;
+	virtual void getCaptureParameters(int& width, int& height,
+		ds::Image::Channels& channels, ds::Image::BitsPerChannel& bpc);
+	virtual void enableWhiteBalanceOnePush(bool enable);
+	virtual void enableWhiteBalanceAuto(bool enable);
+	virtual void getWhiteBalance(unsigned int* ubValue, unsigned int* vrValue);
+	virtual void setWhiteBalance(unsigned int ubValue, unsigned int vrValue);
+	virtual void enableShutterAuto(bool enable);
+	virtual void enableGainAuto(bool enable);
+
+	/**
+	 * @brief Set the number of buffers of the simulated DMA ring.
+	 * @param buffers 1 or more, 16 by default.
+	 *
+	 * Throws a std::runtime_error in capture mode, since the ring is in use.
+	 */
+	virtual void setDMABuffers(int buffers);
+
+	// SimulatedFirewireCamera specific functions
+
+	/**
+	 * @brief Let the factory create simulated cameras.
+	 * @param cameras The number of simulated cameras, 0 for the cameras of
+	 * the platform, which is the default.
+	 *
+	 * While set, FirewireCamera::getNumberOfFirewireCameras returns cameras
+	 * and FirewireCamera::createFirewireCamera creates
+	 * SimulatedFirewireCamera objects.
+	 */
+	static void setSimulatedCameras(int cameras);
+
+	/**
+	 * @brief Return the number of simulated cameras of the factory.
+	 */
+	static int getSimulatedCameras();
+
+	/** @brief Select the camera with the specified index */
+	void selectCamera(int index);
+
+	/**
+	 * @brief Set the maximum delay of the frames.
+	 * @param microseconds The delay, 0 for none, which is the default.
+	 */
+	void setJitter(int microseconds);
+
+	/**
+	 * @brief Return the maximum delay of the frames in microseconds.
+	 */
+	int getJitter() const;
+
+	/**
+	 * @brief Set the size of the frames in Format 7.
+	 * @param width The width, 640 by default.
+	 * @param height The height, 480 by default.
+	 */
+	void setFormat7ImageSize(int width, int height);
+
+	/**
+	 * @brief Return the number of the last delivered frame, starting at 0.
+	 */
+	unsigned long getFrameNumber() const;
+
+	/**
+	 * @brief Return the time, when a frame arrives, including its delay.
+	 * @param frame The number of the frame since captureStart.
+	 */
+	std::chrono::steady_clock::time_point getArrivalTime(unsigned long frame) const;
+
+	/**
+	 * @brief Fill a raw frame with its deterministic content.
+	 * @param buffer The first byte of the frame.
+	 * @param lineBytes The bytes of one line.
+	 * @param height The number of lines.
+	 * @param frame The number of the frame.
+	 * @param camera The index of the camera.
+	 */
+	static void fillFrame(unsigned char* buffer, int lineBytes, int height,
+		unsigned long frame, int camera);
+};
+
+} // namespace input
+
+} // namespace tt
+
+#endif /*TT_INPUT_SIMULATEDFIREWIRECAMERA_H*/
@@ -8,7 +8,9 @@
 #include <string>
 #include <sstream>
 #include <assert.h>
+#include <tt/ds/FramePool.h>
 #include <tt/process/Bayer.h>
+#include <tt/process/YUV.h>
 #include "WindowsCMU1394Camera.h"
 
 #include <iostream>
@@ -35,6 +37,9 @@ WindowsCMU1394Camera::WindowsCMU1394Camera()
 
 WindowsCMU1394Camera::~WindowsCMU1394Camera()
 {
+	// the capture thread uses the camera and the frames
+	stopAsyncCapture();
+	
 	/*
 	if (currentFrame != NULL)
 	{
@@ -245,23 +250,29 @@ void WindowsCMU1394Camera::captureStart()
 	this->imageWidth = width;
 	this->imageHeight = height;
 	
-	// allocate Images to store frames
+	// allocate Images to store frames, restarts get the buffers back from the pool
+	FramePool* pool = &FramePool::getDefault();
 	if (currentFrame != NULL)
 	{
 		delete currentFrame;
 	};
-	currentFrame = new Image(this->imageWidth, this->imageHeight, Image::GREYSCALE);
+	currentFrame = new Image(this->imageWidth, this->imageHeight, Image::GREYSCALE,
+		this->getFrameBitsPerChannel(), pool);
 	if (currentRGBFrame != NULL)
 	{
 		delete currentRGBFrame;
 	};
-	currentRGBFrame = new Image(this->imageWidth, this->imageHeight, Image::RGB);
+	currentRGBFrame = new Image(this->imageWidth, this->imageHeight, Image::RGB,
+		this->getFrameBitsPerChannel(), pool);
+	resetFrameCounters();
 };
 
 void WindowsCMU1394Camera::captureStop()
 {
 	string functionSignature = "void WindowsCMU1394Camera::captureStop()";
 
+	stopAsyncCapture();
+
 	if (this->capturing == true)
 	{
 		int result = this->camera.StopImageCapture();
@@ -284,30 +295,102 @@ void WindowsCMU1394Camera::captureNext()
 		{
 			throw std::runtime_error(functionSignature + " could not capture frame.");
 		};
+		
+		// the frame is complete, when AcquireImage returns
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		unsigned long dropped = 0;
+		if (getCapturedFrames() > 0 && this->videoFormatSet && this->videoFramerateSet &&
+			this->videoFormat != FirewireCamera::FORMAT7)
+		{
+			dropped = estimateDroppedFrames(now - this->captureTime);
+		};
+		this->captureTime = now;
+		// getImage converts into the frame, which keeps its metadata
+		stampFrame(this->currentRGBFrame, now, dropped, -1);
 	};
 };
 
+/**
+ * @brief Return true and the YUV format, if the mode delivers YUV frames.
+ */
+static bool getYUVFormat(FirewireCamera::Mode mode, YUV::Format& format)
+{
+	switch (mode)
+	{
+		case FirewireCamera::MODE_160x120_YUV444:
+			format = YUV::FORMAT_YUV444;
+			return true;
+
+		case FirewireCamera::MODE_640x480_YUV411:
+			format = YUV::FORMAT_YUV411;
+			return true;
+
+		case FirewireCamera::MODE_320x240_YUV422:
+		case FirewireCamera::MODE_640x480_YUV422:
+		case FirewireCamera::MODE_800x600_YUV422:
+		case FirewireCamera::MODE_1024x768_YUV422:
+		case FirewireCamera::MODE_1280x960_YUV422:
+		case FirewireCamera::MODE_1600x1200_YUV422:
+			format = YUV::FORMAT_YUV422;
+			return true;
+
+		default:
+			return false;
+	}
+}
+
 tt::ds::Image* WindowsCMU1394Camera::getImage()
 {
 	if (this->capturing == true)
 	{
+		// images sharing the frames keep the previous pixels and pyramids, the
+		// frames get new buffers instead of copies, since they are overwritten
+		this->currentFrame->discard();
+		this->currentRGBFrame->discard();
+		
+		YUV::Format yuvFormat;
 		if (this->bayerFilter != tt::process::Bayer::NONE)
 		{ // manual debayering 
 			unsigned long cameraBufferLength;
 			unsigned char* cameraBuffer = this->camera.GetRawData(&cameraBufferLength);
 	
-			// copy from camera buffer to grey image
-			unsigned char* greyImage = this->currentFrame->getImageBuffer();
-			unsigned long greyImageLength = this->currentFrame->getAllocatedBytes();
-			// note: the cameraBuferLength can be greater than the greyImageLength
-			// that was one day of debugging.
-			memcpy(greyImage, cameraBuffer, greyImageLength); 
+			if (this->videoModeSet && isMono16(this->videoMode))
+			{
+				// swap the big endian pixels while copying
+				this->convertMono16(cameraBuffer, this->currentFrame);
+			}
+			else
+			{
+				// copy from camera buffer to grey image
+				// note: the cameraBuferLength can be greater than the frame
+				// that was one day of debugging.
+				this->copyPacked(cameraBuffer, this->currentFrame);
+			}
 			
-			Bayer::deBayer(this->currentFrame, this->currentRGBFrame, this->bayerFilter);
+			this->deBayer(this->currentFrame, this->currentRGBFrame);
+		}
+		else if (this->videoModeSet && getYUVFormat(this->videoMode, yuvFormat))
+		{ // convert YUV frames with the vectorized kernels
+			unsigned long cameraBufferLength;
+			unsigned char* cameraBuffer = this->camera.GetRawData(&cameraBufferLength);
+			YUV::convert(cameraBuffer, yuvFormat, this->currentRGBFrame, Bayer::ORDER_RGB);
+			this->correctColors(this->currentRGBFrame, Bayer::ORDER_RGB);
 		}
 		else
 		{ // use RGB auto multiplexer from CMU driver
-			this->camera.getRGB((unsigned char*) (this->currentRGBFrame->getImageBuffer()), this->currentRGBFrame->getAllocatedBytes());
+			// the driver writes unpadded lines
+			int rgbBytes = this->imageWidth * this->imageHeight * 3;
+			if (this->currentRGBFrame->getAllocatedWidth() == this->imageWidth * 3)
+			{
+				this->camera.getRGB(this->currentRGBFrame->getImageBuffer(), rgbBytes);
+			}
+			else
+			{
+				this->packedRGB.resize(rgbBytes);
+				this->camera.getRGB(&this->packedRGB[0], rgbBytes);
+				this->copyPacked(&this->packedRGB[0], this->currentRGBFrame);
+			}
+			this->correctColors(this->currentRGBFrame, tt::process::Bayer::ORDER_RGB);
 		}
 		return this->currentRGBFrame;
 	};
@@ -330,7 +413,7 @@ void WindowsCMU1394Camera::getCaptureParameters(int& width, int& height,
 	width = this->imageWidth;
 	height = this->imageHeight;
 	channels = ds::Image::RGB;
-	bpc = ds::Image::BPC8;
+	bpc = this->getFrameBitsPerChannel();
 };
 
 void WindowsCMU1394Camera::enableWhiteBalanceOnePush(bool enable)
@@ -347,6 +430,12 @@ void WindowsCMU1394Camera::enableWhiteBalanceAuto(bool enable)
 
 void WindowsCMU1394Camera::getWhiteBalance(unsigned int* ubValue, unsigned int* vrValue)
 {
+	if (this->whiteBalanceSoftware)
+	{
+		this->getWhiteBalanceSoftware(ubValue, vrValue);
+		return;
+	}
+
 	unsigned short subValue;
 	unsigned short svrValue;
 
@@ -360,6 +449,12 @@ void WindowsCMU1394Camera::getWhiteBalance(unsigned int* ubValue, unsigned int*
 
 void WindowsCMU1394Camera::setWhiteBalance(unsigned int ubValue, unsigned int vrValue)
 {
+	if (this->whiteBalanceSoftware)
+	{
+		this->setWhiteBalanceSoftware(ubValue, vrValue);
+		return;
+	}
+
 	C1394CameraControl whiteBalance(&camera, FEATURE_WHITE_BALANCE);
 	whiteBalance.SetValue(ubValue, vrValue);
 };
@@ -5,6 +5,7 @@
 
 #include <windows.h>
 #include <1394Camera.h>
+#include <vector>
 #include <tt/ds/Image.h>
 #include "FirewireCamera.h"
 
@@ -21,6 +22,13 @@ namespace input
  * 
  * WindowsCMU1394Camera implements the Camera interface for Firewire cameras
  * on Windows platforms and is based on the open source CMU1394 driver.
+ * 
+ * The driver captures into a single buffer and doesn't report lost frames,
+ * so the timestamp of a frame is the time AcquireImage returned it and the
+ * dropped frames are estimated from the time between the frames, if the
+ * video format and framerate were set and the format isn't Format 7.
+ * Without a ring, setDMABuffers has no effect and the delivery policy only
+ * applies to asynchronous capture.
  */
 class WindowsCMU1394Camera : public tt::input::FirewireCamera
 {
@@ -41,6 +49,10 @@ private:
 	tt::ds::Image* currentFrame;
 	/** @brief The grabbed frame as a RGB image */ 
 	tt::ds::Image* currentRGBFrame;
+	/** @brief The time AcquireImage returned the last frame. */
+	std::chrono::steady_clock::time_point captureTime;
+	/** @brief RGB frame of the driver, if the lines of currentRGBFrame are padded. */
+	std::vector<unsigned char> packedRGB;
 	
 public:
 	/** @brief Initializes the members of the WindowsCMU1394Camera object. */
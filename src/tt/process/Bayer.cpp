@@ -1,5 +1,12 @@
 #include <assert.h>
+#include <string.h>
+#include <stdexcept>
+#include <vector>
+#include <tt/sys/CPU.h>
+#include <tt/sys/WorkerPool.h>
 #include "Bayer.h"
+#include "ColorCorrection.h"
+#include "BayerKernels.h"
 
 namespace tt
 {
@@ -7,122 +14,1106 @@ namespace tt
 namespace process
 {
 
+Bayer::Kernel Bayer::kernel = Bayer::KERNEL_AUTO;
+
+void Bayer::setKernel(Kernel kernel)
+{
+	std::string functionSignature = "void Bayer::setKernel(Kernel kernel)";
+
+	if (!isKernelSupported(kernel))
+	{
+		throw std::runtime_error(functionSignature + 
+			" kernel not supported by this processor.");
+	}
+	
+	Bayer::kernel = kernel;
+}
+
+Bayer::Kernel Bayer::getKernel()
+{
+	if (Bayer::kernel != KERNEL_AUTO)
+	{
+		return Bayer::kernel;
+	}
+
+	if (isKernelSupported(KERNEL_AVX2))
+	{
+		return KERNEL_AVX2;
+	}
+	if (isKernelSupported(KERNEL_SSSE3))
+	{
+		return KERNEL_SSSE3;
+	}
+	if (isKernelSupported(KERNEL_SSE2))
+	{
+		return KERNEL_SSE2;
+	}
+	return KERNEL_SCALAR;
+}
+
+bool Bayer::isKernelSupported(Kernel kernel)
+{
+	switch (kernel)
+	{
+		case KERNEL_AUTO:
+		case KERNEL_SCALAR:
+			return true;
+			
+#ifdef TT_SIMD_X86
+		case KERNEL_SSE2:
+			return tt::sys::CPU::hasSSE2();
+
+		case KERNEL_SSSE3:
+			return tt::sys::CPU::hasSSSE3();
+
+		case KERNEL_AVX2:
+			return tt::sys::CPU::hasAVX2();
+#endif
+			
+		default:
+			return false;
+	}
+}
+
+/**
+ * @brief The vectorized parts of a conversion, NULL selects the scalar code.
+ */
+struct RowKernels
+{
+	/** @brief Bilinear interpolation of pixel pairs, see bayerRowSSE2 */
+	BayerRowKernel bilinear;
+	/** @brief Malvar-He-Cutler interpolation of pixel pairs, see bayerMalvarRowSSE2 */
+	BayerRowKernel malvar;
+	/** @brief Luma of bilinearly interpolated pixel pairs, see bayerLumaRowSSE2 */
+	BayerRowKernel luma;
+	/** @brief 2x2 binning into color pixels, see bayerHalfRowSSE2 */
+	BayerHalfRowKernel half;
+	/** @brief 2x2 binning into luma, see bayerHalfGreyRowSSE2 */
+	BayerHalfRowKernel halfGrey;
+	/** @brief Bilinear interpolation of 16 bit pixel pairs, see bayerRow16SSE2 */
+	BayerRow16Kernel bilinear16;
+	/** @brief Malvar-He-Cutler interpolation of 16 bit pixel pairs, see bayerMalvarRow16SSE2 */
+	BayerRow16Kernel malvar16;
+};
+
+/**
+ * @brief Select the row kernels for 8 or 16 bit pixels.
+ */
+template <typename T>
+struct PixelKernels;
+
+template <>
+struct PixelKernels<unsigned char>
+{
+	static BayerRowKernel bilinear(const RowKernels& kernels)
+	{
+		return kernels.bilinear;
+	}
+
+	static BayerRowKernel malvar(const RowKernels& kernels)
+	{
+		return kernels.malvar;
+	}
+};
+
+template <>
+struct PixelKernels<unsigned short>
+{
+	static BayerRow16Kernel bilinear(const RowKernels& kernels)
+	{
+		return kernels.bilinear16;
+	}
+
+	static BayerRow16Kernel malvar(const RowKernels& kernels)
+	{
+		return kernels.malvar16;
+	}
+};
+
+/**
+ * @brief Return the row kernels for the vectorized part of each line.
+ */
+static RowKernels getRowKernels(Bayer::Kernel kernel)
+{
+	RowKernels kernels;
+	kernels.bilinear = NULL;
+	kernels.malvar = NULL;
+	kernels.luma = NULL;
+	kernels.half = NULL;
+	kernels.halfGrey = NULL;
+	kernels.bilinear16 = NULL;
+	kernels.malvar16 = NULL;
+	
+	switch (kernel)
+	{
+#ifdef TT_SIMD_X86
+		case Bayer::KERNEL_SSE2:
+			kernels.bilinear = bayerRowSSE2;
+			break;
+
+		case Bayer::KERNEL_SSSE3:
+			kernels.bilinear = bayerRowSSSE3;
+			break;
+
+		case Bayer::KERNEL_AVX2:
+			kernels.bilinear = bayerRowAVX2;
+			break;
+#endif
+			
+		default:
+			break;
+	}
+
+	// the other conversions have SSE2 kernels only, which all x86 kernels use
+	if (kernels.bilinear != NULL)
+	{
+#ifdef TT_SIMD_X86
+		kernels.malvar = bayerMalvarRowSSE2;
+		kernels.luma = bayerLumaRowSSE2;
+		kernels.half = bayerHalfRowSSE2;
+		kernels.halfGrey = bayerHalfGreyRowSSE2;
+		kernels.bilinear16 = bayerRow16SSE2;
+		kernels.malvar16 = bayerMalvarRow16SSE2;
+#endif
+	}
+	
+	return kernels;
+}
+
+/**
+ * @brief Interpolate a red or blue pixel from its 3x3 neighbourhood.
+ * @param C0 Output channel of the interpolated red/blue value (0 or 2).
+ * @param r0 The line above, r1 the center line and r2 the line below.
+ * @param x Column of the pixel.
+ * @param dst First channel of the output pixel.
+ */
+template <int C0, typename T>
+static inline void interpolateRedBlue(const T* r0, const T* r1, const T* r2, int x, T* dst)
+{
+	dst[C0] = (T) ((r0[x-1] + r0[x+1] + r2[x-1] + r2[x+1] + 2) >> 2);
+	dst[1] = (T) ((r0[x] + r1[x-1] + r1[x+1] + r2[x] + 2) >> 2);
+	dst[2-C0] = r1[x];
+}
+
+/**
+ * @brief Interpolate a green pixel from its 3x3 neighbourhood.
+ * @param C0 Output channel of the vertically interpolated value (0 or 2).
+ * @param r0 The line above, r1 the center line and r2 the line below.
+ * @param x Column of the pixel.
+ * @param dst First channel of the output pixel.
+ */
+template <int C0, typename T>
+static inline void interpolateGreen(const T* r0, const T* r1, const T* r2, int x, T* dst)
+{
+	dst[C0] = (T) ((r0[x] + r2[x] + 1) >> 1);
+	dst[1] = r1[x];
+	dst[2-C0] = (T) ((r1[x-1] + r1[x+1] + 1) >> 1);
+}
+
+/**
+ * @brief Interpolate one line with the Bayer phase fixed at compile time.
+ * @param Blue 1 or -1, the channel order of the red/blue pixels as in
+ * OpenCV's icvBayer2BGR_8u_C1C3R.
+ * @param StartWithGreen true, if the second pixel of the line is green.
+ * @param T The pixel type, unsigned char or unsigned short.
+ * @param bayer First pixel of the source line above the interpolated line.
+ * @param bayerStep Number of pixels per source line.
+ * @param dst First pixel of the destination line.
+ * @param width Number of pixels per line.
+ * @param rowKernel Vectorized kernel for the pixel pairs or NULL.
+ * 
+ * The first and the last pixel of the line are set to zero.
+ */
+template <int Blue, bool StartWithGreen, typename T>
+static void deBayerRow(const T* bayer, int bayerStep, T* dst, int width,
+	int (*rowKernel)(const T*, int, T*, int, int))
+{
+	const int c0 = Blue > 0 ? 0 : 2;
+	const T* r0 = bayer;
+	const T* r1 = bayer + bayerStep;
+	const T* r2 = bayer + bayerStep * 2;
+
+	dst[0] = dst[1] = dst[2] = 0;
+	dst[(width - 1)*3] = dst[(width - 1)*3 + 1] = dst[(width - 1)*3 + 2] = 0;
+
+	int x = 1;
+	if (StartWithGreen && x < width - 1)
+	{
+		interpolateGreen<c0>(r0, r1, r2, x, dst + x*3);
+		x++;
+	}
+
+	// let the vectorized kernel interpolate as many pixel pairs as it can
+	if (rowKernel != NULL && x < width - 1)
+	{
+		x += rowKernel(r0 + x - 1, bayerStep, dst + x*3, width - 1 - x, Blue);
+	}
+
+	for (; x < width - 2; x += 2)
+	{
+		interpolateRedBlue<c0>(r0, r1, r2, x, dst + x*3);
+		interpolateGreen<c0>(r0, r1, r2, x + 1, dst + x*3 + 3);
+	}
+
+	if (x < width - 1)
+	{
+		interpolateRedBlue<c0>(r0, r1, r2, x, dst + x*3);
+	}
+}
+
+/**
+ * @brief Luma of a pixel in BGR order, see LUMA_RED.
+ */
+static inline unsigned char luma(const unsigned char* bgr)
+{
+	return (unsigned char) ((LUMA_BLUE*bgr[0] + LUMA_GREEN*bgr[1] + LUMA_RED*bgr[2] + 128) >> 8);
+}
+
+/**
+ * @brief Interpolate the luma of one line with the Bayer phase fixed at
+ * compile time.
+ * 
+ * Like deBayerRow, but only the luma of each BGR pixel is written.
+ * The first and the last pixel of the line are set to zero.
+ */
+template <int Blue, bool StartWithGreen>
+static void lumaRow(const unsigned char* bayer, int bayerStep, unsigned char* dst,
+	int width, BayerRowKernel rowKernel)
+{
+	const int c0 = Blue > 0 ? 0 : 2;
+	const unsigned char* r0 = bayer;
+	const unsigned char* r1 = bayer + bayerStep;
+	const unsigned char* r2 = bayer + bayerStep * 2;
+	unsigned char pixel[3];
+
+	dst[0] = 0;
+	dst[width - 1] = 0;
+
+	int x = 1;
+	if (StartWithGreen && x < width - 1)
+	{
+		interpolateGreen<c0>(r0, r1, r2, x, pixel);
+		dst[x] = luma(pixel);
+		x++;
+	}
+
+	if (rowKernel != NULL && x < width - 1)
+	{
+		x += rowKernel(r0 + x - 1, bayerStep, dst + x, width - 1 - x, Blue);
+	}
+
+	for (; x < width - 2; x += 2)
+	{
+		interpolateRedBlue<c0>(r0, r1, r2, x, pixel);
+		dst[x] = luma(pixel);
+		interpolateGreen<c0>(r0, r1, r2, x + 1, pixel);
+		dst[x + 1] = luma(pixel);
+	}
+
+	if (x < width - 1)
+	{
+		interpolateRedBlue<c0>(r0, r1, r2, x, pixel);
+		dst[x] = luma(pixel);
+	}
+}
+
+/**
+ * @brief Round, scale and saturate a Malvar-He-Cutler sum, which is 16 times
+ * the interpolated value.
+ * @param T The pixel type, which gives the saturation limit.
+ */
+template <typename T>
+static inline T malvarValue(int sum)
+{
+	const int max = (1 << (8*sizeof(T))) - 1;
+	sum += 8;
+	if (sum < 0)
+	{
+		return 0;
+	}
+	sum >>= 4;
+	return (T) (sum > max ? max : sum);
+}
+
+/**
+ * @brief Malvar-He-Cutler interpolation of a red or blue pixel.
+ * @param C0 Output channel of the interpolated red/blue value (0 or 2).
+ * @param r Pointers to the 5 lines around the pixel, r[2] is the center line.
+ * @param x Column of the pixel.
+ * @param dst First channel of the output pixel.
+ */
+template <int C0, typename T>
+static inline void malvarRedBlue(const T* const* r, int x, T* dst)
+{
+	int center = r[2][x];
+	int far = r[0][x] + r[4][x] + r[2][x-2] + r[2][x+2];
+	
+	dst[C0] = malvarValue<T>(12*center - 3*far +
+		4*(r[1][x-1] + r[1][x+1] + r[3][x-1] + r[3][x+1]));
+	dst[1] = malvarValue<T>(8*center - 2*far +
+		4*(r[1][x] + r[3][x] + r[2][x-1] + r[2][x+1]));
+	dst[2-C0] = (T) center;
+}
+
+/**
+ * @brief Malvar-He-Cutler interpolation of a green pixel.
+ * @param C0 Output channel of the vertically interpolated value (0 or 2).
+ * @param r Pointers to the 5 lines around the pixel, r[2] is the center line.
+ * @param x Column of the pixel.
+ * @param dst First channel of the output pixel.
+ */
+template <int C0, typename T>
+static inline void malvarGreen(const T* const* r, int x, T* dst)
+{
+	int center = 10*r[2][x];
+	int diagonal = r[1][x-1] + r[1][x+1] + r[3][x-1] + r[3][x+1];
+	int vertical = r[0][x] + r[4][x];
+	int horizontal = r[2][x-2] + r[2][x+2];
+	
+	dst[C0] = malvarValue<T>(center + 8*(r[1][x] + r[3][x]) - 2*vertical -
+		2*diagonal + horizontal);
+	dst[1] = r[2][x];
+	dst[2-C0] = malvarValue<T>(center + 8*(r[2][x-1] + r[2][x+1]) - 2*horizontal -
+		2*diagonal + vertical);
+}
+
+/**
+ * @brief Interpolate one line with the Malvar-He-Cutler filters.
+ * @param Blue 1 or -1, the channel order of the red/blue pixels.
+ * @param StartWithGreen true, if the second pixel of the line is green.
+ * @param bayer First pixel of the source line two lines above the
+ * interpolated line.
+ * @param dst First pixel of the destination line.
+ * @param width Number of pixels per line.
+ * @param rowKernel Vectorized kernel for the pixel pairs or NULL.
+ * 
+ * The 5x5 filters don't fit at the second and the second last pixel, which
+ * are interpolated bilinearly. The first and the last pixel are set to zero.
+ */
+template <int Blue, bool StartWithGreen, typename T>
+static void malvarRow(const T* bayer, int bayerStep, T* dst, int width,
+	int (*rowKernel)(const T*, int, T*, int, int))
+{
+	const int c0 = Blue > 0 ? 0 : 2;
+	const T* r[5];
+	for (int i = 0; i < 5; i++)
+	{
+		r[i] = bayer + i*bayerStep;
+	}
+
+	dst[0] = dst[1] = dst[2] = 0;
+	dst[(width - 1)*3] = dst[(width - 1)*3 + 1] = dst[(width - 1)*3 + 2] = 0;
+	
+	// the pixels 1 and width - 2 are bilinear, green ones are at odd columns
+	// if the line starts with green 
+	if (width > 2)
+	{
+		if (StartWithGreen)
+		{
+			interpolateGreen<c0>(r[1], r[2], r[3], 1, dst + 3);
+		}
+		else
+		{
+			interpolateRedBlue<c0>(r[1], r[2], r[3], 1, dst + 3);
+		}
+	}
+	if (width > 3)
+	{
+		if (((width - 2) % 2 == 1) == StartWithGreen)
+		{
+			interpolateGreen<c0>(r[1], r[2], r[3], width - 2, dst + (width - 2)*3);
+		}
+		else
+		{
+			interpolateRedBlue<c0>(r[1], r[2], r[3], width - 2, dst + (width - 2)*3);
+		}
+	}
+	
+	int x = 2;
+	if (!StartWithGreen && x < width - 2)
+	{
+		malvarGreen<c0>(r, x, dst + x*3);
+		x++;
+	}
+
+	// let the vectorized kernel interpolate as many pixel pairs as it can
+	if (rowKernel != NULL && x < width - 2)
+	{
+		x += rowKernel(r[0] + x - 2, bayerStep, dst + x*3, width - 2 - x, Blue);
+	}
+
+	for (; x < width - 3; x += 2)
+	{
+		malvarRedBlue<c0>(r, x, dst + x*3);
+		malvarGreen<c0>(r, x + 1, dst + x*3 + 3);
+	}
+
+	if (x < width - 2)
+	{
+		malvarRedBlue<c0>(r, x, dst + x*3);
+	}
+}
+
+/**
+ * @brief Apply a color correction to a freshly interpolated line.
+ * @param correction The correction or NULL.
+ * 
+ * The zero lines at the top and bottom are left alone, no gain or gamma
+ * changes black.
+ */
+static inline void correctRow(const ColorCorrection* correction, unsigned char* line,
+	int width, Bayer::Order order)
+{
+	if (correction != NULL)
+	{
+		correction->applyLine(line, width, order);
+	}
+}
+
+/**
+ * @brief The color correction works on 8 bit lines only.
+ * 
+ * getBandFunction throws for a correction of BPC16 images, so 16 bit lines
+ * never come with one.
+ */
+static inline void correctRow(const ColorCorrection* correction, unsigned short* /*line*/,
+	int /*width*/, Bayer::Order /*order*/)
+{
+	assert(correction == NULL);
+}
+
+/**
+ * @brief Interpolate the destination lines firstRow to lastRow - 1.
+ * @param kernels Vectorized kernels for the pixel pairs.
+ * 
+ * This is a port of OpenCV's icvBayer2BGR_8u_C1C3R with the Bayer pattern
+ * and the output order fixed at compile time. Each line reads the source
+ * line above and below, so bands of lines can be converted independently.
+ * The first and the last line of the image are set to zero. T is the pixel
+ * type, unsigned char for BPC8 and unsigned short for BPC16 images.
+ */
+template <Bayer::Pattern P, Bayer::Order O, typename T>
+static void deBayerBand(const tt::ds::Image* source, tt::ds::Image* destination,
+	const RowKernels& kernels, const ColorCorrection* correction, int firstRow, int lastRow)
+{
+	// the phase of the first interpolated line, the second one is inverted
+	const int blue = ((P == Bayer::PATTERN_BG || P == Bayer::PATTERN_GB) ? -1 : 1) *
+		(O == Bayer::ORDER_BGR ? 1 : -1);
+	const bool startWithGreen = P == Bayer::PATTERN_GB || P == Bayer::PATTERN_GR;
+
+	const T* bayer = (const T*) source->getImageBuffer();
+	int bayerStep = source->getAllocatedWidth() / sizeof(T);
+	T* dst = (T*) destination->getImageBuffer();
+	int dstStep = destination->getAllocatedWidth() / sizeof(T);
+	int width = source->getWidth();
+	int height = source->getHeight();
+	int (*rowKernel)(const T*, int, T*, int, int) = PixelKernels<T>::bilinear(kernels);
+
+	if (firstRow == 0)
+	{
+		memset(dst, 0, width*3*sizeof(T));
+	}
+	if (lastRow == height)
+	{
+		memset(dst + (height - 1)*dstStep, 0, width*3*sizeof(T));
+	}
+
+	int y = firstRow > 1 ? firstRow : 1;
+	int last = lastRow < height - 1 ? lastRow : height - 1;
+	
+	if ((y - 1) % 2 == 1 && y < last)
+	{
+		deBayerRow<-blue, !startWithGreen>(bayer + (y - 1)*bayerStep, bayerStep,
+			dst + y*dstStep, width, rowKernel);
+		correctRow(correction, dst + y*dstStep, width, O);
+		y++;
+	}
+	
+	for (; y < last - 1; y += 2)
+	{
+		deBayerRow<blue, startWithGreen>(bayer + (y - 1)*bayerStep, bayerStep,
+			dst + y*dstStep, width, rowKernel);
+		correctRow(correction, dst + y*dstStep, width, O);
+		deBayerRow<-blue, !startWithGreen>(bayer + y*bayerStep, bayerStep,
+			dst + (y + 1)*dstStep, width, rowKernel);
+		correctRow(correction, dst + (y + 1)*dstStep, width, O);
+	}
+	
+	if (y < last)
+	{
+		deBayerRow<blue, startWithGreen>(bayer + (y - 1)*bayerStep, bayerStep,
+			dst + y*dstStep, width, rowKernel);
+		correctRow(correction, dst + y*dstStep, width, O);
+	}
+}
+
+/**
+ * @brief Interpolate the destination lines firstRow to lastRow - 1 with the
+ * Malvar-He-Cutler filters.
+ * @param kernels Vectorized kernels for the pixel pairs.
+ * 
+ * See H. S. Malvar, L. He and R. Cutler, "High-quality linear interpolation
+ * for demosaicing of Bayer-patterned color images", ICASSP 2004. Each line
+ * reads two source lines above and below. The second and the second last
+ * line are interpolated bilinearly, the first and the last line are set to
+ * zero, like in deBayerBand.
+ */
+template <Bayer::Pattern P, Bayer::Order O, typename T>
+static void malvarBand(const tt::ds::Image* source, tt::ds::Image* destination,
+	const RowKernels& kernels, const ColorCorrection* correction, int firstRow, int lastRow)
+{
+	const int blue = ((P == Bayer::PATTERN_BG || P == Bayer::PATTERN_GB) ? -1 : 1) *
+		(O == Bayer::ORDER_BGR ? 1 : -1);
+	const bool startWithGreen = P == Bayer::PATTERN_GB || P == Bayer::PATTERN_GR;
+
+	const T* bayer = (const T*) source->getImageBuffer();
+	int bayerStep = source->getAllocatedWidth() / sizeof(T);
+	T* dst = (T*) destination->getImageBuffer();
+	int dstStep = destination->getAllocatedWidth() / sizeof(T);
+	int width = source->getWidth();
+	int height = source->getHeight();
+	int (*bilinearKernel)(const T*, int, T*, int, int) = PixelKernels<T>::bilinear(kernels);
+	int (*malvarKernel)(const T*, int, T*, int, int) = PixelKernels<T>::malvar(kernels);
+
+	for (int y = firstRow; y < lastRow; y++)
+	{
+		T* line = dst + y*dstStep;
+		bool firstPhase = (y - 1) % 2 == 0;
+		
+		if (y == 0 || y == height - 1)
+		{
+			memset(line, 0, width*3*sizeof(T));
+		}
+		else if (y == 1 || y == height - 2)
+		{
+			if (firstPhase)
+			{
+				deBayerRow<blue, startWithGreen>(bayer + (y - 1)*bayerStep, bayerStep,
+					line, width, bilinearKernel);
+			}
+			else
+			{
+				deBayerRow<-blue, !startWithGreen>(bayer + (y - 1)*bayerStep, bayerStep,
+					line, width, bilinearKernel);
+			}
+		}
+		else if (firstPhase)
+		{
+			malvarRow<blue, startWithGreen>(bayer + (y - 2)*bayerStep, bayerStep,
+				line, width, malvarKernel);
+		}
+		else
+		{
+			malvarRow<-blue, !startWithGreen>(bayer + (y - 2)*bayerStep, bayerStep,
+				line, width, malvarKernel);
+		}
+		correctRow(correction, line, width, O);
+	}
+}
+
+/**
+ * @brief Interpolate the luma of all lines of the destination.
+ * 
+ * The pattern is the one of the BGR filter, the first and the last line are
+ * set to zero like in deBayerBand.
+ */
+template <Bayer::Pattern P>
+static void lumaBand(const tt::ds::Image* source, tt::ds::Image* destination,
+	BayerRowKernel rowKernel)
+{
+	const int blue = (P == Bayer::PATTERN_BG || P == Bayer::PATTERN_GB) ? -1 : 1;
+	const bool startWithGreen = P == Bayer::PATTERN_GB || P == Bayer::PATTERN_GR;
+
+	const unsigned char* bayer = source->getImageBuffer();
+	int bayerStep = source->getAllocatedWidth();
+	unsigned char* dst = destination->getImageBuffer();
+	int dstStep = destination->getAllocatedWidth();
+	int width = source->getWidth();
+	int height = source->getHeight();
+
+	memset(dst, 0, width);
+	memset(dst + (height - 1)*dstStep, 0, width);
+
+	for (int y = 1; y < height - 1; y++)
+	{
+		if ((y - 1) % 2 == 0)
+		{
+			lumaRow<blue, startWithGreen>(bayer + (y - 1)*bayerStep, bayerStep,
+				dst + y*dstStep, width, rowKernel);
+		}
+		else
+		{
+			lumaRow<-blue, !startWithGreen>(bayer + (y - 1)*bayerStep, bayerStep,
+				dst + y*dstStep, width, rowKernel);
+		}
+	}
+}
+
+/** @brief Signature of the deBayerBand and malvarBand instances */
+typedef void (*BandFunction)(const tt::ds::Image* source, tt::ds::Image* destination,
+	const RowKernels& kernels, const ColorCorrection* correction, int firstRow, int lastRow);
+
+/**
+ * @brief Return the band function instance for a pattern, an order and a
+ * pixel type.
+ */
+template <Bayer::Pattern P, Bayer::Order O, typename T>
+static BandFunction getBandFunction(Bayer::Quality quality)
+{
+	if (quality == Bayer::QUALITY_MALVAR)
+	{
+		return malvarBand<P, O, T>;
+	}
+	return deBayerBand<P, O, T>;
+}
+
+/**
+ * @brief Return the band function instance for a filter and a pixel type.
+ * @param order The channel order of the interpolated pixels.
+ * 
+ * The RGB filters are aliases of the BGR filters with the mirrored pattern,
+ * which give the same pixels, so the order can't be told from the filter.
+ * It only matters for the color correction, whose gains must hit the right
+ * channels.
+ */
+template <typename T>
+static BandFunction getBandFunction(Bayer::Filter filter, Bayer::Quality quality,
+	Bayer::Order order)
+{
+	if (order == Bayer::ORDER_RGB)
+	{
+		switch (filter)
+		{
+			case Bayer::BayerRG2RGB:
+				return getBandFunction<Bayer::PATTERN_RG, Bayer::ORDER_RGB, T>(quality);
+
+			case Bayer::BayerGR2RGB:
+				return getBandFunction<Bayer::PATTERN_GR, Bayer::ORDER_RGB, T>(quality);
+
+			case Bayer::BayerGB2RGB:
+				return getBandFunction<Bayer::PATTERN_GB, Bayer::ORDER_RGB, T>(quality);
+
+			case Bayer::BayerBG2RGB:
+			default:
+				return getBandFunction<Bayer::PATTERN_BG, Bayer::ORDER_RGB, T>(quality);
+		}
+	}
+	
+	switch (filter)
+	{
+		case Bayer::BayerBG2BGR:
+			return getBandFunction<Bayer::PATTERN_BG, Bayer::ORDER_BGR, T>(quality);
+
+		case Bayer::BayerGB2BGR:
+			return getBandFunction<Bayer::PATTERN_GB, Bayer::ORDER_BGR, T>(quality);
+
+		case Bayer::BayerGR2BGR:
+			return getBandFunction<Bayer::PATTERN_GR, Bayer::ORDER_BGR, T>(quality);
+
+		case Bayer::BayerRG2BGR:
+		default: // like the OpenCV port, treat unknown filters as BayerRG2BGR
+			return getBandFunction<Bayer::PATTERN_RG, Bayer::ORDER_BGR, T>(quality);
+	}
+}
+
+/**
+ * @brief Check the images of a conversion and return its band function.
+ * 
+ * BPC16 images are converted into BPC16 images, without a color correction.
+ */
+static BandFunction getBandFunction(const std::string& functionSignature,
+	tt::ds::Image* source, tt::ds::Image* destination, Bayer::Filter filter,
+	Bayer::Quality quality, const ColorCorrection* correction, Bayer::Order order)
+{
+	assert(source->getChannels() == tt::ds::Image::GREYSCALE);
+	assert(destination->getChannels() == tt::ds::Image::RGB);
+	assert(source->getWidth() == destination->getWidth());
+	assert(source->getHeight() == destination->getHeight());
+
+	if (source->getBitsPerChannel() != destination->getBitsPerChannel())
+	{
+		throw std::runtime_error(functionSignature + 
+			" source and destination differ in bits per channel.");
+	}
+	if (source->getBitsPerChannel() == tt::ds::Image::BPC16)
+	{
+		if (correction != NULL)
+		{
+			throw std::runtime_error(functionSignature + 
+				" color correction needs 8 bits per channel.");
+		}
+		return getBandFunction<unsigned short>(filter, quality, order);
+	}
+	return getBandFunction<unsigned char>(filter, quality, order);
+}
+
+/**
+ * @brief Interpolates one band of lines per call of run().
+ */
+class DeBayerBands : public tt::sys::WorkerPool::Task
+{
+public:
+	DeBayerBands(const tt::ds::Image* source, tt::ds::Image* destination, 
+		BandFunction band, const RowKernels& kernels, const ColorCorrection* correction,
+		int bands) :
+		source(source),
+		destination(destination),
+		band(band),
+		kernels(kernels),
+		correction(correction),
+		bands(bands)
+	{
+	}
+
+	virtual void run(int index)
+	{
+		int height = source->getHeight();
+		int firstRow = (int) ((long long) height * index / bands);
+		int lastRow = (int) ((long long) height * (index + 1) / bands);
+		band(source, destination, kernels, correction, firstRow, lastRow);
+	}
+
+private:
+	const tt::ds::Image* source;
+	tt::ds::Image* destination;
+	BandFunction band;
+	RowKernels kernels;
+	const ColorCorrection* correction;
+	int bands;
+};
+
 /**
  * @brief Converts a single cahnnel greyscale picture into an rgb image
  * @param source The source picture (must be GREYSCALE)
  * @param destination (must be RGB)
  * @param filter Use this filter for debayering
+ * @param quality The interpolation method
+ * 
+ * Selects the kernel for the filter once and converts the whole frame with
+ * it. The pixel pairs of each line are interpolated by the kernel returned
+ * by getKernel(), the scalar code takes care of the line ends. BPC16 sources
+ * are interpolated into BPC16 destinations, with SSE2 kernels for the pixel
+ * pairs of both methods for all vectorized kernels.
  */
-void Bayer::deBayer(tracking::cvdata::Image* source, tracking::cvdata::Image* destination, Filter filter)
+void Bayer::deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+	Quality quality)
+{
+	deBayer(source, destination, filter, quality, NULL, ORDER_BGR);
+}
+
+void Bayer::deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+	const ColorCorrection& correction, Quality quality, Order order)
+{
+	deBayer(source, destination, filter, quality,
+		correction.isIdentity() ? NULL : &correction, order);
+}
+
+void Bayer::deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+	tt::sys::WorkerPool& pool, Quality quality)
 {
-	assert(source->getChannels() == tracking::cvdata::Image::GREYSCALE);
-	assert(destination->getChannels() == tracking::cvdata::Image::RGB);
+	deBayer(source, destination, filter, pool, quality, NULL, ORDER_BGR);
+}
+
+void Bayer::deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+	tt::sys::WorkerPool& pool, const ColorCorrection& correction, Quality quality,
+	Order order)
+{
+	deBayer(source, destination, filter, pool, quality,
+		correction.isIdentity() ? NULL : &correction, order);
+}
+
+void Bayer::deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+	Quality quality, const ColorCorrection* correction, Order order)
+{
+	std::string functionSignature = "void Bayer::deBayer(tt::ds::Image* source, "
+		"tt::ds::Image* destination, Filter filter, Quality quality, "
+		"const ColorCorrection* correction, Order order)";
+
+	BandFunction band = getBandFunction(functionSignature, source, destination,
+		filter, quality, correction, order);
+	destination->discard();
+	band(source, destination, getRowKernels(getKernel()), correction, 0, source->getHeight());
+}
+
+void Bayer::deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+	tt::sys::WorkerPool& pool, Quality quality, const ColorCorrection* correction,
+	Order order)
+{
+	std::string functionSignature = "void Bayer::deBayer(tt::ds::Image* source, "
+		"tt::ds::Image* destination, Filter filter, tt::sys::WorkerPool& pool, "
+		"Quality quality, const ColorCorrection* correction, Order order)";
+
+	BandFunction band = getBandFunction(functionSignature, source, destination,
+		filter, quality, correction, order);
+	// discard once here, the bands write to the buffer concurrently
+	destination->discard();
+
+	// don't split the image into bands smaller than MIN_BAND_HEIGHT lines
+	int bands = source->getHeight() / MIN_BAND_HEIGHT;
+	if (bands > pool.getThreads())
+	{
+		bands = pool.getThreads();
+	}
+	if (bands < 1)
+	{
+		bands = 1;
+	}
+
+	DeBayerBands task(source, destination, band, getRowKernels(getKernel()),
+		correction, bands);
+	pool.run(task, bands);
+}
+
+template <Bayer::Pattern P, Bayer::Order O>
+void Bayer::deBayer(tt::ds::Image* source, tt::ds::Image* destination)
+{
+	assert(source->getChannels() == tt::ds::Image::GREYSCALE);
+	assert(source->getBitsPerChannel() == tt::ds::Image::BPC8);
+	assert(destination->getChannels() == tt::ds::Image::RGB);
 	assert(source->getWidth() == destination->getWidth());
 	assert(source->getHeight() == destination->getHeight());
 
-	/*
-	opencv  Bayer Pattern -> RGB conversion
-	 
-	int icvBayer2BGR_8u_C1C3R( const uchar* bayer0, int bayer_step,
-	                       uchar *dst0, int dst_step,
-	                       CvSize size, int code )
-	*/
-	const unsigned char* bayer0 = (const unsigned char*) source->getImageBuffer();
-	int bayer_step = source->getAllocatedWidth();
-	unsigned char* dst0 = (unsigned char*) destination->getImageBuffer();
-	int dst_step = destination->getAllocatedWidth();
-	CvSize size;
-	size.width = source->getWidth();
-	size.height = source->getHeight();
-	int code = filter;
-
-	int blue = code == CV_BayerBG2BGR || code == CV_BayerGB2BGR ? -1 : 1;
-	int start_with_green = code == CV_BayerGB2BGR || code == CV_BayerGR2BGR;
-
-	memset(dst0, 0, size.width*3*sizeof(dst0[0]));
-	memset(dst0 + (size.height - 1)*dst_step, 0, size.width*3*sizeof(dst0[0]));
-	dst0 += dst_step + 3 + 1;
-	size.height -= 2;
-	size.width -= 2;
-
-	for (; size.height-- > 0; bayer0 += bayer_step, dst0 += dst_step)
-	{
-		int t0, t1;
-		const uchar* bayer = bayer0;
-		uchar* dst = dst0;
-		const uchar* bayer_end = bayer + size.width;
-
-		dst[-4] = dst[-3] = dst[-2] = dst[size.width*3-1] =
-			dst[size.width*3] = dst[size.width*3+1] = 0;
-
-		if (size.width <= 0)
-			continue;
+	destination->discard();
+	deBayerBand<P, O, unsigned char>(source, destination, getRowKernels(getKernel()),
+		NULL, 0, source->getHeight());
+}
 
-		if (start_with_green)
+// instances of the template for all patterns and orders
+template void Bayer::deBayer<Bayer::PATTERN_BG, Bayer::ORDER_BGR>(tt::ds::Image*, tt::ds::Image*);
+template void Bayer::deBayer<Bayer::PATTERN_GB, Bayer::ORDER_BGR>(tt::ds::Image*, tt::ds::Image*);
+template void Bayer::deBayer<Bayer::PATTERN_RG, Bayer::ORDER_BGR>(tt::ds::Image*, tt::ds::Image*);
+template void Bayer::deBayer<Bayer::PATTERN_GR, Bayer::ORDER_BGR>(tt::ds::Image*, tt::ds::Image*);
+template void Bayer::deBayer<Bayer::PATTERN_BG, Bayer::ORDER_RGB>(tt::ds::Image*, tt::ds::Image*);
+template void Bayer::deBayer<Bayer::PATTERN_GB, Bayer::ORDER_RGB>(tt::ds::Image*, tt::ds::Image*);
+template void Bayer::deBayer<Bayer::PATTERN_RG, Bayer::ORDER_RGB>(tt::ds::Image*, tt::ds::Image*);
+template void Bayer::deBayer<Bayer::PATTERN_GR, Bayer::ORDER_RGB>(tt::ds::Image*, tt::ds::Image*);
+
+/** @brief Signature of the deBayerRow and malvarRow instances */
+typedef void (*RowFunction)(const unsigned char* bayer, int bayerStep, unsigned char* dst,
+	int width, BayerRowKernel rowKernel);
+
+/**
+ * @brief Return the row function instance for a line phase.
+ * @param blue 1 or -1, see deBayerRow.
+ * @param startWithGreen true, if the second pixel of the line is green.
+ */
+static RowFunction getRowFunction(Bayer::Quality quality, int blue, bool startWithGreen)
+{
+	static const RowFunction bilinearRows[4] = {
+		deBayerRow<1, false>, deBayerRow<1, true>,
+		deBayerRow<-1, false>, deBayerRow<-1, true>
+	};
+	static const RowFunction malvarRows[4] = {
+		malvarRow<1, false>, malvarRow<1, true>,
+		malvarRow<-1, false>, malvarRow<-1, true>
+	};
+
+	int index = (blue > 0 ? 0 : 2) + (startWithGreen ? 1 : 0);
+	return quality == Bayer::QUALITY_MALVAR ? malvarRows[index] : bilinearRows[index];
+}
+
+void Bayer::deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+	int x, int y, Quality quality)
+{
+	std::string functionSignature = "void Bayer::deBayer(tt::ds::Image* source, "
+		"tt::ds::Image* destination, Filter filter, int x, int y, Quality quality)";
+	
+	assert(source->getChannels() == tt::ds::Image::GREYSCALE);
+	assert(source->getBitsPerChannel() == tt::ds::Image::BPC8);
+	assert(destination->getChannels() == tt::ds::Image::RGB);
+
+	int width = source->getWidth();
+	int height = source->getHeight();
+	int roiWidth = destination->getWidth();
+	int roiHeight = destination->getHeight();
+	
+	if (x < 0 || y < 0 || x + roiWidth > width || y + roiHeight > height)
+	{
+		throw std::runtime_error(functionSignature + " region exceeds the source.");
+	}
+	destination->discard();
+
+	// the phase of line 1 of the source, like in deBayerBand
+	int blue = filter == BayerBG2BGR || filter == BayerGB2BGR ? -1 : 1;
+	bool startWithGreen = filter == BayerGB2BGR || filter == BayerGR2BGR;
+	RowKernels kernels = getRowKernels(getKernel());
+	
+	// Each line is interpolated for the region plus the margin needed by the
+	// filters, clipped to the source. The row functions treat the ends of
+	// this span like the ends of a source line, so the margin keeps the
+	// region identical to the same part of a full frame conversion.
+	const int margin = quality == QUALITY_MALVAR ? 2 : 1;
+	int first = x - margin > 0 ? x - margin : 0;
+	int last = x + roiWidth + margin < width ? x + roiWidth + margin : width;
+	int span = last - first;
+	std::vector<unsigned char> line(span*3);
+	
+	// an odd first column swaps green and red/blue within the line
+	if (first % 2 == 1)
+	{
+		startWithGreen = !startWithGreen;
+	}
+
+	// read through a const image, which doesn't detach the source
+	const unsigned char* bayer = ((const tt::ds::Image*) source)->getImageBuffer() + first;
+	int bayerStep = source->getAllocatedWidth();
+	
+	for (int row = 0; row < roiHeight; row++)
+	{
+		int sourceRow = y + row;
+		unsigned char* dst = destination->getImageBuffer() + row*destination->getAllocatedWidth();
+		
+		if (sourceRow == 0 || sourceRow == height - 1)
 		{
-			t0 = (bayer[1] + bayer[bayer_step*2+1] + 1) >> 1;
-			t1 = (bayer[bayer_step] + bayer[bayer_step+2] + 1) >> 1;
-			dst[-blue] = (uchar)t0;
-			dst[0] = bayer[bayer_step+1];
-			dst[blue] = (uchar)t1;
-			bayer++;
-			dst += 3;
+			memset(dst, 0, roiWidth*3);
+			continue;
 		}
-
-		if (blue > 0)
+		
+		bool firstPhase = (sourceRow - 1) % 2 == 0;
+		int lineBlue = firstPhase ? blue : -blue;
+		bool lineStartWithGreen = firstPhase ? startWithGreen : !startWithGreen;
+		
+		// Malvar-He-Cutler needs two lines above and below, the second and
+		// the second last line are bilinear like in malvarBand
+		if (quality == QUALITY_MALVAR && sourceRow >= 2 && sourceRow < height - 2)
 		{
-			for (; bayer <= bayer_end - 2; bayer += 2, dst += 6)
-			{
-				t0 = (bayer[0] + bayer[2] + bayer[bayer_step*2] +
-				      bayer[bayer_step*2+2] + 2) >> 2;
-				t1 = (bayer[1] + bayer[bayer_step] +
-				      bayer[bayer_step+2] + bayer[bayer_step*2+1] + 2) >> 2;
-				dst[-1] = (uchar)t0;
-				dst[0] = (uchar)t1;
-				dst[1] = bayer[bayer_step+1];
-
-				t0 = (bayer[2] + bayer[bayer_step*2+2] + 1) >> 1;
-				t1 = (bayer[bayer_step+1] + bayer[bayer_step+3] + 1) >> 1;
-				dst[2] = (uchar)t0;
-				dst[3] = bayer[bayer_step+2];
-				dst[4] = (uchar)t1;
-			}
+			getRowFunction(QUALITY_MALVAR, lineBlue, lineStartWithGreen)(
+				bayer + (sourceRow - 2)*bayerStep, bayerStep, &line[0], span, kernels.malvar);
 		}
 		else
 		{
-			for (; bayer <= bayer_end - 2; bayer += 2, dst += 6)
+			getRowFunction(QUALITY_BILINEAR, lineBlue, lineStartWithGreen)(
+				bayer + (sourceRow - 1)*bayerStep, bayerStep, &line[0], span, kernels.bilinear);
+		}
+		
+		memcpy(dst, &line[(x - first)*3], roiWidth*3);
+	}
+}
+
+void Bayer::deBayerLuma(tt::ds::Image* source, tt::ds::Image* destination, Filter filter)
+{
+	assert(source->getChannels() == tt::ds::Image::GREYSCALE);
+	assert(source->getBitsPerChannel() == tt::ds::Image::BPC8);
+	assert(destination->getChannels() == tt::ds::Image::GREYSCALE);
+	assert(source->getWidth() == destination->getWidth());
+	assert(source->getHeight() == destination->getHeight());
+
+	destination->discard();
+	BayerRowKernel rowKernel = getRowKernels(getKernel()).luma;
+	switch (filter)
+	{
+		case BayerBG2BGR:
+			lumaBand<PATTERN_BG>(source, destination, rowKernel);
+			break;
+
+		case BayerGB2BGR:
+			lumaBand<PATTERN_GB>(source, destination, rowKernel);
+			break;
+
+		case BayerGR2BGR:
+			lumaBand<PATTERN_GR>(source, destination, rowKernel);
+			break;
+
+		case BayerRG2BGR:
+		default:
+			lumaBand<PATTERN_RG>(source, destination, rowKernel);
+			break;
+	}
+}
+
+void Bayer::deBayerHalf(tt::ds::Image* source, tt::ds::Image* destination, Filter filter)
+{
+	assert(source->getChannels() == tt::ds::Image::GREYSCALE);
+	assert(source->getBitsPerChannel() == tt::ds::Image::BPC8);
+	assert(destination->getChannels() == tt::ds::Image::RGB ||
+		destination->getChannels() == tt::ds::Image::GREYSCALE);
+	assert(source->getWidth() / 2 == destination->getWidth());
+	assert(source->getHeight() / 2 == destination->getHeight());
+
+	destination->discard();
+
+	// the layout of the 2x2 cells, which start at even lines and columns
+	// like deBayer, treat unknown filters as BayerRG2BGR
+	int firstGreen = filter == BayerGB2BGR || filter == BayerGR2BGR ? 1 : 0;
+	int blue = filter == BayerBG2BGR || filter == BayerGB2BGR ? 0 : 1;
+	int upperRedBlue = firstGreen;
+	int lowerRedBlue = 1 - firstGreen;
+	
+	bool grey = destination->getChannels() == tt::ds::Image::GREYSCALE;
+	RowKernels kernels = getRowKernels(getKernel());
+	BayerHalfRowKernel rowKernel = grey ? kernels.halfGrey : kernels.half;
+	int channels = grey ? 1 : 3;
+	int width = destination->getWidth();
+	// read through a const image, which doesn't detach the source
+	const unsigned char* bayer = ((const tt::ds::Image*) source)->getImageBuffer();
+	
+	for (int y = 0; y < destination->getHeight(); y++)
+	{
+		const unsigned char* upper = bayer + 2*y*source->getAllocatedWidth();
+		const unsigned char* lower = upper + source->getAllocatedWidth();
+		unsigned char* dst = destination->getImageBuffer() + y*destination->getAllocatedWidth();
+		
+		int x = 0;
+		if (rowKernel != NULL)
+		{
+			x = rowKernel(upper, source->getAllocatedWidth(), dst, width, firstGreen, blue);
+		}
+		
+		for (; x < width; x++)
+		{
+			unsigned char pixel[3];
+			unsigned char upperValue = upper[2*x + upperRedBlue];
+			unsigned char lowerValue = lower[2*x + lowerRedBlue];
+			pixel[0] = blue ? upperValue : lowerValue;
+			pixel[1] = (unsigned char) ((upper[2*x + 1 - upperRedBlue] +
+				lower[2*x + 1 - lowerRedBlue] + 1) >> 1);
+			pixel[2] = blue ? lowerValue : upperValue;
+
+			if (grey)
 			{
-				t0 = (bayer[0] + bayer[2] + bayer[bayer_step*2] +
-				      bayer[bayer_step*2+2] + 2) >> 2;
-				t1 = (bayer[1] + bayer[bayer_step] +
-				      bayer[bayer_step+2] + bayer[bayer_step*2+1] + 2) >> 2;
-				dst[1] = (uchar)t0;
-				dst[0] = (uchar)t1;
-				dst[-1] = bayer[bayer_step+1];
-
-				t0 = (bayer[2] + bayer[bayer_step*2+2] + 1) >> 1;
-				t1 = (bayer[bayer_step+1] + bayer[bayer_step+3] + 1) >> 1;
-				dst[4] = (uchar)t0;
-				dst[3] = bayer[bayer_step+2];
-				dst[2] = (uchar)t1;
+				dst[x] = luma(pixel);
+			}
+			else
+			{
+				memcpy(dst + x*channels, pixel, 3);
 			}
 		}
+	}
+}
 
-		if (bayer < bayer_end)
+void Bayer::mosaic(tt::ds::Image* source, tt::ds::Image* destination, Filter filter)
+{
+	assert(source->getChannels() == tt::ds::Image::RGB);
+	assert(destination->getChannels() == tt::ds::Image::GREYSCALE);
+	assert(source->getWidth() == destination->getWidth());
+	assert(source->getHeight() == destination->getHeight());
+
+	destination->discard();
+
+	int blue = filter == BayerBG2BGR || filter == BayerGB2BGR ? -1 : 1;
+	bool startWithGreen = filter == BayerGB2BGR || filter == BayerGR2BGR;
+	int width = source->getWidth();
+	int height = source->getHeight();
+	// read through a const image, which doesn't detach the source
+	const unsigned char* rgb = ((const tt::ds::Image*) source)->getImageBuffer();
+	
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* src = rgb + y*source->getAllocatedWidth();
+		unsigned char* dst = destination->getImageBuffer() + y*destination->getAllocatedWidth();
+		
+		// the phase of line 1 is the one given by the filter, it alternates
+		// with each line
+		bool firstPhase = (y + 1) % 2 == 0;
+		int lineBlue = firstPhase ? blue : -blue;
+		bool lineStartWithGreen = firstPhase ? startWithGreen : !startWithGreen;
+		int redBlueChannel = lineBlue > 0 ? 2 : 0;
+		
+		for (int x = 0; x < width; x++)
 		{
-			t0 = (bayer[0] + bayer[2] + bayer[bayer_step*2] +
-			      bayer[bayer_step*2+2] + 2) >> 2;
-			t1 = (bayer[1] + bayer[bayer_step] +
-			      bayer[bayer_step+2] + bayer[bayer_step*2+1] + 2) >> 2;
-			dst[-blue] = (uchar)t0;
-			dst[0] = (uchar)t1;
-			dst[blue] = bayer[bayer_step+1];
-			bayer++;
-			dst += 3;
+			bool green = (x % 2 == 1) == lineStartWithGreen;
+			dst[x] = src[x*3 + (green ? 1 : redBlueChannel)];
 		}
-
-		blue = -blue;
-		start_with_green = !start_with_green;
 	}
 }
 
@@ -2,13 +2,35 @@
 #define TT_PROCESS_BAYER_H
 
 #include <tt/ds/Image.h>
+#include <tt/ds/TypedImage.h>
+#include <tt/sys/WorkerPool.h>
 
 namespace tt
 {
 
+/**
+ * @brief Namespace for all image processing functions.
+ */
 namespace process
 {
 
+class ColorCorrection;
+
+/**
+ * @class Bayer Bayer.h tt/process/Bayer.h
+ * @brief Conversion of Bayer pattern images into color images.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ * 
+ * Bayer interpolates the raw single channel images of Firewire cameras with
+ * a color filter array into 3 channel images. The bilinear interpolation is
+ * available as a scalar reference and as SSE2, SSSE3 and AVX2 kernels, the
+ * Malvar-He-Cutler interpolation as scalar and SSE2 kernels. All kernels of
+ * one method produce exactly the same output. The fastest kernel supported by the
+ * processor is selected at runtime. The scalar code is generated per pattern
+ * and channel order, the Filter based functions select the instance once per
+ * frame. Large images can additionally be split
+ * into bands of lines, which are converted in parallel by a WorkerPool.
+ */
 class Bayer
 {
 public:
@@ -25,8 +47,237 @@ public:
 		BayerGR2RGB = BayerGB2BGR
 	};
 	
+	/**
+	 * @brief Color filter arrays, named after the filter enum values
+	 */
+	enum Pattern
+	{
+		PATTERN_BG = 0,
+		PATTERN_GB = 1,
+		PATTERN_RG = 2,
+		PATTERN_GR = 3
+	};
+	
+	/**
+	 * @brief Channel order of the interpolated images
+	 */
+	enum Order
+	{
+		ORDER_BGR = 0,
+		ORDER_RGB = 1
+	};
+
+	/**
+	 * @brief Interpolation methods
+	 * 
+	 * QUALITY_BILINEAR averages the nearest neighbours of each color and is
+	 * the fastest method. QUALITY_MALVAR uses the 5x5 gradient corrected
+	 * linear filters by Malvar, He and Cutler, which avoid most of the zipper
+	 * artifacts at edges for about twice the cost.
+	 */
+	enum Quality
+	{
+		QUALITY_BILINEAR = 0,
+		QUALITY_MALVAR = 1
+	};
+
+	/**
+	 * @brief Implementations of the interpolation kernel
+	 */
+	enum Kernel
+	{
+		KERNEL_AUTO = 0,
+		KERNEL_SCALAR = 1,
+		KERNEL_SSE2 = 2,
+		KERNEL_SSSE3 = 3,
+		KERNEL_AVX2 = 4
+	};
+	
 public:
-	static void deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter);
+	static void deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+		Quality quality = QUALITY_BILINEAR);
+
+	/**
+	 * @brief Converts a single channel greyscale picture with a fixed pattern
+	 * @param P The color filter array of the source picture
+	 * @param O The channel order of the destination picture
+	 * @param source The source picture (must be GREYSCALE)
+	 * @param destination (must be RGB)
+	 * 
+	 * deBayer<P, O> gives the same result as deBayer with the filter BayerP2O.
+	 * Instances exist for all patterns and orders.
+	 */
+	template <Pattern P, Order O>
+	static void deBayer(tt::ds::Image* source, tt::ds::Image* destination);
+
+	/**
+	 * @brief Converts a Bayer pattern picture into an rgb picture
+	 * @param source The source picture, whose pattern selects the conversion
+	 * @param destination The destination picture of the same size
+	 * 
+	 * Calls deBayer<P, ORDER_RGB> without any check of the formats at runtime.
+	 */
+	template <int P>
+	static void deBayer(tt::ds::TypedImage<tt::ds::Bayer8<P> >& source,
+		tt::ds::TypedImage<tt::ds::Rgb8>& destination)
+	{
+		deBayer<(Pattern) P, ORDER_RGB>(&source.getImage(), &destination.getImage());
+	}
+
+	/**
+	 * @brief Converts a Bayer pattern picture into a bgr picture
+	 * @param source The source picture, whose pattern selects the conversion
+	 * @param destination The destination picture of the same size
+	 * 
+	 * Calls deBayer<P, ORDER_BGR> without any check of the formats at runtime.
+	 */
+	template <int P>
+	static void deBayer(tt::ds::TypedImage<tt::ds::Bayer8<P> >& source,
+		tt::ds::TypedImage<tt::ds::Bgr8>& destination)
+	{
+		deBayer<(Pattern) P, ORDER_BGR>(&source.getImage(), &destination.getImage());
+	}
+
+	/**
+	 * @brief Converts a single channel greyscale picture into a color corrected rgb image
+	 * @param source The source picture (must be GREYSCALE)
+	 * @param destination (must be RGB)
+	 * @param filter Use this filter for debayering
+	 * @param correction White balance gains and gamma applied to each line
+	 * @param quality The interpolation method
+	 * @param order The channel order of the destination, which selects the
+	 * channels the gains are applied to. The RGB filters are aliases of the
+	 * BGR filters, so it can't be told from the filter.
+	 * 
+	 * Each line is corrected right after its interpolation, while it is still
+	 * in the cache. This is a single pass over the frame instead of one for the
+	 * interpolation and one for each correction. The correction needs BPC8
+	 * images, BPC16 images throw a std::runtime_error.
+	 */
+	static void deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+		const ColorCorrection& correction, Quality quality = QUALITY_BILINEAR,
+		Order order = ORDER_BGR);
+
+	/**
+	 * @brief Converts a single channel greyscale picture into an rgb image in parallel
+	 * @param source The source picture (must be GREYSCALE)
+	 * @param destination (must be RGB)
+	 * @param filter Use this filter for debayering
+	 * @param pool The threads to use, the calling thread is one of them.
+	 * @param quality The interpolation method
+	 * 
+	 * The image is split into one band of lines per thread. Each band reads
+	 * the source lines above and below itself needed by the interpolation
+	 * method, so the result is exactly the same as the one of the serial
+	 * version. Returns after all bands are converted.
+	 */
+	static void deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+		tt::sys::WorkerPool& pool, Quality quality = QUALITY_BILINEAR);
+
+	/**
+	 * @brief Converts a single channel greyscale picture into a color
+	 * corrected rgb image in parallel
+	 * 
+	 * Combines the parallel and the color corrected deBayer.
+	 */
+	static void deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+		tt::sys::WorkerPool& pool, const ColorCorrection& correction,
+		Quality quality = QUALITY_BILINEAR, Order order = ORDER_BGR);
+
+	/**
+	 * @brief Converts a region of a single channel greyscale picture into an rgb image
+	 * @param source The source picture (must be GREYSCALE)
+	 * @param destination The converted region (must be RGB), its size is
+	 * the size of the region
+	 * @param filter The filter of the whole source picture
+	 * @param x The left column of the region within the source
+	 * @param y The upper line of the region within the source
+	 * @param quality The interpolation method
+	 * 
+	 * Only the region and the source pixels around it needed by the
+	 * interpolation are read. The pattern phase is corrected for odd offsets,
+	 * so the result is exactly the same part of the full conversion with the
+	 * same filter, including the zero border of the source picture. Throws a
+	 * std::runtime_error, if the region exceeds the source.
+	 */
+	static void deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+		int x, int y, Quality quality = QUALITY_BILINEAR);
+
+	/**
+	 * @brief Converts a single channel Bayer pattern picture into its luma
+	 * @param source The source picture (must be GREYSCALE)
+	 * @param destination The luma of the same size (must be GREYSCALE)
+	 * @param filter The filter of the source pattern
+	 * 
+	 * Gives the luma 0.299 R + 0.587 G + 0.114 B (in fixed point) of the
+	 * bilinearly interpolated picture without writing the color picture,
+	 * which saves two thirds of the written bytes for greyscale consumers.
+	 */
+	static void deBayerLuma(tt::ds::Image* source, tt::ds::Image* destination, Filter filter);
+
+	/**
+	 * @brief Converts a single channel Bayer pattern picture into a half
+	 * resolution picture by 2x2 binning
+	 * @param source The source picture (must be GREYSCALE)
+	 * @param destination RGB or GREYSCALE, half the width and height of the
+	 * source, rounded down
+	 * @param filter The filter of the source pattern
+	 * 
+	 * Each 2x2 cell of the pattern gives one pixel, with the red and blue
+	 * values of the cell and the average of both greens in the order of the
+	 * filter. GREYSCALE destinations get the luma of this pixel, see
+	 * deBayerLuma. There is no interpolation, so there are no zero borders.
+	 */
+	static void deBayerHalf(tt::ds::Image* source, tt::ds::Image* destination, Filter filter);
+
+	/**
+	 * @brief Sample an rgb image with a color filter array.
+	 * @param source The source picture (must be RGB)
+	 * @param destination The Bayer pattern image (must be GREYSCALE)
+	 * @param filter The filter whose pattern is sampled
+	 * 
+	 * This is the inverse of deBayer with the same filter, which allows to
+	 * measure the interpolation error on known color images.
+	 */
+	static void mosaic(tt::ds::Image* source, tt::ds::Image* destination, Filter filter);
+
+	/**
+	 * @brief Select the kernel used by deBayer.
+	 * @param kernel The desired kernel. KERNEL_AUTO selects the fastest kernel
+	 * supported by the processor, which is also the default.
+	 * 
+	 * Throws a std::runtime_error, if the processor doesn't support the kernel.
+	 */
+	static void setKernel(Kernel kernel);
+
+	/**
+	 * @brief Return the kernel used by deBayer.
+	 * 
+	 * KERNEL_AUTO is resolved into the actual kernel.
+	 */
+	static Kernel getKernel();
+
+	/**
+	 * @brief Return true, if the kernel can be used on this processor.
+	 * @param kernel The kernel to check.
+	 */
+	static bool isKernelSupported(Kernel kernel);
+
+	/** @brief Bands of lines converted in parallel are at least this high */
+	static const int MIN_BAND_HEIGHT = 32;
+
+private:
+	/** @brief Serial conversion, correction may be NULL */
+	static void deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+		Quality quality, const ColorCorrection* correction, Order order);
+
+	/** @brief Parallel conversion, correction may be NULL */
+	static void deBayer(tt::ds::Image* source, tt::ds::Image* destination, Filter filter,
+		tt::sys::WorkerPool& pool, Quality quality, const ColorCorrection* correction,
+		Order order);
+
+	/** @brief The kernel selected by setKernel */
+	static Kernel kernel;
 };
 
 } // namespace process
@@ -0,0 +1,82 @@
+/*
+ * BayerAVX2
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#ifdef TT_SIMD_X86 // Build the AVX2 kernel only on x86 platforms
+
+#include <immintrin.h>
+#include "BayerKernels.h"
+#include "PixelsSSSE3.h"
+
+namespace tt
+{
+
+namespace process
+{
+
+int bayerRowAVX2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int blue)
+{
+	const unsigned char* bayerStart = bayer;
+	const unsigned char* bayerEnd = bayer + width;
+	const __m256i maskLow = _mm256_set1_epi16(0x00ff);
+	const __m256i delta2 = _mm256_set1_epi16(2);
+
+	// 32 pixels per iteration, reading the source columns 0 to 33
+	for (; bayer <= bayerEnd - 34; bayer += 32, dst += 96)
+	{
+		__m256i r0 = _mm256_loadu_si256((const __m256i*) bayer);
+		__m256i r0n = _mm256_loadu_si256((const __m256i*) (bayer + 2));
+		__m256i r1 = _mm256_loadu_si256((const __m256i*) (bayer + bayerStep));
+		__m256i r1n = _mm256_loadu_si256((const __m256i*) (bayer + bayerStep + 2));
+		__m256i r2 = _mm256_loadu_si256((const __m256i*) (bayer + bayerStep * 2));
+		__m256i r2n = _mm256_loadu_si256((const __m256i*) (bayer + bayerStep * 2 + 2));
+
+		// split into even (red/blue) and odd (green) columns as 16 bit values
+		__m256i r0even = _mm256_and_si256(r0, maskLow);
+		__m256i r0odd = _mm256_srli_epi16(r0, 8);
+		__m256i r0evenNext = _mm256_and_si256(r0n, maskLow);
+		__m256i r1even = _mm256_and_si256(r1, maskLow);
+		__m256i r1odd = _mm256_srli_epi16(r1, 8);
+		__m256i r1evenNext = _mm256_and_si256(r1n, maskLow);
+		__m256i r1oddNext = _mm256_srli_epi16(r1n, 8);
+		__m256i r2even = _mm256_and_si256(r2, maskLow);
+		__m256i r2odd = _mm256_srli_epi16(r2, 8);
+		__m256i r2evenNext = _mm256_and_si256(r2n, maskLow);
+
+		// red/blue pixels: diagonal and cross neighbours
+		__m256i diagonal = _mm256_add_epi16(_mm256_add_epi16(r0even, r0evenNext),
+			_mm256_add_epi16(r2even, r2evenNext));
+		diagonal = _mm256_srli_epi16(_mm256_add_epi16(diagonal, delta2), 2);
+		__m256i cross = _mm256_add_epi16(_mm256_add_epi16(r0odd, r2odd),
+			_mm256_add_epi16(r1even, r1evenNext));
+		cross = _mm256_srli_epi16(_mm256_add_epi16(cross, delta2), 2);
+
+		// green pixels: vertical and horizontal neighbours, (a + b + 1) >> 1
+		__m256i vertical = _mm256_avg_epu16(r0evenNext, r2evenNext);
+		__m256i horizontal = _mm256_avg_epu16(r1odd, r1oddNext);
+
+		// planes with the red/blue pixel in the low and the green pixel in the high byte
+		__m256i interpolated = _mm256_or_si256(diagonal, _mm256_slli_epi16(vertical, 8));
+		__m256i green = _mm256_or_si256(cross, _mm256_slli_epi16(r1evenNext, 8));
+		__m256i center = _mm256_or_si256(r1odd, _mm256_slli_epi16(horizontal, 8));
+
+		__m256i c0 = blue > 0 ? interpolated : center;
+		__m256i c2 = blue > 0 ? center : interpolated;
+
+		// the byte shuffle works within 128 bit lanes, so store each half separately
+		storePixels(dst, _mm256_castsi256_si128(c0), _mm256_castsi256_si128(green),
+			_mm256_castsi256_si128(c2));
+		storePixels(dst + 48, _mm256_extracti128_si256(c0, 1),
+			_mm256_extracti128_si256(green, 1), _mm256_extracti128_si256(c2, 1));
+	}
+
+	return (int) (bayer - bayerStart);
+}
+
+} // namespace process
+
+} // namespace tt
+
+#endif // TT_SIMD_X86
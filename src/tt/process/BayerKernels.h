@@ -0,0 +1,99 @@
+#ifndef TT_PROCESS_BAYERKERNELS_H
+#define TT_PROCESS_BAYERKERNELS_H
+
+/*
+ * Internal interface between Bayer.cpp and the vectorized interpolation
+ * kernels. Each kernel lives in its own translation unit, compiled with the
+ * instruction set it needs, and must only be called after checking the
+ * processor with tt::sys::CPU. This header is not installed.
+ */
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @brief Bilinear interpolation of a run of pixel pairs within one line.
+ * @param bayer Upper left pixel of the 3x3 neighbourhood of the first pixel,
+ * which must be a red or blue pixel.
+ * @param bayerStep Number of bytes per source line.
+ * @param dst First channel of the first output pixel.
+ * @param width Number of source columns left between bayer and the end of
+ * the interpolated part of the line.
+ * @param blue 1 or -1, see Bayer::deBayer.
+ * @return The number of pixels written, which is always even. The remaining
+ * pixels are left for the scalar code.
+ */
+typedef int (*BayerRowKernel)(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int blue);
+
+/*
+ * The Malvar-He-Cutler kernels use the same signature, but bayer points two
+ * lines above and two columns left of the first pixel, and width is the
+ * number of columns left which have a complete 5x5 neighbourhood.
+ *
+ * The Malvar-He-Cutler kernels of 16 bit pixels use the BayerRow16Kernel
+ * signature the same way.
+ *
+ * The luma kernels use the same signature as the bilinear kernels, but write
+ * one byte per pixel, the luma of the bilinearly interpolated pixel in the
+ * order given by blue.
+ */
+
+/**
+ * @brief Bilinear interpolation of 16 bit pixels, like BayerRowKernel.
+ * @param bayerStep Number of pixels per source line.
+ */
+typedef int (*BayerRow16Kernel)(const unsigned short* bayer, int bayerStep,
+	unsigned short* dst, int width, int blue);
+
+/**
+ * @brief 2x2 binning of a run of Bayer cells of a line pair.
+ * @param bayer First pixel of the upper line of the first cell.
+ * @param bayerStep Number of bytes per source line.
+ * @param dst First output pixel.
+ * @param width Number of cells left in the line pair.
+ * @param firstGreen 1, if the upper left pixel of a cell is green, 0 otherwise.
+ * @param blue 1, if the red/blue pixel of the upper line is blue, 0 if it is red.
+ * @return The number of cells written, the remaining ones are left for the
+ * scalar code.
+ */
+typedef int (*BayerHalfRowKernel)(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int firstGreen, int blue);
+
+/*
+ * Fixed point weights of red, green and blue for the luma, the ITU-R BT.601
+ * weights scaled to a sum of 256.
+ */
+static const int LUMA_RED = 77;
+static const int LUMA_GREEN = 150;
+static const int LUMA_BLUE = 29;
+
+#ifdef TT_SIMD_X86
+int bayerMalvarRowSSE2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int blue);
+int bayerLumaRowSSE2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int blue);
+int bayerHalfRowSSE2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int firstGreen, int blue);
+int bayerHalfGreyRowSSE2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int firstGreen, int blue);
+int bayerRowSSE2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int blue);
+int bayerRow16SSE2(const unsigned short* bayer, int bayerStep,
+	unsigned short* dst, int width, int blue);
+int bayerMalvarRow16SSE2(const unsigned short* bayer, int bayerStep,
+	unsigned short* dst, int width, int blue);
+int bayerRowSSSE3(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int blue);
+int bayerRowAVX2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int blue);
+#endif // TT_SIMD_X86
+
+} // namespace process
+
+} // namespace tt
+
+#endif /*TT_PROCESS_BAYERKERNELS_H*/
@@ -0,0 +1,562 @@
+/*
+ * BayerSSE2
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#ifdef TT_SIMD_X86 // Build the SSE2 kernel only on x86 platforms
+
+#include <string.h>
+#include <emmintrin.h>
+#include "BayerKernels.h"
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @brief Pack 4 pixels stored in 32 bit lanes (c0, c1, c2, 0) into 12 bytes.
+ * 
+ * The bytes 12 to 15 of the result are zero.
+ */
+static inline __m128i packPixels(__m128i pixels)
+{
+	const __m128i lowPixel = _mm_set_epi32(0, 0x00ffffff, 0, 0x00ffffff);
+	const __m128i highPixel = _mm_set_epi32(0x0000ffff, (int) 0xff000000, 0x0000ffff, (int) 0xff000000);
+
+	// move the upper pixel of each 64 bit lane next to the lower one
+	__m128i packed = _mm_or_si128(_mm_and_si128(pixels, lowPixel),
+		_mm_and_si128(_mm_srli_epi64(pixels, 8), highPixel));
+
+	// move the 6 bytes of the upper lane next to the 6 bytes of the lower lane
+	return _mm_or_si128(_mm_move_epi64(packed),
+		_mm_slli_si128(_mm_unpackhi_epi64(packed, _mm_setzero_si128()), 6));
+}
+
+/**
+ * @brief Interleave 3 planes of 16 bytes each into 16 pixels with 3 channels.
+ */
+static inline void storePixels(unsigned char* dst, __m128i c0, __m128i c1, __m128i c2)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	// interleave the planes into 32 bit pixels and pack them to 3 bytes
+	__m128i c01Low = _mm_unpacklo_epi8(c0, c1);
+	__m128i c01High = _mm_unpackhi_epi8(c0, c1);
+	__m128i c2Low = _mm_unpacklo_epi8(c2, zero);
+	__m128i c2High = _mm_unpackhi_epi8(c2, zero);
+
+	_mm_storeu_si128((__m128i*) dst, packPixels(_mm_unpacklo_epi16(c01Low, c2Low)));
+	_mm_storeu_si128((__m128i*) (dst + 12), packPixels(_mm_unpackhi_epi16(c01Low, c2Low)));
+	_mm_storeu_si128((__m128i*) (dst + 24), packPixels(_mm_unpacklo_epi16(c01High, c2High)));
+	__m128i last = packPixels(_mm_unpackhi_epi16(c01High, c2High));
+	_mm_storel_epi64((__m128i*) (dst + 36), last);
+	int lastBytes = _mm_cvtsi128_si32(_mm_srli_si128(last, 8));
+	memcpy(dst + 44, &lastBytes, 4);
+}
+
+/**
+ * @brief Bilinear interpolants of 8 pixel pairs as 16 bit values, the
+ * even lanes hold the red/blue pixels, the odd lanes the green pixels.
+ */
+struct BilinearPairs
+{
+	/** @brief The other color of the red/blue pixel */
+	__m128i diagonal;
+	/** @brief Green at the red/blue pixel */
+	__m128i cross;
+	/** @brief The red/blue pixel itself */
+	__m128i center;
+	/** @brief The color of the lines above and below at the green pixel */
+	__m128i vertical;
+	/** @brief The green pixel itself */
+	__m128i green;
+	/** @brief The color of the line at the green pixel */
+	__m128i horizontal;
+};
+
+/**
+ * @brief Interpolate 16 pixels, reading the source columns 0 to 17.
+ */
+static inline void interpolateBilinear(const unsigned char* bayer, int bayerStep,
+	BilinearPairs& pairs)
+{
+	const __m128i maskLow = _mm_set1_epi16(0x00ff);
+	const __m128i delta2 = _mm_set1_epi16(2);
+
+	__m128i r0 = _mm_loadu_si128((const __m128i*) bayer);
+	__m128i r0n = _mm_loadu_si128((const __m128i*) (bayer + 2));
+	__m128i r1 = _mm_loadu_si128((const __m128i*) (bayer + bayerStep));
+	__m128i r1n = _mm_loadu_si128((const __m128i*) (bayer + bayerStep + 2));
+	__m128i r2 = _mm_loadu_si128((const __m128i*) (bayer + bayerStep * 2));
+	__m128i r2n = _mm_loadu_si128((const __m128i*) (bayer + bayerStep * 2 + 2));
+
+	// split into even (red/blue) and odd (green) columns as 16 bit values
+	__m128i r0even = _mm_and_si128(r0, maskLow);
+	__m128i r0odd = _mm_srli_epi16(r0, 8);
+	__m128i r0evenNext = _mm_and_si128(r0n, maskLow);
+	__m128i r1even = _mm_and_si128(r1, maskLow);
+	__m128i r1odd = _mm_srli_epi16(r1, 8);
+	__m128i r1evenNext = _mm_and_si128(r1n, maskLow);
+	__m128i r1oddNext = _mm_srli_epi16(r1n, 8);
+	__m128i r2even = _mm_and_si128(r2, maskLow);
+	__m128i r2odd = _mm_srli_epi16(r2, 8);
+	__m128i r2evenNext = _mm_and_si128(r2n, maskLow);
+
+	// red/blue pixels: diagonal and cross neighbours
+	__m128i diagonal = _mm_add_epi16(_mm_add_epi16(r0even, r0evenNext),
+		_mm_add_epi16(r2even, r2evenNext));
+	pairs.diagonal = _mm_srli_epi16(_mm_add_epi16(diagonal, delta2), 2);
+	__m128i cross = _mm_add_epi16(_mm_add_epi16(r0odd, r2odd),
+		_mm_add_epi16(r1even, r1evenNext));
+	pairs.cross = _mm_srli_epi16(_mm_add_epi16(cross, delta2), 2);
+	pairs.center = r1odd;
+
+	// green pixels: vertical and horizontal neighbours, (a + b + 1) >> 1
+	pairs.vertical = _mm_avg_epu16(r0evenNext, r2evenNext);
+	pairs.green = r1evenNext;
+	pairs.horizontal = _mm_avg_epu16(r1odd, r1oddNext);
+}
+
+int bayerRowSSE2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int blue)
+{
+	const unsigned char* bayerStart = bayer;
+	const unsigned char* bayerEnd = bayer + width;
+
+	// 16 pixels per iteration, reading the source columns 0 to 17
+	for (; bayer <= bayerEnd - 18; bayer += 16, dst += 48)
+	{
+		BilinearPairs pairs;
+		interpolateBilinear(bayer, bayerStep, pairs);
+
+		// planes with the red/blue pixel in the low and the green pixel in the high byte
+		__m128i interpolated = _mm_or_si128(pairs.diagonal, _mm_slli_epi16(pairs.vertical, 8));
+		__m128i green = _mm_or_si128(pairs.cross, _mm_slli_epi16(pairs.green, 8));
+		__m128i center = _mm_or_si128(pairs.center, _mm_slli_epi16(pairs.horizontal, 8));
+
+		if (blue > 0)
+		{
+			storePixels(dst, interpolated, green, center);
+		}
+		else
+		{
+			storePixels(dst, center, green, interpolated);
+		}
+	}
+
+	return (int) (bayer - bayerStart);
+}
+
+/**
+ * @brief Pack 2 pixels stored in 64 bit lanes (c0, c1, c2, 0) of 16 bit
+ * values into 12 bytes.
+ * 
+ * The bytes 12 to 15 of the result are zero.
+ */
+static inline __m128i packPixels16(__m128i pixels)
+{
+	return _mm_or_si128(_mm_move_epi64(pixels), _mm_slli_si128(_mm_srli_si128(pixels, 8), 6));
+}
+
+/**
+ * @brief Interleave 3 planes of 8 16 bit values each into 8 pixels with 3
+ * channels.
+ */
+static inline void storePixels16(unsigned short* dst, __m128i c0, __m128i c1, __m128i c2)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i c01Low = _mm_unpacklo_epi16(c0, c1);
+	__m128i c01High = _mm_unpackhi_epi16(c0, c1);
+	__m128i c2Low = _mm_unpacklo_epi16(c2, zero);
+	__m128i c2High = _mm_unpackhi_epi16(c2, zero);
+
+	_mm_storeu_si128((__m128i*) dst, packPixels16(_mm_unpacklo_epi32(c01Low, c2Low)));
+	_mm_storeu_si128((__m128i*) (dst + 6), packPixels16(_mm_unpackhi_epi32(c01Low, c2Low)));
+	_mm_storeu_si128((__m128i*) (dst + 12), packPixels16(_mm_unpacklo_epi32(c01High, c2High)));
+	__m128i last = packPixels16(_mm_unpackhi_epi32(c01High, c2High));
+	_mm_storel_epi64((__m128i*) (dst + 18), last);
+	int lastValues = _mm_cvtsi128_si32(_mm_srli_si128(last, 8));
+	memcpy(dst + 22, &lastValues, 4);
+}
+
+int bayerRow16SSE2(const unsigned short* bayer, int bayerStep,
+	unsigned short* dst, int width, int blue)
+{
+	const __m128i maskLow = _mm_set1_epi32(0x0000ffff);
+	const __m128i delta2 = _mm_set1_epi32(2);
+	const unsigned short* bayerStart = bayer;
+	const unsigned short* bayerEnd = bayer + width;
+
+	// 8 pixels per iteration, reading the source columns 0 to 9, like
+	// interpolateBilinear, but with 32 bit lanes for the sums of 16 bit values
+	for (; bayer <= bayerEnd - 10; bayer += 8, dst += 24)
+	{
+		__m128i r0 = _mm_loadu_si128((const __m128i*) bayer);
+		__m128i r0n = _mm_loadu_si128((const __m128i*) (bayer + 2));
+		__m128i r1 = _mm_loadu_si128((const __m128i*) (bayer + bayerStep));
+		__m128i r1n = _mm_loadu_si128((const __m128i*) (bayer + bayerStep + 2));
+		__m128i r2 = _mm_loadu_si128((const __m128i*) (bayer + bayerStep * 2));
+		__m128i r2n = _mm_loadu_si128((const __m128i*) (bayer + bayerStep * 2 + 2));
+
+		__m128i r0even = _mm_and_si128(r0, maskLow);
+		__m128i r0odd = _mm_srli_epi32(r0, 16);
+		__m128i r0evenNext = _mm_and_si128(r0n, maskLow);
+		__m128i r1even = _mm_and_si128(r1, maskLow);
+		__m128i r1odd = _mm_srli_epi32(r1, 16);
+		__m128i r1evenNext = _mm_and_si128(r1n, maskLow);
+		__m128i r2even = _mm_and_si128(r2, maskLow);
+		__m128i r2odd = _mm_srli_epi32(r2, 16);
+		__m128i r2evenNext = _mm_and_si128(r2n, maskLow);
+
+		// red/blue pixels
+		__m128i diagonal = _mm_add_epi32(_mm_add_epi32(r0even, r0evenNext),
+			_mm_add_epi32(r2even, r2evenNext));
+		diagonal = _mm_srli_epi32(_mm_add_epi32(diagonal, delta2), 2);
+		__m128i cross = _mm_add_epi32(_mm_add_epi32(r0odd, r2odd),
+			_mm_add_epi32(r1even, r1evenNext));
+		cross = _mm_srli_epi32(_mm_add_epi32(cross, delta2), 2);
+
+		// green pixels, (a + b + 1) >> 1 of the 16 bit values
+		__m128i vertical = _mm_and_si128(_mm_avg_epu16(r0n, r2n), maskLow);
+		__m128i horizontal = _mm_srli_epi32(_mm_avg_epu16(r1, r1n), 16);
+
+		// planes with the red/blue pixel in the low and the green pixel in the high half
+		__m128i interpolated = _mm_or_si128(diagonal, _mm_slli_epi32(vertical, 16));
+		__m128i green = _mm_or_si128(cross, _mm_slli_epi32(r1evenNext, 16));
+		__m128i center = _mm_or_si128(r1odd, _mm_slli_epi32(horizontal, 16));
+
+		if (blue > 0)
+		{
+			storePixels16(dst, interpolated, green, center);
+		}
+		else
+		{
+			storePixels16(dst, center, green, interpolated);
+		}
+	}
+
+	return (int) (bayer - bayerStart);
+}
+
+/**
+ * @brief Luma of 16 bit blue, green and red values, rounded to 8 bit values
+ * in 16 bit lanes.
+ */
+static inline __m128i luma(__m128i blue, __m128i green, __m128i red)
+{
+	// the sum of the weights is 256, so the sum fits unsigned 16 bit lanes
+	__m128i sum = _mm_add_epi16(_mm_mullo_epi16(blue, _mm_set1_epi16(LUMA_BLUE)),
+		_mm_mullo_epi16(green, _mm_set1_epi16(LUMA_GREEN)));
+	sum = _mm_add_epi16(sum, _mm_mullo_epi16(red, _mm_set1_epi16(LUMA_RED)));
+	return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+int bayerLumaRowSSE2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int blue)
+{
+	const unsigned char* bayerStart = bayer;
+	const unsigned char* bayerEnd = bayer + width;
+
+	for (; bayer <= bayerEnd - 18; bayer += 16, dst += 16)
+	{
+		BilinearPairs pairs;
+		interpolateBilinear(bayer, bayerStep, pairs);
+
+		__m128i redBlue;
+		__m128i green;
+		if (blue > 0)
+		{
+			redBlue = luma(pairs.diagonal, pairs.cross, pairs.center);
+			green = luma(pairs.vertical, pairs.green, pairs.horizontal);
+		}
+		else
+		{
+			redBlue = luma(pairs.center, pairs.cross, pairs.diagonal);
+			green = luma(pairs.horizontal, pairs.green, pairs.vertical);
+		}
+		_mm_storeu_si128((__m128i*) dst, _mm_or_si128(redBlue, _mm_slli_epi16(green, 8)));
+	}
+
+	return (int) (bayer - bayerStart);
+}
+
+/**
+ * @brief Bin 16 Bayer cells into 8 bit blue, green and red planes.
+ */
+static inline void binCells(const unsigned char* bayer, int bayerStep, int firstGreen,
+	int blue, __m128i& b, __m128i& g, __m128i& r)
+{
+	const __m128i maskLow = _mm_set1_epi16(0x00ff);
+	
+	__m128i upper0 = _mm_loadu_si128((const __m128i*) bayer);
+	__m128i upper1 = _mm_loadu_si128((const __m128i*) (bayer + 16));
+	__m128i lower0 = _mm_loadu_si128((const __m128i*) (bayer + bayerStep));
+	__m128i lower1 = _mm_loadu_si128((const __m128i*) (bayer + bayerStep + 16));
+
+	// the left and right column of each cell as bytes
+	__m128i upperLeft = _mm_packus_epi16(_mm_and_si128(upper0, maskLow),
+		_mm_and_si128(upper1, maskLow));
+	__m128i upperRight = _mm_packus_epi16(_mm_srli_epi16(upper0, 8),
+		_mm_srli_epi16(upper1, 8));
+	__m128i lowerLeft = _mm_packus_epi16(_mm_and_si128(lower0, maskLow),
+		_mm_and_si128(lower1, maskLow));
+	__m128i lowerRight = _mm_packus_epi16(_mm_srli_epi16(lower0, 8),
+		_mm_srli_epi16(lower1, 8));
+
+	__m128i upperRedBlue = firstGreen ? upperRight : upperLeft;
+	__m128i lowerRedBlue = firstGreen ? lowerLeft : lowerRight;
+	
+	// (a + b + 1) >> 1 of both greens
+	g = firstGreen ? _mm_avg_epu8(upperLeft, lowerRight) : _mm_avg_epu8(upperRight, lowerLeft);
+	b = blue ? upperRedBlue : lowerRedBlue;
+	r = blue ? lowerRedBlue : upperRedBlue;
+}
+
+int bayerHalfRowSSE2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int firstGreen, int blue)
+{
+	int cells = 0;
+	
+	// 16 cells per iteration, reading 32 columns of both lines
+	for (; cells + 16 <= width; cells += 16, bayer += 32, dst += 48)
+	{
+		__m128i b, g, r;
+		binCells(bayer, bayerStep, firstGreen, blue, b, g, r);
+		storePixels(dst, b, g, r);
+	}
+
+	return cells;
+}
+
+int bayerHalfGreyRowSSE2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int firstGreen, int blue)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int cells = 0;
+	
+	for (; cells + 16 <= width; cells += 16, bayer += 32, dst += 16)
+	{
+		__m128i b, g, r;
+		binCells(bayer, bayerStep, firstGreen, blue, b, g, r);
+		
+		__m128i low = luma(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(g, zero),
+			_mm_unpacklo_epi8(r, zero));
+		__m128i high = luma(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(g, zero),
+			_mm_unpackhi_epi8(r, zero));
+		_mm_storeu_si128((__m128i*) dst, _mm_packus_epi16(low, high));
+	}
+
+	return cells;
+}
+
+/**
+ * @brief Malvar-He-Cutler result of 16 times the interpolated value,
+ * rounded, scaled and saturated to 0..255.
+ */
+static inline __m128i malvarValue(__m128i sum)
+{
+	const __m128i delta8 = _mm_set1_epi16(8);
+	const __m128i max = _mm_set1_epi16(255);
+	
+	sum = _mm_srai_epi16(_mm_add_epi16(sum, delta8), 4);
+	return _mm_min_epi16(_mm_max_epi16(sum, _mm_setzero_si128()), max);
+}
+
+int bayerMalvarRowSSE2(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int blue)
+{
+	const __m128i maskLow = _mm_set1_epi16(0x00ff);
+	const __m128i k3 = _mm_set1_epi16(3);
+	const __m128i k8 = _mm_set1_epi16(8);
+	const __m128i k10 = _mm_set1_epi16(10);
+	const __m128i k12 = _mm_set1_epi16(12);
+	int pixels = 0;
+
+	// 16 pixels per iteration, the column names are relative to the first
+	// red/blue pixel of each pair, the lines 0 to 4 around the center line 2
+	for (; pixels + 16 <= width; pixels += 16, bayer += 16, dst += 48)
+	{
+		const unsigned char* r0 = bayer;
+		const unsigned char* r1 = bayer + bayerStep;
+		const unsigned char* r2 = bayer + bayerStep * 2;
+		const unsigned char* r3 = bayer + bayerStep * 3;
+		const unsigned char* r4 = bayer + bayerStep * 4;
+
+		__m128i v = _mm_loadu_si128((const __m128i*) (r0 + 2));
+		__m128i r0c0 = _mm_and_si128(v, maskLow);
+		__m128i r0c1 = _mm_srli_epi16(v, 8);
+		v = _mm_loadu_si128((const __m128i*) (r4 + 2));
+		__m128i r4c0 = _mm_and_si128(v, maskLow);
+		__m128i r4c1 = _mm_srli_epi16(v, 8);
+
+		v = _mm_loadu_si128((const __m128i*) r1);
+		__m128i r1m1 = _mm_srli_epi16(v, 8);
+		v = _mm_loadu_si128((const __m128i*) (r1 + 2));
+		__m128i r1c0 = _mm_and_si128(v, maskLow);
+		__m128i r1c1 = _mm_srli_epi16(v, 8);
+		__m128i r1c2 = _mm_and_si128(_mm_loadu_si128((const __m128i*) (r1 + 4)), maskLow);
+
+		v = _mm_loadu_si128((const __m128i*) r3);
+		__m128i r3m1 = _mm_srli_epi16(v, 8);
+		v = _mm_loadu_si128((const __m128i*) (r3 + 2));
+		__m128i r3c0 = _mm_and_si128(v, maskLow);
+		__m128i r3c1 = _mm_srli_epi16(v, 8);
+		__m128i r3c2 = _mm_and_si128(_mm_loadu_si128((const __m128i*) (r3 + 4)), maskLow);
+
+		v = _mm_loadu_si128((const __m128i*) r2);
+		__m128i r2m2 = _mm_and_si128(v, maskLow);
+		__m128i r2m1 = _mm_srli_epi16(v, 8);
+		v = _mm_loadu_si128((const __m128i*) (r2 + 2));
+		__m128i r2c0 = _mm_and_si128(v, maskLow);
+		__m128i r2c1 = _mm_srli_epi16(v, 8);
+		v = _mm_loadu_si128((const __m128i*) (r2 + 4));
+		__m128i r2c2 = _mm_and_si128(v, maskLow);
+		__m128i r2c3 = _mm_srli_epi16(v, 8);
+
+		// red/blue pixels in column 0
+		__m128i far = _mm_add_epi16(_mm_add_epi16(r0c0, r4c0), _mm_add_epi16(r2m2, r2c2));
+		__m128i sum = _mm_add_epi16(_mm_add_epi16(r1m1, r1c1), _mm_add_epi16(r3m1, r3c1));
+		__m128i otherAtRedBlue = malvarValue(_mm_add_epi16(_mm_sub_epi16(
+			_mm_mullo_epi16(r2c0, k12), _mm_mullo_epi16(far, k3)), _mm_slli_epi16(sum, 2)));
+		sum = _mm_add_epi16(_mm_add_epi16(r1c0, r3c0), _mm_add_epi16(r2m1, r2c1));
+		__m128i greenAtRedBlue = malvarValue(_mm_add_epi16(_mm_sub_epi16(
+			_mm_slli_epi16(r2c0, 3), _mm_slli_epi16(far, 1)), _mm_slli_epi16(sum, 2)));
+
+		// green pixels in column 1
+		__m128i center = _mm_mullo_epi16(r2c1, k10);
+		__m128i diagonal = _mm_add_epi16(_mm_add_epi16(r1c0, r1c2), _mm_add_epi16(r3c0, r3c2));
+		__m128i vertical = _mm_add_epi16(r0c1, r4c1);
+		__m128i horizontal = _mm_add_epi16(r2m1, r2c3);
+		__m128i common = _mm_sub_epi16(center, _mm_slli_epi16(diagonal, 1));
+		__m128i verticalAtGreen = malvarValue(_mm_add_epi16(_mm_add_epi16(common, horizontal),
+			_mm_sub_epi16(_mm_mullo_epi16(_mm_add_epi16(r1c1, r3c1), k8), _mm_slli_epi16(vertical, 1))));
+		__m128i horizontalAtGreen = malvarValue(_mm_add_epi16(_mm_add_epi16(common, vertical),
+			_mm_sub_epi16(_mm_mullo_epi16(_mm_add_epi16(r2c0, r2c2), k8), _mm_slli_epi16(horizontal, 1))));
+
+		// planes with the red/blue pixel in the low and the green pixel in the high byte
+		__m128i interpolated = _mm_or_si128(otherAtRedBlue, _mm_slli_epi16(verticalAtGreen, 8));
+		__m128i green = _mm_or_si128(greenAtRedBlue, _mm_slli_epi16(r2c1, 8));
+		__m128i measured = _mm_or_si128(r2c0, _mm_slli_epi16(horizontalAtGreen, 8));
+
+		if (blue > 0)
+		{
+			storePixels(dst, interpolated, green, measured);
+		}
+		else
+		{
+			storePixels(dst, measured, green, interpolated);
+		}
+	}
+
+	return pixels;
+}
+
+/**
+ * @brief Malvar-He-Cutler result of 16 times the interpolated values in 32
+ * bit lanes, rounded, scaled and saturated to 0..65535.
+ */
+static inline __m128i malvarValue16(__m128i sum)
+{
+	const __m128i delta8 = _mm_set1_epi32(8);
+	const __m128i max = _mm_set1_epi32(65535);
+	
+	sum = _mm_srai_epi32(_mm_add_epi32(sum, delta8), 4);
+	sum = _mm_and_si128(sum, _mm_cmpgt_epi32(sum, _mm_setzero_si128()));
+	__m128i above = _mm_cmpgt_epi32(sum, max);
+	return _mm_or_si128(_mm_andnot_si128(above, sum), _mm_and_si128(above, max));
+}
+
+int bayerMalvarRow16SSE2(const unsigned short* bayer, int bayerStep,
+	unsigned short* dst, int width, int blue)
+{
+	const __m128i maskLow = _mm_set1_epi32(0x0000ffff);
+	int pixels = 0;
+
+	// 8 pixels per iteration like bayerMalvarRowSSE2, but with 32 bit lanes
+	// for the sums of 16 bit values, the multiplications are shifts and adds
+	for (; pixels + 8 <= width; pixels += 8, bayer += 8, dst += 24)
+	{
+		const unsigned short* r0 = bayer;
+		const unsigned short* r1 = bayer + bayerStep;
+		const unsigned short* r2 = bayer + bayerStep * 2;
+		const unsigned short* r3 = bayer + bayerStep * 3;
+		const unsigned short* r4 = bayer + bayerStep * 4;
+
+		__m128i v = _mm_loadu_si128((const __m128i*) (r0 + 2));
+		__m128i r0c0 = _mm_and_si128(v, maskLow);
+		__m128i r0c1 = _mm_srli_epi32(v, 16);
+		v = _mm_loadu_si128((const __m128i*) (r4 + 2));
+		__m128i r4c0 = _mm_and_si128(v, maskLow);
+		__m128i r4c1 = _mm_srli_epi32(v, 16);
+
+		v = _mm_loadu_si128((const __m128i*) r1);
+		__m128i r1m1 = _mm_srli_epi32(v, 16);
+		v = _mm_loadu_si128((const __m128i*) (r1 + 2));
+		__m128i r1c0 = _mm_and_si128(v, maskLow);
+		__m128i r1c1 = _mm_srli_epi32(v, 16);
+		__m128i r1c2 = _mm_and_si128(_mm_loadu_si128((const __m128i*) (r1 + 4)), maskLow);
+
+		v = _mm_loadu_si128((const __m128i*) r3);
+		__m128i r3m1 = _mm_srli_epi32(v, 16);
+		v = _mm_loadu_si128((const __m128i*) (r3 + 2));
+		__m128i r3c0 = _mm_and_si128(v, maskLow);
+		__m128i r3c1 = _mm_srli_epi32(v, 16);
+		__m128i r3c2 = _mm_and_si128(_mm_loadu_si128((const __m128i*) (r3 + 4)), maskLow);
+
+		v = _mm_loadu_si128((const __m128i*) r2);
+		__m128i r2m2 = _mm_and_si128(v, maskLow);
+		__m128i r2m1 = _mm_srli_epi32(v, 16);
+		v = _mm_loadu_si128((const __m128i*) (r2 + 2));
+		__m128i r2c0 = _mm_and_si128(v, maskLow);
+		__m128i r2c1 = _mm_srli_epi32(v, 16);
+		v = _mm_loadu_si128((const __m128i*) (r2 + 4));
+		__m128i r2c2 = _mm_and_si128(v, maskLow);
+		__m128i r2c3 = _mm_srli_epi32(v, 16);
+
+		// red/blue pixels in column 0, 12 * center - 3 * far + 4 * sum
+		__m128i far = _mm_add_epi32(_mm_add_epi32(r0c0, r4c0), _mm_add_epi32(r2m2, r2c2));
+		__m128i sum = _mm_add_epi32(_mm_add_epi32(r1m1, r1c1), _mm_add_epi32(r3m1, r3c1));
+		__m128i center = _mm_add_epi32(_mm_slli_epi32(r2c0, 3), _mm_slli_epi32(r2c0, 2));
+		__m128i otherAtRedBlue = malvarValue16(_mm_add_epi32(_mm_sub_epi32(center,
+			_mm_add_epi32(_mm_slli_epi32(far, 1), far)), _mm_slli_epi32(sum, 2)));
+		sum = _mm_add_epi32(_mm_add_epi32(r1c0, r3c0), _mm_add_epi32(r2m1, r2c1));
+		__m128i greenAtRedBlue = malvarValue16(_mm_add_epi32(_mm_sub_epi32(
+			_mm_slli_epi32(r2c0, 3), _mm_slli_epi32(far, 1)), _mm_slli_epi32(sum, 2)));
+
+		// green pixels in column 1, the center weighs 10
+		center = _mm_add_epi32(_mm_slli_epi32(r2c1, 3), _mm_slli_epi32(r2c1, 1));
+		__m128i diagonal = _mm_add_epi32(_mm_add_epi32(r1c0, r1c2), _mm_add_epi32(r3c0, r3c2));
+		__m128i vertical = _mm_add_epi32(r0c1, r4c1);
+		__m128i horizontal = _mm_add_epi32(r2m1, r2c3);
+		__m128i common = _mm_sub_epi32(center, _mm_slli_epi32(diagonal, 1));
+		__m128i verticalAtGreen = malvarValue16(_mm_add_epi32(_mm_add_epi32(common, horizontal),
+			_mm_sub_epi32(_mm_slli_epi32(_mm_add_epi32(r1c1, r3c1), 3), _mm_slli_epi32(vertical, 1))));
+		__m128i horizontalAtGreen = malvarValue16(_mm_add_epi32(_mm_add_epi32(common, vertical),
+			_mm_sub_epi32(_mm_slli_epi32(_mm_add_epi32(r2c0, r2c2), 3), _mm_slli_epi32(horizontal, 1))));
+
+		// planes with the red/blue pixel in the low and the green pixel in the high half
+		__m128i interpolated = _mm_or_si128(otherAtRedBlue, _mm_slli_epi32(verticalAtGreen, 16));
+		__m128i green = _mm_or_si128(greenAtRedBlue, _mm_slli_epi32(r2c1, 16));
+		__m128i measured = _mm_or_si128(r2c0, _mm_slli_epi32(horizontalAtGreen, 16));
+
+		if (blue > 0)
+		{
+			storePixels16(dst, interpolated, green, measured);
+		}
+		else
+		{
+			storePixels16(dst, measured, green, interpolated);
+		}
+	}
+
+	return pixels;
+}
+
+} // namespace process
+
+} // namespace tt
+
+#endif // TT_SIMD_X86
@@ -0,0 +1,82 @@
+/*
+ * BayerSSSE3
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#ifdef TT_SIMD_X86 // Build the SSSE3 kernel only on x86 platforms
+
+#include <tmmintrin.h>
+#include "BayerKernels.h"
+#include "PixelsSSSE3.h"
+
+namespace tt
+{
+
+namespace process
+{
+
+int bayerRowSSSE3(const unsigned char* bayer, int bayerStep,
+	unsigned char* dst, int width, int blue)
+{
+	const unsigned char* bayerStart = bayer;
+	const unsigned char* bayerEnd = bayer + width;
+	const __m128i maskLow = _mm_set1_epi16(0x00ff);
+	const __m128i delta2 = _mm_set1_epi16(2);
+
+	// 16 pixels per iteration, reading the source columns 0 to 17
+	for (; bayer <= bayerEnd - 18; bayer += 16, dst += 48)
+	{
+		__m128i r0 = _mm_loadu_si128((const __m128i*) bayer);
+		__m128i r0n = _mm_loadu_si128((const __m128i*) (bayer + 2));
+		__m128i r1 = _mm_loadu_si128((const __m128i*) (bayer + bayerStep));
+		__m128i r1n = _mm_loadu_si128((const __m128i*) (bayer + bayerStep + 2));
+		__m128i r2 = _mm_loadu_si128((const __m128i*) (bayer + bayerStep * 2));
+		__m128i r2n = _mm_loadu_si128((const __m128i*) (bayer + bayerStep * 2 + 2));
+
+		// split into even (red/blue) and odd (green) columns as 16 bit values
+		__m128i r0even = _mm_and_si128(r0, maskLow);
+		__m128i r0odd = _mm_srli_epi16(r0, 8);
+		__m128i r0evenNext = _mm_and_si128(r0n, maskLow);
+		__m128i r1even = _mm_and_si128(r1, maskLow);
+		__m128i r1odd = _mm_srli_epi16(r1, 8);
+		__m128i r1evenNext = _mm_and_si128(r1n, maskLow);
+		__m128i r1oddNext = _mm_srli_epi16(r1n, 8);
+		__m128i r2even = _mm_and_si128(r2, maskLow);
+		__m128i r2odd = _mm_srli_epi16(r2, 8);
+		__m128i r2evenNext = _mm_and_si128(r2n, maskLow);
+
+		// red/blue pixels: diagonal and cross neighbours
+		__m128i diagonal = _mm_add_epi16(_mm_add_epi16(r0even, r0evenNext),
+			_mm_add_epi16(r2even, r2evenNext));
+		diagonal = _mm_srli_epi16(_mm_add_epi16(diagonal, delta2), 2);
+		__m128i cross = _mm_add_epi16(_mm_add_epi16(r0odd, r2odd),
+			_mm_add_epi16(r1even, r1evenNext));
+		cross = _mm_srli_epi16(_mm_add_epi16(cross, delta2), 2);
+
+		// green pixels: vertical and horizontal neighbours, (a + b + 1) >> 1
+		__m128i vertical = _mm_avg_epu16(r0evenNext, r2evenNext);
+		__m128i horizontal = _mm_avg_epu16(r1odd, r1oddNext);
+
+		// planes with the red/blue pixel in the low and the green pixel in the high byte
+		__m128i interpolated = _mm_or_si128(diagonal, _mm_slli_epi16(vertical, 8));
+		__m128i green = _mm_or_si128(cross, _mm_slli_epi16(r1evenNext, 8));
+		__m128i center = _mm_or_si128(r1odd, _mm_slli_epi16(horizontal, 8));
+
+		if (blue > 0)
+		{
+			storePixels(dst, interpolated, green, center);
+		}
+		else
+		{
+			storePixels(dst, center, green, interpolated);
+		}
+	}
+
+	return (int) (bayer - bayerStart);
+}
+
+} // namespace process
+
+} // namespace tt
+
+#endif // TT_SIMD_X86
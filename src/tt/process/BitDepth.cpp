@@ -0,0 +1,259 @@
+/*
+ * BitDepth
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <stdexcept>
+#include <string>
+#include <tt/sys/CPU.h>
+#include "BitDepth.h"
+#include "BitDepthKernels.h"
+
+namespace tt
+{
+
+namespace process
+{
+
+BitDepth::Kernel BitDepth::kernel = BitDepth::KERNEL_AUTO;
+
+void BitDepth::setKernel(Kernel kernel)
+{
+	std::string functionSignature = "void BitDepth::setKernel(Kernel kernel)";
+
+	if (!isKernelSupported(kernel))
+	{
+		throw std::runtime_error(functionSignature + 
+			" kernel not supported by this processor.");
+	}
+	
+	BitDepth::kernel = kernel;
+}
+
+BitDepth::Kernel BitDepth::getKernel()
+{
+	if (BitDepth::kernel != KERNEL_AUTO)
+	{
+		return BitDepth::kernel;
+	}
+
+	if (isKernelSupported(KERNEL_SSE2))
+	{
+		return KERNEL_SSE2;
+	}
+	return KERNEL_SCALAR;
+}
+
+bool BitDepth::isKernelSupported(Kernel kernel)
+{
+	switch (kernel)
+	{
+		case KERNEL_AUTO:
+		case KERNEL_SCALAR:
+			return true;
+
+#ifdef TT_SIMD_X86
+		case KERNEL_SSE2:
+			return tt::sys::CPU::hasSSE2();
+#endif
+			
+		default:
+			return false;
+	}
+}
+
+/**
+ * @brief Shift a 16 bit value and saturate it to 8 bits.
+ */
+static inline unsigned char shiftValue(unsigned int value, int shift)
+{
+	value >>= shift;
+	return (unsigned char) (value > 255 ? 255 : value);
+}
+
+/**
+ * @brief Check the shift and the size, channels and depth of the images.
+ * @param sourceDepth The bits per channel of the source or 0 for a raw frame.
+ */
+static void checkImages(const std::string& functionSignature, const tt::ds::Image* source,
+	tt::ds::Image::BitsPerChannel sourceDepth, tt::ds::Image* destination,
+	tt::ds::Image::BitsPerChannel destinationDepth, int shift)
+{
+	if (source != NULL)
+	{
+		if (source->getBitsPerChannel() != sourceDepth)
+		{
+			throw std::runtime_error(functionSignature + " source has the wrong bits per channel.");
+		}
+		if (source->getWidth() != destination->getWidth() ||
+			source->getHeight() != destination->getHeight() ||
+			source->getChannels() != destination->getChannels())
+		{
+			throw std::runtime_error(functionSignature + 
+				" source and destination differ in size or channels.");
+		}
+	}
+	if (destination->getBitsPerChannel() != destinationDepth)
+	{
+		throw std::runtime_error(functionSignature + " destination has the wrong bits per channel.");
+	}
+	if (shift < 0 || shift > 15)
+	{
+		throw std::runtime_error(functionSignature + " shift out of range.");
+	}
+}
+
+void BitDepth::convert(const tt::ds::Image* source, tt::ds::Image* destination, int shift)
+{
+	std::string functionSignature = "void BitDepth::convert(const tt::ds::Image* source, "
+		"tt::ds::Image* destination, int shift)";
+	
+	checkImages(functionSignature, source, tt::ds::Image::BPC16,
+		destination, tt::ds::Image::BPC8, shift);
+	destination->discard();
+	
+	ShiftRowKernel rowKernel = NULL;
+#ifdef TT_SIMD_X86
+	if (getKernel() == KERNEL_SSE2)
+	{
+		rowKernel = shiftRowSSE2;
+	}
+#endif
+
+	int count = destination->getWidth() * destination->getChannels();
+	for (int y = 0; y < destination->getHeight(); y++)
+	{
+		const unsigned short* src = (const unsigned short*) (source->getImageBuffer() +
+			y*source->getAllocatedWidth());
+		unsigned char* dst = destination->getImageBuffer() + y*destination->getAllocatedWidth();
+		
+		int i = 0;
+		if (rowKernel != NULL)
+		{
+			i = rowKernel(src, dst, count, shift);
+		}
+		for (; i < count; i++)
+		{
+			dst[i] = shiftValue(src[i], shift);
+		}
+	}
+}
+
+void BitDepth::convert(const tt::ds::Image* source, tt::ds::Image* destination,
+	const std::vector<unsigned char>& table)
+{
+	std::string functionSignature = "void BitDepth::convert(const tt::ds::Image* source, "
+		"tt::ds::Image* destination, const std::vector<unsigned char>& table)";
+	
+	checkImages(functionSignature, source, tt::ds::Image::BPC16,
+		destination, tt::ds::Image::BPC8, 0);
+	if (table.size() < (size_t) TABLE_SIZE)
+	{
+		throw std::runtime_error(functionSignature + " table has less than TABLE_SIZE entries.");
+	}
+	destination->discard();
+	
+	const unsigned char* lookup = &table[0];
+	int count = destination->getWidth() * destination->getChannels();
+	for (int y = 0; y < destination->getHeight(); y++)
+	{
+		const unsigned short* src = (const unsigned short*) (source->getImageBuffer() +
+			y*source->getAllocatedWidth());
+		unsigned char* dst = destination->getImageBuffer() + y*destination->getAllocatedWidth();
+		
+		// there is no gather before AVX2, 4 independent lookups per iteration
+		// keep the loads in flight
+		int i = 0;
+		for (; i <= count - 4; i += 4)
+		{
+			unsigned char v0 = lookup[src[i]];
+			unsigned char v1 = lookup[src[i + 1]];
+			unsigned char v2 = lookup[src[i + 2]];
+			unsigned char v3 = lookup[src[i + 3]];
+			dst[i] = v0;
+			dst[i + 1] = v1;
+			dst[i + 2] = v2;
+			dst[i + 3] = v3;
+		}
+		for (; i < count; i++)
+		{
+			dst[i] = lookup[src[i]];
+		}
+	}
+}
+
+void BitDepth::copyBigEndian(const unsigned char* source, tt::ds::Image* destination)
+{
+	std::string functionSignature = "void BitDepth::copyBigEndian(const unsigned char* source, "
+		"tt::ds::Image* destination)";
+	
+	checkImages(functionSignature, NULL, tt::ds::Image::BPC16,
+		destination, tt::ds::Image::BPC16, 0);
+	destination->discard();
+	
+	SwapRowKernel rowKernel = NULL;
+#ifdef TT_SIMD_X86
+	if (getKernel() == KERNEL_SSE2)
+	{
+		rowKernel = swapRowSSE2;
+	}
+#endif
+
+	int count = destination->getWidth() * destination->getChannels();
+	for (int y = 0; y < destination->getHeight(); y++)
+	{
+		const unsigned char* src = source + y*count*2;
+		unsigned short* dst = (unsigned short*) (destination->getImageBuffer() +
+			y*destination->getAllocatedWidth());
+		
+		int i = 0;
+		if (rowKernel != NULL)
+		{
+			i = rowKernel(src, dst, count);
+		}
+		for (; i < count; i++)
+		{
+			dst[i] = (unsigned short) ((src[2*i] << 8) | src[2*i + 1]);
+		}
+	}
+}
+
+void BitDepth::convertBigEndian(const unsigned char* source, tt::ds::Image* destination,
+	int shift)
+{
+	std::string functionSignature = "void BitDepth::convertBigEndian(const unsigned char* source, "
+		"tt::ds::Image* destination, int shift)";
+	
+	checkImages(functionSignature, NULL, tt::ds::Image::BPC16,
+		destination, tt::ds::Image::BPC8, shift);
+	destination->discard();
+	
+	ShiftBigEndianRowKernel rowKernel = NULL;
+#ifdef TT_SIMD_X86
+	if (getKernel() == KERNEL_SSE2)
+	{
+		rowKernel = shiftBigEndianRowSSE2;
+	}
+#endif
+
+	int count = destination->getWidth() * destination->getChannels();
+	for (int y = 0; y < destination->getHeight(); y++)
+	{
+		const unsigned char* src = source + y*count*2;
+		unsigned char* dst = destination->getImageBuffer() + y*destination->getAllocatedWidth();
+		
+		int i = 0;
+		if (rowKernel != NULL)
+		{
+			i = rowKernel(src, dst, count, shift);
+		}
+		for (; i < count; i++)
+		{
+			dst[i] = shiftValue((src[2*i] << 8) | src[2*i + 1], shift);
+		}
+	}
+}
+
+} // namespace process
+
+} // namespace tt
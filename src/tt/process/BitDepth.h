@@ -0,0 +1,137 @@
+#ifndef TT_PROCESS_BITDEPTH_H
+#define TT_PROCESS_BITDEPTH_H
+
+#include <vector>
+#include <tt/ds/Image.h>
+#include <tt/ds/TypedImage.h>
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @class BitDepth BitDepth.h tt/process/BitDepth.h
+ * @brief Conversion between 16 and 8 bits per channel.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ * 
+ * IIDC Firewire cameras deliver MONO16 frames in big endian byte order
+ * without padding between the lines. BitDepth copies such frames into BPC16
+ * images, converts them directly into BPC8 images and reduces BPC16 images
+ * to BPC8 by a shift or a lookup table. The shift conversions are available
+ * as a scalar reference and as SSE2 kernels, which produce exactly the same
+ * output. The kernel is selected at runtime like in Bayer.
+ */
+class BitDepth
+{
+public:
+	/**
+	 * @brief Implementations of the conversion kernels
+	 */
+	enum Kernel
+	{
+		KERNEL_AUTO = 0,
+		KERNEL_SCALAR = 1,
+		KERNEL_SSE2 = 2
+	};
+	
+	/** @brief The number of entries of a lookup table for convert. */
+	static const int TABLE_SIZE = 65536;
+
+public:
+	/**
+	 * @brief Reduce a BPC16 image to a BPC8 image by a shift.
+	 * @param source The BPC16 image.
+	 * @param destination The BPC8 image with the size and channels of the source.
+	 * @param shift The number of bits to drop (0 to 15). Values still
+	 * exceeding 255 saturate to 255, so a shift of 4 maps 12 bit data with
+	 * the least significant bits in bit 0.
+	 * 
+	 * Throws a std::runtime_error, if the images or the shift don't match.
+	 */
+	static void convert(const tt::ds::Image* source, tt::ds::Image* destination,
+		int shift = 8);
+
+	/**
+	 * @brief Reduce a 16 bit image to the 8 bit format of the same layout by a shift.
+	 * @param source An image in Gray16, Rgb16, Bgr16 or Bayer16.
+	 * @param destination The 8 bit image of the size of the source.
+	 * @param shift The number of bits to drop (0 to 15).
+	 * 
+	 * Other pairs of formats don't compile. Throws a std::runtime_error, if
+	 * the sizes or the shift don't match.
+	 */
+	template <typename F>
+	static void convert(const tt::ds::TypedImage<F>& source,
+		tt::ds::TypedImage<typename F::Format8>& destination, int shift = 8)
+	{
+		convert(&source.getImage(), &destination.getImage(), shift);
+	}
+
+	/**
+	 * @brief Reduce a BPC16 image to a BPC8 image by a lookup table.
+	 * @param source The BPC16 image.
+	 * @param destination The BPC8 image with the size and channels of the source.
+	 * @param table The 8 bit value for each 16 bit value, TABLE_SIZE entries.
+	 * 
+	 * For nonlinear mappings like a gamma, which keep the detail of the dark
+	 * parts of low light frames. Throws a std::runtime_error, if the images
+	 * or the table don't match.
+	 */
+	static void convert(const tt::ds::Image* source, tt::ds::Image* destination,
+		const std::vector<unsigned char>& table);
+
+	/**
+	 * @brief Copy a big endian 16 bit frame into a BPC16 image.
+	 * @param source The first byte of the frame, whose lines are not padded.
+	 * @param destination The BPC16 image, whose size and channels are the
+	 * ones of the frame.
+	 */
+	static void copyBigEndian(const unsigned char* source, tt::ds::Image* destination);
+
+	/**
+	 * @brief Convert a big endian 16 bit frame into a BPC8 image.
+	 * @param source The first byte of the frame, whose lines are not padded.
+	 * @param destination The BPC8 image, whose size and channels are the
+	 * ones of the frame.
+	 * @param shift The number of bits to drop, see convert.
+	 * 
+	 * Like copyBigEndian followed by convert, but in one pass without the
+	 * intermediate image.
+	 */
+	static void convertBigEndian(const unsigned char* source, tt::ds::Image* destination,
+		int shift = 8);
+
+	/**
+	 * @brief Select the kernel used by the conversions.
+	 * @param kernel The desired kernel. KERNEL_AUTO selects the fastest kernel
+	 * supported by the processor, which is also the default.
+	 * 
+	 * Throws a std::runtime_error, if the processor doesn't support the kernel.
+	 */
+	static void setKernel(Kernel kernel);
+
+	/**
+	 * @brief Return the kernel used by the conversions.
+	 * 
+	 * KERNEL_AUTO is resolved into the actual kernel.
+	 */
+	static Kernel getKernel();
+
+	/**
+	 * @brief Return true, if the kernel can be used on this processor.
+	 * @param kernel The kernel to check.
+	 */
+	static bool isKernelSupported(Kernel kernel);
+
+private:
+	/** @brief The kernel selected by setKernel */
+	static Kernel kernel;
+};
+
+} // namespace process
+
+} // namespace tt
+
+#endif /*TT_PROCESS_BITDEPTH_H*/
@@ -0,0 +1,37 @@
+#ifndef TT_PROCESS_BITDEPTHKERNELS_H
+#define TT_PROCESS_BITDEPTHKERNELS_H
+
+/*
+ * Internal interface between BitDepth.cpp and the vectorized conversion
+ * kernels, see BayerKernels.h. This header is not installed.
+ * 
+ * Each kernel converts a run of samples within one line and returns the
+ * number of samples written, the remaining ones are left for the scalar code.
+ */
+
+namespace tt
+{
+
+namespace process
+{
+
+/** @brief Shift and saturate host order 16 bit samples to 8 bits. */
+typedef int (*ShiftRowKernel)(const unsigned short* src, unsigned char* dst, int count, int shift);
+
+/** @brief Copy big endian 16 bit samples into host order. */
+typedef int (*SwapRowKernel)(const unsigned char* src, unsigned short* dst, int count);
+
+/** @brief Shift and saturate big endian 16 bit samples to 8 bits. */
+typedef int (*ShiftBigEndianRowKernel)(const unsigned char* src, unsigned char* dst, int count, int shift);
+
+#ifdef TT_SIMD_X86
+int shiftRowSSE2(const unsigned short* src, unsigned char* dst, int count, int shift);
+int swapRowSSE2(const unsigned char* src, unsigned short* dst, int count);
+int shiftBigEndianRowSSE2(const unsigned char* src, unsigned char* dst, int count, int shift);
+#endif // TT_SIMD_X86
+
+} // namespace process
+
+} // namespace tt
+
+#endif /*TT_PROCESS_BITDEPTHKERNELS_H*/
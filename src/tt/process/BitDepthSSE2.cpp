@@ -0,0 +1,92 @@
+/*
+ * BitDepthSSE2
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#ifdef TT_SIMD_X86 // Build the SSE2 kernels only on x86 platforms
+
+#include <emmintrin.h>
+#include "BitDepthKernels.h"
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @brief Swap the bytes of 8 16 bit values.
+ */
+static inline __m128i swapBytes(__m128i values)
+{
+	return _mm_or_si128(_mm_slli_epi16(values, 8), _mm_srli_epi16(values, 8));
+}
+
+/**
+ * @brief Shift 16 unsigned 16 bit values and pack them into bytes, values
+ * above 255 saturate to 255.
+ * 
+ * packus treats its input as signed, so the values are limited to 255 with
+ * an unsigned saturating subtraction first.
+ */
+static inline __m128i shiftPack(__m128i low, __m128i high, __m128i bits)
+{
+	const __m128i max = _mm_set1_epi16(255);
+	low = _mm_srl_epi16(low, bits);
+	high = _mm_srl_epi16(high, bits);
+	low = _mm_sub_epi16(low, _mm_subs_epu16(low, max));
+	high = _mm_sub_epi16(high, _mm_subs_epu16(high, max));
+	return _mm_packus_epi16(low, high);
+}
+
+int shiftRowSSE2(const unsigned short* src, unsigned char* dst, int count, int shift)
+{
+	const __m128i bits = _mm_cvtsi32_si128(shift);
+	int i = 0;
+
+	// 16 samples per iteration
+	for (; i <= count - 16; i += 16)
+	{
+		__m128i low = _mm_loadu_si128((const __m128i*) (src + i));
+		__m128i high = _mm_loadu_si128((const __m128i*) (src + i + 8));
+		_mm_storeu_si128((__m128i*) (dst + i), shiftPack(low, high, bits));
+	}
+
+	return i;
+}
+
+int swapRowSSE2(const unsigned char* src, unsigned short* dst, int count)
+{
+	int i = 0;
+
+	for (; i <= count - 16; i += 16)
+	{
+		__m128i low = _mm_loadu_si128((const __m128i*) (src + 2*i));
+		__m128i high = _mm_loadu_si128((const __m128i*) (src + 2*i + 16));
+		_mm_storeu_si128((__m128i*) (dst + i), swapBytes(low));
+		_mm_storeu_si128((__m128i*) (dst + i + 8), swapBytes(high));
+	}
+
+	return i;
+}
+
+int shiftBigEndianRowSSE2(const unsigned char* src, unsigned char* dst, int count, int shift)
+{
+	const __m128i bits = _mm_cvtsi32_si128(shift);
+	int i = 0;
+
+	for (; i <= count - 16; i += 16)
+	{
+		__m128i low = swapBytes(_mm_loadu_si128((const __m128i*) (src + 2*i)));
+		__m128i high = swapBytes(_mm_loadu_si128((const __m128i*) (src + 2*i + 16)));
+		_mm_storeu_si128((__m128i*) (dst + i), shiftPack(low, high, bits));
+	}
+
+	return i;
+}
+
+} // namespace process
+
+} // namespace tt
+
+#endif // TT_SIMD_X86
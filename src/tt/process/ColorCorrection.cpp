@@ -0,0 +1,142 @@
+/*
+ * ColorCorrection
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include "ColorCorrection.h"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace tt
+{
+
+namespace process
+{
+
+ColorCorrection::ColorCorrection() :
+	gamma(1.0),
+	identity(true)
+{
+	gains[0] = gains[1] = gains[2] = 1 << GAIN_BITS;
+	updateTables();
+}
+
+void ColorCorrection::setGains(double red, double green, double blue)
+{
+	string functionSignature = "void ColorCorrection::setGains(double red, double green, double blue)";
+	
+	double values[3] = {red, green, blue};
+	for (int c = 0; c < 3; c++)
+	{
+		if (!(values[c] >= 0.0 && values[c] <= MAX_GAIN))
+		{
+			throw std::runtime_error(functionSignature + " gain out of range.");
+		}
+	}
+
+	for (int c = 0; c < 3; c++)
+	{
+		gains[c] = (int) (values[c] * (1 << GAIN_BITS) + 0.5);
+	}
+	updateTables();
+}
+
+void ColorCorrection::getGains(double& red, double& green, double& blue) const
+{
+	red = (double) gains[0] / (1 << GAIN_BITS);
+	green = (double) gains[1] / (1 << GAIN_BITS);
+	blue = (double) gains[2] / (1 << GAIN_BITS);
+}
+
+void ColorCorrection::setGamma(double gamma)
+{
+	string functionSignature = "void ColorCorrection::setGamma(double gamma)";
+
+	if (!(gamma > 0.0))
+	{
+		throw std::runtime_error(functionSignature + " gamma must be positive.");
+	}
+	
+	this->gamma = gamma;
+	updateTables();
+}
+
+double ColorCorrection::getGamma() const
+{
+	return this->gamma;
+}
+
+bool ColorCorrection::isIdentity() const
+{
+	return this->identity;
+}
+
+void ColorCorrection::updateTables()
+{
+	unsigned char gammaTable[256];
+	for (int v = 0; v < 256; v++)
+	{
+		gammaTable[v] = (unsigned char) (255.0 * pow(v / 255.0, 1.0 / gamma) + 0.5);
+	}
+
+	// the gain is applied in fixed point before the gamma curve, both end up
+	// in a single lookup
+	identity = true;
+	for (int c = 0; c < 3; c++)
+	{
+		for (int v = 0; v < 256; v++)
+		{
+			int scaled = (v * gains[c] + (1 << (GAIN_BITS - 1))) >> GAIN_BITS;
+			tables[c][v] = gammaTable[scaled > 255 ? 255 : scaled];
+			identity = identity && tables[c][v] == v;
+		}
+	}
+}
+
+void ColorCorrection::applyLine(unsigned char* line, int width, Bayer::Order order) const
+{
+	const unsigned char* table0 = tables[order == Bayer::ORDER_BGR ? 2 : 0];
+	const unsigned char* table1 = tables[1];
+	const unsigned char* table2 = tables[order == Bayer::ORDER_BGR ? 0 : 2];
+	
+	for (int x = 0; x < width; x++, line += 3)
+	{
+		line[0] = table0[line[0]];
+		line[1] = table1[line[1]];
+		line[2] = table2[line[2]];
+	}
+}
+
+void ColorCorrection::apply(tt::ds::Image* image, Bayer::Order order) const
+{
+	string functionSignature = "void ColorCorrection::apply(tt::ds::Image* image, Bayer::Order order)";
+	
+	if (image->getChannels() != tt::ds::Image::RGB)
+	{
+		throw std::runtime_error(functionSignature + " image must be RGB.");
+	}
+	if (image->getBitsPerChannel() != tt::ds::Image::BPC8)
+	{
+		throw std::runtime_error(functionSignature + " color correction needs 8 bits per channel.");
+	}
+	
+	if (identity)
+	{
+		return;
+	}
+	
+	// the image is corrected in place, the non-const buffer accessor detaches
+	// it, so a share keeps the uncorrected pixels
+	unsigned char* line = image->getImageBuffer();
+	for (int y = 0; y < image->getHeight(); y++, line += image->getAllocatedWidth())
+	{
+		applyLine(line, image->getWidth(), order);
+	}
+}
+
+} // namespace process
+
+} // namespace tt
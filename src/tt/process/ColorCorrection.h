@@ -0,0 +1,114 @@
+#ifndef TT_PROCESS_COLORCORRECTION_H
+#define TT_PROCESS_COLORCORRECTION_H
+
+#include <tt/ds/Image.h>
+#include <tt/process/Bayer.h>
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @class ColorCorrection ColorCorrection.h tt/process/ColorCorrection.h
+ * @brief White balance gains and gamma correction of 8 bit color images.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ * 
+ * The gains are kept in fixed point with GAIN_BITS fractional bits and are
+ * folded together with the gamma curve into one table of 256 entries per
+ * channel, so correcting a pixel costs three table lookups. Bayer::deBayer
+ * applies a ColorCorrection to each line right after interpolating it,
+ * while the line is still in the cache, which saves separate passes over
+ * the whole frame.
+ */
+class ColorCorrection
+{
+public:
+	/** @brief Fractional bits of the fixed point gains */
+	static const int GAIN_BITS = 10;
+
+	/** @brief Largest gain accepted by setGains */
+	static const int MAX_GAIN = 16;
+	
+	/**
+	 * @brief Create an identity correction, all gains and the gamma are 1.
+	 */
+	ColorCorrection();
+
+	/**
+	 * @brief Set the gains of the color channels.
+	 * @param red Gain of the red channel.
+	 * @param green Gain of the green channel.
+	 * @param blue Gain of the blue channel.
+	 * 
+	 * The gains are rounded to multiples of 1 / 2^GAIN_BITS. Throws a
+	 * std::runtime_error, if a gain is negative or greater than MAX_GAIN.
+	 */
+	void setGains(double red, double green, double blue);
+
+	/**
+	 * @brief Return the gains of the color channels, as rounded by setGains.
+	 */
+	void getGains(double& red, double& green, double& blue) const;
+
+	/**
+	 * @brief Set the gamma of the correction.
+	 * @param gamma The gamma, each channel value v becomes
+	 * 255 * (v / 255)^(1 / gamma) after applying the gain. 1 leaves the values
+	 * untouched, 2.2 encodes linear camera values for common displays.
+	 * 
+	 * Throws a std::runtime_error, if gamma isn't positive.
+	 */
+	void setGamma(double gamma);
+
+	/**
+	 * @brief Return the gamma of the correction.
+	 */
+	double getGamma() const;
+
+	/**
+	 * @brief Return true, if the correction doesn't change any value.
+	 */
+	bool isIdentity() const;
+
+	/**
+	 * @brief Correct an image in place.
+	 * @param image An RGB image with 8 bits per channel.
+	 * @param order The channel order of the image.
+	 * 
+	 * Throws a std::runtime_error for other images, like the correction
+	 * within Bayer::deBayer.
+	 */
+	void apply(tt::ds::Image* image, Bayer::Order order = Bayer::ORDER_BGR) const;
+
+	/**
+	 * @brief Correct one line of pixels in place.
+	 * @param line The first channel of the first pixel.
+	 * @param width The number of pixels with 3 channels each.
+	 * @param order The channel order of the pixels.
+	 */
+	void applyLine(unsigned char* line, int width, Bayer::Order order) const;
+
+private:
+	/** @brief Recompute the tables after changing the gains or the gamma */
+	void updateTables();
+
+	/** @brief The fixed point gains of red, green and blue */
+	int gains[3];
+
+	/** @brief The gamma */
+	double gamma;
+
+	/** @brief True, if all tables map each value onto itself */
+	bool identity;
+	
+	/** @brief Gain and gamma tables of red, green and blue */
+	unsigned char tables[3][256];
+};
+
+} // namespace process
+
+} // namespace tt
+
+#endif /*TT_PROCESS_COLORCORRECTION_H*/
@@ -0,0 +1,337 @@
+/*
+ * Integral
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <tt/ds/IntegralCache.h>
+#include <tt/sys/CPU.h>
+#include "Integral.h"
+#include "IntegralKernels.h"
+
+namespace tt
+{
+
+namespace process
+{
+
+Integral::Kernel Integral::kernel = Integral::KERNEL_AUTO;
+tt::sys::WorkerPool* Integral::workerPool = NULL;
+
+void Integral::setKernel(Kernel kernel)
+{
+	std::string functionSignature = "void Integral::setKernel(Kernel kernel)";
+
+	if (!isKernelSupported(kernel))
+	{
+		throw std::runtime_error(functionSignature + 
+			" kernel not supported by this processor.");
+	}
+	
+	Integral::kernel = kernel;
+}
+
+Integral::Kernel Integral::getKernel()
+{
+	if (Integral::kernel != KERNEL_AUTO)
+	{
+		return Integral::kernel;
+	}
+
+	if (isKernelSupported(KERNEL_SSE2))
+	{
+		return KERNEL_SSE2;
+	}
+	return KERNEL_SCALAR;
+}
+
+bool Integral::isKernelSupported(Kernel kernel)
+{
+	switch (kernel)
+	{
+		case KERNEL_AUTO:
+		case KERNEL_SCALAR:
+			return true;
+
+#ifdef TT_SIMD_X86
+		case KERNEL_SSE2:
+			return tt::sys::CPU::hasSSE2();
+#endif
+			
+		default:
+			return false;
+	}
+}
+
+void Integral::setWorkerPool(tt::sys::WorkerPool* pool)
+{
+	Integral::workerPool = pool;
+}
+
+tt::sys::WorkerPool* Integral::getWorkerPool()
+{
+	return Integral::workerPool;
+}
+
+/**
+ * @brief The row kernels of one implementation, NULL for the scalar code.
+ */
+struct IntegralKernels
+{
+	SumRowKernel sums;
+	SquareRowKernel squares;
+};
+
+static IntegralKernels getIntegralKernels(Integral::Kernel kernel)
+{
+	IntegralKernels kernels = { NULL, NULL };
+#ifdef TT_SIMD_X86
+	if (kernel == Integral::KERNEL_SSE2)
+	{
+		kernels.sums = integralSumRowSSE2;
+		kernels.squares = integralSquareRowSSE2;
+	}
+#endif
+	return kernels;
+}
+
+static void checkImages(const std::string& functionSignature, const tt::ds::Image* source,
+	const tt::ds::IntegralImage* destination)
+{
+	if (source->getChannels() != tt::ds::Image::GREYSCALE ||
+		source->getBitsPerChannel() != tt::ds::Image::BPC8)
+	{
+		throw std::runtime_error(functionSignature + " source must be a GREYSCALE BPC8 image.");
+	}
+	if (destination->getWidth() != source->getWidth() ||
+		destination->getHeight() != source->getHeight())
+	{
+		throw std::runtime_error(functionSignature + 
+			" destination must have the size of the source.");
+	}
+}
+
+/**
+ * @brief Compute the table lines of the image lines firstRow to lastRow - 1.
+ * 
+ * The first line is added to zeros instead of the line above, so bands
+ * don't depend on each other. The sums of the bands above are added later
+ * by addOffsets. The table line y + 1 belongs to the image line y.
+ */
+static void computeBand(const tt::ds::Image* source, tt::ds::IntegralImage* destination,
+	const IntegralKernels& kernels, int firstRow, int lastRow)
+{
+	int width = source->getWidth();
+	bool squares = destination->hasSquares();
+	std::vector<unsigned int> zeroSums(width + 1, 0);
+	std::vector<unsigned long long> zeroSquares(squares ? width + 1 : 0, 0);
+
+	for (int y = firstRow; y < lastRow; y++)
+	{
+		const unsigned char* src = source->getImageBuffer() + y * source->getAllocatedWidth();
+
+		// skip the column of zeros
+		const unsigned int* above = (y == firstRow ? &zeroSums[0] : destination->getSums(y)) + 1;
+		unsigned int* sums = destination->getSums(y + 1) + 1;
+		int x = 0;
+		if (kernels.sums != NULL)
+		{
+			x = kernels.sums(src, above, sums, width);
+		}
+		// the sum of the line so far, wrapped like the table
+		unsigned int line = sums[x - 1] - above[x - 1];
+		for (; x < width; x++)
+		{
+			line += src[x];
+			sums[x] = above[x] + line;
+		}
+
+		if (squares)
+		{
+			const unsigned long long* squaresAbove = 
+				(y == firstRow ? &zeroSquares[0] : destination->getSquares(y)) + 1;
+			unsigned long long* squareSums = destination->getSquares(y + 1) + 1;
+			x = 0;
+			if (kernels.squares != NULL)
+			{
+				x = kernels.squares(src, squaresAbove, squareSums, width);
+			}
+			unsigned long long squareLine = squareSums[x - 1] - squaresAbove[x - 1];
+			for (; x < width; x++)
+			{
+				squareLine += src[x] * src[x];
+				squareSums[x] = squaresAbove[x] + squareLine;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Task computing the bands of a table in parallel
+ */
+class ComputeBands : public tt::sys::WorkerPool::Task
+{
+public:
+	ComputeBands(const tt::ds::Image* source, tt::ds::IntegralImage* destination, 
+		const IntegralKernels& kernels, int bands) :
+		source(source),
+		destination(destination),
+		kernels(kernels),
+		bands(bands)
+	{
+	}
+
+	virtual void run(int index)
+	{
+		computeBand(source, destination, kernels, getFirstRow(index), getFirstRow(index + 1));
+	}
+
+	int getFirstRow(int index) const
+	{
+		return (int) ((long long) destination->getHeight() * index / bands);
+	}
+
+private:
+	const tt::ds::Image* source;
+	tt::ds::IntegralImage* destination;
+	IntegralKernels kernels;
+	int bands;
+};
+
+/**
+ * @brief Task adding the last lines of the bands above to each band
+ */
+class AddOffsets : public tt::sys::WorkerPool::Task
+{
+public:
+	AddOffsets(const ComputeBands& bands, tt::ds::IntegralImage* destination,
+		const std::vector<unsigned int>& sums, 
+		const std::vector<unsigned long long>& squares) :
+		bands(bands),
+		destination(destination),
+		sums(sums),
+		squares(squares)
+	{
+	}
+
+	virtual void run(int index)
+	{
+		// the first band has no offset
+		index++;
+		int width = destination->getWidth() + 1;
+		const unsigned int* sumOffset = &sums[(index - 1) * width];
+		int lastRow = bands.getFirstRow(index + 1);
+		for (int y = bands.getFirstRow(index); y < lastRow; y++)
+		{
+			unsigned int* line = destination->getSums(y + 1);
+			for (int x = 0; x < width; x++)
+			{
+				line[x] += sumOffset[x];
+			}
+		}
+
+		if (destination->hasSquares())
+		{
+			const unsigned long long* squareOffset = &squares[(index - 1) * width];
+			for (int y = bands.getFirstRow(index); y < lastRow; y++)
+			{
+				unsigned long long* line = destination->getSquares(y + 1);
+				for (int x = 0; x < width; x++)
+				{
+					line[x] += squareOffset[x];
+				}
+			}
+		}
+	}
+
+private:
+	const ComputeBands& bands;
+	tt::ds::IntegralImage* destination;
+	const std::vector<unsigned int>& sums;
+	const std::vector<unsigned long long>& squares;
+};
+
+void Integral::compute(const tt::ds::Image* source, tt::ds::IntegralImage* destination)
+{
+	std::string functionSignature = "void Integral::compute(const tt::ds::Image* source, "
+		"tt::ds::IntegralImage* destination)";
+
+	checkImages(functionSignature, source, destination);
+	computeBand(source, destination, getIntegralKernels(getKernel()), 0, source->getHeight());
+}
+
+void Integral::compute(const tt::ds::Image* source, tt::ds::IntegralImage* destination,
+	tt::sys::WorkerPool& pool)
+{
+	std::string functionSignature = "void Integral::compute(const tt::ds::Image* source, "
+		"tt::ds::IntegralImage* destination, tt::sys::WorkerPool& pool)";
+
+	checkImages(functionSignature, source, destination);
+
+	// don't split the image into bands smaller than MIN_BAND_HEIGHT lines
+	int bands = source->getHeight() / MIN_BAND_HEIGHT;
+	if (bands > pool.getThreads())
+	{
+		bands = pool.getThreads();
+	}
+	if (bands <= 1)
+	{
+		compute(source, destination);
+		return;
+	}
+
+	ComputeBands computeBands(source, destination, getIntegralKernels(getKernel()), bands);
+	pool.run(computeBands, bands);
+
+	// the offset of a band is the sum of the last lines of the bands above
+	int width = destination->getWidth() + 1;
+	std::vector<unsigned int> sums((bands - 1) * width, 0);
+	std::vector<unsigned long long> squares(destination->hasSquares() ? (bands - 1) * width : 0, 0);
+	for (int band = 1; band < bands; band++)
+	{
+		int lastLine = computeBands.getFirstRow(band);
+		const unsigned int* line = destination->getSums(lastLine);
+		unsigned int* offset = &sums[(band - 1) * width];
+		for (int x = 0; x < width; x++)
+		{
+			offset[x] = line[x] + (band > 1 ? offset[x - width] : 0);
+		}
+
+		if (destination->hasSquares())
+		{
+			const unsigned long long* squareLine = destination->getSquares(lastLine);
+			unsigned long long* squareOffset = &squares[(band - 1) * width];
+			for (int x = 0; x < width; x++)
+			{
+				squareOffset[x] = squareLine[x] + (band > 1 ? squareOffset[x - width] : 0);
+			}
+		}
+	}
+
+	AddOffsets addOffsets(computeBands, destination, sums, squares);
+	pool.run(addOffsets, bands - 1);
+}
+
+std::shared_ptr<const tt::ds::IntegralImage> Integral::get(tt::ds::Image& image, bool squares)
+{
+	return image.getIntegralCache().get(image, squares, computeCached);
+}
+
+void Integral::computeCached(const tt::ds::Image* source, tt::ds::IntegralImage* destination)
+{
+	tt::sys::WorkerPool* pool = Integral::workerPool;
+	if (pool != NULL)
+	{
+		compute(source, destination, *pool);
+	}
+	else
+	{
+		compute(source, destination);
+	}
+}
+
+} // namespace process
+
+} // namespace tt
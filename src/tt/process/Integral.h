@@ -0,0 +1,127 @@
+#ifndef TT_PROCESS_INTEGRAL_H
+#define TT_PROCESS_INTEGRAL_H
+
+#include <memory>
+#include <tt/ds/Image.h>
+#include <tt/ds/IntegralImage.h>
+#include <tt/sys/WorkerPool.h>
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @class Integral Integral.h tt/process/Integral.h
+ * @brief Computation of integral images for box filters and Haar features.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ * 
+ * compute fills a tt::ds::IntegralImage line by line, each line is the
+ * prefix sum of the image line plus the line above. The prefix sums are
+ * available as a scalar reference and as SSE2 kernels, which produce exactly
+ * the same table. A WorkerPool computes bands of lines independently and
+ * adds the totals of the bands above in a second pass.
+ * 
+ * get returns the table of a frame from its tt::ds::IntegralCache, so
+ * several consumers of the same frame compute it only once.
+ */
+class Integral
+{
+public:
+	/**
+	 * @brief Implementations of the prefix sum kernel
+	 */
+	enum Kernel
+	{
+		KERNEL_AUTO = 0,
+		KERNEL_SCALAR = 1,
+		KERNEL_SSE2 = 2
+	};
+
+	/**
+	 * @brief Compute the integral image of an image.
+	 * @param source The GREYSCALE BPC8 image.
+	 * @param destination The table of the size of the image. Sums of
+	 * squares are computed, if it has them.
+	 * 
+	 * Throws a std::runtime_error, if the image or the table don't match.
+	 */
+	static void compute(const tt::ds::Image* source, tt::ds::IntegralImage* destination);
+
+	/**
+	 * @brief Compute the integral image in parallel bands.
+	 * @param source The GREYSCALE BPC8 image.
+	 * @param destination The table of the size of the image.
+	 * @param pool The threads computing the bands.
+	 * 
+	 * Gives exactly the same table as the serial compute. Images of less than
+	 * 2 * MIN_BAND_HEIGHT lines aren't split.
+	 */
+	static void compute(const tt::ds::Image* source, tt::ds::IntegralImage* destination,
+		tt::sys::WorkerPool& pool);
+
+	/**
+	 * @brief Return the integral image of an image.
+	 * @param image The GREYSCALE BPC8 image.
+	 * @param squares True, if the sums of squares are needed.
+	 * 
+	 * The table is computed on the first request and cached with the buffer
+	 * of the image, see tt::ds::IntegralCache. The returned table stays
+	 * valid, when the image changes. Thread safe for readers, which share
+	 * the buffer of the image.
+	 */
+	static std::shared_ptr<const tt::ds::IntegralImage> get(tt::ds::Image& image,
+		bool squares = false);
+
+	/**
+	 * @brief Set the pool computing the tables of get.
+	 * @param pool The pool or NULL for the calling thread (default).
+	 */
+	static void setWorkerPool(tt::sys::WorkerPool* pool);
+
+	/**
+	 * @brief Return the pool computing the tables of get or NULL.
+	 */
+	static tt::sys::WorkerPool* getWorkerPool();
+
+	/**
+	 * @brief Select the kernel used by compute.
+	 * @param kernel The desired kernel. KERNEL_AUTO selects the fastest kernel
+	 * supported by the processor, which is also the default.
+	 * 
+	 * Throws a std::runtime_error, if the processor doesn't support the kernel.
+	 */
+	static void setKernel(Kernel kernel);
+
+	/**
+	 * @brief Return the kernel used by compute.
+	 * 
+	 * KERNEL_AUTO is resolved into the actual kernel.
+	 */
+	static Kernel getKernel();
+
+	/**
+	 * @brief Return true, if the kernel can be used on this processor.
+	 * @param kernel The kernel to check.
+	 */
+	static bool isKernelSupported(Kernel kernel);
+
+	/** @brief The minimum number of lines per band */
+	static const int MIN_BAND_HEIGHT = 32;
+
+private:
+	/** @brief Compute a table of get on the worker pool */
+	static void computeCached(const tt::ds::Image* source, tt::ds::IntegralImage* destination);
+
+	/** @brief The kernel selected by setKernel */
+	static Kernel kernel;
+	/** @brief The pool of get or NULL */
+	static tt::sys::WorkerPool* workerPool;
+};
+
+} // namespace process
+
+} // namespace tt
+
+#endif /*TT_PROCESS_INTEGRAL_H*/
@@ -0,0 +1,43 @@
+#ifndef TT_PROCESS_INTEGRALKERNELS_H
+#define TT_PROCESS_INTEGRALKERNELS_H
+
+/*
+ * Internal interface between Integral.cpp and the vectorized prefix sum
+ * kernels, see BayerKernels.h. This header is not installed.
+ * 
+ * Each kernel computes the first pixels of one line of the table and
+ * returns their number, the remaining ones are left for the scalar code.
+ * The table pointers point to the entry of the first pixel, behind the
+ * column of zeros.
+ */
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @brief Add the prefix sums of a line to the sums of the line above.
+ */
+typedef int (*SumRowKernel)(const unsigned char* src, const unsigned int* above,
+	unsigned int* sums, int width);
+
+/**
+ * @brief Add the prefix sums of the squares of a line to the line above.
+ */
+typedef int (*SquareRowKernel)(const unsigned char* src, const unsigned long long* above,
+	unsigned long long* squares, int width);
+
+#ifdef TT_SIMD_X86
+int integralSumRowSSE2(const unsigned char* src, const unsigned int* above,
+	unsigned int* sums, int width);
+int integralSquareRowSSE2(const unsigned char* src, const unsigned long long* above,
+	unsigned long long* squares, int width);
+#endif // TT_SIMD_X86
+
+} // namespace process
+
+} // namespace tt
+
+#endif /*TT_PROCESS_INTEGRALKERNELS_H*/
@@ -0,0 +1,100 @@
+/*
+ * IntegralSSE2
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#ifdef TT_SIMD_X86 // Build the SSE2 kernels only on x86 platforms
+
+#include <emmintrin.h>
+#include "IntegralKernels.h"
+
+namespace tt
+{
+
+namespace process
+{
+
+int integralSumRowSSE2(const unsigned char* src, const unsigned int* above,
+	unsigned int* sums, int width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	// the running sum of the line in all lanes
+	__m128i carry = zero;
+	int x = 0;
+
+	// 16 pixels per iteration
+	for (; x <= width - 16; x += 16)
+	{
+		__m128i pixels = _mm_loadu_si128((const __m128i*) (src + x));
+		__m128i low = _mm_unpacklo_epi8(pixels, zero);
+		__m128i high = _mm_unpackhi_epi8(pixels, zero);
+
+		// prefix sums of 8 pixels fit into 16 bits
+		low = _mm_add_epi16(low, _mm_slli_si128(low, 2));
+		high = _mm_add_epi16(high, _mm_slli_si128(high, 2));
+		low = _mm_add_epi16(low, _mm_slli_si128(low, 4));
+		high = _mm_add_epi16(high, _mm_slli_si128(high, 4));
+		low = _mm_add_epi16(low, _mm_slli_si128(low, 8));
+		high = _mm_add_epi16(high, _mm_slli_si128(high, 8));
+
+		__m128i s0 = _mm_add_epi32(_mm_unpacklo_epi16(low, zero), carry);
+		__m128i s1 = _mm_add_epi32(_mm_unpackhi_epi16(low, zero), carry);
+		carry = _mm_shuffle_epi32(s1, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128i s2 = _mm_add_epi32(_mm_unpacklo_epi16(high, zero), carry);
+		__m128i s3 = _mm_add_epi32(_mm_unpackhi_epi16(high, zero), carry);
+		carry = _mm_shuffle_epi32(s3, _MM_SHUFFLE(3, 3, 3, 3));
+
+		_mm_storeu_si128((__m128i*) (sums + x), 
+			_mm_add_epi32(s0, _mm_loadu_si128((const __m128i*) (above + x))));
+		_mm_storeu_si128((__m128i*) (sums + x + 4), 
+			_mm_add_epi32(s1, _mm_loadu_si128((const __m128i*) (above + x + 4))));
+		_mm_storeu_si128((__m128i*) (sums + x + 8), 
+			_mm_add_epi32(s2, _mm_loadu_si128((const __m128i*) (above + x + 8))));
+		_mm_storeu_si128((__m128i*) (sums + x + 12), 
+			_mm_add_epi32(s3, _mm_loadu_si128((const __m128i*) (above + x + 12))));
+	}
+
+	return x;
+}
+
+int integralSquareRowSSE2(const unsigned char* src, const unsigned long long* above,
+	unsigned long long* squares, int width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	// the running sum of the line in both lanes
+	__m128i carry = zero;
+	int x = 0;
+
+	// 8 pixels per iteration
+	for (; x <= width - 8; x += 8)
+	{
+		__m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*) (src + x)), zero);
+		for (int half = 0; half < 2; half++)
+		{
+			// squares of 4 pixels and their prefix sums in 32 bits
+			__m128i p = half == 0 ? _mm_unpacklo_epi16(pixels, zero) : _mm_unpackhi_epi16(pixels, zero);
+			__m128i s = _mm_madd_epi16(p, p);
+			s = _mm_add_epi32(s, _mm_slli_si128(s, 4));
+			s = _mm_add_epi32(s, _mm_slli_si128(s, 8));
+
+			// continue in 64 bits
+			__m128i s0 = _mm_add_epi64(_mm_unpacklo_epi32(s, zero), carry);
+			__m128i s1 = _mm_add_epi64(_mm_unpackhi_epi32(s, zero), carry);
+			carry = _mm_unpackhi_epi64(s1, s1);
+
+			int i = x + 4 * half;
+			_mm_storeu_si128((__m128i*) (squares + i),
+				_mm_add_epi64(s0, _mm_loadu_si128((const __m128i*) (above + i))));
+			_mm_storeu_si128((__m128i*) (squares + i + 2),
+				_mm_add_epi64(s1, _mm_loadu_si128((const __m128i*) (above + i + 2))));
+		}
+	}
+
+	return x;
+}
+
+} // namespace process
+
+} // namespace tt
+
+#endif // TT_SIMD_X86
@@ -0,0 +1,45 @@
+#ifndef TT_PROCESS_PIXELSSSSE3_H
+#define TT_PROCESS_PIXELSSSSE3_H
+
+/*
+ * Internal helpers shared by the kernels compiled for SSSE3 or better. Only
+ * include this header in translation units compiled with SSSE3 enabled. This
+ * header is not installed.
+ */
+
+#include <tmmintrin.h>
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @brief Interleave 3 planes of 16 bytes each into 16 pixels with 3 channels.
+ */
+static inline void storePixels(unsigned char* dst, __m128i c0, __m128i c1, __m128i c2)
+{
+	const __m128i m00 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+	const __m128i m01 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+	const __m128i m02 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+	const __m128i m10 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+	const __m128i m11 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+	const __m128i m12 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+	const __m128i m20 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+	const __m128i m21 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+	const __m128i m22 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+	_mm_storeu_si128((__m128i*) dst, _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0, m00), _mm_shuffle_epi8(c1, m01)), _mm_shuffle_epi8(c2, m02)));
+	_mm_storeu_si128((__m128i*) (dst + 16), _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0, m10), _mm_shuffle_epi8(c1, m11)), _mm_shuffle_epi8(c2, m12)));
+	_mm_storeu_si128((__m128i*) (dst + 32), _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0, m20), _mm_shuffle_epi8(c1, m21)), _mm_shuffle_epi8(c2, m22)));
+}
+
+} // namespace process
+
+} // namespace tt
+
+#endif /*TT_PROCESS_PIXELSSSSE3_H*/
@@ -0,0 +1,279 @@
+/*
+ * Pyramid
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <tt/ds/PyramidCache.h>
+#include <tt/sys/CPU.h>
+#include "Pyramid.h"
+#include "PyramidKernels.h"
+
+namespace tt
+{
+
+namespace process
+{
+
+Pyramid::Kernel Pyramid::kernel = Pyramid::KERNEL_AUTO;
+tt::sys::WorkerPool* Pyramid::workerPool = NULL;
+
+void Pyramid::setKernel(Kernel kernel)
+{
+	std::string functionSignature = "void Pyramid::setKernel(Kernel kernel)";
+
+	if (!isKernelSupported(kernel))
+	{
+		throw std::runtime_error(functionSignature + 
+			" kernel not supported by this processor.");
+	}
+	
+	Pyramid::kernel = kernel;
+}
+
+Pyramid::Kernel Pyramid::getKernel()
+{
+	if (Pyramid::kernel != KERNEL_AUTO)
+	{
+		return Pyramid::kernel;
+	}
+
+	if (isKernelSupported(KERNEL_SSE2))
+	{
+		return KERNEL_SSE2;
+	}
+	return KERNEL_SCALAR;
+}
+
+bool Pyramid::isKernelSupported(Kernel kernel)
+{
+	switch (kernel)
+	{
+		case KERNEL_AUTO:
+		case KERNEL_SCALAR:
+			return true;
+
+#ifdef TT_SIMD_X86
+		case KERNEL_SSE2:
+			return tt::sys::CPU::hasSSE2();
+#endif
+			
+		default:
+			return false;
+	}
+}
+
+void Pyramid::setWorkerPool(tt::sys::WorkerPool* pool)
+{
+	Pyramid::workerPool = pool;
+}
+
+tt::sys::WorkerPool* Pyramid::getWorkerPool()
+{
+	return Pyramid::workerPool;
+}
+
+/**
+ * @brief The row kernels of one implementation, NULL for the scalar code.
+ */
+struct PyramidKernels
+{
+	VerticalRowKernel vertical;
+	HorizontalRowKernel horizontal;
+};
+
+static PyramidKernels getPyramidKernels(Pyramid::Kernel kernel)
+{
+	PyramidKernels kernels = { NULL, NULL };
+#ifdef TT_SIMD_X86
+	if (kernel == Pyramid::KERNEL_SSE2)
+	{
+		kernels.vertical = pyramidVerticalSSE2;
+		kernels.horizontal = pyramidHorizontalSSE2;
+	}
+#endif
+	return kernels;
+}
+
+static void checkImages(const std::string& functionSignature, const tt::ds::Image* source,
+	const tt::ds::Image* destination)
+{
+	if (source->getBitsPerChannel() != tt::ds::Image::BPC8 ||
+		destination->getBitsPerChannel() != tt::ds::Image::BPC8)
+	{
+		throw std::runtime_error(functionSignature + " images must have 8 bits per channel.");
+	}
+	if (source->getChannels() != destination->getChannels() ||
+		destination->getWidth() != (source->getWidth() + 1) / 2 ||
+		destination->getHeight() != (source->getHeight() + 1) / 2)
+	{
+		throw std::runtime_error(functionSignature + 
+			" destination must have the channels and half the size of the source.");
+	}
+}
+
+/**
+ * @brief Reduce the destination lines firstRow to lastRow - 1.
+ * 
+ * Each destination line is computed from the vertical sums of 5 source
+ * lines, which are kept as 16 bit values with 2 repeated pixels at both
+ * ends. The weights add up to 256, so the result is rounded and shifted
+ * by 8 bits. The largest sum 255 * 256 fits into 16 bits.
+ */
+static void reduceBand(const tt::ds::Image* source, tt::ds::Image* destination,
+	const PyramidKernels& kernels, int firstRow, int lastRow)
+{
+	int width = source->getWidth();
+	int height = source->getHeight();
+	int channels = source->getChannels();
+	int count = width * channels;
+	int destinationWidth = destination->getWidth();
+	
+	std::vector<unsigned short> buffer((width + 4) * channels);
+	unsigned short* sums = &buffer[2 * channels];
+
+	for (int y = firstRow; y < lastRow; y++)
+	{
+		// the lines around the source line 2y, the edge lines are repeated
+		const unsigned char* rows[5];
+		for (int i = 0; i < 5; i++)
+		{
+			int row = 2 * y - 2 + i;
+			row = row < 0 ? 0 : (row >= height ? height - 1 : row);
+			rows[i] = source->getImageBuffer() + row * source->getAllocatedWidth();
+		}
+
+		int i = 0;
+		if (kernels.vertical != NULL)
+		{
+			i = kernels.vertical(rows, sums, count);
+		}
+		for (; i < count; i++)
+		{
+			sums[i] = rows[0][i] + rows[4][i] + 4 * (rows[1][i] + rows[3][i]) + 6 * rows[2][i];
+		}
+
+		// repeat the edge pixels
+		for (int c = 0; c < channels; c++)
+		{
+			sums[c - 2 * channels] = sums[c - channels] = sums[c];
+			sums[count + c] = sums[count + channels + c] = sums[count - channels + c];
+		}
+
+		unsigned char* dst = destination->getImageBuffer() + y * destination->getAllocatedWidth();
+		int x = 0;
+		if (kernels.horizontal != NULL)
+		{
+			x = kernels.horizontal(sums, dst, width, channels);
+		}
+		for (; x < destinationWidth; x++)
+		{
+			const unsigned short* s = sums + 2 * x * channels;
+			for (int c = 0; c < channels; c++)
+			{
+				unsigned int sum = s[c - 2 * channels] + s[c + 2 * channels] +
+					4 * (s[c - channels] + s[c + channels]) + 6 * s[c];
+				dst[x * channels + c] = (unsigned char) ((sum + 128) >> 8);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Task reducing the bands of an image in parallel
+ */
+class ReduceBands : public tt::sys::WorkerPool::Task
+{
+public:
+	ReduceBands(const tt::ds::Image* source, tt::ds::Image* destination, 
+		const PyramidKernels& kernels, int bands) :
+		source(source),
+		destination(destination),
+		kernels(kernels),
+		bands(bands)
+	{
+	}
+
+	virtual void run(int index)
+	{
+		int height = destination->getHeight();
+		int firstRow = (int) ((long long) height * index / bands);
+		int lastRow = (int) ((long long) height * (index + 1) / bands);
+		reduceBand(source, destination, kernels, firstRow, lastRow);
+	}
+
+private:
+	const tt::ds::Image* source;
+	tt::ds::Image* destination;
+	PyramidKernels kernels;
+	int bands;
+};
+
+void Pyramid::reduce(const tt::ds::Image* source, tt::ds::Image* destination)
+{
+	std::string functionSignature = "void Pyramid::reduce(const tt::ds::Image* source, "
+		"tt::ds::Image* destination)";
+
+	checkImages(functionSignature, source, destination);
+	destination->discard();
+	reduceBand(source, destination, getPyramidKernels(getKernel()), 0, destination->getHeight());
+}
+
+void Pyramid::reduce(const tt::ds::Image* source, tt::ds::Image* destination,
+	tt::sys::WorkerPool& pool)
+{
+	std::string functionSignature = "void Pyramid::reduce(const tt::ds::Image* source, "
+		"tt::ds::Image* destination, tt::sys::WorkerPool& pool)";
+
+	checkImages(functionSignature, source, destination);
+	destination->discard();
+
+	// don't split the image into bands smaller than MIN_BAND_HEIGHT lines
+	int bands = destination->getHeight() / MIN_BAND_HEIGHT;
+	if (bands > pool.getThreads())
+	{
+		bands = pool.getThreads();
+	}
+	if (bands < 1)
+	{
+		bands = 1;
+	}
+
+	ReduceBands task(source, destination, getPyramidKernels(getKernel()), bands);
+	pool.run(task, bands);
+}
+
+tt::ds::Image Pyramid::getLevel(tt::ds::Image& image, int level)
+{
+	std::string functionSignature = "tt::ds::Image Pyramid::getLevel(tt::ds::Image& image, "
+		"int level)";
+
+	if (level < 0)
+	{
+		throw std::runtime_error(functionSignature + " level out of range.");
+	}
+	if (level == 0)
+	{
+		return image.share();
+	}
+	return image.getPyramidCache().getLevel(image, level, reduceLevel);
+}
+
+void Pyramid::reduceLevel(const tt::ds::Image* source, tt::ds::Image* destination)
+{
+	tt::sys::WorkerPool* pool = Pyramid::workerPool;
+	if (pool != NULL)
+	{
+		reduce(source, destination, *pool);
+	}
+	else
+	{
+		reduce(source, destination);
+	}
+}
+
+} // namespace process
+
+} // namespace tt
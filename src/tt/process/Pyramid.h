@@ -0,0 +1,126 @@
+#ifndef TT_PROCESS_PYRAMID_H
+#define TT_PROCESS_PYRAMID_H
+
+#include <tt/ds/Image.h>
+#include <tt/sys/WorkerPool.h>
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @class Pyramid Pyramid.h tt/process/Pyramid.h
+ * @brief Gaussian image pyramids for coarse to fine processing.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ * 
+ * reduce halves an image with the separable 5x5 binomial filter of Burt and
+ * Adelson, the weights 1 4 6 4 1 in each direction, and repeats the edge
+ * pixels at the borders. It is available as a scalar reference and as an
+ * SSE2 kernel, which produce exactly the same output, and can split the
+ * image into bands for a WorkerPool.
+ * 
+ * getLevel returns the levels of a frame from its tt::ds::PyramidCache, so
+ * several trackers reading the same frame compute each level only once.
+ * The levels are computed on the worker pool set with setWorkerPool.
+ */
+class Pyramid
+{
+public:
+	/**
+	 * @brief Implementations of the filter kernel
+	 */
+	enum Kernel
+	{
+		KERNEL_AUTO = 0,
+		KERNEL_SCALAR = 1,
+		KERNEL_SSE2 = 2
+	};
+
+	/**
+	 * @brief Halve an image with the 5x5 Gaussian.
+	 * @param source The BPC8 source image.
+	 * @param destination An image with the channels and bits per channel of
+	 * the source and half its width and height, rounded up.
+	 * 
+	 * Throws a std::runtime_error, if the images don't match.
+	 */
+	static void reduce(const tt::ds::Image* source, tt::ds::Image* destination);
+
+	/**
+	 * @brief Halve an image in parallel bands.
+	 * @param source The BPC8 source image.
+	 * @param destination The image of half the size, see reduce.
+	 * @param pool The threads converting the bands.
+	 * 
+	 * Gives exactly the same result as the serial reduce. Images of less than
+	 * 2 * MIN_BAND_HEIGHT destination lines aren't split.
+	 */
+	static void reduce(const tt::ds::Image* source, tt::ds::Image* destination,
+		tt::sys::WorkerPool& pool);
+
+	/**
+	 * @brief Return a level of the pyramid of an image.
+	 * @param image The image, level 0.
+	 * @param level The level, each level has half the size of the previous one.
+	 * 
+	 * Level 0 shares the buffer of the image. Higher levels are computed on
+	 * the first request and cached with the buffer of the image, see
+	 * tt::ds::PyramidCache. The returned levels share the cached buffers and
+	 * stay valid, when the image changes. Thread safe for readers, which share
+	 * the buffer of the image. Throws a std::runtime_error for negative levels.
+	 */
+	static tt::ds::Image getLevel(tt::ds::Image& image, int level);
+
+	/**
+	 * @brief Set the pool computing the levels of getLevel.
+	 * @param pool The pool or NULL for the calling thread (default).
+	 */
+	static void setWorkerPool(tt::sys::WorkerPool* pool);
+
+	/**
+	 * @brief Return the pool computing the levels of getLevel or NULL.
+	 */
+	static tt::sys::WorkerPool* getWorkerPool();
+
+	/**
+	 * @brief Select the kernel used by reduce.
+	 * @param kernel The desired kernel. KERNEL_AUTO selects the fastest kernel
+	 * supported by the processor, which is also the default.
+	 * 
+	 * Throws a std::runtime_error, if the processor doesn't support the kernel.
+	 */
+	static void setKernel(Kernel kernel);
+
+	/**
+	 * @brief Return the kernel used by reduce.
+	 * 
+	 * KERNEL_AUTO is resolved into the actual kernel.
+	 */
+	static Kernel getKernel();
+
+	/**
+	 * @brief Return true, if the kernel can be used on this processor.
+	 * @param kernel The kernel to check.
+	 */
+	static bool isKernelSupported(Kernel kernel);
+
+	/** @brief The minimum number of destination lines per band */
+	static const int MIN_BAND_HEIGHT = 16;
+
+private:
+	/** @brief Compute a level of getLevel on the worker pool */
+	static void reduceLevel(const tt::ds::Image* source, tt::ds::Image* destination);
+
+	/** @brief The kernel selected by setKernel */
+	static Kernel kernel;
+	/** @brief The pool of getLevel or NULL */
+	static tt::sys::WorkerPool* workerPool;
+};
+
+} // namespace process
+
+} // namespace tt
+
+#endif /*TT_PROCESS_PYRAMID_H*/
@@ -0,0 +1,47 @@
+#ifndef TT_PROCESS_PYRAMIDKERNELS_H
+#define TT_PROCESS_PYRAMIDKERNELS_H
+
+/*
+ * Internal interface between Pyramid.cpp and the vectorized filter kernels,
+ * see BayerKernels.h. This header is not installed.
+ * 
+ * Each kernel processes a run of one line and returns the number of samples
+ * or pixels written, the remaining ones are left for the scalar code.
+ */
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @brief Sum 5 lines with the weights 1 4 6 4 1.
+ * @param rows The 5 source lines.
+ * @param sums The sums of the count samples of the lines.
+ */
+typedef int (*VerticalRowKernel)(const unsigned char* const* rows, unsigned short* sums,
+	int count);
+
+/**
+ * @brief Filter a line of vertical sums with the weights 1 4 6 4 1 and keep
+ * every second pixel.
+ * @param sums The vertical sums, repeated for 2 pixels beyond both ends.
+ * @param dst The destination line.
+ * @param width The number of source pixels.
+ * @param channels The number of channels per pixel.
+ * @return The number of destination pixels written.
+ */
+typedef int (*HorizontalRowKernel)(const unsigned short* sums, unsigned char* dst,
+	int width, int channels);
+
+#ifdef TT_SIMD_X86
+int pyramidVerticalSSE2(const unsigned char* const* rows, unsigned short* sums, int count);
+int pyramidHorizontalSSE2(const unsigned short* sums, unsigned char* dst, int width, int channels);
+#endif // TT_SIMD_X86
+
+} // namespace process
+
+} // namespace tt
+
+#endif /*TT_PROCESS_PYRAMIDKERNELS_H*/
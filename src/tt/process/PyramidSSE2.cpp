@@ -0,0 +1,135 @@
+/*
+ * PyramidSSE2
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#ifdef TT_SIMD_X86 // Build the SSE2 kernels only on x86 platforms
+
+#include <emmintrin.h>
+#include "PyramidKernels.h"
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @brief Weight 5 vectors of 16 bit values with 1 4 6 4 1.
+ * 
+ * The sums of 8 bit values and of their vertical sums stay below 65536, so
+ * the 16 bit additions don't overflow.
+ */
+static inline __m128i weigh(__m128i a, __m128i b, __m128i c, __m128i d, __m128i e)
+{
+	__m128i outer = _mm_add_epi16(a, e);
+	__m128i inner = _mm_slli_epi16(_mm_add_epi16(b, d), 2);
+	__m128i center = _mm_add_epi16(_mm_slli_epi16(c, 2), _mm_slli_epi16(c, 1));
+	return _mm_add_epi16(_mm_add_epi16(outer, inner), center);
+}
+
+int pyramidVerticalSSE2(const unsigned char* const* rows, unsigned short* sums, int count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int i = 0;
+
+	// 16 samples per iteration
+	for (; i <= count - 16; i += 16)
+	{
+		__m128i r[5];
+		for (int k = 0; k < 5; k++)
+		{
+			r[k] = _mm_loadu_si128((const __m128i*) (rows[k] + i));
+		}
+		__m128i low = weigh(_mm_unpacklo_epi8(r[0], zero), _mm_unpacklo_epi8(r[1], zero),
+			_mm_unpacklo_epi8(r[2], zero), _mm_unpacklo_epi8(r[3], zero),
+			_mm_unpacklo_epi8(r[4], zero));
+		__m128i high = weigh(_mm_unpackhi_epi8(r[0], zero), _mm_unpackhi_epi8(r[1], zero),
+			_mm_unpackhi_epi8(r[2], zero), _mm_unpackhi_epi8(r[3], zero),
+			_mm_unpackhi_epi8(r[4], zero));
+		_mm_storeu_si128((__m128i*) (sums + i), low);
+		_mm_storeu_si128((__m128i*) (sums + i + 8), high);
+	}
+
+	return i;
+}
+
+/**
+ * @brief Filter 8 samples of vertical sums horizontally, rounded to 8 bits
+ * in 16 bit lanes.
+ */
+static inline __m128i filterSums(const unsigned short* s, int channels)
+{
+	const __m128i round = _mm_set1_epi16(128);
+	__m128i sum = weigh(_mm_loadu_si128((const __m128i*) (s - 2 * channels)),
+		_mm_loadu_si128((const __m128i*) (s - channels)),
+		_mm_loadu_si128((const __m128i*) s),
+		_mm_loadu_si128((const __m128i*) (s + channels)),
+		_mm_loadu_si128((const __m128i*) (s + 2 * channels)));
+	return _mm_srli_epi16(_mm_add_epi16(sum, round), 8);
+}
+
+int pyramidHorizontalSSE2(const unsigned short* sums, unsigned char* dst, int width, int channels)
+{
+	int x = 0;
+
+	if (channels == 1)
+	{
+		// keep the even 16 bit lanes, the values fit into the signed pack
+		const __m128i even = _mm_set1_epi32(0xffff);
+		for (; 2 * x + 16 <= width; x += 8)
+		{
+			const unsigned short* s = sums + 2 * x;
+			__m128i low = _mm_and_si128(filterSums(s, 1), even);
+			__m128i high = _mm_and_si128(filterSums(s + 8, 1), even);
+			__m128i pixels = _mm_packs_epi32(low, high);
+			_mm_storel_epi64((__m128i*) (dst + x), _mm_packus_epi16(pixels, pixels));
+		}
+		return x;
+	}
+
+	if (channels == 4)
+	{
+		// each 64 bit half holds a pixel, keep the first one of each vector
+		for (; 2 * x + 16 <= width; x += 8)
+		{
+			const unsigned short* s = sums + 8 * x;
+			__m128i p[4];
+			for (int i = 0; i < 4; i++)
+			{
+				p[i] = _mm_unpacklo_epi64(filterSums(s + 16 * i, 4), filterSums(s + 16 * i + 8, 4));
+			}
+			_mm_storeu_si128((__m128i*) (dst + 4 * x), _mm_packus_epi16(p[0], p[1]));
+			_mm_storeu_si128((__m128i*) (dst + 4 * x + 16), _mm_packus_epi16(p[2], p[3]));
+		}
+		return x;
+	}
+
+	// filter 16 source pixels at full resolution, keep the 8 even ones
+	for (; 2 * x + 16 <= width; x += 8)
+	{
+		unsigned char filtered[64];
+		const unsigned short* s = sums + 2 * x * channels;
+		for (int i = 0; i < 16 * channels; i += 16)
+		{
+			__m128i low = filterSums(s + i, channels);
+			__m128i high = filterSums(s + i + 8, channels);
+			_mm_storeu_si128((__m128i*) (filtered + i), _mm_packus_epi16(low, high));
+		}
+		for (int p = 0; p < 8; p++)
+		{
+			for (int c = 0; c < channels; c++)
+			{
+				dst[(x + p) * channels + c] = filtered[2 * p * channels + c];
+			}
+		}
+	}
+
+	return x;
+}
+
+} // namespace process
+
+} // namespace tt
+
+#endif // TT_SIMD_X86
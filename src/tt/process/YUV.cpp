@@ -0,0 +1,253 @@
+/*
+ * YUV
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <string.h>
+#include <stdexcept>
+#include <string>
+#include <tt/sys/CPU.h>
+#include "YUV.h"
+#include "YUVKernels.h"
+
+namespace tt
+{
+
+namespace process
+{
+
+YUV::Kernel YUV::kernel = YUV::KERNEL_AUTO;
+
+void YUV::setKernel(Kernel kernel)
+{
+	std::string functionSignature = "void YUV::setKernel(Kernel kernel)";
+
+	if (!isKernelSupported(kernel))
+	{
+		throw std::runtime_error(functionSignature + 
+			" kernel not supported by this processor.");
+	}
+	
+	YUV::kernel = kernel;
+}
+
+YUV::Kernel YUV::getKernel()
+{
+	if (YUV::kernel != KERNEL_AUTO)
+	{
+		return YUV::kernel;
+	}
+
+	if (isKernelSupported(KERNEL_SSSE3))
+	{
+		return KERNEL_SSSE3;
+	}
+	return KERNEL_SCALAR;
+}
+
+bool YUV::isKernelSupported(Kernel kernel)
+{
+	switch (kernel)
+	{
+		case KERNEL_AUTO:
+		case KERNEL_SCALAR:
+			return true;
+
+#ifdef TT_SIMD_X86
+		case KERNEL_SSSE3:
+			return tt::sys::CPU::hasSSSE3();
+#endif
+			
+		default:
+			return false;
+	}
+}
+
+int YUV::getLineBytes(Format format, int width)
+{
+	switch (format)
+	{
+		case FORMAT_YUV444:
+			return width*3;
+
+		case FORMAT_YUV422:
+			return width*2;
+
+		case FORMAT_YUV411:
+		default:
+			return width*3/2;
+	}
+}
+
+/**
+ * @brief Convert one pixel.
+ * @param R Output channel of red (0 or 2).
+ * @param y The luma.
+ * @param u The U sample, offset by 128.
+ * @param v The V sample, offset by 128.
+ * @param dst First channel of the output pixel.
+ */
+template <int R>
+static inline void convertPixel(int y, int u, int v, unsigned char* dst)
+{
+	u -= 128;
+	v -= 128;
+	int r = y + ((v*YUV_RED_V) >> 10);
+	int g = y - ((u*YUV_GREEN_U + v*YUV_GREEN_V) >> 10);
+	int b = y + ((u*YUV_BLUE_U) >> 10);
+	
+	dst[R] = (unsigned char) (r < 0 ? 0 : (r > 255 ? 255 : r));
+	dst[1] = (unsigned char) (g < 0 ? 0 : (g > 255 ? 255 : g));
+	dst[2-R] = (unsigned char) (b < 0 ? 0 : (b > 255 ? 255 : b));
+}
+
+/**
+ * @brief Convert the pixels x to width - 1 of one line.
+ * @param yuv The first byte of the line.
+ */
+template <YUV::Format F, int R>
+static void convertRow(const unsigned char* yuv, unsigned char* dst, int x, int width)
+{
+	for (; x < width; )
+	{
+		switch (F)
+		{
+			case YUV::FORMAT_YUV444:
+				convertPixel<R>(yuv[x*3 + 1], yuv[x*3], yuv[x*3 + 2], dst + x*3);
+				x++;
+				break;
+
+			case YUV::FORMAT_YUV422:
+			{
+				const unsigned char* group = yuv + x*2;
+				convertPixel<R>(group[1], group[0], group[2], dst + x*3);
+				convertPixel<R>(group[3], group[0], group[2], dst + x*3 + 3);
+				x += 2;
+				break;
+			}
+
+			case YUV::FORMAT_YUV411:
+			{
+				const unsigned char* group = yuv + x*3/2;
+				convertPixel<R>(group[1], group[0], group[3], dst + x*3);
+				convertPixel<R>(group[2], group[0], group[3], dst + x*3 + 3);
+				convertPixel<R>(group[4], group[0], group[3], dst + x*3 + 6);
+				convertPixel<R>(group[5], group[0], group[3], dst + x*3 + 9);
+				x += 4;
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Convert a frame with the format and the channel order fixed at
+ * compile time.
+ */
+template <YUV::Format F, int R>
+static void convertFrame(const unsigned char* source, tt::ds::Image* destination,
+	YUVRowKernel rowKernel)
+{
+	int width = destination->getWidth();
+	int lineBytes = YUV::getLineBytes(F, width);
+	
+	for (int y = 0; y < destination->getHeight(); y++)
+	{
+		const unsigned char* yuv = source + y*lineBytes;
+		unsigned char* dst = destination->getImageBuffer() + y*destination->getAllocatedWidth();
+		
+		int x = 0;
+		if (rowKernel != NULL)
+		{
+			x = rowKernel(yuv, dst, width, R == 0 ? 1 : 0);
+		}
+		convertRow<F, R>(yuv, dst, x, width);
+	}
+}
+
+void YUV::convert(const unsigned char* source, Format format,
+	tt::ds::Image* destination, Bayer::Order order)
+{
+	std::string functionSignature = "void YUV::convert(const unsigned char* source, "
+		"Format format, tt::ds::Image* destination, Bayer::Order order)";
+	
+	if (destination->getChannels() != tt::ds::Image::RGB)
+	{
+		throw std::runtime_error(functionSignature + " destination must be RGB.");
+	}
+	if (destination->getBitsPerChannel() != tt::ds::Image::BPC8)
+	{
+		throw std::runtime_error(functionSignature + " destination must have 8 bits per channel.");
+	}
+	
+	int width = destination->getWidth();
+	if ((format == FORMAT_YUV422 && width % 2 != 0) ||
+		(format == FORMAT_YUV411 && width % 4 != 0))
+	{
+		throw std::runtime_error(functionSignature + 
+			" width is not a multiple of the pixels sharing a chroma sample.");
+	}
+	destination->discard();
+	
+	YUVRowKernel rowKernel = NULL;
+#ifdef TT_SIMD_X86
+	if (getKernel() == KERNEL_SSSE3)
+	{
+		switch (format)
+		{
+			case FORMAT_YUV444:
+				rowKernel = yuv444RowSSSE3;
+				break;
+
+			case FORMAT_YUV422:
+				rowKernel = yuv422RowSSSE3;
+				break;
+
+			case FORMAT_YUV411:
+				rowKernel = yuv411RowSSSE3;
+				break;
+		}
+	}
+#endif
+
+	bool rgb = order == Bayer::ORDER_RGB;
+	switch (format)
+	{
+		case FORMAT_YUV444:
+			if (rgb)
+			{
+				convertFrame<FORMAT_YUV444, 0>(source, destination, rowKernel);
+			}
+			else
+			{
+				convertFrame<FORMAT_YUV444, 2>(source, destination, rowKernel);
+			}
+			break;
+
+		case FORMAT_YUV422:
+			if (rgb)
+			{
+				convertFrame<FORMAT_YUV422, 0>(source, destination, rowKernel);
+			}
+			else
+			{
+				convertFrame<FORMAT_YUV422, 2>(source, destination, rowKernel);
+			}
+			break;
+
+		case FORMAT_YUV411:
+			if (rgb)
+			{
+				convertFrame<FORMAT_YUV411, 0>(source, destination, rowKernel);
+			}
+			else
+			{
+				convertFrame<FORMAT_YUV411, 2>(source, destination, rowKernel);
+			}
+			break;
+	}
+}
+
+} // namespace process
+
+} // namespace tt
@@ -0,0 +1,103 @@
+#ifndef TT_PROCESS_YUV_H
+#define TT_PROCESS_YUV_H
+
+#include <tt/ds/Image.h>
+#include <tt/process/Bayer.h>
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @class YUV YUV.h tt/process/YUV.h
+ * @brief Conversion of the YUV formats of IIDC Firewire cameras into color images.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ * 
+ * The IIDC formats store the pixels without padding between the lines:
+ * YUV444 as U Y V per pixel, YUV422 as U Y V Y per 2 pixels and YUV411 as
+ * U Y Y V Y Y per 4 pixels, with U and V offset by 128. The conversion uses
+ * the ITU-R BT.601 factors in fixed point with 10 fractional bits, like
+ * libdc1394. It is available as a scalar reference and as SSSE3 kernels,
+ * which produce exactly the same output. The kernel is selected at runtime
+ * like in Bayer.
+ */
+class YUV
+{
+public:
+	/**
+	 * @brief Pixel formats of the source
+	 */
+	enum Format
+	{
+		FORMAT_YUV444 = 0,
+		FORMAT_YUV422 = 1,
+		FORMAT_YUV411 = 2
+	};
+	
+	/**
+	 * @brief Implementations of the conversion kernel
+	 */
+	enum Kernel
+	{
+		KERNEL_AUTO = 0,
+		KERNEL_SCALAR = 1,
+		KERNEL_SSSE3 = 3
+	};
+
+public:
+	/**
+	 * @brief Convert a YUV frame into a color image.
+	 * @param source The first byte of the frame in the given format.
+	 * @param format The format of the source.
+	 * @param destination The color image (must be RGB and BPC8), whose size
+	 * is the size of the source frame.
+	 * @param order The channel order of the destination.
+	 * 
+	 * The width must be a multiple of the pixels sharing one chroma sample,
+	 * 2 for YUV422 and 4 for YUV411, otherwise a std::runtime_error is thrown.
+	 * Destinations of another format throw as well.
+	 */
+	static void convert(const unsigned char* source, Format format,
+		tt::ds::Image* destination, Bayer::Order order = Bayer::ORDER_BGR);
+
+	/**
+	 * @brief Return the number of bytes of one source line.
+	 * @param format The format of the source.
+	 * @param width The number of pixels per line.
+	 */
+	static int getLineBytes(Format format, int width);
+
+	/**
+	 * @brief Select the kernel used by convert.
+	 * @param kernel The desired kernel. KERNEL_AUTO selects the fastest kernel
+	 * supported by the processor, which is also the default.
+	 * 
+	 * Throws a std::runtime_error, if the processor doesn't support the kernel.
+	 */
+	static void setKernel(Kernel kernel);
+
+	/**
+	 * @brief Return the kernel used by convert.
+	 * 
+	 * KERNEL_AUTO is resolved into the actual kernel.
+	 */
+	static Kernel getKernel();
+
+	/**
+	 * @brief Return true, if the kernel can be used on this processor.
+	 * @param kernel The kernel to check.
+	 */
+	static bool isKernelSupported(Kernel kernel);
+
+private:
+	/** @brief The kernel selected by setKernel */
+	static Kernel kernel;
+};
+
+} // namespace process
+
+} // namespace tt
+
+#endif /*TT_PROCESS_YUV_H*/
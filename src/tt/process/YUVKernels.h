@@ -0,0 +1,45 @@
+#ifndef TT_PROCESS_YUVKERNELS_H
+#define TT_PROCESS_YUVKERNELS_H
+
+/*
+ * Internal interface between YUV.cpp and the vectorized conversion kernels,
+ * see BayerKernels.h. This header is not installed.
+ */
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @brief Conversion of a run of YUV pixels within one line.
+ * @param yuv The first byte of the first pixel group.
+ * @param dst First channel of the first output pixel.
+ * @param width Number of pixels left in the line.
+ * @param rgb 1 for RGB output, 0 for BGR output.
+ * @return The number of pixels written, which is a multiple of the pixels
+ * sharing one chroma sample. The remaining pixels are left for the scalar code.
+ */
+typedef int (*YUVRowKernel)(const unsigned char* yuv, unsigned char* dst, int width, int rgb);
+
+/*
+ * Fixed point factors of U and V with 10 fractional bits, the ITU-R BT.601
+ * factors as used by libdc1394.
+ */
+static const int YUV_RED_V = 1436;
+static const int YUV_GREEN_U = 352;
+static const int YUV_GREEN_V = 731;
+static const int YUV_BLUE_U = 1814;
+
+#ifdef TT_SIMD_X86
+int yuv444RowSSSE3(const unsigned char* yuv, unsigned char* dst, int width, int rgb);
+int yuv422RowSSSE3(const unsigned char* yuv, unsigned char* dst, int width, int rgb);
+int yuv411RowSSSE3(const unsigned char* yuv, unsigned char* dst, int width, int rgb);
+#endif // TT_SIMD_X86
+
+} // namespace process
+
+} // namespace tt
+
+#endif /*TT_PROCESS_YUVKERNELS_H*/
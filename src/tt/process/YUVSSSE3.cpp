@@ -0,0 +1,157 @@
+/*
+ * YUVSSSE3
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#ifdef TT_SIMD_X86 // Build the SSSE3 kernels only on x86 platforms
+
+#include <tmmintrin.h>
+#include "YUVKernels.h"
+#include "PixelsSSSE3.h"
+
+namespace tt
+{
+
+namespace process
+{
+
+/**
+ * @brief Convert 8 pixels with 16 bit Y, U - 128 and V - 128 values into
+ * 16 bit red, green and blue values.
+ * 
+ * Gives exactly the results of the scalar conversion in YUV.cpp.
+ */
+static inline void convertPixels(__m128i y, __m128i u, __m128i v,
+	__m128i& r, __m128i& g, __m128i& b)
+{
+	const __m128i redV = _mm_set1_epi16(YUV_RED_V);
+	const __m128i blueU = _mm_set1_epi16(YUV_BLUE_U);
+	const __m128i greenUV = _mm_set_epi16(YUV_GREEN_V, YUV_GREEN_U, YUV_GREEN_V, YUV_GREEN_U,
+		YUV_GREEN_V, YUV_GREEN_U, YUV_GREEN_V, YUV_GREEN_U);
+
+	// (v * f) >> 10 as ((v << 7) * f) >> 16 followed by >> 1, both round down
+	__m128i redOffset = _mm_srai_epi16(_mm_mulhi_epi16(_mm_slli_epi16(v, 7), redV), 1);
+	__m128i blueOffset = _mm_srai_epi16(_mm_mulhi_epi16(_mm_slli_epi16(u, 7), blueU), 1);
+
+	// the green offset sums both products before shifting, in 32 bit lanes
+	__m128i greenLow = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(u, v), greenUV), 10);
+	__m128i greenHigh = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(u, v), greenUV), 10);
+	__m128i greenOffset = _mm_packs_epi32(greenLow, greenHigh);
+
+	r = _mm_add_epi16(y, redOffset);
+	g = _mm_sub_epi16(y, greenOffset);
+	b = _mm_add_epi16(y, blueOffset);
+}
+
+/**
+ * @brief Convert 16 pixels given as two halves of 16 bit Y, U and V values
+ * and store them with 3 channels.
+ */
+static inline void storeConverted(unsigned char* dst, int rgb,
+	__m128i y0, __m128i u0, __m128i v0, __m128i y1, __m128i u1, __m128i v1)
+{
+	const __m128i offset = _mm_set1_epi16(128);
+	__m128i r0, g0, b0, r1, g1, b1;
+
+	convertPixels(y0, _mm_sub_epi16(u0, offset), _mm_sub_epi16(v0, offset), r0, g0, b0);
+	convertPixels(y1, _mm_sub_epi16(u1, offset), _mm_sub_epi16(v1, offset), r1, g1, b1);
+
+	// saturate to 0..255
+	__m128i r = _mm_packus_epi16(r0, r1);
+	__m128i g = _mm_packus_epi16(g0, g1);
+	__m128i b = _mm_packus_epi16(b0, b1);
+	if (rgb)
+	{
+		storePixels(dst, r, g, b);
+	}
+	else
+	{
+		storePixels(dst, b, g, r);
+	}
+}
+
+int yuv444RowSSSE3(const unsigned char* yuv, unsigned char* dst, int width, int rgb)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i u0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i u1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+	const __m128i u2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+	const __m128i y0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i y1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+	const __m128i y2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+	const __m128i v0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const __m128i v1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+	const __m128i v2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+	int pixels = 0;
+
+	// 16 pixels U Y V per iteration
+	for (; pixels + 16 <= width; pixels += 16, yuv += 48, dst += 48)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*) yuv);
+		__m128i b = _mm_loadu_si128((const __m128i*) (yuv + 16));
+		__m128i c = _mm_loadu_si128((const __m128i*) (yuv + 32));
+
+		__m128i y = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, y0),
+			_mm_shuffle_epi8(b, y1)), _mm_shuffle_epi8(c, y2));
+		__m128i u = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, u0),
+			_mm_shuffle_epi8(b, u1)), _mm_shuffle_epi8(c, u2));
+		__m128i v = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, v0),
+			_mm_shuffle_epi8(b, v1)), _mm_shuffle_epi8(c, v2));
+
+		storeConverted(dst, rgb,
+			_mm_unpacklo_epi8(y, zero), _mm_unpacklo_epi8(u, zero), _mm_unpacklo_epi8(v, zero),
+			_mm_unpackhi_epi8(y, zero), _mm_unpackhi_epi8(u, zero), _mm_unpackhi_epi8(v, zero));
+	}
+
+	return pixels;
+}
+
+int yuv422RowSSSE3(const unsigned char* yuv, unsigned char* dst, int width, int rgb)
+{
+	// 8 pixels U Y V Y as 16 bit values from 16 bytes
+	const __m128i y = _mm_setr_epi8(1, -1, 3, -1, 5, -1, 7, -1, 9, -1, 11, -1, 13, -1, 15, -1);
+	const __m128i u = _mm_setr_epi8(0, -1, 0, -1, 4, -1, 4, -1, 8, -1, 8, -1, 12, -1, 12, -1);
+	const __m128i v = _mm_setr_epi8(2, -1, 2, -1, 6, -1, 6, -1, 10, -1, 10, -1, 14, -1, 14, -1);
+	int pixels = 0;
+
+	for (; pixels + 16 <= width; pixels += 16, yuv += 32, dst += 48)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*) yuv);
+		__m128i b = _mm_loadu_si128((const __m128i*) (yuv + 16));
+
+		storeConverted(dst, rgb,
+			_mm_shuffle_epi8(a, y), _mm_shuffle_epi8(a, u), _mm_shuffle_epi8(a, v),
+			_mm_shuffle_epi8(b, y), _mm_shuffle_epi8(b, u), _mm_shuffle_epi8(b, v));
+	}
+
+	return pixels;
+}
+
+int yuv411RowSSSE3(const unsigned char* yuv, unsigned char* dst, int width, int rgb)
+{
+	// 8 pixels U Y Y V Y Y as 16 bit values from the first 12 of 16 bytes
+	const __m128i y = _mm_setr_epi8(1, -1, 2, -1, 4, -1, 5, -1, 7, -1, 8, -1, 10, -1, 11, -1);
+	const __m128i u = _mm_setr_epi8(0, -1, 0, -1, 0, -1, 0, -1, 6, -1, 6, -1, 6, -1, 6, -1);
+	const __m128i v = _mm_setr_epi8(3, -1, 3, -1, 3, -1, 3, -1, 9, -1, 9, -1, 9, -1, 9, -1);
+	int pixels = 0;
+
+	// the second load reads 4 bytes beyond the 24 bytes of 16 pixels, which
+	// belong to the next 4 pixels
+	for (; pixels + 20 <= width; pixels += 16, yuv += 24, dst += 48)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i*) yuv);
+		__m128i b = _mm_loadu_si128((const __m128i*) (yuv + 12));
+
+		storeConverted(dst, rgb,
+			_mm_shuffle_epi8(a, y), _mm_shuffle_epi8(a, u), _mm_shuffle_epi8(a, v),
+			_mm_shuffle_epi8(b, y), _mm_shuffle_epi8(b, u), _mm_shuffle_epi8(b, v));
+	}
+
+	return pixels;
+}
+
+} // namespace process
+
+} // namespace tt
+
+#endif // TT_SIMD_X86
@@ -0,0 +1,119 @@
+/*
+ * CPU
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include "CPU.h"
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	#include <intrin.h>
+	#define TT_SYS_CPU_X86
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	#include <cpuid.h>
+	#define TT_SYS_CPU_X86
+#endif
+
+namespace tt
+{
+
+namespace sys
+{
+
+#ifdef TT_SYS_CPU_X86
+
+/**
+ * @brief Execute the cpuid instruction for the given leaf and subleaf.
+ * @param regs Receives eax, ebx, ecx and edx.
+ */
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, (int) leaf, (int) subleaf);
+	for (int i = 0; i < 4; i++)
+	{
+		regs[i] = (unsigned int) info[i];
+	}
+#else
+	regs[0] = regs[1] = regs[2] = regs[3] = 0;
+	if (leaf <= __get_cpuid_max(0, 0))
+	{
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+	}
+#endif
+}
+
+/**
+ * @brief Return the lower 32 bits of the extended control register 0.
+ */
+static unsigned int xgetbv0()
+{
+#if defined(_MSC_VER)
+	return (unsigned int) _xgetbv(0);
+#else
+	unsigned int eax;
+	unsigned int edx;
+	__asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	return eax;
+#endif
+}
+
+#endif // TT_SYS_CPU_X86
+
+int CPU::detectFeatures()
+{
+	int detected = 0;
+#ifdef TT_SYS_CPU_X86
+	unsigned int regs[4];
+
+	cpuid(1, 0, regs);
+	if (regs[3] & (1u << 26))
+	{
+		detected |= FEATURE_SSE2;
+	}
+	if (regs[2] & (1u << 9))
+	{
+		detected |= FEATURE_SSSE3;
+	}
+	
+	// AVX2 needs AVX and OSXSAVE in leaf 1 and the OS managing YMM state
+	bool osxsave = (regs[2] & (1u << 27)) != 0;
+	bool avx = (regs[2] & (1u << 28)) != 0;
+	if (osxsave && avx && ((xgetbv0() & 0x6) == 0x6))
+	{
+		cpuid(7, 0, regs);
+		if (regs[1] & (1u << 5))
+		{
+			detected |= FEATURE_AVX2;
+		}
+	}
+#endif
+
+	return detected;
+}
+
+int CPU::getFeatures()
+{
+	// initialized once, also when several threads convert frames at once
+	static const int features = detectFeatures();
+	return features;
+}
+
+bool CPU::hasSSE2()
+{
+	return (getFeatures() & FEATURE_SSE2) != 0;
+}
+
+bool CPU::hasSSSE3()
+{
+	return (getFeatures() & FEATURE_SSSE3) != 0;
+}
+
+bool CPU::hasAVX2()
+{
+	return (getFeatures() & FEATURE_AVX2) != 0;
+}
+
+} // namespace sys
+
+} // namespace tt
@@ -0,0 +1,64 @@
+#ifndef TT_SYS_CPU_H
+#define TT_SYS_CPU_H
+
+namespace tt
+{
+
+/**
+ * @brief Namespace for operating system and hardware dependent helpers.
+ */
+namespace sys
+{
+
+/**
+ * @class CPU CPU.h tt/sys/CPU.h
+ * @brief Runtime detection of processor features.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ * 
+ * CPU queries the instruction set extensions of the processor the library is
+ * running on. The vectorized image processing kernels use it to select the
+ * fastest implementation at runtime, so one binary runs on all x86 machines.
+ * On other architectures all queries return false.
+ */
+class CPU
+{
+public:
+	/**
+	 * @brief Return true, if the processor supports SSE2.
+	 */
+	static bool hasSSE2();
+
+	/**
+	 * @brief Return true, if the processor supports SSSE3.
+	 */
+	static bool hasSSSE3();
+
+	/**
+	 * @brief Return true, if the processor and the operating system support AVX2.
+	 * 
+	 * AVX2 requires the operating system to save the upper halves of the YMM
+	 * registers on context switches, which is checked as well.
+	 */
+	static bool hasAVX2();
+
+private:
+	/** @brief Bit flags of the detected features */
+	enum Feature
+	{
+		FEATURE_SSE2 = 1,
+		FEATURE_SSSE3 = 2,
+		FEATURE_AVX2 = 4
+	};
+
+	/** @brief Query the processor once and return the detected Feature flags. */
+	static int getFeatures();
+
+	/** @brief Query the processor for the Feature flags. */
+	static int detectFeatures();
+};
+
+} // namespace sys
+
+} // namespace tt
+
+#endif /*TT_SYS_CPU_H*/
@@ -0,0 +1,73 @@
+/*
+ * Memory
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include <stdlib.h>
+#include <new>
+#ifdef WIN32
+	#include <malloc.h>
+#endif
+#ifdef LINUX
+	#include <sys/mman.h>
+#endif
+#include "Memory.h"
+
+namespace tt
+{
+
+namespace sys
+{
+
+const size_t Memory::CACHE_LINE;
+const size_t Memory::HUGE_PAGE;
+
+unsigned char* Memory::allocate(size_t bytes, size_t alignment)
+{
+	void* buffer = NULL;
+	// empty images still get a unique buffer
+	if (bytes == 0)
+	{
+		bytes = 1;
+	}
+#ifdef WIN32
+	buffer = _aligned_malloc(bytes, alignment);
+#else
+	if (posix_memalign(&buffer, alignment, bytes) != 0)
+	{
+		buffer = NULL;
+	}
+#endif
+	if (buffer == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return (unsigned char*) buffer;
+}
+
+unsigned char* Memory::allocateHugePages(size_t bytes)
+{
+#if defined(LINUX) && defined(MADV_HUGEPAGE)
+	// transparent huge pages need a whole, aligned huge page
+	bytes = (bytes + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+	unsigned char* buffer = allocate(bytes, HUGE_PAGE);
+	// only advice, the buffer works on small pages as well
+	madvise(buffer, bytes, MADV_HUGEPAGE);
+	return buffer;
+#else
+	return allocate(bytes, CACHE_LINE);
+#endif
+}
+
+void Memory::release(unsigned char* buffer)
+{
+#ifdef WIN32
+	_aligned_free(buffer);
+#else
+	free(buffer);
+#endif
+}
+
+} // namespace sys
+
+} // namespace tt
@@ -0,0 +1,61 @@
+#ifndef TT_SYS_MEMORY_H
+#define TT_SYS_MEMORY_H
+
+#include <stddef.h>
+
+namespace tt
+{
+
+namespace sys
+{
+
+/**
+ * @class Memory Memory.h tt/sys/Memory.h
+ * @brief Aligned allocation of large buffers.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * Image buffers start at a cache line, so a vector load of an aligned line
+ * never spans two cache lines. Large buffers may additionally be placed on
+ * huge pages, which saves most of the TLB misses of walking a frame. On
+ * Linux the buffer is aligned to a huge page and the kernel is advised to
+ * back it with transparent huge pages. Other systems get an ordinary
+ * aligned buffer. All buffers are released with release().
+ */
+class Memory
+{
+public:
+	/** @brief Assumed size of a cache line in bytes */
+	static const size_t CACHE_LINE = 64;
+
+	/** @brief Size of a huge page in bytes */
+	static const size_t HUGE_PAGE = 2 << 20;
+
+	/**
+	 * @brief Allocate an aligned buffer.
+	 * @param bytes Size of the buffer.
+	 * @param alignment A power of two, at least the size of a pointer.
+	 *
+	 * Throws a std::bad_alloc, if the memory is exhausted.
+	 */
+	static unsigned char* allocate(size_t bytes, size_t alignment = CACHE_LINE);
+
+	/**
+	 * @brief Allocate a buffer on huge pages, if the system supports them.
+	 * @param bytes Size of the buffer, rounded up to whole huge pages.
+	 *
+	 * Throws a std::bad_alloc, if the memory is exhausted.
+	 */
+	static unsigned char* allocateHugePages(size_t bytes);
+
+	/**
+	 * @brief Release a buffer of allocate or allocateHugePages.
+	 * @param buffer The buffer or NULL.
+	 */
+	static void release(unsigned char* buffer);
+};
+
+} // namespace sys
+
+} // namespace tt
+
+#endif /*TT_SYS_MEMORY_H*/
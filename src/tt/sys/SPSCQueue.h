@@ -0,0 +1,159 @@
+#ifndef TT_SYS_SPSCQUEUE_H
+#define TT_SYS_SPSCQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdexcept>
+#include <vector>
+
+namespace tt
+{
+
+namespace sys
+{
+
+/**
+ * @class SPSCQueue SPSCQueue.h tt/sys/SPSCQueue.h
+ * @brief Bounded lock-free queue for one producer and one consumer thread.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ *
+ * push() and pop() never block and never allocate, they only exchange
+ * the read and write index of a ring of slots with acquire/release
+ * semantics. Only one thread may call push() and only one thread may call
+ * pop(). Both indices lie on separate cache lines, and each side keeps a
+ * copy of the index of the other side, which is only reloaded when the ring
+ * looks full or empty, so the threads don't bounce a cache line per item.
+ */
+template <typename T>
+class SPSCQueue
+{
+public:
+	/**
+	 * @brief Create an empty queue.
+	 * @param capacity Maximum number of items in the queue, at least 1.
+	 */
+	SPSCQueue(size_t capacity) :
+		slots(capacity + 1),
+		head(0),
+		cachedTail(0),
+		tail(0),
+		cachedHead(0)
+	{
+		if (capacity == 0)
+		{
+			throw std::runtime_error("SPSCQueue::SPSCQueue(size_t capacity) capacity must be at least 1.");
+		}
+	}
+
+	/**
+	 * @brief Append an item, called by the producer only.
+	 * @return False, if the queue is full.
+	 */
+	bool push(const T& item)
+	{
+		size_t position = tail.load(std::memory_order_relaxed);
+		size_t next = increment(position);
+		if (next == cachedHead)
+		{
+			cachedHead = head.load(std::memory_order_acquire);
+			if (next == cachedHead)
+			{
+				return false;
+			}
+		}
+		slots[position] = item;
+		tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Remove the oldest item, called by the consumer only.
+	 * @return False, if the queue is empty.
+	 */
+	bool pop(T& item)
+	{
+		size_t position = head.load(std::memory_order_relaxed);
+		if (position == cachedTail)
+		{
+			cachedTail = tail.load(std::memory_order_acquire);
+			if (position == cachedTail)
+			{
+				return false;
+			}
+		}
+		item = slots[position];
+		head.store(increment(position), std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Return true, if push() would fail, called by the producer only.
+	 */
+	bool isFull() const
+	{
+		return increment(tail.load(std::memory_order_relaxed)) ==
+			head.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Return true, if the queue is empty.
+	 *
+	 * Exact for the consumer, a snapshot for other threads.
+	 */
+	bool isEmpty() const
+	{
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Return the number of items, a snapshot if called concurrently.
+	 */
+	size_t getSize() const
+	{
+		size_t h = head.load(std::memory_order_acquire);
+		size_t t = tail.load(std::memory_order_acquire);
+		return t >= h ? t - h : t + slots.size() - h;
+	}
+
+	/**
+	 * @brief Return the maximum number of items.
+	 */
+	size_t getCapacity() const
+	{
+		return slots.size() - 1;
+	}
+
+private:
+	/** @brief Assumed size of a cache line in bytes */
+	static const size_t CACHE_LINE = 64;
+
+	/** @brief The ring, one slot stays free to tell a full from an empty ring */
+	std::vector<T> slots;
+	char padding0[CACHE_LINE];
+	/** @brief Next slot to read, written by the consumer */
+	std::atomic<size_t> head;
+	/** @brief The consumer's copy of tail */
+	size_t cachedTail;
+	char padding1[CACHE_LINE];
+	/** @brief Next slot to write, written by the producer */
+	std::atomic<size_t> tail;
+	/** @brief The producer's copy of head */
+	size_t cachedHead;
+	char padding2[CACHE_LINE];
+
+	/** @brief Return the slot after position */
+	size_t increment(size_t position) const
+	{
+		return position + 1 == slots.size() ? 0 : position + 1;
+	}
+
+	// the queue is shared by two threads and can't be copied
+	SPSCQueue(const SPSCQueue&);
+	SPSCQueue& operator = (const SPSCQueue&);
+};
+
+} // namespace sys
+
+} // namespace tt
+
+#endif /*TT_SYS_SPSCQUEUE_H*/
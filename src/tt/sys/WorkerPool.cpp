@@ -0,0 +1,144 @@
+/*
+ * WorkerPool
+ * by Martin Wojtczyk <wojtczyk@in.tum.de>
+ */
+
+#include "WorkerPool.h"
+
+namespace tt
+{
+
+namespace sys
+{
+
+WorkerPool::Task::~Task()
+{
+}
+
+WorkerPool::WorkerPool(int threads) :
+	threads(threads),
+	task(NULL),
+	count(0),
+	next(0),
+	pending(0),
+	generation(0),
+	stopping(false)
+{
+	if (this->threads <= 0)
+	{
+		this->threads = (int) std::thread::hardware_concurrency();
+	}
+	if (this->threads <= 0)
+	{
+		this->threads = 1;
+	}
+	
+	// the thread calling run() is the first worker
+	for (int i = 1; i < this->threads; i++)
+	{
+		workers.push_back(std::thread(&WorkerPool::work, this));
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+	
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+int WorkerPool::getThreads() const
+{
+	return this->threads;
+}
+
+void WorkerPool::run(Task& task, int count)
+{
+	std::lock_guard<std::mutex> runLock(runMutex);
+	std::unique_lock<std::mutex> lock(mutex);
+	
+	this->task = &task;
+	this->count = count;
+	this->next = 0;
+	this->pending = count;
+	this->error = std::exception_ptr();
+	this->generation++;
+	workAvailable.notify_all();
+	
+	process(lock);
+	while (pending > 0)
+	{
+		workDone.wait(lock);
+	}
+	
+	this->task = NULL;
+	if (error)
+	{
+		std::exception_ptr thrown = error;
+		error = std::exception_ptr();
+		std::rethrow_exception(thrown);
+	}
+}
+
+void WorkerPool::work()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	unsigned int seen = generation;
+	
+	while (true)
+	{
+		while (!stopping && generation == seen)
+		{
+			workAvailable.wait(lock);
+		}
+		if (stopping)
+		{
+			return;
+		}
+		
+		seen = generation;
+		process(lock);
+	}
+}
+
+void WorkerPool::process(std::unique_lock<std::mutex>& lock)
+{
+	while (next < count)
+	{
+		int index = next++;
+		Task* current = task;
+		
+		lock.unlock();
+		try
+		{
+			current->run(index);
+		}
+		catch (...)
+		{
+			lock.lock();
+			if (!error)
+			{
+				error = std::current_exception();
+			}
+			lock.unlock();
+		}
+		lock.lock();
+		
+		pending--;
+		if (pending == 0)
+		{
+			workDone.notify_all();
+		}
+	}
+}
+
+} // namespace sys
+
+} // namespace tt
@@ -0,0 +1,120 @@
+#ifndef TT_SYS_WORKERPOOL_H
+#define TT_SYS_WORKERPOOL_H
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tt
+{
+
+namespace sys
+{
+
+/**
+ * @class WorkerPool WorkerPool.h tt/sys/WorkerPool.h
+ * @brief Persistent threads for data parallel processing.
+ * @author Martin Wojtczyk <wojtczyk@in.tum.de>
+ * 
+ * A WorkerPool starts its threads once and keeps them waiting for work, so
+ * splitting every frame into parallel parts doesn't cost a thread creation.
+ * The number of threads limits the cores a WorkerPool occupies, which allows
+ * to share a machine between several cameras. The thread calling run() works
+ * along, a WorkerPool with one thread therefore runs everything serially on
+ * the calling thread.
+ */
+class WorkerPool
+{
+public:
+	/**
+	 * @class Task WorkerPool.h tt/sys/WorkerPool.h
+	 * @brief Interface for work which is split into independent parts.
+	 */
+	class Task
+	{
+	public:
+		virtual ~Task();
+		
+		/**
+		 * @brief Process one part of the work.
+		 * @param index Number of the part, starting at 0.
+		 * 
+		 * Called concurrently by the threads of the pool.
+		 */
+		virtual void run(int index) = 0;
+	};
+	
+	/**
+	 * @brief Start the threads of the pool.
+	 * @param threads Number of threads including the thread calling run().
+	 * 0 uses one thread per processor core.
+	 */
+	WorkerPool(int threads = 0);
+
+	/**
+	 * @brief Stop and join the threads of the pool.
+	 */
+	virtual ~WorkerPool();
+	
+	/**
+	 * @brief Return the number of threads including the thread calling run().
+	 */
+	int getThreads() const;
+	
+	/**
+	 * @brief Run the parts 0 to count - 1 of a task and wait for them to finish.
+	 * @param task The task to run.
+	 * @param count Number of parts.
+	 * 
+	 * If a part throws an exception, the remaining parts are still run and
+	 * the first exception is rethrown by this method. Calls from several
+	 * threads are run one after the other.
+	 */
+	void run(Task& task, int count);
+	
+private:
+	/** @brief Number of threads including the calling thread */
+	int threads;
+	/** @brief The started threads */
+	std::vector<std::thread> workers;
+	/** @brief Serializes calls of run() */
+	std::mutex runMutex;
+	/** @brief Protects the state below */
+	std::mutex mutex;
+	/** @brief Signals new work or shutdown to the workers */
+	std::condition_variable workAvailable;
+	/** @brief Signals the completion of all parts to run() */
+	std::condition_variable workDone;
+	/** @brief The current task */
+	Task* task;
+	/** @brief Number of parts of the current task */
+	int count;
+	/** @brief Next part to be processed */
+	int next;
+	/** @brief Number of parts which are not finished yet */
+	int pending;
+	/** @brief Incremented with each task, so workers notice new work */
+	unsigned int generation;
+	/** @brief True if the destructor asks the workers to quit */
+	bool stopping;
+	/** @brief First exception thrown by a part of the current task */
+	std::exception_ptr error;
+	
+	/** @brief Main loop of the worker threads */
+	void work();
+	
+	/** @brief Process parts of the current task until none is left, mutex must be locked */
+	void process(std::unique_lock<std::mutex>& lock);
+
+	// a WorkerPool owns threads and can't be copied
+	WorkerPool(const WorkerPool&);
+	WorkerPool& operator = (const WorkerPool&);
+};
+
+} // namespace sys
+
+} // namespace tt
+
+#endif /*TT_SYS_WORKERPOOL_H*/